@@ -4,17 +4,28 @@
 #include <cstddef>
 
 #include "esp_log.h"
+#include "esp_task_wdt.h"
 
 // Include the full definitions of the components we use.
 #include "audio_source.hpp"
 #include "ble_manager.hpp"
+#include "clip_recorder.hpp"
+#include "job_scheduler.hpp"
 #include "led_manager.hpp"
+#include "memory_placement.hpp"
+#include "ota_updater.hpp"
 #include "state_base.hpp"
 #include "storage_manager.hpp"
 
 namespace {
 // File-local constants.
 static const char* kTag = "Application";
+
+// Microphone interface of the board. Variants fitted with a PDM MEMS
+// microphone use CaptureMode::kPdm, those with a microphone pair
+// CaptureMode::kStereoBeamform.
+constexpr audio::AudioSource::CaptureMode kCaptureMode =
+    audio::AudioSource::CaptureMode::kStandard;
 }  // namespace
 
 namespace app {
@@ -94,18 +105,58 @@ esp_err_t Application::Initialize() {
     ble_manager_ = ble::BLEManager::GetInstance();
 
     // --- Initialize AudioSource Instance ---
-    audio_source_ = audio::AudioSource::Create();
+    audio_source_ = audio::AudioSource::Create(kCaptureMode);
     if (!audio_source_) {
         ESP_LOGE(kTag, "Failed to create AudioSource instance.");
         return ESP_FAIL;
     }
+    audio_source_->SetAdaptiveHeadroom(true);
+
+    // --- Initialize JobScheduler Instance ---
+    // Spreads each frame's analytics over both cores.
+    job_scheduler_ =
+        pipeline::JobScheduler::Create(pipeline::JobScheduler::Config{});
+    if (!job_scheduler_) {
+        ESP_LOGW(kTag, "Job scheduler unavailable, analytics run on one core.");
+    }
+
+    // --- Initialize ClipRecorder Instance ---
+    // The history buffer lives in PSRAM, or in internal RAM while enough of
+    // it stays free. Without it the device still streams, only clip capture
+    // is disabled.
+    clip_recorder_ = clip::ClipRecorder::Create(clip::ClipRecorder::Config{
+        .sample_rate_hz = audio::AudioSource::kSampleRateHz,
+        .frame_samples = audio::AudioSource::kMaxFrameSamples});
+    if (!clip_recorder_) {
+        ESP_LOGW(kTag, "Clip recording unavailable.");
+    }
+
+    // --- Initialize OtaUpdater Instance ---
+    ota_updater_ = ota::OtaUpdater::Create();
+    if (!ota_updater_) {
+        ESP_LOGW(kTag, "Firmware updates unavailable.");
+    }
 
     // --- Setup Callbacks ---
     // Use lambdas to forward the BLE events to our private handler methods.
     ble_manager_->SetOnConnectedCallback([this]() { this->OnBleConnected(); });
     ble_manager_->SetOnDisconnectedCallback(
         [this]() { this->OnBleDisconnected(); });
-
+    ble_manager_->SetOnAudioPacketReceivedCallback(
+        [this](const ble::AudioPacket& packet) {
+            if (packet.data_type == ble::PacketConfig::kDataTypeSpectrogram) {
+                streaming_state_.SetSpectrogramEnabled(packet.payload != 0);
+            }
+        });
+    ble_manager_->SetOnFramePacketReceivedCallback(
+        [this](const ble::FramePacket& packet) {
+            if (packet.data_type == ble::PacketConfig::kDataTypeOta &&
+                ota_updater_) {
+                ota_updater_->HandlePacket(packet);
+            }
+        });
+
+    memory::MemoryPlacement::LogUsage();
     ESP_LOGI(kTag, "Components initialized. Setting initial state.");
 
     return ESP_OK;
@@ -114,6 +165,10 @@ esp_err_t Application::Initialize() {
 void Application::Start() {
     ESP_LOGI(kTag, "Starting main application task...");
     // Create the FreeRTOS task that will run the main loop.
+    // Frame packets and DSP buffers come from the streaming scratch arena;
+    // the deepest remaining path is a frame send, which encodes one packet
+    // on the stack. The streaming state logs the unused stack on exit; the
+    // size has not been re-derived from that reading yet.
     xTaskCreate(MainTask, "MainAppTask", 4096, this, 5, &main_task_handle_);
 }
 
@@ -131,9 +186,16 @@ void Application::RunMainTask() {
     SetState(AppState::kWaitingForConnection);
     ESP_LOGI(kTag, "First state set.");
 
+    // Every state returns from Execute() well within the watchdog timeout,
+    // so a missed feed means the loop hung, e.g. on a lost I2S interrupt.
+    if (esp_task_wdt_add(nullptr) != ESP_OK) {
+        ESP_LOGW(kTag, "Main task not watched by the task watchdog.");
+    }
+
     while (true) {
         // The core of the state machine: delegate execution to the current state.
         current_state_->Execute();
+        esp_task_wdt_reset();
     }
 }
 
@@ -194,6 +256,8 @@ void Application::OnBleConnected() {
 void Application::OnBleDisconnected() {
     ESP_LOGI(kTag, "Event: BLE Disconnected. Transitioning to Waiting.");
     // The client has disconnected. Go back to waiting for a new connection.
+    // Stream options are per client.
+    streaming_state_.SetSpectrogramEnabled(false);
     SetState(AppState::kWaitingForConnection);
 }
 
@@ -21,6 +21,15 @@ class AudioSource;
 namespace ble {
 class BLEManager;
 }
+namespace clip {
+class ClipRecorder;
+}
+namespace ota {
+class OtaUpdater;
+}
+namespace pipeline {
+class JobScheduler;
+}
 
 namespace app {
 
@@ -72,6 +81,15 @@ class Application {
     // --- Public Getters for States to Use ---
     audio::AudioSource* GetAudioSource() { return audio_source_.get(); }
     ble::BLEManager* GetBleManager() { return ble_manager_; }
+    // May be nullptr, clip recording is optional.
+    clip::ClipRecorder* GetClipRecorder() { return clip_recorder_.get(); }
+    // May be nullptr when the partition table has no OTA slots.
+    ota::OtaUpdater* GetOtaUpdater() { return ota_updater_.get(); }
+    // May be nullptr; parallel DSP jobs then run on the calling task.
+    pipeline::JobScheduler* GetJobScheduler() { return job_scheduler_.get(); }
+    // The task running the state machine; states may also be switched
+    // from the NimBLE host task.
+    TaskHandle_t GetMainTaskHandle() const { return main_task_handle_; }
 
    private:
     // Grant friendship to allow state classes to access the Application's
@@ -111,6 +129,9 @@ class Application {
 
     std::unique_ptr<audio::AudioSource> audio_source_;
     ble::BLEManager* ble_manager_ = nullptr;
+    std::unique_ptr<clip::ClipRecorder> clip_recorder_;
+    std::unique_ptr<ota::OtaUpdater> ota_updater_;
+    std::unique_ptr<pipeline::JobScheduler> job_scheduler_;
     TaskHandle_t main_task_handle_ = nullptr;
 
     // Static pointer to the single instance of this class.
@@ -0,0 +1,49 @@
+#ifndef APP_STATES_PIPELINE_FEATURES_HPP_
+#define APP_STATES_PIPELINE_FEATURES_HPP_
+
+#include "sdkconfig.h"
+
+/**
+ * @file pipeline_features.hpp
+ * @brief Optional streaming pipeline stages selected in menuconfig, see
+ * the "SonaFlow feature pipeline" menu.
+ */
+
+namespace app::features {
+
+#ifdef CONFIG_SONAFLOW_STAGE_EVENTS
+inline constexpr bool kEvents = true;
+#else
+inline constexpr bool kEvents = false;
+#endif
+
+#ifdef CONFIG_SONAFLOW_STAGE_TONES
+inline constexpr bool kTones = true;
+#else
+inline constexpr bool kTones = false;
+#endif
+
+#ifdef CONFIG_SONAFLOW_STAGE_PITCH
+inline constexpr bool kPitch = true;
+#else
+inline constexpr bool kPitch = false;
+#endif
+
+#ifdef CONFIG_SONAFLOW_STAGE_SPECTROGRAM
+inline constexpr bool kSpectrogram = true;
+#else
+inline constexpr bool kSpectrogram = false;
+#endif
+
+#ifdef CONFIG_SONAFLOW_STAGE_LIVE_AUDIO
+inline constexpr bool kLiveAudio = true;
+#else
+inline constexpr bool kLiveAudio = false;
+#endif
+
+// Pitch and ADPCM audio both run on the decimated analysis stream.
+inline constexpr bool kAnalysisStream = kPitch || kLiveAudio;
+
+}  // namespace app::features
+
+#endif  // APP_STATES_PIPELINE_FEATURES_HPP_
@@ -1,5 +1,11 @@
 #include "states/streaming_state.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+
+#include "esp_cpu.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 
@@ -7,26 +13,311 @@
 #include "audio_source.hpp"
 #include "ble_manager.hpp"
 #include "ble_packet.hpp"
+#include "block_exponent.hpp"
+#include "clip_recorder.hpp"
+#include "job_scheduler.hpp"
 #include "led_manager.hpp"
 #include "storage_manager.hpp"
 
 namespace {
 static const char* kTag = "StreamingState";
 constexpr uint32_t kStreamingTaskDelayMs = 20;
+// Every frame's feature goes to the BLEManager, which decimates it to the
+// rate of each client. Pitch frames and the feature log go at 50 Hz. Audio
+// analysis itself runs on every captured frame, paced by the blocking I2S
+// read.
+constexpr int64_t kFeaturePacketPeriodUs = kStreamingTaskDelayMs * 1000;
+// While the noise gate is closed only a heartbeat is sent, once a second.
+constexpr int64_t kHeartbeatPeriodUs = 1000 * 1000;
+constexpr int64_t kTimebasePeriodUs = 1000 * 1000;
+constexpr int64_t kDeadlineReportPeriodUs = 5 * 1000 * 1000;
+
+// One capture frame. Frames may start up to half a period late before the
+// capture DMA buffering is eaten into.
+constexpr uint32_t kFramePeriodUs = static_cast<uint32_t>(
+    1000000ull * audio::AudioSource::kMaxFrameSamples /
+    audio::AudioSource::kSampleRateHz);
+constexpr uint32_t kFrameBudgetUs = kFramePeriodUs * 3 / 2;
+
+// Analytics stages are stateful, so they are shed in spans of contiguous
+// audio and reset at the start of each. A span outlasts the longest tone
+// hold plus its block, so every stage settles and reports within it.
+constexpr uint16_t kAnalyticsSpanFrames = static_cast<uint16_t>(
+    2 * audio::AudioSource::kSampleRateHz /
+    audio::AudioSource::kMaxFrameSamples);
+
+// Optional work shed under overload, least important first. Analytics
+// drop to every other span before stopping; the feature log thins out
+// before it stops; live audio goes last. Capture, events and the level
+// feature stream always run. No LED work runs per frame, so the LED class
+// has no step.
+constexpr pipeline::LoadShedder::Step kShedLadder[] = {
+    {pipeline::LoadShedder::Priority::kAnalytics, 2, kAnalyticsSpanFrames},
+    {pipeline::LoadShedder::Priority::kAnalytics, 0},
+    {pipeline::LoadShedder::Priority::kLogging, 4},
+    {pipeline::LoadShedder::Priority::kLogging, 0},
+    {pipeline::LoadShedder::Priority::kTransport, 0},
+};
+
+// Per-frame budgets of the pipeline stages, in StreamingState::Stage order.
+// Capture includes the wait for the DMA, up to one frame period.
+constexpr pipeline::DeadlineMonitor::StageConfig kStageConfigs[] = {
+    {"capture", kFramePeriodUs + 2000,
+     pipeline::DeadlineMonitor::Cause::kI2sWait},
+    {"events", 1000, pipeline::DeadlineMonitor::Cause::kUnknown},
+    {"analysis", 1000, pipeline::DeadlineMonitor::Cause::kUnknown},
+    // Tones, pitch and the spectrogram, spread over both cores.
+    {"analytics", 2500, pipeline::DeadlineMonitor::Cause::kUnknown},
+    {"audio", 3000, pipeline::DeadlineMonitor::Cause::kUnknown},
+    {"feature", 500, pipeline::DeadlineMonitor::Cause::kQueueFull},
+    {"storage", 2000, pipeline::DeadlineMonitor::Cause::kFlashStall},
+};
+
+// Clip triggers: a near-full-scale feature level, or a sharp onset.
+constexpr int8_t kClipTriggerLevel = 90;
+constexpr float kClipTriggerOnsetDb = 12.0f;
+
+// Tones watched by the Goertzel detector bank. The bandwidth sets each
+// detector's block length and therefore its reaction time.
+constexpr dsp::GoertzelBank::ToneConfig kWatchedTones[] = {
+    // Smoke alarm piezo sounders sit between roughly 3.0 and 3.4 kHz and
+    // beep in a 0.5 s on/off pattern, so release slowly.
+    {.frequency_hz = 3200.0f,
+     .bandwidth_hz = 400.0f,
+     .threshold = 0.3f,
+     .hold_ms = 300,
+     .release_ms = 2000},
+    // Mains-frequency machine hum of 50 Hz and 60 Hz grids, in one
+    // detector: the resonator headroom limits blocks this low to about
+    // 30 Hz of bandwidth, too wide to tell the two grids apart.
+    {.frequency_hz = 55.0f,
+     .bandwidth_hz = 30.0f,
+     .threshold = 0.4f,
+     .hold_ms = 1000,
+     .release_ms = 1000},
+};
+
+// Size of one pitch estimate in a kDataTypePitch frame.
+constexpr size_t kPitchEntrySize = 3;
+// Bytes ahead of the codec data in kDataTypeAdpcm and kDataTypeLc3 frames.
+constexpr size_t kAdpcmHeaderSize = 1;
+constexpr size_t kLc3HeaderSize = 3;
+
+// Writes `bytes` bytes of `value` big-endian.
+void PutBigEndian(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * (bytes - 1 - i)));
+    }
+}
+
+// Converts a value to an int8_t packet payload with rounding and clamping.
+int8_t ToPayload(float value) {
+    return static_cast<int8_t>(std::clamp(std::lround(value), 0L, 127L));
+}
 }  // namespace
 
 namespace app {
 
-StreamingState::StreamingState(Application& context) : StateBase(context) {}
+StreamingState::StreamingState(Application& context)
+    : StateBase(context),
+      deadline_monitor_(kFrameBudgetUs),
+      load_shedder_(pipeline::LoadShedder::Config{}, kShedLadder),
+      onset_detector_(dsp::OnsetDetector::Config{
+          .sample_rate_hz = audio::AudioSource::kSampleRateHz}),
+      tempo_tracker_(dsp::TempoTracker::Config{}),
+      tone_bank_(dsp::GoertzelBank::Config{
+          .sample_rate_hz = audio::AudioSource::kSampleRateHz}),
+      noise_gate_(dsp::NoiseGate::Config{
+          .frame_rate_hz = audio::AudioSource::kSampleRateHz /
+                           audio::AudioSource::kMaxFrameSamples}),
+      pitch_tracker_(dsp::PitchTracker::Config{
+          .sample_rate_hz =
+              audio::AudioSource::kSampleRateHz / kAnalysisDecimation}),
+      spectrogram_(dsp::Spectrogram::Config{
+          .sample_rate_hz = audio::AudioSource::kSampleRateHz,
+          .bands = kSpectrogramBands}),
+      spectrogram_encoder_(kSpectrogramBands, kSpectrogramDeadband),
+      scratch_(kScratchBytes) {
+    static_assert(std::size(kStageConfigs) == kStageCount,
+                  "Every stage needs a budget");
+    for (const pipeline::DeadlineMonitor::StageConfig& stage : kStageConfigs) {
+        deadline_monitor_.AddStage(stage);
+    }
+    pipeline::IfPresent(tone_bank_, [](auto& tone_bank) {
+        for (const dsp::GoertzelBank::ToneConfig& tone : kWatchedTones) {
+            if (tone_bank.AddTone(tone) == dsp::GoertzelBank::kMaxTones) {
+                ESP_LOGE(kTag, "Failed to add %.0f Hz tone detector.",
+                         tone.frequency_hz);
+            }
+        }
+    });
+}
 
 void StreamingState::OnEnter() {
     ESP_LOGI(kTag, "Entering Streaming state.");
     // Reset the packet sequence number for the new streaming session.
     sequence_number_ = 0;
+    event_sequence_number_ = 0;
+    frame_sequence_number_ = 0;
+    last_feature_packet_us_ = 0;
+    last_timebase_us_ = 0;
+    last_deadline_report_us_ = esp_timer_get_time();
+    deadline_monitor_.ResetStats();
+    load_shedder_.Reset();
+    analytics_ran_ = false;
+    scratch_.ResetStats();
+    if (pipeline::JobScheduler* scheduler = context_.GetJobScheduler()) {
+        scheduler->ResetStats();
+    }
+
+    const auto reset = [](auto& stage) { stage.Reset(); };
+    pipeline::IfPresent(onset_detector_, reset);
+    pipeline::IfPresent(tempo_tracker_, reset);
+    pipeline::IfPresent(tone_bank_, reset);
+    noise_gate_.Reset();
+    pipeline::IfPresent(analysis_decimator_, reset);
+    pipeline::IfPresent(pitch_tracker_, reset);
+    pitch_frame_.length = 0;
+    latest_pitch_dhz_ = 0;
+    latest_pitch_confidence_ = 0;
+    latest_tempo_dbpm_ = 0;
+    snapshot_sequence_ = 0;
+    spectrogram_running_ = false;
+    pipeline::IfPresent(adpcm_encoder_, reset);
+    adpcm_fill_ = 0;
+    adpcm_cycles_ = 0;
+    adpcm_samples_ = 0;
+
+    // The LC3 encoder is opened on first use and kept afterwards.
+    pipeline::IfPresent(lc3_encoder_, [](auto& lc3_encoder) {
+        if (!lc3_encoder) {
+            lc3_encoder = codec::Lc3Encoder::Create(codec::Lc3Encoder::Config{
+                .sample_rate_hz = kLc3SampleRateHz});
+            if (!lc3_encoder) {
+                ESP_LOGW(kTag, "LC3 unavailable, streaming ADPCM audio.");
+            }
+        }
+    });
+    pipeline::IfPresent(lc3_resampler_, reset);
+    lc3_fill_ = 0;
+    lc3_packet_.length = 0;
+    lc3_max_cycles_ = 0;
+    lc3_cycles_ = 0;
+    lc3_frames_ = 0;
+    lc3_resample_cycles_ = 0;
+    lc3_resampled_samples_ = 0;
+    work_cycles_ = 0;
+    work_max_cycles_ = 0;
+    work_frames_ = 0;
+    context_.GetBleManager()->ResetEventLatencyStats();
+    context_.GetAudioSource()->ResetHeadroomStats();
+    last_frame_exponent_ = context_.GetAudioSource()->GetLastFrameExponent();
 
     led::LEDManager::GetInstance().SetAndRefreshColor(0, 0, 64, 0);
 }
 
+void StreamingState::OnExit() {
+    const pipeline::DeadlineMonitor::Stats& frames =
+        deadline_monitor_.GetFrameStats();
+    ESP_LOGI(kTag,
+             "Frames: %lu late of %lu, worst period %lu us, shedding level "
+             "up to %u.",
+             static_cast<unsigned long>(frames.overruns),
+             static_cast<unsigned long>(frames.runs),
+             static_cast<unsigned long>(frames.worst_us),
+             static_cast<unsigned>(load_shedder_.GetMaxLevel()));
+    if (work_frames_ > 0) {
+        // Compare builds with different pipeline stages by this line.
+        ESP_LOGI(kTag, "Frame work: %lu cycles avg, %lu max.",
+                 static_cast<unsigned long>(work_cycles_ / work_frames_),
+                 static_cast<unsigned long>(work_max_cycles_));
+    }
+    const pipeline::JobScheduler* scheduler = context_.GetJobScheduler();
+    if (scheduler != nullptr && scheduler->GetStats().batches > 0) {
+        const pipeline::JobScheduler::Stats& jobs = scheduler->GetStats();
+        ESP_LOGI(kTag,
+                 "Analytics jobs: %lu frames, %lu us serial vs %lu us wall "
+                 "per frame (speedup %.2f), overhead %lu us, %lu of %lu "
+                 "stolen.",
+                 static_cast<unsigned long>(jobs.batches),
+                 static_cast<unsigned long>(jobs.job_us / jobs.batches),
+                 static_cast<unsigned long>(jobs.wall_us / jobs.batches),
+                 scheduler->GetSpeedup(),
+                 static_cast<unsigned long>(scheduler->GetOverheadUs()),
+                 static_cast<unsigned long>(jobs.stolen),
+                 static_cast<unsigned long>(jobs.jobs));
+    }
+    for (size_t i = 0; i < deadline_monitor_.GetStageCount(); ++i) {
+        const pipeline::DeadlineMonitor::Stats& stage =
+            deadline_monitor_.GetStageStats(i);
+        if (stage.overruns == 0) {
+            continue;
+        }
+        ESP_LOGW(kTag, "Stage %s: %lu overruns, worst %lu us, last cause %s.",
+                 deadline_monitor_.GetStageName(i),
+                 static_cast<unsigned long>(stage.overruns),
+                 static_cast<unsigned long>(stage.worst_us),
+                 pipeline::DeadlineMonitor::GetCauseName(stage.last_cause));
+    }
+    ESP_LOGI(kTag, "Scratch: peak %zu of %zu bytes, %lu failed allocations.",
+             scratch_.GetPeak(), scratch_.GetCapacity(),
+             static_cast<unsigned long>(scratch_.GetFailures()));
+    // Size the main task stack by this line. OnExit() may run on the
+    // NimBLE host task, so the main task is named explicitly.
+    if (TaskHandle_t main_task = context_.GetMainTaskHandle()) {
+        ESP_LOGI(kTag, "Main task stack: %lu bytes never used.",
+                 static_cast<unsigned long>(
+                     uxTaskGetStackHighWaterMark(main_task)));
+    }
+    const ble::BLEManager::LatencyStats stats =
+        context_.GetBleManager()->GetEventLatencyStats();
+    ESP_LOGI(kTag,
+             "Event latency: %lu events, max %lu us, %lu over target.",
+             static_cast<unsigned long>(stats.count),
+             static_cast<unsigned long>(stats.max_us),
+             static_cast<unsigned long>(stats.over_target));
+    const ble::ClockSync::Estimate clock =
+        context_.GetBleManager()->GetClockSync().GetEstimate();
+    if (clock.valid) {
+        ESP_LOGI(kTag,
+                 "Client clock: skew %.2f ppm, dispersion %lu us, %u of %u "
+                 "samples, min round trip %lu us.",
+                 clock.skew_ppm,
+                 static_cast<unsigned long>(clock.dispersion_us),
+                 clock.accepted, clock.samples,
+                 static_cast<unsigned long>(clock.min_delay_us));
+    }
+    const audio::AudioSource::HeadroomStats headroom =
+        context_.GetAudioSource()->GetHeadroomStats();
+    ESP_LOGI(kTag, "Capture: %lu clipped samples in %lu frames, %lu shift "
+             "changes, %.2f Hz measured.",
+             static_cast<unsigned long>(headroom.clipped_samples),
+             static_cast<unsigned long>(headroom.clipped_frames),
+             static_cast<unsigned long>(headroom.shift_changes),
+             context_.GetAudioSource()->GetMeasuredSampleRateHz());
+    if (adpcm_samples_ > 0) {
+        ESP_LOGI(kTag, "ADPCM encoder: %.1f cycles/sample.",
+                 static_cast<double>(adpcm_cycles_) / adpcm_samples_);
+    }
+    if (lc3_frames_ > 0) {
+        // One 10 ms frame must encode in well under 10 ms of one core.
+        constexpr uint32_t kCyclesPerFrame =
+            CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ *
+            codec::Lc3Encoder::kFrameDurationUs;
+        ESP_LOGI(kTag,
+                 "LC3 encoder: %lu cycles/frame avg, %lu max (%.1f%% of one "
+                 "core).",
+                 static_cast<unsigned long>(lc3_cycles_ / lc3_frames_),
+                 static_cast<unsigned long>(lc3_max_cycles_),
+                 100.0 * lc3_max_cycles_ / kCyclesPerFrame);
+    }
+    if (lc3_resampled_samples_ > 0) {
+        ESP_LOGI(kTag, "LC3 resampler: %.1f cycles/output sample.",
+                 static_cast<double>(lc3_resample_cycles_) /
+                     lc3_resampled_samples_);
+    }
+}
+
 void StreamingState::Execute() {
     // --- Robustness Check ---
     // Ensure BLE is still connected.
@@ -38,9 +329,40 @@ void StreamingState::Execute() {
         return;  // Exit immediately to allow the transition to happen.
     }
 
+    deadline_monitor_.BeginFrame();
+    ProcessFrame();
+    deadline_monitor_.EndFrame();
+    UpdateLoad();
+}
+
+void StreamingState::ProcessFrame() {
+    using Scope = pipeline::DeadlineMonitor::Scope;
+    using Priority = pipeline::LoadShedder::Priority;
+
+    work_start_us_ = 0;
+    scratch_.Reset();
+    analysis_ = {};
+    analysis_samples_ = 0;
     // --- Get Audio Feature ---
+    // The read blocks until the next frame has been captured. With clip
+    // recording enabled the frame is captured straight into the history.
     int8_t feature = 0;
-    esp_err_t ret = context_.GetAudioSource()->GetFeature(feature);
+    clip::ClipRecorder* recorder = context_.GetClipRecorder();
+    esp_err_t ret;
+    {
+        Scope stage(deadline_monitor_, kStageCapture);
+        if (recorder != nullptr) {
+            ret = context_.GetAudioSource()->GetFeature(
+                feature,
+                recorder->AcquireFrame(audio::AudioSource::kMaxFrameSamples));
+            if (ret == ESP_OK) {
+                recorder->CommitFrame(
+                    context_.GetAudioSource()->GetLastFrame().size());
+            }
+        } else {
+            ret = context_.GetAudioSource()->GetFeature(feature);
+        }
+    }
 
     if (ret != ESP_OK) {
         ESP_LOGE(kTag, "Failed to get audio feature.");
@@ -49,23 +371,708 @@ void StreamingState::Execute() {
         return;
     }
 
+    const int64_t now_us = esp_timer_get_time();
+    work_start_us_ = now_us;
+    work_start_cycles_ = esp_cpu_get_cycle_count();
+    if (now_us - last_timebase_us_ >= kTimebasePeriodUs) {
+        SendTimebase(now_us);
+    }
+    if (now_us - last_deadline_report_us_ >= kDeadlineReportPeriodUs) {
+        SendDeadlineReport(now_us);
+    }
+
+    FollowBlockExponent();
+
+    // --- Events first, they bypass the feature rate limit ---
+    const bool run_analytics = load_shedder_.ShouldRun(Priority::kAnalytics);
+    if (features::kEvents) {
+        Scope stage(deadline_monitor_, kStageEvents);
+        pipeline::IfPresent(onset_detector_, [this](auto& onset_detector) {
+            DetectEvents(onset_detector, tempo_tracker_);
+        });
+    }
+    if (features::kAnalysisStream) {
+        // The analysis stream also feeds ADPCM audio.
+        Scope stage(deadline_monitor_, kStageAnalysis);
+        pipeline::IfPresent(analysis_decimator_, [this](auto& decimator) {
+            DecimateFrame(decimator);
+        });
+    }
+    if ((features::kTones || features::kPitch || features::kSpectrogram) &&
+        run_analytics) {
+        Scope stage(deadline_monitor_, kStageAnalytics);
+        if (!analytics_ran_) {
+            RestartAnalytics();
+        }
+        RunAnalytics();
+    }
+    analytics_ran_ = run_analytics;
+
+    // --- Noise Gate ---
+    // While quiet, only a heartbeat goes out and nothing is written to
+    // flash. The frame that opens the gate is sent right away.
+    // The gate shares the frame energy summed during capture conversion.
+    const bool was_open = noise_gate_.IsOpen();
+    audio::AudioSource* source = context_.GetAudioSource();
+    const bool active = noise_gate_.ProcessEnergy(
+        source->GetLastFrameEnergy(), source->GetLastFrame().size());
+    PublishSnapshot(feature);
+    if (!active) {
+        pitch_frame_.length = 0;
+        ResetLiveAudio();
+        if (now_us - last_feature_packet_us_ >= kHeartbeatPeriodUs) {
+            SendHeartbeat(now_us);
+        }
+        return;
+    }
+
+    // Live audio is not rate limited, but goes when the link is saturated.
+    if (!load_shedder_.ShouldRun(Priority::kTransport)) {
+        ResetLiveAudio();
+    } else if (features::kLiveAudio) {
+        Scope stage(deadline_monitor_, kStageAudio);
+        pipeline::IfPresent(lc3_encoder_, [this](auto& lc3_encoder) {
+            if (lc3_encoder) {
+                EncodeLc3(*lc3_encoder, lc3_resampler_);
+                return;
+            }
+            pipeline::IfPresent(adpcm_encoder_, [this](auto& adpcm_encoder) {
+                EncodeAdpcm(adpcm_encoder);
+            });
+        });
+    }
+
+    if (recorder != nullptr && feature >= kClipTriggerLevel) {
+        recorder->Trigger(clip::ClipRecorder::TriggerSource::kLevel);
+    }
+
+    // --- Rate Limiting ---
+    // Only pitch frames and the log; links decimate the feature stream.
+    const bool log_due =
+        !was_open || now_us - last_feature_packet_us_ >= kFeaturePacketPeriodUs;
+    if (log_due) {
+        last_feature_packet_us_ = now_us;
+    }
+
     // --- Construct and Send Packet ---
+    // Stamped with the capture time of the frame, not the send time. The
+    // sequence numbers the logged series; every link numbers its own.
+    const int64_t frame_time_us =
+        context_.GetAudioSource()->GetLastFrameTimeUs();
     ble::AudioPacket packet = {
         .header = ble::PacketConfig::kHeaderSync,
         .data_type = ble::PacketConfig::kDataTypeAudio,
-        .sequence = sequence_number_++,
-        .timestamp = static_cast<uint32_t>(esp_timer_get_time() / 1000),
+        .sequence = sequence_number_,
+        .timestamp = static_cast<uint32_t>(frame_time_us / 1000),
         .payload = feature,
         .checksum = 0,  // Checksum will be calculated by the encoder.
     };
-    context_.GetBleManager()->SendAudioPacket(packet);
+    {
+        Scope stage(deadline_monitor_, kStageFeature);
+        context_.GetBleManager()->SendFeaturePacket(packet, frame_time_us);
+        if (log_due) {
+            FlushPitchFrame();
+        }
+    }
+    if (!log_due) {
+        return;
+    }
+    ++sequence_number_;
 
     // Log the feature to flash storage
-    storage::StorageManager::GetInstance().LogAudioFeature(packet);
+    if (load_shedder_.ShouldRun(Priority::kLogging)) {
+        Scope stage(deadline_monitor_, kStageStorage);
+        storage::StorageManager::GetInstance().LogAudioFeature(packet);
+    }
+}
 
-    // --- Rate Limiting ---
-    // Yield the CPU and control the data transmission rate.
-    vTaskDelay(pdMS_TO_TICKS(kStreamingTaskDelayMs));
+void StreamingState::UpdateLoad() {
+    if (work_start_us_ == 0) {
+        return;
+    }
+    const uint32_t cycles = esp_cpu_get_cycle_count() - work_start_cycles_;
+    work_cycles_ += cycles;
+    work_max_cycles_ = std::max(work_max_cycles_, cycles);
+    ++work_frames_;
+    const float cpu_load =
+        static_cast<float>(esp_timer_get_time() - work_start_us_) /
+        kFramePeriodUs;
+    if (!load_shedder_.Update(
+            cpu_load, context_.GetBleManager()->GetSendQueueOccupancy())) {
+        return;
+    }
+    ESP_LOGW(kTag, "CPU load %.0f%%, send queue %.0f%%: shedding level %u.",
+             100.0f * load_shedder_.GetCpuLoad(),
+             100.0f * load_shedder_.GetQueueOccupancy(),
+             static_cast<unsigned>(load_shedder_.GetLevel()));
+}
+
+template <typename OnsetDetector, typename TempoTracker>
+void StreamingState::DetectEvents(OnsetDetector& onset_detector,
+                                  TempoTracker& tempo_tracker) {
+    const std::span<const int16_t> frame =
+        context_.GetAudioSource()->GetLastFrame();
+
+    std::optional<dsp::OnsetDetector::Onset> onset =
+        onset_detector.Process(frame);
+    if (!onset) {
+        return;
+    }
+
+    const int64_t onset_time_us = FrameSampleTimeUs(onset->sample_offset);
+
+    clip::ClipRecorder* recorder = context_.GetClipRecorder();
+    if (recorder != nullptr && onset->strength_db >= kClipTriggerOnsetDb) {
+        recorder->Trigger(clip::ClipRecorder::TriggerSource::kOnset);
+    }
+
+    ble::AudioPacket event = {
+        .header = ble::PacketConfig::kHeaderSync,
+        .data_type = ble::PacketConfig::kDataTypeOnset,
+        .sequence = event_sequence_number_++,
+        .timestamp = static_cast<uint32_t>(onset_time_us / 1000),
+        .payload = ToPayload(onset->strength_db * 2.0f),
+        .checksum = 0,
+    };
+    context_.GetBleManager()->SendEventPacket(event, onset_time_us);
+
+    std::optional<dsp::TempoTracker::Beat> beat =
+        tempo_tracker.OnOnset(onset_time_us);
+    if (!beat) {
+        return;
+    }
+
+    latest_tempo_dbpm_ = static_cast<uint16_t>(
+        std::clamp(std::lround(beat->bpm * 10.0f), 0L, 65535L));
+    event.data_type = ble::PacketConfig::kDataTypeBeat;
+    event.sequence = event_sequence_number_++;
+    event.payload = ToPayload(beat->bpm / 2.0f);
+    context_.GetBleManager()->SendEventPacket(event, onset_time_us);
+}
+
+void StreamingState::RestartAnalytics() {
+    const auto reset = [](auto& stage) { stage.Reset(); };
+    pipeline::IfPresent(tone_bank_, reset);
+    pipeline::IfPresent(pitch_tracker_, reset);
+    // Restarts with a keyframe.
+    spectrogram_running_ = false;
+}
+
+void StreamingState::RunAnalytics() {
+    using Job = pipeline::JobScheduler::Job;
+    audio::AudioSource* source = context_.GetAudioSource();
+    const std::span<const int16_t> frame = source->GetLastFrame();
+    const int8_t exponent = source->GetLastFrameExponent();
+
+    // Outputs are carved before the jobs start, as the arena is not
+    // thread-safe. Each job only touches its own DSP object and output;
+    // packets are sent afterwards, in order, from this task.
+    pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+    std::span<dsp::GoertzelBank::ToneEvent> tone_events;
+    size_t tone_count = 0;
+    std::span<dsp::PitchTracker::Estimate> estimates;
+    size_t estimate_count = 0;
+    bool spectrogram_due = false;
+    bool spectrogram_ready = false;
+
+    auto detect_tones = [&] {
+        pipeline::IfPresent(tone_bank_, [&](auto& tone_bank) {
+            tone_count = tone_bank.Process(frame, tone_events);
+        });
+    };
+    auto track_pitch = [&] {
+        pipeline::IfPresent(pitch_tracker_, [&](auto& pitch_tracker) {
+            estimate_count = pitch_tracker.Process(
+                analysis_.first(analysis_samples_), estimates);
+        });
+    };
+    auto update_spectrogram = [&] {
+        pipeline::IfPresent(spectrogram_, [&](auto& spectrogram) {
+            spectrogram_ready = spectrogram.Process(frame, exponent);
+        });
+    };
+
+    std::array<Job, 3> jobs;
+    size_t job_count = 0;
+    pipeline::IfPresent(tone_bank_, [&](auto&) {
+        tone_events = scratch_.Allocate<dsp::GoertzelBank::ToneEvent>(
+            dsp::GoertzelBank::kMaxTones);
+        if (!tone_events.empty()) {
+            jobs[job_count++] = Job::Of(detect_tones);
+        }
+    });
+    pipeline::IfPresent(pitch_tracker_, [&](auto&) {
+        estimates = scratch_.Allocate<dsp::PitchTracker::Estimate>(
+            kMaxAnalysisSamples / dsp::PitchTracker::kHop + 1);
+        if (!estimates.empty()) {
+            jobs[job_count++] = Job::Of(track_pitch);
+        }
+    });
+    // The spectrogram keeps scrolling while the gate is closed; stable
+    // bands cost a byte per frame.
+    pipeline::IfPresent(spectrogram_, [&](auto& spectrogram) {
+        spectrogram_due = PrepareSpectrogram(spectrogram);
+        if (spectrogram_due) {
+            jobs[job_count++] = Job::Of(update_spectrogram);
+        }
+    });
+
+    const std::span<const Job> batch(jobs.data(), job_count);
+    pipeline::JobScheduler* scheduler = context_.GetJobScheduler();
+    if (scheduler != nullptr) {
+        scheduler->Run(batch);
+    } else {
+        for (const Job& job : batch) {
+            job.function(job.context);
+        }
+    }
+
+    EmitToneEvents(tone_events.first(tone_count));
+    AppendPitchEstimates(estimates.first(estimate_count));
+    if (spectrogram_ready) {
+        pipeline::IfPresent(spectrogram_, [this](auto& spectrogram) {
+            EmitSpectrogram(spectrogram, spectrogram_encoder_);
+        });
+    }
+}
+
+void StreamingState::EmitToneEvents(
+    std::span<const dsp::GoertzelBank::ToneEvent> events) {
+    for (size_t i = 0; i < events.size(); ++i) {
+        const int64_t time_us = FrameSampleTimeUs(events[i].sample_offset);
+        ble::AudioPacket event = {
+            .header = ble::PacketConfig::kHeaderSync,
+            .data_type = ble::PacketConfig::kDataTypeTone,
+            .sequence = event_sequence_number_++,
+            .timestamp = static_cast<uint32_t>(time_us / 1000),
+            .payload = static_cast<int8_t>((events[i].present ? 0x40 : 0x00) |
+                                           (events[i].tone_index & 0x3F)),
+            .checksum = 0,
+        };
+        context_.GetBleManager()->SendEventPacket(event, time_us);
+        ESP_LOGI(kTag, "Tone %u %s (ratio %.2f).",
+                 static_cast<unsigned>(events[i].tone_index),
+                 events[i].present ? "started" : "stopped", events[i].ratio);
+    }
+}
+
+template <typename Decimator>
+void StreamingState::DecimateFrame(Decimator& decimator) {
+    // Without scratch the decimator still consumes the frame, so its
+    // history stays continuous; the frame's analysis is lost.
+    analysis_ = scratch_.Allocate<int16_t>(kMaxAnalysisSamples);
+    analysis_samples_ = decimator.Process(
+        context_.GetAudioSource()->GetLastFrame(), analysis_);
+}
+
+void StreamingState::AppendPitchEstimates(
+    std::span<const dsp::PitchTracker::Estimate> estimates) {
+    // A frame must fit every link's MTU; at the default MTU it holds three
+    // estimates, fewer than a 20 ms period brings.
+    const size_t budget = context_.GetBleManager()->GetMaxFramePayload();
+    for (size_t i = 0; i < estimates.size(); ++i) {
+        const uint16_t pitch_dhz = static_cast<uint16_t>(std::min(
+            std::lround(estimates[i].frequency_hz * 10.0f), 65535L));
+        const uint8_t confidence = static_cast<uint8_t>(
+            std::lround(estimates[i].confidence * 255.0f));
+        latest_pitch_dhz_ = pitch_dhz;
+        latest_pitch_confidence_ = confidence;
+
+        if (pitch_frame_.length + kPitchEntrySize > budget) {
+            FlushPitchFrame();
+            if (kPitchEntrySize > budget) {
+                continue;
+            }
+        }
+        if (pitch_frame_.length == 0) {
+            const size_t frame_offset =
+                (estimates[i].sample_offset + 1) * kAnalysisDecimation - 1;
+            pitch_frame_.timestamp =
+                static_cast<uint32_t>(FrameSampleTimeUs(frame_offset) / 1000);
+        }
+
+        uint8_t* entry = &pitch_frame_.payload[pitch_frame_.length];
+        entry[0] = pitch_dhz >> 8;
+        entry[1] = pitch_dhz & 0xFF;
+        entry[2] = confidence;
+        pitch_frame_.length += kPitchEntrySize;
+    }
+}
+
+template <typename Spectrogram>
+bool StreamingState::PrepareSpectrogram(Spectrogram& spectrogram) {
+    if (!spectrogram_enabled_.load(std::memory_order_relaxed)) {
+        spectrogram_running_ = false;
+        return false;
+    }
+    if (!spectrogram_running_) {
+        spectrogram_running_ = true;
+        spectrogram.Reset();
+        spectrogram_packet_.length = 0;
+        spectrogram_packet_frames_ = 0;
+        spectrogram_frames_since_key_ = kSpectrogramKeyframeInterval;
+    }
+    return true;
+}
+
+template <typename Spectrogram, typename Encoder>
+void StreamingState::EmitSpectrogram(Spectrogram& spectrogram,
+                                     Encoder& encoder) {
+    static_assert(kSpectrogramHeaderSize +
+                      kSpectrogramFramesPerPacket *
+                          dsp::SpectrogramCodec::MaxEncodedSize(
+                              kSpectrogramBands) <=
+                  ble::PacketConfig::kMaxFramePayload);
+
+    pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+    const std::span<uint8_t> coded = scratch_.Allocate<uint8_t>(
+        dsp::SpectrogramCodec::MaxEncodedSize(kSpectrogramBands));
+    if (coded.empty()) {
+        return;
+    }
+    // Keyframes always start a packet, so the packet flag marks every
+    // point a client can resynchronise at.
+    const bool keyframe =
+        spectrogram_frames_since_key_ >= kSpectrogramKeyframeInterval;
+    const size_t coded_size =
+        encoder.Encode(spectrogram.GetBands(), keyframe, coded);
+    if (coded_size == 0) {
+        return;
+    }
+    spectrogram_frames_since_key_ =
+        keyframe ? 1 : spectrogram_frames_since_key_ + 1;
+
+    const size_t budget = context_.GetBleManager()->GetMaxFramePayload();
+    if (keyframe || spectrogram_packet_.length + coded_size > budget) {
+        FlushSpectrogramPacket();
+    }
+    if (spectrogram_packet_.length == 0) {
+        spectrogram_packet_.timestamp = static_cast<uint32_t>(
+            FrameSampleTimeUs(spectrogram.GetSampleOffset()) / 1000);
+        spectrogram_packet_.payload[0] = spectrogram_frame_index_;
+        spectrogram_packet_.payload[1] = kSpectrogramBands;
+        spectrogram_packet_.payload[2] = keyframe ? 0x01 : 0x00;
+        spectrogram_packet_.length = kSpectrogramHeaderSize;
+    }
+    std::copy_n(coded.begin(), coded_size,
+                &spectrogram_packet_.payload[spectrogram_packet_.length]);
+    spectrogram_packet_.length =
+        static_cast<uint8_t>(spectrogram_packet_.length + coded_size);
+    ++spectrogram_frame_index_;
+
+    if (++spectrogram_packet_frames_ == kSpectrogramFramesPerPacket) {
+        FlushSpectrogramPacket();
+    }
+}
+
+void StreamingState::FlushSpectrogramPacket() {
+    if (spectrogram_packet_.length == 0) {
+        return;
+    }
+    spectrogram_packet_.data_type = ble::PacketConfig::kDataTypeSpectrogram;
+    spectrogram_packet_.sequence = frame_sequence_number_++;
+    const esp_err_t ret =
+        context_.GetBleManager()->SendFramePacket(spectrogram_packet_);
+    if (ret == ESP_ERR_TIMEOUT) {
+        deadline_monitor_.NoteCause(
+            pipeline::DeadlineMonitor::Cause::kQueueFull);
+    }
+    if (ret != ESP_OK) {
+        // The client loses the delta chain, so restart it.
+        spectrogram_frames_since_key_ = kSpectrogramKeyframeInterval;
+    }
+    spectrogram_packet_.length = 0;
+    spectrogram_packet_frames_ = 0;
+}
+
+void StreamingState::FlushPitchFrame() {
+    if (pitch_frame_.length == 0) {
+        return;
+    }
+    pitch_frame_.data_type = ble::PacketConfig::kDataTypePitch;
+    pitch_frame_.sequence = frame_sequence_number_++;
+    context_.GetBleManager()->SendFramePacket(pitch_frame_);
+    pitch_frame_.length = 0;
+}
+
+template <typename Encoder>
+void StreamingState::EncodeAdpcm(Encoder& encoder) {
+    static_assert(kAdpcmHeaderSize +
+                      dsp::ImaAdpcmEncoder::EncodedSize(kAdpcmBlockSamples) <=
+                  ble::PacketConfig::kMaxFramePayload);
+
+    size_t consumed = 0;
+    while (consumed < analysis_samples_) {
+        if (adpcm_fill_ == 0) {
+            const size_t frame_offset =
+                (consumed + 1) * kAnalysisDecimation - 1;
+            adpcm_block_time_us_ = FrameSampleTimeUs(frame_offset);
+        }
+        const size_t count = std::min(analysis_samples_ - consumed,
+                                      kAdpcmBlockSamples - adpcm_fill_);
+        std::copy_n(&analysis_[consumed], count, &adpcm_block_[adpcm_fill_]);
+        adpcm_fill_ += count;
+        consumed += count;
+        if (adpcm_fill_ < kAdpcmBlockSamples) {
+            break;
+        }
+        adpcm_fill_ = 0;
+
+        pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+        ble::FramePacket* frame = NewFramePacket(
+            ble::PacketConfig::kDataTypeAdpcm, adpcm_block_time_us_);
+        if (frame == nullptr) {
+            continue;
+        }
+        frame->payload[0] = static_cast<uint8_t>(last_frame_exponent_);
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+        frame->length = static_cast<uint8_t>(
+            kAdpcmHeaderSize +
+            encoder.EncodeBlock(adpcm_block_,
+                                std::span(frame->payload)
+                                    .subspan(kAdpcmHeaderSize)));
+        adpcm_cycles_ += esp_cpu_get_cycle_count() - start_cycles;
+        adpcm_samples_ += kAdpcmBlockSamples;
+        if (context_.GetBleManager()->SendFramePacket(*frame) ==
+            ESP_ERR_TIMEOUT) {
+            deadline_monitor_.NoteCause(
+                pipeline::DeadlineMonitor::Cause::kQueueFull);
+        }
+    }
+}
+
+template <typename Encoder, typename Resampler>
+void StreamingState::EncodeLc3(Encoder& encoder, Resampler& resampler) {
+    pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+    const std::span<int16_t> resampled = scratch_.Allocate<int16_t>(
+        Lc3Resampler::MaxOutputSamples(audio::AudioSource::kMaxFrameSamples));
+    if (resampled.empty()) {
+        return;
+    }
+
+    const std::span<const int16_t> frame =
+        context_.GetAudioSource()->GetLastFrame();
+    const uint32_t start_resample_cycles = esp_cpu_get_cycle_count();
+    const size_t samples = resampler.Process(frame, resampled);
+    lc3_resample_cycles_ += esp_cpu_get_cycle_count() - start_resample_cycles;
+    lc3_resampled_samples_ += samples;
+
+    const size_t frame_bytes = encoder.GetFrameBytes();
+    size_t consumed = 0;
+    while (consumed < samples) {
+        const size_t count =
+            std::min(samples - consumed, lc3_pcm_.size() - lc3_fill_);
+        std::copy_n(&resampled[consumed], count, &lc3_pcm_[lc3_fill_]);
+        lc3_fill_ += count;
+        consumed += count;
+        if (lc3_fill_ < lc3_pcm_.size()) {
+            break;
+        }
+        lc3_fill_ = 0;
+
+        if (lc3_packet_.length == 0) {
+            // Back-date the batch to the start of its first codec frame.
+            const size_t frame_offset = consumed * frame.size() / samples - 1;
+            const int64_t start_us = FrameSampleTimeUs(frame_offset) -
+                                     codec::Lc3Encoder::kFrameDurationUs;
+            lc3_packet_.timestamp = static_cast<uint32_t>(start_us / 1000);
+            lc3_packet_.payload[0] =
+                static_cast<uint8_t>(last_frame_exponent_);
+            lc3_packet_.payload[1] = kLc3SampleRateHz / 1000;
+            lc3_packet_.payload[2] = static_cast<uint8_t>(frame_bytes);
+            lc3_packet_.length = kLc3HeaderSize;
+        }
+
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+        const esp_err_t ret = encoder.Encode(
+            lc3_pcm_,
+            std::span(&lc3_packet_.payload[lc3_packet_.length], frame_bytes));
+        const uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+        if (ret != ESP_OK) {
+            // Frames in a batch must be consecutive: send the ones before
+            // the failed frame and start a new batch after it.
+            FlushLc3Packet();
+            continue;
+        }
+        lc3_cycles_ += cycles;
+        lc3_max_cycles_ = std::max(lc3_max_cycles_, cycles);
+        ++lc3_frames_;
+
+        lc3_packet_.length += frame_bytes;
+        const bool batch_full =
+            lc3_packet_.length >=
+                kLc3HeaderSize + kLc3FramesPerPacket * frame_bytes ||
+            lc3_packet_.length + frame_bytes >
+                ble::PacketConfig::kMaxFramePayload;
+        if (batch_full) {
+            FlushLc3Packet();
+        }
+    }
+}
+
+void StreamingState::FlushLc3Packet() {
+    if (lc3_packet_.length <= kLc3HeaderSize) {
+        lc3_packet_.length = 0;
+        return;
+    }
+    lc3_packet_.data_type = ble::PacketConfig::kDataTypeLc3;
+    lc3_packet_.sequence = frame_sequence_number_++;
+    if (context_.GetBleManager()->SendFramePacket(lc3_packet_) ==
+        ESP_ERR_TIMEOUT) {
+        deadline_monitor_.NoteCause(
+            pipeline::DeadlineMonitor::Cause::kQueueFull);
+    }
+    lc3_packet_.length = 0;
+}
+
+void StreamingState::ResetLiveAudio() {
+    adpcm_fill_ = 0;
+    lc3_fill_ = 0;
+    lc3_packet_.length = 0;
+    pipeline::IfPresent(lc3_resampler_,
+                        [](auto& resampler) { resampler.Reset(); });
+}
+
+void StreamingState::FollowBlockExponent() {
+    const int8_t exponent = context_.GetAudioSource()->GetLastFrameExponent();
+    if (exponent == last_frame_exponent_) {
+        return;
+    }
+    const int bits = exponent - last_frame_exponent_;
+    last_frame_exponent_ = exponent;
+
+    // The change is a 6 dB step in the PCM level, not an onset, so let the
+    // detector settle on the new scale.
+    pipeline::IfPresent(onset_detector_,
+                        [](auto& onset_detector) { onset_detector.Reset(); });
+
+    // Finished LC3 frames go out under the old exponent. The encoder's own
+    // overlap memory cannot be rescaled, which leaves a transient of a few
+    // milliseconds at the start of the next batch.
+    FlushLc3Packet();
+    const auto rescale = [bits](auto& stage) { stage.Rescale(bits); };
+    pipeline::IfPresent(analysis_decimator_, rescale);
+    pipeline::IfPresent(lc3_resampler_, rescale);
+    dsp::RescaleSamples(std::span(adpcm_block_).first(adpcm_fill_), bits);
+    dsp::RescaleSamples(std::span(lc3_pcm_).first(lc3_fill_), bits);
+}
+
+void StreamingState::PublishSnapshot(int8_t feature) {
+    pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+    const std::span<ble::FramePacket> packet =
+        scratch_.Allocate<ble::FramePacket>(1);
+    if (packet.empty()) {
+        return;
+    }
+    // Snapshots count on their own, as they are read rather than sent.
+    ble::FramePacket& snapshot = packet[0];
+    snapshot.data_type = ble::PacketConfig::kDataTypeSnapshot;
+    snapshot.sequence = snapshot_sequence_++;
+    snapshot.timestamp = static_cast<uint32_t>(
+        context_.GetAudioSource()->GetLastFrameTimeUs() / 1000);
+    snapshot.length = ble::PacketConfig::kSnapshotPayloadSize;
+    snapshot.payload[0] = static_cast<uint8_t>(feature);
+    snapshot.payload[1] = noise_gate_.IsOpen() ? 0x01 : 0x00;
+    snapshot.payload[2] =
+        static_cast<uint8_t>(ToPayload(noise_gate_.GetNoiseFloorDb()));
+    PutBigEndian(&snapshot.payload[3], latest_pitch_dhz_, 2);
+    snapshot.payload[5] = latest_pitch_confidence_;
+    PutBigEndian(&snapshot.payload[6], latest_tempo_dbpm_, 2);
+    snapshot.payload[8] = static_cast<uint8_t>(last_frame_exponent_);
+    context_.GetBleManager()->PublishSnapshot(snapshot);
+}
+
+void StreamingState::SendHeartbeat(int64_t now_us) {
+    last_feature_packet_us_ = now_us;
+    const int64_t frame_time_us =
+        context_.GetAudioSource()->GetLastFrameTimeUs();
+    ble::AudioPacket packet = {
+        .header = ble::PacketConfig::kHeaderSync,
+        .data_type = ble::PacketConfig::kDataTypeHeartbeat,
+        .sequence = sequence_number_++,
+        .timestamp = static_cast<uint32_t>(frame_time_us / 1000),
+        .payload = ToPayload(noise_gate_.GetNoiseFloorDb()),
+        .checksum = 0,
+    };
+    context_.GetBleManager()->SendFeaturePacket(packet, frame_time_us);
+}
+
+void StreamingState::SendDeadlineReport(int64_t now_us) {
+    last_deadline_report_us_ = now_us;
+    constexpr size_t kEntrySize = 5;
+    pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+    ble::FramePacket* frame =
+        NewFramePacket(ble::PacketConfig::kDataTypeDeadline, now_us);
+    if (frame == nullptr) {
+        return;
+    }
+    frame->length = 1;
+    auto put_entry = [frame](const pipeline::DeadlineMonitor::Stats& stats) {
+        uint8_t* entry = &frame->payload[frame->length];
+        PutBigEndian(entry, std::min<uint32_t>(stats.overruns, 0xFFFF), 2);
+        PutBigEndian(&entry[2], std::min<uint32_t>(stats.worst_us, 0xFFFF), 2);
+        entry[4] = static_cast<uint8_t>(stats.last_cause);
+        frame->length += kEntrySize;
+    };
+
+    put_entry(deadline_monitor_.GetFrameStats());
+    for (size_t i = 0; i < deadline_monitor_.GetStageCount(); ++i) {
+        put_entry(deadline_monitor_.GetStageStats(i));
+    }
+    frame->payload[0] =
+        static_cast<uint8_t>(deadline_monitor_.GetStageCount() + 1);
+    context_.GetBleManager()->SendFramePacket(*frame);
+}
+
+void StreamingState::SendTimebase(int64_t now_us) {
+    last_timebase_us_ = now_us;
+    audio::AudioSource* source = context_.GetAudioSource();
+    const uint64_t sample_index =
+        source->GetLastFrameSampleIndex() + source->GetLastFrame().size() - 1;
+    const int64_t sample_time_us = source->GetSampleTimeUs(sample_index);
+
+    pipeline::ScratchArena::Checkpoint checkpoint(scratch_);
+    ble::FramePacket* frame =
+        NewFramePacket(ble::PacketConfig::kDataTypeTimebase, sample_time_us);
+    if (frame == nullptr) {
+        return;
+    }
+    frame->length = 20;
+    PutBigEndian(&frame->payload[0], audio::AudioSource::kSampleRateHz, 4);
+    PutBigEndian(&frame->payload[4], sample_index, 8);
+    PutBigEndian(&frame->payload[12], static_cast<uint64_t>(sample_time_us),
+                 8);
+    // With a synchronised client the sample's client time follows, which
+    // lets the client measure end-to-end latency against its own clock.
+    int64_t client_time_us = 0;
+    if (context_.GetBleManager()->GetClockSync().ToClientTimeUs(
+            sample_time_us, client_time_us)) {
+        PutBigEndian(&frame->payload[20],
+                     static_cast<uint64_t>(client_time_us), 8);
+        frame->length = 28;
+    }
+    context_.GetBleManager()->SendFramePacket(*frame);
+}
+
+ble::FramePacket* StreamingState::NewFramePacket(uint8_t data_type,
+                                                 int64_t time_us) {
+    const std::span<ble::FramePacket> packet =
+        scratch_.Allocate<ble::FramePacket>(1);
+    if (packet.empty()) {
+        return nullptr;
+    }
+    packet[0].data_type = data_type;
+    packet[0].sequence = frame_sequence_number_++;
+    packet[0].timestamp = static_cast<uint32_t>(time_us / 1000);
+    packet[0].length = 0;
+    return &packet[0];
+}
+
+int64_t StreamingState::FrameSampleTimeUs(size_t sample_offset) const {
+    // Derived from the sample clock, so every stage agrees on sample times.
+    audio::AudioSource* source = context_.GetAudioSource();
+    return source->GetSampleTimeUs(source->GetLastFrameSampleIndex() +
+                                   sample_offset);
 }
 
 AppState StreamingState::GetStateEnum() const {
@@ -1,8 +1,32 @@
 #ifndef APP_STATES_STREAMING_STATE_HPP_
 #define APP_STATES_STREAMING_STATE_HPP_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <span>
+
+#include "audio_source.hpp"
+#include "ble_packet.hpp"
+#include "deadline_monitor.hpp"
+#include "decimator.hpp"
+#include "goertzel_bank.hpp"
+#include "ima_adpcm_encoder.hpp"
+#include "lc3_encoder.hpp"
+#include "load_shedder.hpp"
+#include "noise_gate.hpp"
+#include "onset_detector.hpp"
+#include "optional_stage.hpp"
+#include "pipeline_features.hpp"
+#include "pitch_tracker.hpp"
+#include "polyphase_resampler.hpp"
+#include "scratch_arena.hpp"
+#include "spectrogram.hpp"
+#include "spectrogram_codec.hpp"
 #include "states/state_base.hpp"
+#include "tempo_tracker.hpp"
 
 namespace app {
 
@@ -10,19 +34,340 @@ namespace app {
  * @class StreamingState
  * @brief Represents the state where the device is actively sampling audio,
  * processing features, and transmitting them over a BLE connection.
+ *
+ * Optional stages sit in pipeline::OptionalStage slots chosen by
+ * app::features, and are only touched through pipeline::IfPresent, so a
+ * stage left out in menuconfig contributes neither code nor state.
  */
 class StreamingState : public StateBase {
    public:
     explicit StreamingState(Application& context);
 
     void OnEnter() override;
+    void OnExit() override;
     void Execute() override;
     AppState GetStateEnum() const override;
 
+    /**
+     * @brief Turns the spectrogram stream on or off. May be called from any
+     * task, e.g. when the client asks for it.
+     */
+    void SetSpectrogramEnabled(bool enabled) {
+        spectrogram_enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
    private:
+    // Pipeline stages timed by the deadline monitor, in the order of
+    // kStageConfigs.
+    enum Stage : size_t {
+        kStageCapture,
+        kStageEvents,
+        kStageAnalysis,
+        kStageAnalytics,
+        kStageAudio,
+        kStageFeature,
+        kStageStorage,
+        kStageCount,
+    };
+
+    /**
+     * @brief Captures and processes one frame, timing every stage.
+     */
+    void ProcessFrame();
+
+    /**
+     * @brief Feeds the frame's CPU load and the send queue occupancy to the
+     * load shedder.
+     */
+    void UpdateLoad();
+
+    // The optional stages below take their DSP objects as template
+    // parameters, so they are only instantiated when those are built; see
+    // pipeline::IfPresent.
+
+    /**
+     * @brief Runs onset and beat detection on the last captured frame and
+     * sends any resulting event packets immediately.
+     */
+    template <typename OnsetDetector, typename TempoTracker>
+    void DetectEvents(OnsetDetector& onset_detector,
+                      TempoTracker& tempo_tracker);
+
+    /**
+     * @brief Decimates the last captured frame into the analysis stream.
+     */
+    template <typename Decimator>
+    void DecimateFrame(Decimator& decimator);
+
+    /**
+     * @brief Resets the analytics stages before they resume after being
+     * shed, so they do not splice audio across the gap.
+     */
+    void RestartAnalytics();
+
+    /**
+     * @brief Runs tone detection, pitch tracking and the spectrogram as
+     * one batch of jobs on the job scheduler, then sends their results.
+     *
+     * The three stages share no state, so they run concurrently on both
+     * cores; without a scheduler they run in turn on the calling task.
+     */
+    void RunAnalytics();
+
+    /**
+     * @brief Sends an event packet for every tone that started or stopped.
+     */
+    void EmitToneEvents(std::span<const dsp::GoertzelBank::ToneEvent> events);
+
+    /**
+     * @brief Appends pitch estimates to the pending pitch frame.
+     */
+    void AppendPitchEstimates(
+        std::span<const dsp::PitchTracker::Estimate> estimates);
+
+    /**
+     * @brief Collects the analysis stream into ADPCM blocks and sends every
+     * completed block as an audio frame packet.
+     */
+    template <typename Encoder>
+    void EncodeAdpcm(Encoder& encoder);
+
+    /**
+     * @brief Resamples the last captured frame for the LC3 encoder, encodes
+     * every completed 10 ms frame and sends them in batches.
+     */
+    template <typename Encoder, typename Resampler>
+    void EncodeLc3(Encoder& encoder, Resampler& resampler);
+
+    /**
+     * @brief Starts or stops the spectrogram as requested by the client.
+     * @return true if the spectrogram should process this frame.
+     */
+    template <typename Spectrogram>
+    bool PrepareSpectrogram(Spectrogram& spectrogram);
+
+    /**
+     * @brief Encodes the completed band frame and batches it for sending.
+     */
+    template <typename Spectrogram, typename Encoder>
+    void EmitSpectrogram(Spectrogram& spectrogram, Encoder& encoder);
+
+    /**
+     * @brief Sends and clears the pending spectrogram packet.
+     */
+    void FlushSpectrogramPacket();
+
+    /**
+     * @brief Sends and clears the pending pitch frame, if it holds any
+     * estimates.
+     */
+    void FlushPitchFrame();
+
+    /**
+     * @brief Sends and clears the pending LC3 batch, if it holds any
+     * frames.
+     */
+    void FlushLc3Packet();
+
+    /**
+     * @brief Drops partly collected live audio, so audio resumed after a
+     * pause is not joined to the audio before it.
+     */
+    void ResetLiveAudio();
+
+    /**
+     * @brief Follows a change of the capture block exponent.
+     *
+     * Audio buffered across frames, in filter histories and partly filled
+     * blocks, is moved to the new exponent, so every audio packet carries
+     * a single exponent. A batch of finished LC3 frames is sent first.
+     */
+    void FollowBlockExponent();
+
+    /**
+     * @brief Publishes the latest feature values for clients that read the
+     * snapshot characteristic.
+     * @param feature Level feature of the last captured frame.
+     */
+    void PublishSnapshot(int8_t feature);
+
+    /**
+     * @brief Sends a heartbeat packet in place of the feature stream.
+     * @param now_us Current esp_timer time in microseconds.
+     */
+    void SendHeartbeat(int64_t now_us);
+
+    /**
+     * @brief Sends the deadline monitor's overrun counters and worst times.
+     * @param now_us Current esp_timer time in microseconds.
+     */
+    void SendDeadlineReport(int64_t now_us);
+
+    /**
+     * @brief Sends the mapping from capture sample index to device time.
+     * @param now_us Current esp_timer time in microseconds.
+     */
+    void SendTimebase(int64_t now_us);
+
+    /**
+     * @brief Carves a frame packet from the scratch arena, keeping it off
+     * the task stack, and takes the next frame sequence number.
+     * @param data_type Frame data type.
+     * @param time_us esp_timer time of the packet's timestamp.
+     * @return The packet with an empty payload, or nullptr if the arena is
+     * full.
+     */
+    ble::FramePacket* NewFramePacket(uint8_t data_type, int64_t time_us);
+
+    /**
+     * @brief Returns the capture time of a sample in the last frame.
+     * @param sample_offset Index of the sample within the frame.
+     */
+    int64_t FrameSampleTimeUs(size_t sample_offset) const;
+
     // A sequence number for the BLE packets, local to this state.
     // It is reset every time a new streaming session starts (in OnEnter).
     uint16_t sequence_number_ = 0;
+    // Separate sequence for event packets, so the feature stream stays
+    // gap-free for clients that ignore events.
+    uint16_t event_sequence_number_ = 0;
+    // Sequence number shared by all frame packets.
+    uint16_t frame_sequence_number_ = 0;
+    // esp_timer time of the last feature packet, for rate limiting.
+    int64_t last_feature_packet_us_ = 0;
+    // esp_timer time of the last timebase packet.
+    int64_t last_timebase_us_ = 0;
+    // esp_timer time of the last deadline report.
+    int64_t last_deadline_report_us_ = 0;
+
+    pipeline::DeadlineMonitor deadline_monitor_;
+    // Sheds analytics, flash logging and live audio, in that order, when
+    // the frame work or the BLE link falls behind.
+    pipeline::LoadShedder load_shedder_;
+    // Whether the analytics stages saw the previous frame.
+    bool analytics_ran_ = false;
+    // esp_timer time the current frame's capture completed, 0 if it failed.
+    int64_t work_start_us_ = 0;
+    uint32_t work_start_cycles_ = 0;
+    // Frame work after capture, reported when the session ends.
+    uint64_t work_cycles_ = 0;
+    uint32_t work_max_cycles_ = 0;
+    uint32_t work_frames_ = 0;
+
+    [[no_unique_address]] pipeline::OptionalStage<features::kEvents,
+                                                  dsp::OnsetDetector>
+        onset_detector_;
+    // Capture block exponent of the last frame, and of all buffered audio.
+    int8_t last_frame_exponent_ = 0;
+    [[no_unique_address]] pipeline::OptionalStage<features::kEvents,
+                                                  dsp::TempoTracker>
+        tempo_tracker_;
+    [[no_unique_address]] pipeline::OptionalStage<features::kTones,
+                                                  dsp::GoertzelBank>
+        tone_bank_;
+
+    // Suppresses the feature stream in quiet environments.
+    dsp::NoiseGate noise_gate_;
+
+    // Pitch and compressed audio run on a 4:1 decimated analysis stream
+    // (11.025 kHz).
+    static constexpr size_t kAnalysisDecimation = 4;
+    [[no_unique_address]] pipeline::OptionalStage<
+        features::kAnalysisStream, dsp::Decimator<kAnalysisDecimation, 32>>
+        analysis_decimator_;
+    static constexpr size_t kMaxAnalysisSamples =
+        audio::AudioSource::kMaxFrameSamples / kAnalysisDecimation + 1;
+    // Carved from scratch_ every frame.
+    std::span<int16_t> analysis_;
+    size_t analysis_samples_ = 0;
+
+    [[no_unique_address]] pipeline::OptionalStage<features::kPitch,
+                                                  dsp::PitchTracker>
+        pitch_tracker_;
+    // Newest pitch and tempo, for the feature snapshot.
+    uint16_t latest_pitch_dhz_ = 0;
+    uint8_t latest_pitch_confidence_ = 0;
+    uint16_t latest_tempo_dbpm_ = 0;
+    uint16_t snapshot_sequence_ = 0;
+    // Estimates collected since the last feature packet.
+    ble::FramePacket pitch_frame_{};
+
+    // ~23 ms of audio per block, 131 bytes per packet at 11.025 kHz.
+    static constexpr size_t kAdpcmBlockSamples = 256;
+    [[no_unique_address]] pipeline::OptionalStage<features::kLiveAudio,
+                                                  dsp::ImaAdpcmEncoder>
+        adpcm_encoder_;
+    std::array<int16_t, kAdpcmBlockSamples> adpcm_block_{};
+    size_t adpcm_fill_ = 0;
+    int64_t adpcm_block_time_us_ = 0;
+    // Encoder cost, reported when the session ends.
+    uint64_t adpcm_cycles_ = 0;
+    uint64_t adpcm_samples_ = 0;
+
+    // Live audio uses LC3 when the encoder is available, ADPCM otherwise.
+    // The capture stream is resampled straight to the 16 kHz codec rate;
+    // 64 taps per phase keep it flat to 6 kHz and reject aliases by 70 dB.
+    static constexpr uint32_t kLc3SampleRateHz = 16000;
+    static constexpr size_t kLc3FramesPerPacket = 5;
+    using Lc3Resampler =
+        dsp::PolyphaseResampler<audio::AudioSource::kSampleRateHz,
+                                kLc3SampleRateHz, 64>;
+    [[no_unique_address]] pipeline::OptionalStage<
+        features::kLiveAudio, std::unique_ptr<codec::Lc3Encoder>>
+        lc3_encoder_;
+    [[no_unique_address]] pipeline::OptionalStage<features::kLiveAudio,
+                                                  Lc3Resampler>
+        lc3_resampler_;
+    std::array<int16_t, kLc3SampleRateHz / 100> lc3_pcm_{};
+    size_t lc3_fill_ = 0;
+    ble::FramePacket lc3_packet_{};
+    uint32_t lc3_max_cycles_ = 0;
+    uint64_t lc3_cycles_ = 0;
+    uint32_t lc3_frames_ = 0;
+    uint64_t lc3_resample_cycles_ = 0;
+    uint64_t lc3_resampled_samples_ = 0;
+
+    // Scrolling spectrogram, sent while the client has it enabled. Small
+    // changes are dropped by the encoder's deadband; packets are flushed
+    // after ~100 ms at the latest so the display stays fluid.
+    static constexpr size_t kSpectrogramBands = 32;
+    static constexpr uint8_t kSpectrogramDeadband = 2;  // 1 dB
+    static constexpr size_t kSpectrogramHeaderSize = 3;
+    static constexpr size_t kSpectrogramFramesPerPacket = 3;
+    static constexpr uint32_t kSpectrogramKeyframeInterval = 30;
+    std::atomic<bool> spectrogram_enabled_{false};
+    bool spectrogram_running_ = false;
+    [[no_unique_address]] pipeline::OptionalStage<features::kSpectrogram,
+                                                  dsp::Spectrogram>
+        spectrogram_;
+    [[no_unique_address]] pipeline::OptionalStage<features::kSpectrogram,
+                                                  dsp::SpectrogramEncoder>
+        spectrogram_encoder_;
+    ble::FramePacket spectrogram_packet_{};
+    uint8_t spectrogram_frame_index_ = 0;
+    size_t spectrogram_packet_frames_ = 0;
+    uint32_t spectrogram_frames_since_key_ = 0;
+
+    // Per-frame temporaries, reset at the start of every frame. The
+    // analysis stream lives for the whole frame; every other buffer only
+    // for its own stage, so only the largest stage counts. The analytics
+    // outputs are all live at once while their jobs run. Outgoing frame
+    // packets are carved here too, as they would take a sixth of the task
+    // stack.
+    static constexpr size_t kScratchBytes =
+        pipeline::ScratchArena::Footprint<int16_t>(kMaxAnalysisSamples) +
+        std::max(
+            pipeline::ScratchArena::Footprint<dsp::GoertzelBank::ToneEvent>(
+                dsp::GoertzelBank::kMaxTones) +
+                pipeline::ScratchArena::Footprint<dsp::PitchTracker::Estimate>(
+                    kMaxAnalysisSamples / dsp::PitchTracker::kHop + 1) +
+                pipeline::ScratchArena::Footprint<uint8_t>(
+                    dsp::SpectrogramCodec::MaxEncodedSize(kSpectrogramBands)),
+            std::max(pipeline::ScratchArena::Footprint<int16_t>(
+                         Lc3Resampler::MaxOutputSamples(
+                             audio::AudioSource::kMaxFrameSamples)),
+                     pipeline::ScratchArena::Footprint<ble::FramePacket>(1)));
+    pipeline::ScratchArena scratch_;
 };
 
 }  // namespace app
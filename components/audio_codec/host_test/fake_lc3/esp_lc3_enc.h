@@ -0,0 +1,101 @@
+// Fake of the esp_audio_codec LC3 encoder API, which ships as a binary for
+// the chip only. It records what Lc3Encoder asks of the codec and answers
+// as FakeLc3 tells it to, so the wrapper's logic runs on the host.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+typedef int esp_audio_err_t;
+#define ESP_AUDIO_ERR_OK 0
+#define ESP_AUDIO_ERR_FAIL -1
+#define ESP_AUDIO_ERR_MEM_LACK -2
+
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t channel;
+    uint8_t bits_per_sample;
+    uint8_t frame_dms;
+    uint16_t nbyte;
+    bool len_prefixed;
+} esp_lc3_enc_config_t;
+
+#define ESP_LC3_ENC_CONFIG_DEFAULT()                                        \
+    esp_lc3_enc_config_t {                                                  \
+        .sample_rate = 8000, .channel = 2, .bits_per_sample = 16,           \
+        .frame_dms = 100, .nbyte = 30, .len_prefixed = true,                \
+    }
+
+typedef struct {
+    uint8_t* buffer;
+    uint32_t len;
+} esp_audio_enc_in_frame_t;
+
+typedef struct {
+    uint8_t* buffer;
+    uint32_t len;
+    uint32_t encoded_bytes;
+} esp_audio_enc_out_frame_t;
+
+struct FakeLc3 {
+    // Behaviour.
+    esp_audio_err_t open_result = ESP_AUDIO_ERR_OK;
+    esp_audio_err_t process_result = ESP_AUDIO_ERR_OK;
+    // Bytes reported as encoded; negative means the configured nbyte.
+    int encoded_bytes = -1;
+
+    // Observations.
+    int opens = 0;
+    int closes = 0;
+    int frames = 0;
+    uint32_t config_size = 0;
+    esp_lc3_enc_config_t config{};
+    std::vector<int16_t> last_pcm;
+    void* closed_handle = nullptr;
+
+    static FakeLc3& Get() {
+        static FakeLc3 fake;
+        return fake;
+    }
+    static void Reset() { Get() = FakeLc3{}; }
+    void* Handle() { return this; }
+};
+
+inline esp_audio_err_t esp_lc3_enc_open(void* config, uint32_t config_size,
+                                        void** handle) {
+    FakeLc3& fake = FakeLc3::Get();
+    ++fake.opens;
+    fake.config_size = config_size;
+    std::memcpy(&fake.config, config, sizeof(fake.config));
+    if (fake.open_result != ESP_AUDIO_ERR_OK) {
+        return fake.open_result;
+    }
+    *handle = fake.Handle();
+    return ESP_AUDIO_ERR_OK;
+}
+
+inline esp_audio_err_t esp_lc3_enc_process(void* /*handle*/,
+                                           esp_audio_enc_in_frame_t* in,
+                                           esp_audio_enc_out_frame_t* out) {
+    FakeLc3& fake = FakeLc3::Get();
+    ++fake.frames;
+    const int16_t* pcm = reinterpret_cast<const int16_t*>(in->buffer);
+    fake.last_pcm.assign(pcm, pcm + in->len / sizeof(int16_t));
+    if (fake.process_result != ESP_AUDIO_ERR_OK) {
+        return fake.process_result;
+    }
+    const uint32_t bytes = fake.encoded_bytes < 0
+                               ? fake.config.nbyte
+                               : static_cast<uint32_t>(fake.encoded_bytes);
+    // A recognisable pattern: the frame number in every byte.
+    std::memset(out->buffer, fake.frames & 0xFF, bytes);
+    out->encoded_bytes = bytes;
+    return ESP_AUDIO_ERR_OK;
+}
+
+inline void esp_lc3_enc_close(void* handle) {
+    FakeLc3& fake = FakeLc3::Get();
+    ++fake.closes;
+    fake.closed_handle = handle;
+}
@@ -0,0 +1,133 @@
+#include "lc3_encoder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "esp_lc3_enc.h"
+
+namespace {
+
+using codec::Lc3Encoder;
+
+// The codec itself is a binary for the chip and is covered by the
+// on-target test in ../test; this checks what the wrapper does around it.
+class Lc3EncoderTest : public ::testing::Test {
+   protected:
+    void SetUp() override { FakeLc3::Reset(); }
+    FakeLc3& fake() { return FakeLc3::Get(); }
+};
+
+TEST_F(Lc3EncoderTest, OpensMonoCodecWithTheConfiguration) {
+    auto encoder = Lc3Encoder::Create({.sample_rate_hz = 24000,
+                                       .frame_bytes = 60});
+    ASSERT_NE(encoder, nullptr);
+
+    EXPECT_EQ(fake().opens, 1);
+    EXPECT_EQ(fake().config_size, sizeof(esp_lc3_enc_config_t));
+    EXPECT_EQ(fake().config.sample_rate, 24000u);
+    EXPECT_EQ(fake().config.channel, 1);
+    EXPECT_EQ(fake().config.bits_per_sample, 16);
+    EXPECT_EQ(fake().config.frame_dms, 100);
+    EXPECT_EQ(fake().config.nbyte, 60);
+    EXPECT_FALSE(fake().config.len_prefixed);
+
+    EXPECT_EQ(encoder->GetSampleRateHz(), 24000u);
+    EXPECT_EQ(encoder->GetFrameBytes(), 60u);
+}
+
+TEST_F(Lc3EncoderTest, FrameSamplesFollowTheSampleRate) {
+    for (const auto& [rate, samples] :
+         {std::pair{16000u, 160u}, {24000u, 240u}, {32000u, 320u}}) {
+        auto encoder = Lc3Encoder::Create({.sample_rate_hz = rate});
+        ASSERT_NE(encoder, nullptr) << rate;
+        EXPECT_EQ(encoder->GetFrameSamples(), samples) << rate;
+    }
+}
+
+TEST_F(Lc3EncoderTest, RejectsUnsupportedConfigurationsWithoutOpening) {
+    EXPECT_EQ(Lc3Encoder::Create({.sample_rate_hz = 44100}), nullptr);
+    EXPECT_EQ(Lc3Encoder::Create({.sample_rate_hz = 8000}), nullptr);
+    EXPECT_EQ(Lc3Encoder::Create({.frame_bytes = 19}), nullptr);
+    EXPECT_EQ(Lc3Encoder::Create({.frame_bytes = Lc3Encoder::kMaxFrameBytes +
+                                                 1}),
+              nullptr);
+    EXPECT_EQ(fake().opens, 0);
+
+    EXPECT_NE(Lc3Encoder::Create({.frame_bytes = 20}), nullptr);
+    EXPECT_NE(Lc3Encoder::Create({.frame_bytes = Lc3Encoder::kMaxFrameBytes}),
+              nullptr);
+}
+
+TEST_F(Lc3EncoderTest, FailedOpenReturnsNothingAndClosesNothing) {
+    fake().open_result = ESP_AUDIO_ERR_MEM_LACK;
+    EXPECT_EQ(Lc3Encoder::Create({}), nullptr);
+    EXPECT_EQ(fake().opens, 1);
+    EXPECT_EQ(fake().closes, 0);
+}
+
+TEST_F(Lc3EncoderTest, ClosesTheCodecOnce) {
+    auto encoder = Lc3Encoder::Create({});
+    ASSERT_NE(encoder, nullptr);
+    EXPECT_EQ(fake().closes, 0);
+    encoder.reset();
+    EXPECT_EQ(fake().closes, 1);
+    EXPECT_EQ(fake().closed_handle, fake().Handle());
+}
+
+TEST_F(Lc3EncoderTest, EncodesOneFrame) {
+    auto encoder = Lc3Encoder::Create({});
+    ASSERT_NE(encoder, nullptr);
+    std::vector<int16_t> pcm(encoder->GetFrameSamples());
+    std::iota(pcm.begin(), pcm.end(), -80);
+    std::array<uint8_t, Lc3Encoder::kMaxFrameBytes> out{};
+
+    ASSERT_EQ(encoder->Encode(pcm, out), ESP_OK);
+    EXPECT_EQ(fake().frames, 1);
+    EXPECT_EQ(fake().last_pcm, pcm);
+    for (size_t i = 0; i < encoder->GetFrameBytes(); ++i) {
+        EXPECT_EQ(out[i], 1) << i;
+    }
+    EXPECT_EQ(out[encoder->GetFrameBytes()], 0);
+}
+
+TEST_F(Lc3EncoderTest, RejectsWrongSizesWithoutEncoding) {
+    auto encoder = Lc3Encoder::Create({});
+    ASSERT_NE(encoder, nullptr);
+    const size_t samples = encoder->GetFrameSamples();
+    std::vector<int16_t> pcm(samples);
+    std::vector<int16_t> short_pcm(samples - 1);
+    std::vector<int16_t> long_pcm(samples + 1);
+    std::vector<uint8_t> out(encoder->GetFrameBytes());
+    std::vector<uint8_t> short_out(encoder->GetFrameBytes() - 1);
+
+    EXPECT_EQ(encoder->Encode(short_pcm, out), ESP_ERR_INVALID_SIZE);
+    EXPECT_EQ(encoder->Encode(long_pcm, out), ESP_ERR_INVALID_SIZE);
+    EXPECT_EQ(encoder->Encode(pcm, short_out), ESP_ERR_INVALID_SIZE);
+    EXPECT_EQ(fake().frames, 0);
+    EXPECT_EQ(encoder->Encode(pcm, out), ESP_OK);
+}
+
+TEST_F(Lc3EncoderTest, ReportsCodecFailures) {
+    auto encoder = Lc3Encoder::Create({});
+    ASSERT_NE(encoder, nullptr);
+    std::vector<int16_t> pcm(encoder->GetFrameSamples());
+    std::vector<uint8_t> out(encoder->GetFrameBytes());
+
+    fake().process_result = ESP_AUDIO_ERR_FAIL;
+    EXPECT_EQ(encoder->Encode(pcm, out), ESP_FAIL);
+
+    // A frame of another size than configured would break the fixed-size
+    // frame layout of kDataTypeLc3 packets.
+    fake().process_result = ESP_AUDIO_ERR_OK;
+    fake().encoded_bytes = static_cast<int>(encoder->GetFrameBytes()) - 1;
+    EXPECT_EQ(encoder->Encode(pcm, out), ESP_FAIL);
+
+    fake().encoded_bytes = -1;
+    EXPECT_EQ(encoder->Encode(pcm, out), ESP_OK);
+}
+
+}  // namespace
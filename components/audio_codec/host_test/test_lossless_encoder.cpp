@@ -0,0 +1,271 @@
+#include "lossless_encoder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using codec::LosslessEncoder;
+
+constexpr double kSampleRateHz = 16000.0;
+
+// Reads bit fields written most significant bit first.
+class BitReader {
+   public:
+    BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    uint32_t Read(uint32_t bits) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; ++i) {
+            value = (value << 1) | ReadBit();
+        }
+        return value;
+    }
+
+    uint32_t ReadUnary() {
+        uint32_t zeros = 0;
+        while (ReadBit() == 0 && !overrun_) {
+            ++zeros;
+        }
+        return zeros;
+    }
+
+    // Bytes consumed, counting a partly read byte as whole.
+    size_t BytesUsed() const { return (position_ + 7) / 8; }
+    bool overrun() const { return overrun_; }
+
+   private:
+    uint32_t ReadBit() {
+        if (position_ >= 8 * size_) {
+            overrun_ = true;
+            return 1;
+        }
+        const uint32_t bit = (data_[position_ / 8] >> (7 - position_ % 8)) & 1;
+        ++position_;
+        return bit;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_ = 0;
+    bool overrun_ = false;
+};
+
+int32_t Predict(const std::vector<int16_t>& x, size_t i, uint32_t order) {
+    switch (order) {
+        case 1:
+            return x[i - 1];
+        case 2:
+            return 2 * x[i - 1] - x[i - 2];
+        case 3:
+            return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+        case 4:
+            return 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4];
+        default:
+            return 0;
+    }
+}
+
+// Reference decoder for one block in the format documented in the header.
+// Sets `used` to the number of bytes the block occupies.
+std::vector<int16_t> DecodeBlock(const uint8_t* data, size_t size,
+                                 size_t& used) {
+    BitReader reader(data, size);
+    const size_t count = reader.Read(16);
+    const uint32_t order = reader.Read(3);
+    std::vector<int16_t> samples;
+    samples.reserve(count);
+    if (order == LosslessEncoder::kVerbatim) {
+        for (size_t i = 0; i < count; ++i) {
+            samples.push_back(static_cast<int16_t>(reader.Read(16)));
+        }
+    } else {
+        for (size_t i = 0; i < order && i < count; ++i) {
+            samples.push_back(static_cast<int16_t>(reader.Read(16)));
+        }
+        for (size_t p = 0; p * LosslessEncoder::kPartitionSamples < count;
+             ++p) {
+            const size_t begin = std::max<size_t>(
+                p * LosslessEncoder::kPartitionSamples, order);
+            const size_t end = std::min(
+                (p + 1) * LosslessEncoder::kPartitionSamples, count);
+            const uint32_t k = reader.Read(5);
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t u = (reader.ReadUnary() << k) | reader.Read(k);
+                const int32_t residual =
+                    static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+                samples.push_back(static_cast<int16_t>(
+                    Predict(samples, i, order) + residual));
+            }
+        }
+    }
+    EXPECT_FALSE(reader.overrun());
+    used = reader.BytesUsed();
+    return samples;
+}
+
+struct RoundTripResult {
+    std::vector<int16_t> decoded;
+    size_t encoded_bytes = 0;
+    double encode_ns_per_sample = 0.0;
+};
+
+// Encodes `pcm` as a stream and decodes it again.
+RoundTripResult RoundTrip(const std::vector<int16_t>& pcm) {
+    LosslessEncoder encoder;
+    std::vector<uint8_t> stream(LosslessEncoder::kStreamHeaderSize);
+    LosslessEncoder::WriteStreamHeader(
+        static_cast<uint32_t>(kSampleRateHz), pcm.size(),
+        std::span<uint8_t, LosslessEncoder::kStreamHeaderSize>(stream));
+
+    std::array<uint8_t, LosslessEncoder::kMaxEncodedBlockBytes> block;
+    std::chrono::nanoseconds encode_time{0};
+    for (size_t start = 0; start < pcm.size();
+         start += LosslessEncoder::kBlockSamples) {
+        const size_t count =
+            std::min(LosslessEncoder::kBlockSamples, pcm.size() - start);
+        const auto begin = std::chrono::steady_clock::now();
+        const size_t size = encoder.EncodeBlock(
+            std::span<const int16_t>(&pcm[start], count), block);
+        encode_time += std::chrono::steady_clock::now() - begin;
+        EXPECT_GT(size, 0u);
+        EXPECT_LE(size, LosslessEncoder::kMaxEncodedBlockBytes);
+        stream.insert(stream.end(), block.begin(), block.begin() + size);
+    }
+
+    RoundTripResult result;
+    result.encoded_bytes = stream.size();
+    result.encode_ns_per_sample =
+        static_cast<double>(encode_time.count()) /
+        std::max<size_t>(pcm.size(), 1);
+
+    EXPECT_TRUE(std::equal(stream.begin(), stream.begin() + 4, "SFLA"));
+    const uint32_t total = (stream[12] << 24) | (stream[13] << 16) |
+                           (stream[14] << 8) | stream[15];
+    EXPECT_EQ(total, pcm.size());
+    size_t offset = LosslessEncoder::kStreamHeaderSize;
+    while (offset < stream.size()) {
+        size_t used = 0;
+        const std::vector<int16_t> samples =
+            DecodeBlock(&stream[offset], stream.size() - offset, used);
+        result.decoded.insert(result.decoded.end(), samples.begin(),
+                              samples.end());
+        offset += used;
+    }
+    return result;
+}
+
+std::vector<int16_t> MakeTone(double frequency_hz, double amplitude,
+                              size_t samples) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(std::lround(
+            amplitude * std::sin(2.0 * M_PI * frequency_hz * i /
+                                 kSampleRateHz)));
+    }
+    return pcm;
+}
+
+std::vector<int16_t> MakeNoise(double amplitude, size_t samples,
+                               uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, amplitude);
+    std::vector<int16_t> pcm(samples);
+    for (int16_t& sample : pcm) {
+        sample = static_cast<int16_t>(
+            std::clamp(std::lround(noise(rng)), -32768L, 32767L));
+    }
+    return pcm;
+}
+
+// Compression ratio against 16-bit PCM, stream header included.
+double Ratio(const std::vector<int16_t>& pcm, const RoundTripResult& result) {
+    return static_cast<double>(pcm.size() * sizeof(int16_t)) /
+           result.encoded_bytes;
+}
+
+// Prints the compression ratio and encode speed of one signal and records
+// them in the test report.
+void Report(const std::string& name, const std::vector<int16_t>& pcm,
+            const RoundTripResult& result) {
+    const double ratio = Ratio(pcm, result);
+    std::printf("%-12s ratio %.2f, %.1f ns/sample\n", name.c_str(), ratio,
+                result.encode_ns_per_sample);
+    testing::Test::RecordProperty(name + "_ratio_x100",
+                                  static_cast<int>(ratio * 100));
+}
+
+TEST(LosslessEncoder, RoundTripIsBitExact) {
+    constexpr size_t kSamples = 10 * LosslessEncoder::kBlockSamples + 123;
+    struct Case {
+        const char* name;
+        std::vector<int16_t> pcm;
+    };
+    std::vector<int16_t> quiet_tone = MakeTone(440.0, 2000.0, kSamples);
+    const std::vector<int16_t> hiss = MakeNoise(30.0, kSamples, 1);
+    for (size_t i = 0; i < kSamples; ++i) {
+        quiet_tone[i] = static_cast<int16_t>(quiet_tone[i] + hiss[i]);
+    }
+    std::vector<int16_t> extremes(kSamples);
+    for (size_t i = 0; i < kSamples; ++i) {
+        // Alternating full scale gives the largest order-4 residuals.
+        extremes[i] = (i / 3) % 2 ? INT16_MAX : INT16_MIN;
+    }
+    const Case kCases[] = {
+        {"silence", std::vector<int16_t>(kSamples, 0)},
+        {"tone", MakeTone(1000.0, 20000.0, kSamples)},
+        {"quiet_tone", quiet_tone},
+        {"noise", MakeNoise(8000.0, kSamples, 2)},
+        {"extremes", extremes},
+    };
+    for (const Case& test : kCases) {
+        const RoundTripResult result = RoundTrip(test.pcm);
+        EXPECT_EQ(result.decoded, test.pcm) << test.name;
+        Report(test.name, test.pcm, result);
+    }
+}
+
+TEST(LosslessEncoder, ShortBlocksRoundTrip) {
+    const std::vector<int16_t> tone = MakeTone(700.0, 12000.0, 70);
+    for (size_t count = 1; count <= tone.size(); ++count) {
+        const std::vector<int16_t> pcm(tone.begin(), tone.begin() + count);
+        EXPECT_EQ(RoundTrip(pcm).decoded, pcm) << count << " samples";
+    }
+}
+
+TEST(LosslessEncoder, CompressesPredictableAudio) {
+    constexpr size_t kSamples = 16 * LosslessEncoder::kBlockSamples;
+    const std::vector<int16_t> tone = MakeTone(500.0, 8000.0, kSamples);
+    EXPECT_GT(Ratio(tone, RoundTrip(tone)), 2.0);
+    const std::vector<int16_t> silence(kSamples, 0);
+    EXPECT_GT(Ratio(silence, RoundTrip(silence)), 10.0);
+}
+
+TEST(LosslessEncoder, NoiseFallsBackToVerbatim) {
+    constexpr size_t kSamples = 4 * LosslessEncoder::kBlockSamples;
+    const std::vector<int16_t> noise = MakeNoise(20000.0, kSamples, 3);
+    const RoundTripResult result = RoundTrip(noise);
+    EXPECT_EQ(result.decoded, noise);
+    EXPECT_LE(result.encoded_bytes,
+              LosslessEncoder::kStreamHeaderSize +
+                  4 * LosslessEncoder::kMaxEncodedBlockBytes);
+}
+
+TEST(LosslessEncoder, RejectsInvalidBlocks) {
+    LosslessEncoder encoder;
+    std::array<uint8_t, LosslessEncoder::kMaxEncodedBlockBytes> out;
+    const std::vector<int16_t> too_long(LosslessEncoder::kBlockSamples + 1);
+    EXPECT_EQ(encoder.EncodeBlock(too_long, out), 0u);
+    EXPECT_EQ(encoder.EncodeBlock(std::span<const int16_t>(), out), 0u);
+}
+
+}  // namespace
@@ -0,0 +1,85 @@
+#include "lc3_encoder.hpp"
+
+#include "esp_lc3_enc.h"
+#include "esp_log.h"
+
+namespace {
+static const char* kTag = "Lc3Encoder";
+}  // namespace
+
+namespace codec {
+
+std::unique_ptr<Lc3Encoder> Lc3Encoder::Create(const Config& config) {
+    if (config.sample_rate_hz != 16000 && config.sample_rate_hz != 24000 &&
+        config.sample_rate_hz != 32000) {
+        ESP_LOGE(kTag, "Unsupported sample rate %lu Hz.",
+                 static_cast<unsigned long>(config.sample_rate_hz));
+        return nullptr;
+    }
+    if (config.frame_bytes < 20 || config.frame_bytes > kMaxFrameBytes) {
+        ESP_LOGE(kTag, "Unsupported frame size %u bytes.",
+                 static_cast<unsigned>(config.frame_bytes));
+        return nullptr;
+    }
+
+    // Use `new` because constructor is private.
+    std::unique_ptr<Lc3Encoder> encoder(new Lc3Encoder(config));
+
+    esp_lc3_enc_config_t lc3_config = ESP_LC3_ENC_CONFIG_DEFAULT();
+    lc3_config.sample_rate = config.sample_rate_hz;
+    lc3_config.channel = 1;
+    lc3_config.bits_per_sample = 16;
+    lc3_config.frame_dms = kFrameDurationUs / 100;
+    lc3_config.nbyte = config.frame_bytes;
+    lc3_config.len_prefixed = false;
+
+    esp_audio_err_t err = esp_lc3_enc_open(&lc3_config, sizeof(lc3_config),
+                                           &encoder->handle_);
+    if (err != ESP_AUDIO_ERR_OK) {
+        ESP_LOGE(kTag, "Failed to open LC3 encoder (%d).", err);
+        return nullptr;
+    }
+
+    ESP_LOGI(kTag, "LC3 encoder opened: %lu Hz, %u bytes per 10 ms frame.",
+             static_cast<unsigned long>(config.sample_rate_hz),
+             static_cast<unsigned>(config.frame_bytes));
+    return encoder;
+}
+
+Lc3Encoder::Lc3Encoder(const Config& config)
+    : config_(config),
+      frame_samples_(static_cast<size_t>(config.sample_rate_hz) *
+                     kFrameDurationUs / 1000000) {}
+
+Lc3Encoder::~Lc3Encoder() {
+    if (handle_ != nullptr) {
+        esp_lc3_enc_close(handle_);
+    }
+}
+
+esp_err_t Lc3Encoder::Encode(std::span<const int16_t> pcm,
+                             std::span<uint8_t> out) {
+    if (pcm.size() != frame_samples_ || out.size() < config_.frame_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_audio_enc_in_frame_t in_frame = {
+        // The codec API is not const-correct; the input is only read.
+        .buffer = reinterpret_cast<uint8_t*>(const_cast<int16_t*>(pcm.data())),
+        .len = static_cast<uint32_t>(pcm.size_bytes()),
+    };
+    esp_audio_enc_out_frame_t out_frame = {
+        .buffer = out.data(),
+        .len = static_cast<uint32_t>(out.size()),
+        .encoded_bytes = 0,
+    };
+    esp_audio_err_t err = esp_lc3_enc_process(handle_, &in_frame, &out_frame);
+    if (err != ESP_AUDIO_ERR_OK ||
+        out_frame.encoded_bytes != config_.frame_bytes) {
+        ESP_LOGE(kTag, "LC3 encode failed (%d).", err);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+}  // namespace codec
@@ -0,0 +1,77 @@
+#ifndef AUDIO_CODEC_LC3_ENCODER_HPP_
+#define AUDIO_CODEC_LC3_ENCODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "esp_err.h"
+
+namespace codec {
+
+/**
+ * @class Lc3Encoder
+ * @brief Mono LC3 encoder with 10 ms frames and a fixed bitrate.
+ *
+ * Wraps the esp_audio_codec LC3 encoder. The codec state is allocated once
+ * when the encoder is created; encoding a frame allocates nothing.
+ */
+class Lc3Encoder {
+   public:
+    static constexpr uint32_t kFrameDurationUs = 10000;
+    // Largest encoded frame this wrapper accepts (LC3 allows 20-400 bytes).
+    static constexpr size_t kMaxFrameBytes = 120;
+
+    struct Config {
+        uint32_t sample_rate_hz = 16000;  // 16, 24 or 32 kHz
+        size_t frame_bytes = 40;          // 32 kbit/s at 10 ms frames
+    };
+
+    /**
+     * @brief Creates and opens an LC3 encoder.
+     * @param config Encoder configuration.
+     * @return The encoder on success, or nullptr if the configuration is
+     * not supported or the codec could not be opened.
+     */
+    static std::unique_ptr<Lc3Encoder> Create(const Config& config);
+
+    ~Lc3Encoder();
+
+    Lc3Encoder(const Lc3Encoder&) = delete;
+    Lc3Encoder& operator=(const Lc3Encoder&) = delete;
+
+    /**
+     * @brief Returns the number of PCM samples in one frame.
+     */
+    size_t GetFrameSamples() const { return frame_samples_; }
+
+    /**
+     * @brief Returns the size of one encoded frame in bytes.
+     */
+    size_t GetFrameBytes() const { return config_.frame_bytes; }
+
+    /**
+     * @brief Returns the configured sample rate.
+     */
+    uint32_t GetSampleRateHz() const { return config_.sample_rate_hz; }
+
+    /**
+     * @brief Encodes one frame.
+     * @param pcm Exactly GetFrameSamples() samples.
+     * @param[out] out Receives GetFrameBytes() bytes.
+     * @return esp_err_t ESP_OK on success.
+     */
+    esp_err_t Encode(std::span<const int16_t> pcm, std::span<uint8_t> out);
+
+   private:
+    explicit Lc3Encoder(const Config& config);
+
+    Config config_;
+    size_t frame_samples_;
+    void* handle_ = nullptr;
+};
+
+}  // namespace codec
+
+#endif  // AUDIO_CODEC_LC3_ENCODER_HPP_
@@ -0,0 +1,191 @@
+#include "lossless_encoder.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+constexpr uint8_t kMaxOrder = 4;
+constexpr uint8_t kFormatVersion = 1;
+constexpr uint32_t kMaxRiceParameter = 20;  // Residuals are below 2^20
+
+// Appends bit fields to a byte buffer, most significant bit first.
+class BitWriter {
+   public:
+    explicit BitWriter(uint8_t* out) : out_(out) {}
+
+    void Write(uint32_t value, uint32_t bits) {
+        accumulator_ = (accumulator_ << bits) | value;
+        pending_ += bits;
+        while (pending_ >= 8) {
+            pending_ -= 8;
+            *out_++ = static_cast<uint8_t>(accumulator_ >> pending_);
+        }
+    }
+
+    void WriteUnary(uint32_t zeros) {
+        for (; zeros >= 24; zeros -= 24) {
+            Write(0, 24);
+        }
+        Write(1, zeros + 1);
+    }
+
+    // Pads the last byte with zeros and returns the end of the output.
+    uint8_t* Flush() {
+        if (pending_ > 0) {
+            Write(0, 8 - pending_);
+        }
+        return out_;
+    }
+
+   private:
+    uint8_t* out_;
+    uint64_t accumulator_ = 0;
+    uint32_t pending_ = 0;
+};
+
+int32_t Predict(std::span<const int16_t> x, size_t i, uint8_t order) {
+    switch (order) {
+        case 1:
+            return x[i - 1];
+        case 2:
+            return 2 * x[i - 1] - x[i - 2];
+        case 3:
+            return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+        case 4:
+            return 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4];
+        default:
+            return 0;
+    }
+}
+
+uint32_t ZigZag(int32_t residual) {
+    return (static_cast<uint32_t>(residual) << 1) ^
+           static_cast<uint32_t>(residual >> 31);
+}
+
+void PutBe16(uint8_t* out, uint16_t value) {
+    out[0] = value >> 8;
+    out[1] = value & 0xFF;
+}
+
+void PutBe32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (value >> (24 - 8 * i)) & 0xFF;
+    }
+}
+}  // namespace
+
+namespace codec {
+
+void LosslessEncoder::WriteStreamHeader(
+    uint32_t sample_rate_hz, uint32_t total_samples,
+    std::span<uint8_t, kStreamHeaderSize> out) {
+    memcpy(&out[0], "SFLA", 4);
+    out[4] = kFormatVersion;
+    out[5] = 0;
+    PutBe16(&out[6], kBlockSamples);
+    PutBe32(&out[8], sample_rate_hz);
+    PutBe32(&out[12], total_samples);
+}
+
+uint8_t LosslessEncoder::SelectOrder(std::span<const int16_t> samples) {
+    if (samples.size() <= kMaxOrder) {
+        return 0;
+    }
+
+    // Successive differences of the signal are exactly the residuals of
+    // the fixed predictors of increasing order.
+    std::array<uint64_t, kMaxOrder + 1> error{};
+    int32_t last0 = samples[3];
+    int32_t last1 = samples[3] - samples[2];
+    int32_t last2 = last1 - (samples[2] - samples[1]);
+    int32_t last3 = last2 - (samples[2] - 2 * samples[1] + samples[0]);
+    for (size_t i = kMaxOrder; i < samples.size(); ++i) {
+        const int32_t e0 = samples[i];
+        const int32_t e1 = e0 - last0;
+        const int32_t e2 = e1 - last1;
+        const int32_t e3 = e2 - last2;
+        const int32_t e4 = e3 - last3;
+        error[0] += std::abs(e0);
+        error[1] += std::abs(e1);
+        error[2] += std::abs(e2);
+        error[3] += std::abs(e3);
+        error[4] += std::abs(e4);
+        last0 = e0;
+        last1 = e1;
+        last2 = e2;
+        last3 = e3;
+    }
+    return static_cast<uint8_t>(
+        std::min_element(error.begin(), error.end()) - error.begin());
+}
+
+size_t LosslessEncoder::EncodeBlock(
+    std::span<const int16_t> samples,
+    std::span<uint8_t, kMaxEncodedBlockBytes> out) {
+    const size_t count = samples.size();
+    if (count == 0 || count > kBlockSamples) {
+        return 0;
+    }
+
+    const uint8_t order = SelectOrder(samples);
+    for (size_t i = order; i < count; ++i) {
+        residuals_[i] = ZigZag(samples[i] - Predict(samples, i, order));
+    }
+
+    // Choose the Rice parameter of every partition and total up the size.
+    constexpr size_t kMaxPartitions = kBlockSamples / kPartitionSamples;
+    std::array<uint8_t, kMaxPartitions> parameters;
+    size_t coded_bits = 16 + 3 + 16 * order;
+    for (size_t p = 0; p * kPartitionSamples < count; ++p) {
+        const size_t begin = std::max<size_t>(p * kPartitionSamples, order);
+        const size_t end = std::min((p + 1) * kPartitionSamples, count);
+        const size_t n = end > begin ? end - begin : 0;
+
+        uint64_t sum = 0;
+        for (size_t i = begin; i < end; ++i) {
+            sum += residuals_[i];
+        }
+        // The optimal parameter is close to log2 of the mean residual.
+        uint32_t k = 0;
+        while (k < kMaxRiceParameter && (static_cast<uint64_t>(n) << k) < sum) {
+            ++k;
+        }
+        parameters[p] = static_cast<uint8_t>(k);
+
+        coded_bits += 5 + n * (k + 1);
+        for (size_t i = begin; i < end; ++i) {
+            coded_bits += residuals_[i] >> k;
+        }
+    }
+
+    BitWriter writer(out.data());
+    writer.Write(static_cast<uint32_t>(count), 16);
+    if (coded_bits >= 16 + 3 + 16 * count) {
+        // Noise-like audio: raw samples are smaller.
+        writer.Write(kVerbatim, 3);
+        for (int16_t sample : samples) {
+            writer.Write(static_cast<uint16_t>(sample), 16);
+        }
+        return writer.Flush() - out.data();
+    }
+
+    writer.Write(order, 3);
+    for (size_t i = 0; i < order; ++i) {
+        writer.Write(static_cast<uint16_t>(samples[i]), 16);
+    }
+    for (size_t p = 0; p * kPartitionSamples < count; ++p) {
+        const size_t begin = std::max<size_t>(p * kPartitionSamples, order);
+        const size_t end = std::min((p + 1) * kPartitionSamples, count);
+        const uint32_t k = parameters[p];
+        writer.Write(k, 5);
+        for (size_t i = begin; i < end; ++i) {
+            writer.WriteUnary(residuals_[i] >> k);
+            writer.Write(residuals_[i] & ((1u << k) - 1), k);
+        }
+    }
+    return writer.Flush() - out.data();
+}
+
+}  // namespace codec
@@ -0,0 +1,79 @@
+#ifndef AUDIO_CODEC_LOSSLESS_ENCODER_HPP_
+#define AUDIO_CODEC_LOSSLESS_ENCODER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace codec {
+
+/**
+ * @class LosslessEncoder
+ * @brief FLAC-style lossless encoder for 16-bit mono PCM.
+ *
+ * Audio is coded in independent blocks of up to kBlockSamples samples. Each
+ * block picks the fixed polynomial predictor (order 0-4) with the smallest
+ * residual and Rice-codes the residual with a parameter chosen per
+ * partition of kPartitionSamples samples. Blocks that would not compress
+ * are stored verbatim, which bounds the encoded size.
+ *
+ * Stream layout (multi-byte fields big-endian):
+ * - Stream header (kStreamHeaderSize bytes): "SFLA", version, reserved,
+ *   block size (uint16), sample rate (uint32), total samples (uint32).
+ * - Blocks, each starting on a byte boundary, as a bitstream written most
+ *   significant bit first:
+ *   - 16 bits: number of samples N
+ *   - 3 bits: predictor order, or kVerbatim
+ *   - Verbatim: N samples of 16 bits.
+ *   - Otherwise: `order` warm-up samples of 16 bits, then for each
+ *     partition a 5-bit Rice parameter k followed by its residuals. A
+ *     residual r is zigzag-mapped to u = 2r (r >= 0) or -2r - 1 (r < 0) and
+ *     written as u >> k zero bits, a one bit, and the low k bits of u.
+ *
+ * The encoder only needs one block of working memory, so clips of any
+ * length can be encoded as they are written.
+ */
+class LosslessEncoder {
+   public:
+    static constexpr size_t kBlockSamples = 1024;
+    static constexpr size_t kPartitionSamples = 64;
+    static constexpr size_t kStreamHeaderSize = 16;
+    static constexpr uint8_t kVerbatim = 7;
+    // A verbatim block: sample count, method and raw samples.
+    static constexpr size_t kMaxEncodedBlockBytes =
+        (16 + 3 + 16 * kBlockSamples + 7) / 8;
+
+    /**
+     * @brief Writes the stream header.
+     * @param sample_rate_hz Sample rate of the audio.
+     * @param total_samples Number of samples in the whole stream.
+     * @param[out] out Receives the header.
+     */
+    static void WriteStreamHeader(
+        uint32_t sample_rate_hz, uint32_t total_samples,
+        std::span<uint8_t, kStreamHeaderSize> out);
+
+    /**
+     * @brief Encodes one block.
+     * @param samples Between 1 and kBlockSamples PCM samples.
+     * @param[out] out Receives the encoded block.
+     * @return The number of bytes written, or 0 if `samples` is empty or
+     * too long.
+     */
+    size_t EncodeBlock(std::span<const int16_t> samples,
+                       std::span<uint8_t, kMaxEncodedBlockBytes> out);
+
+   private:
+    /**
+     * @brief Picks the predictor order with the smallest residual.
+     */
+    static uint8_t SelectOrder(std::span<const int16_t> samples);
+
+    // Zigzag-mapped residuals of the current block.
+    std::array<uint32_t, kBlockSamples> residuals_;
+};
+
+}  // namespace codec
+
+#endif  // AUDIO_CODEC_LOSSLESS_ENCODER_HPP_
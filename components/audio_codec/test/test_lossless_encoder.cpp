@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "unity.h"
+
+#include "lossless_encoder.hpp"
+
+namespace {
+static const char* kTag = "test_lossless";
+
+constexpr uint32_t kSampleRateHz = 16000;
+constexpr size_t kBlocks = 16;
+}  // namespace
+
+// Bit-exactness is covered by the host test in ../host_test; this measures
+// what the encoder costs on the target.
+TEST_CASE("Lossless encode cycles per sample", "[lossless][benchmark]") {
+    constexpr size_t kSamples = kBlocks * codec::LosslessEncoder::kBlockSamples;
+    std::vector<int16_t> pcm(kSamples);
+    uint32_t noise = 1;
+    for (size_t i = 0; i < kSamples; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        pcm[i] = static_cast<int16_t>(
+            std::lround(8000.0 * std::sin(2.0 * M_PI * 440.0 * i /
+                                          kSampleRateHz)) +
+            static_cast<int16_t>(noise >> 16) / 512);
+    }
+
+    codec::LosslessEncoder encoder;
+    std::array<uint8_t, codec::LosslessEncoder::kMaxEncodedBlockBytes> out;
+    size_t encoded_bytes = 0;
+    uint32_t worst = 0;
+    uint64_t total = 0;
+    for (size_t block = 0; block < kBlocks; ++block) {
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+        const size_t size = encoder.EncodeBlock(
+            std::span<const int16_t>(
+                &pcm[block * codec::LosslessEncoder::kBlockSamples],
+                codec::LosslessEncoder::kBlockSamples),
+            out);
+        const uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+        TEST_ASSERT_GREATER_THAN(0, size);
+        encoded_bytes += size;
+        total += cycles;
+        worst = std::max(worst, cycles);
+    }
+
+    const double ratio =
+        static_cast<double>(kSamples * sizeof(int16_t)) / encoded_bytes;
+    const double cycles_per_sample = static_cast<double>(total) / kSamples;
+    ESP_LOGI(kTag, "Ratio %.2f, %.1f cycles/sample avg, %lu max per block.",
+             ratio, cycles_per_sample, static_cast<unsigned long>(worst));
+    // Clips are encoded at 16 kHz while streaming continues; a tenth of a
+    // core leaves the capture and analysis stages their headroom.
+    TEST_ASSERT_LESS_THAN(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000 / 10,
+                          static_cast<uint32_t>(cycles_per_sample *
+                                                kSampleRateHz));
+    // A tone in low-level noise still has to compress.
+    TEST_ASSERT_TRUE(ratio > 1.2);
+}
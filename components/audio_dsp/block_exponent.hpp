@@ -0,0 +1,37 @@
+#ifndef AUDIO_DSP_BLOCK_EXPONENT_HPP_
+#define AUDIO_DSP_BLOCK_EXPONENT_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @brief Moves buffered samples from one block exponent to another.
+ *
+ * A sample times 2^exponent is at the nominal scale, so raising the
+ * exponent by `bits` halves the samples `bits` times, rounding to nearest,
+ * and lowering it doubles them, saturating at 16 bits.
+ *
+ * @param samples Samples to rescale in place.
+ * @param bits New exponent minus old exponent.
+ */
+inline void RescaleSamples(std::span<int16_t> samples, int bits) {
+    if (bits > 0) {
+        const int32_t half = 1 << (bits - 1);
+        for (int16_t& sample : samples) {
+            sample = static_cast<int16_t>((sample + half) >> bits);
+        }
+    } else if (bits < 0) {
+        for (int16_t& sample : samples) {
+            sample = static_cast<int16_t>(std::clamp<int32_t>(
+                static_cast<int32_t>(sample) * (1 << -bits), INT16_MIN,
+                INT16_MAX));
+        }
+    }
+}
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_BLOCK_EXPONENT_HPP_
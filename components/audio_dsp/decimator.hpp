@@ -0,0 +1,118 @@
+#ifndef AUDIO_DSP_DECIMATOR_HPP_
+#define AUDIO_DSP_DECIMATOR_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "block_exponent.hpp"
+
+namespace dsp {
+
+/**
+ * @class Decimator
+ * @brief Integer-factor FIR decimator for the analysis stream.
+ *
+ * A Blackman-windowed sinc low-pass with Q15 coefficients removes content
+ * above the new Nyquist frequency. Only every `Factor`-th output is
+ * computed. The filter history is kept across calls, so input frames of any
+ * length produce a continuous output stream.
+ *
+ * @tparam Factor Decimation factor.
+ * @tparam Taps Number of FIR taps.
+ */
+template <size_t Factor, size_t Taps>
+class Decimator {
+    static_assert(Factor >= 2, "Factor must be at least 2");
+
+   public:
+    Decimator() {
+        // Cut off slightly below the output Nyquist frequency to leave room
+        // for the transition band.
+        constexpr float kPi = 3.14159265358979f;
+        const float cutoff = 0.45f / Factor;  // In cycles per input sample
+        const float center = (Taps - 1) / 2.0f;
+        std::array<float, Taps> taps;
+        float sum = 0.0f;
+        for (size_t i = 0; i < Taps; ++i) {
+            const float t = i - center;
+            const float sinc =
+                t == 0.0f ? 2.0f * cutoff
+                          : std::sin(2.0f * kPi * cutoff * t) / (kPi * t);
+            const float phase = 2.0f * kPi * i / (Taps - 1);
+            const float window =
+                0.42f - 0.5f * std::cos(phase) + 0.08f * std::cos(2.0f * phase);
+            taps[i] = sinc * window;
+            sum += taps[i];
+        }
+        // Normalise for unity DC gain.
+        for (size_t i = 0; i < Taps; ++i) {
+            coefficients_[i] =
+                static_cast<int16_t>(std::lround(taps[i] / sum * 32767.0f));
+        }
+    }
+
+    /**
+     * @brief Filters and decimates a block of samples.
+     * @param input Samples at the input rate.
+     * @param[out] output Receives the decimated samples. Must hold at least
+     * input.size() / Factor + 1 samples.
+     * @return The number of samples written to `output`.
+     */
+    size_t Process(std::span<const int16_t> input, std::span<int16_t> output) {
+        size_t produced = 0;
+        for (const int16_t sample : input) {
+            // The history is stored twice so the newest Taps samples are
+            // always contiguous, without a modulo in the inner loop.
+            history_[head_] = sample;
+            history_[head_ + Taps] = sample;
+            head_ = (head_ + 1) % Taps;
+
+            if (++phase_ < Factor) {
+                continue;
+            }
+            phase_ = 0;
+            if (produced >= output.size()) {
+                continue;
+            }
+
+            const int16_t* window = &history_[head_];
+            int32_t accumulator = 0;
+            for (size_t i = 0; i < Taps; ++i) {
+                accumulator +=
+                    static_cast<int32_t>(coefficients_[i]) * window[i];
+            }
+            output[produced++] = static_cast<int16_t>(
+                std::clamp<int32_t>(accumulator >> 15, INT16_MIN, INT16_MAX));
+        }
+        return produced;
+    }
+
+    /**
+     * @brief Moves the filter history to a new block exponent.
+     * @param bits New exponent minus old exponent, see RescaleSamples().
+     */
+    void Rescale(int bits) { RescaleSamples(history_, bits); }
+
+    /**
+     * @brief Clears the filter history.
+     */
+    void Reset() {
+        history_.fill(0);
+        head_ = 0;
+        phase_ = 0;
+    }
+
+   private:
+    std::array<int16_t, Taps> coefficients_{};
+    std::array<int16_t, 2 * Taps> history_{};
+    size_t head_ = 0;
+    size_t phase_ = 0;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_DECIMATOR_HPP_
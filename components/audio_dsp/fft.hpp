@@ -0,0 +1,109 @@
+#ifndef AUDIO_DSP_FFT_HPP_
+#define AUDIO_DSP_FFT_HPP_
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @class Fft
+ * @brief In-place radix-2 complex FFT of a fixed power-of-two size.
+ *
+ * Twiddle factors and the bit-reversal permutation are computed once at
+ * construction and stored inline, so an instance needs no heap memory and
+ * can live in a pre-allocated pipeline stage.
+ *
+ * @tparam N Transform size, a power of two.
+ */
+template <size_t N>
+class Fft {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+   public:
+    using Complex = std::complex<float>;
+
+    Fft() {
+        for (size_t k = 0; k < N / 2; ++k) {
+            const float angle = -2.0f * kPi * k / N;
+            twiddles_[k] = Complex(std::cos(angle), std::sin(angle));
+        }
+        size_t bits = 0;
+        while ((size_t{1} << bits) < N) {
+            ++bits;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; ++b) {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bit_reverse_[i] = static_cast<uint16_t>(reversed);
+        }
+    }
+
+    /**
+     * @brief Computes the forward transform in place.
+     * @param data N complex samples, replaced by their spectrum.
+     */
+    void Forward(std::span<Complex, N> data) const {
+        for (size_t i = 0; i < N; ++i) {
+            const size_t j = bit_reverse_[i];
+            if (i < j) {
+                std::swap(data[i], data[j]);
+            }
+        }
+        for (size_t length = 2; length <= N; length <<= 1) {
+            const size_t half = length / 2;
+            const size_t stride = N / length;
+            for (size_t start = 0; start < N; start += length) {
+                for (size_t k = 0; k < half; ++k) {
+                    const Complex t =
+                        Multiply(twiddles_[k * stride], data[start + k + half]);
+                    data[start + k + half] = data[start + k] - t;
+                    data[start + k] += t;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Computes the unscaled inverse transform in place.
+     *
+     * The result is N times the true inverse; callers fold the 1/N scale
+     * into their own normalisation.
+     *
+     * @param data N spectrum bins, replaced by the time-domain samples.
+     */
+    void Inverse(std::span<Complex, N> data) const {
+        for (Complex& value : data) {
+            value = std::conj(value);
+        }
+        Forward(data);
+        for (Complex& value : data) {
+            value = std::conj(value);
+        }
+    }
+
+    /**
+     * @brief Complex product without the NaN/Inf recovery that
+     * std::complex's operator* performs, which is costly on the target.
+     */
+    static Complex Multiply(const Complex& a, const Complex& b) {
+        return Complex(a.real() * b.real() - a.imag() * b.imag(),
+                       a.real() * b.imag() + a.imag() * b.real());
+    }
+
+   private:
+    static constexpr float kPi = 3.14159265358979f;
+
+    std::array<Complex, N / 2> twiddles_;
+    std::array<uint16_t, N> bit_reverse_;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_FFT_HPP_
@@ -0,0 +1,161 @@
+#include "goertzel_bank.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace dsp {
+
+namespace {
+constexpr float kPi = 3.14159265358979f;
+}  // namespace
+
+GoertzelBank::GoertzelBank(const Config& config) : config_(config) {}
+
+size_t GoertzelBank::AddTone(const ToneConfig& tone) {
+    const float nyquist = config_.sample_rate_hz / 2.0f;
+    if (tone_count_ >= kMaxTones || tone.frequency_hz < kMinFrequencyHz ||
+        tone.frequency_hz >= nyquist || tone.bandwidth_hz <= 0.0f) {
+        return kMaxTones;
+    }
+
+    const float omega = 2.0f * kPi * tone.frequency_hz / config_.sample_rate_hz;
+    const size_t block = std::min(
+        MaxBlockSamples(omega),
+        static_cast<size_t>(config_.sample_rate_hz / tone.bandwidth_hz));
+    if (block == 0) {
+        return kMaxTones;
+    }
+
+    const size_t index = tone_count_++;
+    coefficients_[index] = static_cast<int32_t>(
+        std::lround(2.0f * std::cos(omega) * (1 << kCoefficientFractionBits)));
+    block_samples_[index] = static_cast<uint32_t>(block);
+    thresholds_[index] = tone.threshold;
+    hold_samples_[index] = static_cast<uint32_t>(
+        static_cast<uint64_t>(tone.hold_ms) * config_.sample_rate_hz / 1000);
+    release_samples_[index] = static_cast<uint32_t>(
+        static_cast<uint64_t>(tone.release_ms) * config_.sample_rate_hz / 1000);
+
+    s1_[index] = 0;
+    s2_[index] = 0;
+    block_fill_[index] = 0;
+    block_start_energy_[index] = energy_;
+    state_samples_[index] = 0;
+    present_[index] = false;
+    last_ratio_[index] = 0.0f;
+    return index;
+}
+
+size_t GoertzelBank::MaxBlockSamples(float omega) {
+    // The resonator's impulse response is sin((n + 1) omega) / sin(omega),
+    // so after n samples of bounded input its state is bounded by the input
+    // bound times the sum of |h|. The feedback term is up to twice the
+    // state, so the state keeps to under half the int32 range.
+    constexpr float kInputBound = static_cast<float>(INT16_MAX >> kInputShift);
+    const float limit =
+        0.45f * static_cast<float>(INT32_MAX) / kInputBound * std::sin(omega);
+    float gain = 0.0f;
+    size_t samples = 0;
+    while (samples < kMaxBlockSamples) {
+        gain += std::fabs(std::sin((samples + 1) * omega));
+        if (gain > limit) {
+            break;
+        }
+        ++samples;
+    }
+    return samples;
+}
+
+void GoertzelBank::Reset() {
+    energy_ = 0;
+    for (size_t t = 0; t < tone_count_; ++t) {
+        s1_[t] = 0;
+        s2_[t] = 0;
+        block_fill_[t] = 0;
+        block_start_energy_[t] = 0;
+        state_samples_[t] = 0;
+        present_[t] = false;
+        last_ratio_[t] = 0.0f;
+    }
+}
+
+size_t GoertzelBank::Process(std::span<const int16_t> frame,
+                             std::span<ToneEvent> events) {
+    size_t event_count = 0;
+
+    for (size_t i = 0; i < frame.size(); ++i) {
+        const int32_t x = frame[i] >> kInputShift;
+        energy_ += x * x;
+
+        for (size_t t = 0; t < tone_count_; ++t) {
+            const int32_t s0 =
+                x +
+                static_cast<int32_t>((static_cast<int64_t>(coefficients_[t]) *
+                                      s1_[t]) >>
+                                     kCoefficientFractionBits) -
+                s2_[t];
+            s2_[t] = s1_[t];
+            s1_[t] = s0;
+
+            if (++block_fill_[t] < block_samples_[t]) {
+                continue;
+            }
+            if (FinishBlock(t) && event_count < events.size()) {
+                events[event_count++] = ToneEvent{
+                    .tone_index = t,
+                    .present = present_[t],
+                    .ratio = last_ratio_[t],
+                    .sample_offset = i,
+                };
+            }
+        }
+    }
+    return event_count;
+}
+
+bool GoertzelBank::FinishBlock(size_t tone) {
+    const float s1 = static_cast<float>(s1_[tone]);
+    const float s2 = static_cast<float>(s2_[tone]);
+    const float coefficient = static_cast<float>(coefficients_[tone]) /
+                              (1 << kCoefficientFractionBits);
+    const float bin_power = s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+
+    const uint32_t block = block_samples_[tone];
+    const float block_energy =
+        static_cast<float>(energy_ - block_start_energy_[tone]);
+
+    // Level gate on the block RMS, referred back to unscaled input.
+    const float mean_square =
+        block_energy * (1 << (2 * kInputShift)) / static_cast<float>(block);
+    const float level_db = 10.0f * std::log10(mean_square + 1.0f);
+
+    float ratio = 0.0f;
+    if (level_db >= config_.min_level_db && block_energy > 0.0f) {
+        ratio = bin_power / (0.5f * block * block_energy);
+    }
+    last_ratio_[tone] = ratio;
+
+    s1_[tone] = 0;
+    s2_[tone] = 0;
+    block_fill_[tone] = 0;
+    block_start_energy_[tone] = energy_;
+
+    // Presence with hold and release hysteresis.
+    const bool above = ratio >= thresholds_[tone];
+    if (above == present_[tone]) {
+        state_samples_[tone] = 0;
+        return false;
+    }
+    state_samples_[tone] += block;
+    const uint32_t required =
+        present_[tone] ? release_samples_[tone] : hold_samples_[tone];
+    if (state_samples_[tone] < required) {
+        return false;
+    }
+    present_[tone] = above;
+    state_samples_[tone] = 0;
+    return true;
+}
+
+}  // namespace dsp
@@ -0,0 +1,128 @@
+#ifndef AUDIO_DSP_GOERTZEL_BANK_HPP_
+#define AUDIO_DSP_GOERTZEL_BANK_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @class GoertzelBank
+ * @brief A bank of fixed-point Goertzel detectors for targeted tones.
+ *
+ * Each tone is tracked by a second-order resonator with a Q14 coefficient.
+ * All resonators are advanced together in a single pass over the frame, so
+ * the cost is a multiply-add per tone per sample. Each tone has its own
+ * block length, derived from the requested bandwidth, and carries its state
+ * across frames.
+ *
+ * At the end of a tone's block the bin power is normalised by the block
+ * energy, giving the share of the signal that lies in the tone's bin (1.0
+ * for a pure tone). A tone is reported present once that ratio has stayed
+ * above its threshold for the hold time, and absent once it has stayed below
+ * for the release time.
+ */
+class GoertzelBank {
+   public:
+    static constexpr size_t kMaxTones = 8;
+    // Resonators for lower tones need more headroom than int32 offers.
+    // Above it, blocks are also cut short where a full-scale input could
+    // overflow the resonator, which widens the bandwidth of low tones.
+    static constexpr float kMinFrequencyHz = 40.0f;
+    static constexpr size_t kMaxBlockSamples = 8192;
+
+    struct Config {
+        uint32_t sample_rate_hz = 44100;
+        float min_level_db = 30.0f;  // Quieter blocks never count as a tone
+    };
+
+    struct ToneConfig {
+        float frequency_hz;
+        float bandwidth_hz;  // Sets the block length: sample rate / bandwidth
+        float threshold;     // Minimum bin power ratio, 0.0 to 1.0
+        uint32_t hold_ms;     // Time above threshold before reporting
+        uint32_t release_ms;  // Time below threshold before clearing
+    };
+
+    /**
+     * @brief A change in the presence of a tone.
+     */
+    struct ToneEvent {
+        size_t tone_index;
+        bool present;
+        float ratio;           // Bin power ratio of the deciding block
+        size_t sample_offset;  // Offset of the deciding block's last sample
+    };
+
+    explicit GoertzelBank(const Config& config);
+
+    /**
+     * @brief Adds a tone detector to the bank.
+     * @param tone The tone to detect.
+     * @return The index of the tone, or kMaxTones if the bank is full or the
+     * configuration is out of range.
+     */
+    size_t AddTone(const ToneConfig& tone);
+
+    /**
+     * @brief Runs all detectors over a frame of PCM samples.
+     * @param frame PCM samples, in capture order.
+     * @param[out] events Receives the presence changes decided in this frame.
+     * @return The number of events written to `events`.
+     */
+    size_t Process(std::span<const int16_t> frame,
+                   std::span<ToneEvent> events);
+
+    /**
+     * @brief Returns whether a tone is currently reported present.
+     */
+    bool IsPresent(size_t tone_index) const {
+        return tone_index < tone_count_ && present_[tone_index];
+    }
+
+    /**
+     * @brief Clears all resonator and hold state. Tones stay configured.
+     */
+    void Reset();
+
+   private:
+    // Input is scaled down before entering the resonators for headroom.
+    static constexpr int kInputShift = 2;
+    static constexpr int kCoefficientFractionBits = 14;
+
+    /**
+     * @brief Returns the longest block over which no input can overflow the
+     * resonator of a tone.
+     * @param omega Tone frequency in radians per sample.
+     */
+    static size_t MaxBlockSamples(float omega);
+
+    bool FinishBlock(size_t tone);
+
+    Config config_;
+    size_t tone_count_ = 0;
+
+    // Structure-of-arrays layout keeps the inner tone loop contiguous.
+    std::array<int32_t, kMaxTones> coefficients_{};
+    std::array<int32_t, kMaxTones> s1_{};
+    std::array<int32_t, kMaxTones> s2_{};
+    std::array<uint32_t, kMaxTones> block_samples_{};
+    std::array<uint32_t, kMaxTones> block_fill_{};
+    std::array<int64_t, kMaxTones> block_start_energy_{};
+
+    std::array<float, kMaxTones> thresholds_{};
+    std::array<uint32_t, kMaxTones> hold_samples_{};
+    std::array<uint32_t, kMaxTones> release_samples_{};
+    std::array<uint32_t, kMaxTones> state_samples_{};
+    std::array<bool, kMaxTones> present_{};
+    std::array<float, kMaxTones> last_ratio_{};
+
+    // Running energy of the scaled input, shared by all tones.
+    int64_t energy_ = 0;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_GOERTZEL_BANK_HPP_
@@ -0,0 +1,140 @@
+#include "ima_adpcm_encoder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+constexpr std::array<int16_t, 89> kStepTable = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+constexpr std::array<int8_t, 8> kIndexTable = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+constexpr double kSampleRateHz = 11025.0;
+constexpr size_t kBlockSamples = 256;
+
+// Reference decoder for the block format documented in the header.
+std::vector<int16_t> DecodeBlock(const uint8_t* block, size_t samples) {
+    int32_t predictor = static_cast<int16_t>((block[0] << 8) | block[1]);
+    int32_t step_index = block[2];
+    std::vector<int16_t> out;
+    out.reserve(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        const uint8_t byte =
+            block[dsp::ImaAdpcmEncoder::kHeaderSize + i / 2];
+        const uint8_t code = (i % 2 == 0) ? (byte & 0x0F) : (byte >> 4);
+        const int32_t step = kStepTable[step_index];
+        int32_t delta = step >> 3;
+        if (code & 4) delta += step;
+        if (code & 2) delta += step >> 1;
+        if (code & 1) delta += step >> 2;
+        predictor += (code & 8) ? -delta : delta;
+        predictor = std::clamp<int32_t>(predictor, INT16_MIN, INT16_MAX);
+        step_index = std::clamp<int32_t>(step_index + kIndexTable[code & 7], 0,
+                                         kStepTable.size() - 1);
+        out.push_back(static_cast<int16_t>(predictor));
+    }
+    return out;
+}
+
+std::vector<int16_t> MakeTone(double frequency_hz, double amplitude,
+                              size_t samples) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(std::lround(
+            amplitude * std::sin(2.0 * M_PI * frequency_hz * i /
+                                 kSampleRateHz)));
+    }
+    return pcm;
+}
+
+// Encodes in blocks and decodes every block from its own header.
+std::vector<int16_t> RoundTrip(const std::vector<int16_t>& pcm) {
+    dsp::ImaAdpcmEncoder encoder;
+    std::vector<uint8_t> block(
+        dsp::ImaAdpcmEncoder::EncodedSize(kBlockSamples));
+    std::vector<int16_t> decoded;
+    for (size_t start = 0; start < pcm.size(); start += kBlockSamples) {
+        const size_t count = std::min(kBlockSamples, pcm.size() - start);
+        const size_t size = encoder.EncodeBlock(
+            std::span<const int16_t>(&pcm[start], count), block);
+        EXPECT_EQ(size, dsp::ImaAdpcmEncoder::EncodedSize(count));
+        const std::vector<int16_t> samples = DecodeBlock(block.data(), count);
+        decoded.insert(decoded.end(), samples.begin(), samples.end());
+    }
+    return decoded;
+}
+
+double SnrDb(const std::vector<int16_t>& reference,
+             const std::vector<int16_t>& decoded, size_t skip) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i = skip; i < reference.size(); ++i) {
+        const double error = static_cast<double>(decoded[i]) - reference[i];
+        signal += static_cast<double>(reference[i]) * reference[i];
+        noise += error * error;
+    }
+    return 10.0 * std::log10(signal / std::max(noise, 1.0));
+}
+
+TEST(ImaAdpcmEncoder, RoundTripSnrOfTones) {
+    // 4-bit ADPCM tracks slow signals well and loses accuracy towards
+    // Nyquist, where successive samples differ most.
+    struct Case {
+        double frequency_hz;
+        double min_snr_db;
+    };
+    constexpr Case kCases[] = {{200.0, 35.0}, {1000.0, 22.0}, {3000.0, 15.0}};
+    for (const Case& test : kCases) {
+        for (const double amplitude : {1000.0, 8000.0, 30000.0}) {
+            const std::vector<int16_t> pcm =
+                MakeTone(test.frequency_hz, amplitude, 16 * kBlockSamples);
+            // Skips the first block, while the step size adapts from rest.
+            const double snr = SnrDb(pcm, RoundTrip(pcm), kBlockSamples);
+            EXPECT_GT(snr, test.min_snr_db)
+                << test.frequency_hz << " Hz at amplitude " << amplitude;
+        }
+    }
+}
+
+TEST(ImaAdpcmEncoder, BlocksDecodeIndependently) {
+    const std::vector<int16_t> pcm = MakeTone(440.0, 12000.0, 4 * 300);
+    dsp::ImaAdpcmEncoder encoder;
+    std::vector<std::vector<uint8_t>> blocks;
+    for (size_t start = 0; start < pcm.size(); start += 300) {
+        std::vector<uint8_t> block(dsp::ImaAdpcmEncoder::EncodedSize(300));
+        encoder.EncodeBlock(std::span<const int16_t>(&pcm[start], 300),
+                            block);
+        blocks.push_back(block);
+    }
+    // Decoding the last block alone gives the same samples as decoding
+    // the stream continuously, since the header carries the state.
+    encoder.Reset();
+    std::vector<uint8_t> whole(dsp::ImaAdpcmEncoder::EncodedSize(pcm.size()));
+    encoder.EncodeBlock(pcm, whole);
+    const std::vector<int16_t> continuous =
+        DecodeBlock(whole.data(), pcm.size());
+    const std::vector<int16_t> last = DecodeBlock(blocks.back().data(), 300);
+    EXPECT_TRUE(std::equal(last.begin(), last.end(), continuous.end() - 300));
+}
+
+TEST(ImaAdpcmEncoder, RejectsShortOutput) {
+    dsp::ImaAdpcmEncoder encoder;
+    const std::array<int16_t, 8> pcm{};
+    std::array<uint8_t, dsp::ImaAdpcmEncoder::EncodedSize(8) - 1> out{};
+    EXPECT_EQ(encoder.EncodeBlock(pcm, out), 0u);
+}
+
+}  // namespace
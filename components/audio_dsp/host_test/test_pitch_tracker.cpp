@@ -0,0 +1,258 @@
+#include "pitch_tracker.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using dsp::PitchTracker;
+
+constexpr uint32_t kSampleRateHz = 11025;
+constexpr size_t kWindow = PitchTracker::kWindow;
+constexpr size_t kBuffer = 2 * kWindow;
+
+// A sum of harmonics of `f0_hz`; amplitudes[k] is that of harmonic k + 1.
+std::vector<int16_t> MakeHarmonic(double f0_hz,
+                                  const std::vector<double>& amplitudes,
+                                  size_t samples) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        double value = 0.0;
+        for (size_t k = 0; k < amplitudes.size(); ++k) {
+            value += amplitudes[k] *
+                     std::sin(2.0 * M_PI * f0_hz * (k + 1) * i /
+                                  kSampleRateHz +
+                              0.3 * k);
+        }
+        pcm[i] = static_cast<int16_t>(std::lround(value));
+    }
+    return pcm;
+}
+
+std::vector<int16_t> MakeTone(double frequency_hz, size_t samples) {
+    return MakeHarmonic(frequency_hz, {8000.0}, samples);
+}
+
+// Straightforward YIN (de Cheveigne and Kawahara, 2002) on the buffer the
+// tracker analyses: the direct O(W^2) difference function in double, the
+// cumulative mean normalised difference, the absolute threshold and
+// parabolic interpolation, with the tracker's lag range and level gate.
+PitchTracker::Estimate ReferenceYin(const int16_t* x,
+                                    const PitchTracker::Config& config) {
+    const PitchTracker::Estimate unvoiced{0.0f, 0.0f, 0};
+
+    double mean = 0.0;
+    for (size_t j = 0; j < kBuffer; ++j) {
+        mean += x[j];
+    }
+    mean /= kBuffer;
+    double energy = 0.0;
+    for (size_t j = 0; j < kWindow; ++j) {
+        energy += (x[j] - mean) * (x[j] - mean);
+    }
+    if (10.0 * std::log10(energy / kWindow + 1.0) < config.min_level_db) {
+        return unvoiced;
+    }
+
+    std::vector<double> cmnd(kWindow, 1.0);
+    double running_sum = 0.0;
+    for (size_t tau = 1; tau < kWindow; ++tau) {
+        double d = 0.0;
+        for (size_t j = 0; j < kWindow; ++j) {
+            const double diff = static_cast<double>(x[j]) - x[j + tau];
+            d += diff * diff;
+        }
+        running_sum += d;
+        cmnd[tau] = running_sum > 0.0 ? d * tau / running_sum : 1.0;
+    }
+
+    const size_t min_lag = std::max<size_t>(
+        2, static_cast<size_t>(config.sample_rate_hz /
+                               config.max_frequency_hz));
+    const size_t max_lag = std::min<size_t>(
+        kWindow - 2, static_cast<size_t>(std::ceil(
+                         config.sample_rate_hz / config.min_frequency_hz)));
+    for (size_t tau = min_lag; tau <= max_lag; ++tau) {
+        if (cmnd[tau] >= config.threshold) {
+            continue;
+        }
+        while (tau + 1 <= max_lag && cmnd[tau + 1] < cmnd[tau]) {
+            ++tau;
+        }
+        const double curvature = cmnd[tau - 1] - 2.0 * cmnd[tau] + cmnd[tau + 1];
+        double shift = 0.0;
+        if (curvature > 0.0) {
+            shift = std::clamp(0.5 * (cmnd[tau - 1] - cmnd[tau + 1]) /
+                                   curvature,
+                               -0.5, 0.5);
+        }
+        return PitchTracker::Estimate{
+            static_cast<float>(config.sample_rate_hz / (tau + shift)),
+            static_cast<float>(std::clamp(1.0 - cmnd[tau], 0.0, 1.0)), 0};
+    }
+    return unvoiced;
+}
+
+// Runs `pcm` through the tracker in blocks of `block` samples. Estimates
+// carry the absolute index of their hop's last sample.
+std::vector<PitchTracker::Estimate> Track(PitchTracker& tracker,
+                                          const std::vector<int16_t>& pcm,
+                                          size_t block) {
+    std::vector<PitchTracker::Estimate> all;
+    std::vector<PitchTracker::Estimate> estimates(block /
+                                                      PitchTracker::kHop +
+                                                  1);
+    for (size_t start = 0; start < pcm.size(); start += block) {
+        const size_t count = std::min(block, pcm.size() - start);
+        const size_t produced = tracker.Process(
+            std::span<const int16_t>(&pcm[start], count), estimates);
+        for (size_t i = 0; i < produced; ++i) {
+            estimates[i].sample_offset += start;
+            all.push_back(estimates[i]);
+        }
+    }
+    return all;
+}
+
+// Checks every estimate of `pcm` against the reference on the same buffer.
+void ExpectMatchesReference(const std::vector<int16_t>& pcm, size_t block) {
+    const PitchTracker::Config config{.sample_rate_hz = kSampleRateHz};
+    PitchTracker tracker(config);
+    const std::vector<PitchTracker::Estimate> estimates =
+        Track(tracker, pcm, block);
+    ASSERT_EQ(estimates.size(),
+              (pcm.size() / PitchTracker::kHop) -
+                  (kBuffer / PitchTracker::kHop) + 1);
+
+    for (const PitchTracker::Estimate& estimate : estimates) {
+        ASSERT_GE(estimate.sample_offset + 1, kBuffer);
+        const PitchTracker::Estimate reference = ReferenceYin(
+            &pcm[estimate.sample_offset + 1 - kBuffer], config);
+        SCOPED_TRACE(estimate.sample_offset);
+        ASSERT_EQ(estimate.frequency_hz > 0.0f, reference.frequency_hz > 0.0f);
+        if (reference.frequency_hz > 0.0f) {
+            EXPECT_NEAR(estimate.frequency_hz, reference.frequency_hz,
+                        1e-3 * reference.frequency_hz);
+            EXPECT_NEAR(estimate.confidence, reference.confidence, 0.01f);
+        }
+    }
+}
+
+// Median of the voiced estimates, which must be all of them.
+float MedianPitch(const std::vector<PitchTracker::Estimate>& estimates) {
+    std::vector<float> pitches;
+    for (const PitchTracker::Estimate& estimate : estimates) {
+        EXPECT_GT(estimate.frequency_hz, 0.0f);
+        pitches.push_back(estimate.frequency_hz);
+    }
+    std::nth_element(pitches.begin(), pitches.begin() + pitches.size() / 2,
+                     pitches.end());
+    return pitches[pitches.size() / 2];
+}
+
+TEST(PitchTrackerTest, FindsTheFrequencyOfTones) {
+    for (const double f0 : {60.0, 82.4, 110.0, 196.0, 440.0, 880.0}) {
+        SCOPED_TRACE(f0);
+        PitchTracker tracker({.sample_rate_hz = kSampleRateHz});
+        const auto estimates = Track(tracker, MakeTone(f0, 4096), 256);
+        ASSERT_FALSE(estimates.empty());
+        for (const PitchTracker::Estimate& estimate : estimates) {
+            EXPECT_NEAR(estimate.frequency_hz, f0, 0.01 * f0);
+            EXPECT_GT(estimate.confidence, 0.9f);
+        }
+    }
+}
+
+TEST(PitchTrackerTest, FindsTheFundamentalOfHarmonicSignals) {
+    // Strong upper harmonics, as in voice and most instruments.
+    for (const double f0 : {98.0, 146.8, 261.6, 523.3}) {
+        SCOPED_TRACE(f0);
+        PitchTracker tracker({.sample_rate_hz = kSampleRateHz});
+        const auto estimates = Track(
+            tracker,
+            MakeHarmonic(f0, {3000.0, 4000.0, 2500.0, 1500.0, 800.0}, 4096),
+            256);
+        ASSERT_FALSE(estimates.empty());
+        EXPECT_NEAR(MedianPitch(estimates), f0, 0.01 * f0);
+    }
+
+    // A missing fundamental is still heard, and found, at f0.
+    PitchTracker tracker({.sample_rate_hz = kSampleRateHz});
+    const auto estimates = Track(
+        tracker, MakeHarmonic(200.0, {0.0, 4000.0, 3000.0, 2000.0}, 4096),
+        256);
+    EXPECT_NEAR(MedianPitch(estimates), 200.0, 2.0);
+}
+
+TEST(PitchTrackerTest, MatchesReferenceYinOnTones) {
+    for (const double f0 : {55.0, 130.8, 311.1, 987.8}) {
+        SCOPED_TRACE(f0);
+        ExpectMatchesReference(MakeTone(f0, 3072), 100);
+    }
+}
+
+TEST(PitchTrackerTest, MatchesReferenceYinOnHarmonicSignals) {
+    ExpectMatchesReference(
+        MakeHarmonic(123.5, {2000.0, 5000.0, 3000.0, 2000.0, 1000.0}, 3072),
+        64);
+    ExpectMatchesReference(
+        MakeHarmonic(392.0, {6000.0, 1500.0, 3000.0}, 3072), 333);
+}
+
+TEST(PitchTrackerTest, MatchesReferenceYinOnNoisyHarmonics) {
+    std::vector<int16_t> pcm =
+        MakeHarmonic(175.0, {4000.0, 3000.0, 2000.0}, 3072);
+    std::mt19937 rng(11);
+    std::normal_distribution<double> noise(0.0, 1500.0);
+    for (int16_t& sample : pcm) {
+        sample = static_cast<int16_t>(
+            std::clamp(sample + noise(rng), -32768.0, 32767.0));
+    }
+    ExpectMatchesReference(pcm, 512);
+}
+
+TEST(PitchTrackerTest, SilenceAndNoiseAreUnvoiced) {
+    PitchTracker tracker({.sample_rate_hz = kSampleRateHz});
+    for (const auto& estimate :
+         Track(tracker, std::vector<int16_t>(2048, 0), 256)) {
+        EXPECT_EQ(estimate.frequency_hz, 0.0f);
+        EXPECT_EQ(estimate.confidence, 0.0f);
+    }
+
+    std::vector<int16_t> noise(8192);
+    std::mt19937 rng(5);
+    std::normal_distribution<double> gaussian(0.0, 4000.0);
+    for (int16_t& sample : noise) {
+        sample = static_cast<int16_t>(std::clamp(gaussian(rng), -32768.0,
+                                                 32767.0));
+    }
+    PitchTracker noise_tracker({.sample_rate_hz = kSampleRateHz});
+    const auto estimates = Track(noise_tracker, noise, 256);
+    const size_t voiced = std::count_if(
+        estimates.begin(), estimates.end(),
+        [](const auto& estimate) { return estimate.frequency_hz > 0.0f; });
+    EXPECT_LT(voiced, estimates.size() / 10);
+}
+
+TEST(PitchTrackerTest, ResetStartsOverAfterAFullBuffer) {
+    PitchTracker tracker({.sample_rate_hz = kSampleRateHz});
+    Track(tracker, MakeTone(440.0, 2048), 256);
+    tracker.Reset();
+
+    // No estimate until the buffer has filled again, then only the new
+    // tone.
+    const auto estimates = Track(tracker, MakeTone(220.0, 1024), 64);
+    ASSERT_EQ(estimates.size(),
+              (1024 - kBuffer) / PitchTracker::kHop + 1);
+    EXPECT_EQ(estimates.front().sample_offset, kBuffer - 1);
+    for (const PitchTracker::Estimate& estimate : estimates) {
+        EXPECT_NEAR(estimate.frequency_hz, 220.0f, 2.2f);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,149 @@
+#include "polyphase_resampler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+// The LC3 path: capture rate down to 16 kHz.
+constexpr uint32_t kInputRateHz = 44100;
+constexpr uint32_t kOutputRateHz = 16000;
+using Resampler = dsp::PolyphaseResampler<kInputRateHz, kOutputRateHz, 64>;
+
+constexpr double kAmplitude = 16000.0;
+
+std::vector<int16_t> MakeTone(double frequency_hz, size_t samples) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(std::lround(
+            kAmplitude * std::sin(2.0 * M_PI * frequency_hz * i /
+                                  kInputRateHz)));
+    }
+    return pcm;
+}
+
+// Feeds `input` in blocks of `block` samples.
+std::vector<int16_t> Resample(Resampler& resampler,
+                              const std::vector<int16_t>& input,
+                              size_t block) {
+    std::vector<int16_t> output;
+    std::vector<int16_t> chunk(Resampler::MaxOutputSamples(block));
+    for (size_t start = 0; start < input.size(); start += block) {
+        const size_t count = std::min(block, input.size() - start);
+        const size_t produced = resampler.Process(
+            std::span<const int16_t>(&input[start], count), chunk);
+        EXPECT_LE(produced, Resampler::MaxOutputSamples(count));
+        output.insert(output.end(), chunk.begin(), chunk.begin() + produced);
+    }
+    return output;
+}
+
+// Level in dB relative to kAmplitude of the component at `frequency_hz`
+// of the output, skipping the filter's settling time.
+double LevelDb(const std::vector<int16_t>& output, double frequency_hz) {
+    constexpr size_t kSettle = 256;
+    double in_phase = 0.0;
+    double quadrature = 0.0;
+    for (size_t i = kSettle; i < output.size(); ++i) {
+        const double angle = 2.0 * M_PI * frequency_hz * i / kOutputRateHz;
+        in_phase += output[i] * std::cos(angle);
+        quadrature += output[i] * std::sin(angle);
+    }
+    const double amplitude = 2.0 * std::hypot(in_phase, quadrature) /
+                             static_cast<double>(output.size() - kSettle);
+    return 20.0 * std::log10(std::max(amplitude, 1e-3) / kAmplitude);
+}
+
+// Where a tone at `frequency_hz` lands after sampling at the output rate.
+double AliasHz(double frequency_hz) {
+    const double folded = std::fmod(frequency_hz, kOutputRateHz);
+    return std::min(folded, kOutputRateHz - folded);
+}
+
+TEST(PolyphaseResampler, PassbandIsFlat) {
+    // The cut-off sits at 0.9 of the output Nyquist frequency, 7.2 kHz,
+    // with the transition band below it.
+    for (const double frequency_hz : {100.0, 440.0, 1000.0, 3000.0, 5000.0}) {
+        Resampler resampler;
+        const std::vector<int16_t> output =
+            Resample(resampler, MakeTone(frequency_hz, kInputRateHz), 441);
+        EXPECT_NEAR(LevelDb(output, frequency_hz), 0.0, 0.1)
+            << frequency_hz << " Hz";
+    }
+}
+
+TEST(PolyphaseResampler, StopbandDoesNotAlias) {
+    // Above the output Nyquist frequency, tones would fold back into the
+    // passband without the filter.
+    for (const double frequency_hz :
+         {9000.0, 11000.0, 13000.0, 17000.0, 21000.0}) {
+        Resampler resampler;
+        const std::vector<int16_t> output =
+            Resample(resampler, MakeTone(frequency_hz, kInputRateHz), 441);
+        EXPECT_LT(LevelDb(output, AliasHz(frequency_hz)), -60.0)
+            << frequency_hz << " Hz";
+    }
+}
+
+TEST(PolyphaseResampler, DcGainIsUnity) {
+    Resampler resampler;
+    const std::vector<int16_t> input(4096, 12345);
+    const std::vector<int16_t> output = Resample(resampler, input, 100);
+    for (size_t i = 64; i < output.size(); ++i) {
+        ASSERT_NEAR(output[i], 12345, 1) << "sample " << i;
+    }
+}
+
+TEST(PolyphaseResampler, OutputCountNeverDrifts) {
+    // An hour of capture in randomly sized frames: the output count stays
+    // exactly ceil(n L / M), where a per-block rounded count would drift
+    // by up to a sample per frame.
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<size_t> frame(1, 1024);
+    Resampler resampler;
+    std::vector<int16_t> input(1024);
+    std::vector<int16_t> output(Resampler::MaxOutputSamples(1024));
+    uint64_t consumed = 0;
+    uint64_t produced = 0;
+    while (consumed < 3600ull * kInputRateHz) {
+        const size_t count = frame(rng);
+        produced += resampler.Process(
+            std::span<const int16_t>(input.data(), count), output);
+        consumed += count;
+        ASSERT_EQ(produced, (consumed * Resampler::kPhases +
+                             Resampler::kStep - 1) /
+                                Resampler::kStep)
+            << "after " << consumed << " samples";
+    }
+}
+
+TEST(PolyphaseResampler, BlockSizeDoesNotChangeOutput) {
+    const std::vector<int16_t> input = MakeTone(1234.0, 20000);
+    Resampler whole;
+    const std::vector<int16_t> reference =
+        Resample(whole, input, input.size());
+    for (const size_t block : {size_t{1}, size_t{7}, size_t{441},
+                               size_t{1000}}) {
+        Resampler chunked;
+        EXPECT_EQ(Resample(chunked, input, block), reference)
+            << "blocks of " << block;
+    }
+}
+
+TEST(PolyphaseResampler, OutputMayAliasInput) {
+    std::vector<int16_t> buffer = MakeTone(800.0, 4410);
+    Resampler separate;
+    std::vector<int16_t> expected(Resampler::MaxOutputSamples(buffer.size()));
+    expected.resize(separate.Process(buffer, expected));
+
+    Resampler in_place;
+    const size_t produced = in_place.Process(buffer, buffer);
+    buffer.resize(produced);
+    EXPECT_EQ(buffer, expected);
+}
+
+}  // namespace
@@ -0,0 +1,173 @@
+#include "spectrogram_codec.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using dsp::SpectrogramCodec;
+using dsp::SpectrogramDecoder;
+using dsp::SpectrogramEncoder;
+
+using Frame = std::vector<uint8_t>;
+
+constexpr uint8_t kDeadband = 2;
+
+// Encodes `frames`, with a keyframe every `key_interval`, into one stream.
+std::vector<uint8_t> EncodeStream(const std::vector<Frame>& frames,
+                                  size_t bands, size_t key_interval) {
+    SpectrogramEncoder encoder(bands, kDeadband);
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> coded(SpectrogramCodec::MaxEncodedSize(bands));
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const size_t size =
+            encoder.Encode(frames[i], i % key_interval == 0, coded);
+        EXPECT_GT(size, 0u);
+        EXPECT_LE(size, SpectrogramCodec::MaxEncodedSize(bands));
+        stream.insert(stream.end(), coded.begin(), coded.begin() + size);
+    }
+    return stream;
+}
+
+// Slowly varying bands with occasional jumps, like a real spectrogram.
+std::vector<Frame> MakeFrames(size_t bands, size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> drift(0.0, 3.0);
+    std::uniform_int_distribution<int> level(0, 255);
+    std::bernoulli_distribution jump(0.05);
+    std::vector<Frame> frames;
+    Frame frame(bands);
+    for (uint8_t& value : frame) {
+        value = static_cast<uint8_t>(level(rng));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        for (uint8_t& value : frame) {
+            const int next = jump(rng) ? level(rng)
+                                       : value + static_cast<int>(drift(rng));
+            value = static_cast<uint8_t>(std::clamp(next, 0, 255));
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+TEST(SpectrogramCodec, DecodesWithinDeadbandWithoutDrift) {
+    for (const size_t bands : {size_t{1}, size_t{7}, size_t{32},
+                               SpectrogramCodec::kMaxBands}) {
+        const std::vector<Frame> frames = MakeFrames(bands, 300, 5);
+        const std::vector<uint8_t> stream = EncodeStream(frames, bands, 30);
+
+        SpectrogramDecoder decoder(bands);
+        size_t offset = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            size_t consumed = 0;
+            const std::span<const uint8_t> decoded = decoder.Decode(
+                std::span<const uint8_t>(stream).subspan(offset), consumed);
+            ASSERT_EQ(decoded.size(), bands) << "frame " << i;
+            offset += consumed;
+            for (size_t b = 0; b < bands; ++b) {
+                const int error = decoded[b] - frames[i][b];
+                if (i % 30 == 0) {
+                    EXPECT_EQ(error, 0) << "keyframe " << i << " band " << b;
+                } else {
+                    EXPECT_LE(std::abs(error), kDeadband)
+                        << "frame " << i << " band " << b;
+                }
+            }
+        }
+        EXPECT_EQ(offset, stream.size());
+    }
+}
+
+TEST(SpectrogramCodec, BoundHoldsForEveryDeltaPattern) {
+    // Every band takes one of the change classes the encoder tells apart:
+    // within the deadband, a 3-bit delta, a 6-bit delta and a jump.
+    constexpr int kClasses[] = {0, 3, 20, 100};
+    for (size_t bands = 1; bands <= 8; ++bands) {
+        size_t worst = 0;
+        size_t patterns = 1;
+        for (size_t i = 0; i < bands; ++i) {
+            patterns *= std::size(kClasses);
+        }
+        for (size_t pattern = 0; pattern < patterns; ++pattern) {
+            SpectrogramEncoder encoder(bands, kDeadband);
+            const Frame base(bands, 128);
+            std::vector<uint8_t> coded(
+                SpectrogramCodec::MaxEncodedSize(bands));
+            encoder.Encode(base, true, coded);
+
+            Frame frame = base;
+            size_t digits = pattern;
+            for (size_t b = 0; b < bands; ++b) {
+                frame[b] = static_cast<uint8_t>(
+                    128 + kClasses[digits % std::size(kClasses)]);
+                digits /= std::size(kClasses);
+            }
+            const size_t size = encoder.Encode(frame, false, coded);
+            ASSERT_GT(size, 0u);
+            worst = std::max(worst, size);
+        }
+        // The bound is tight.
+        EXPECT_EQ(worst, SpectrogramCodec::MaxEncodedSize(bands))
+            << bands << " bands";
+    }
+}
+
+TEST(SpectrogramCodec, BoundHoldsForAlternatingJumps) {
+    const size_t bands = SpectrogramCodec::kMaxBands;
+    SpectrogramEncoder encoder(bands, kDeadband);
+    std::vector<uint8_t> coded(SpectrogramCodec::MaxEncodedSize(bands));
+    Frame frame(bands, 100);
+    encoder.Encode(frame, true, coded);
+    for (size_t b = 0; b < bands; ++b) {
+        frame[b] = static_cast<uint8_t>(b % 2 == 0 ? 200 : 110);
+    }
+    EXPECT_EQ(encoder.Encode(frame, false, coded),
+              SpectrogramCodec::MaxEncodedSize(bands));
+}
+
+TEST(SpectrogramCodec, EncodeRejectsShortBuffers) {
+    const size_t bands = 16;
+    SpectrogramEncoder encoder(bands, kDeadband);
+    const Frame frame(bands, 50);
+    std::vector<uint8_t> small(SpectrogramCodec::MaxEncodedSize(bands) - 1);
+    EXPECT_EQ(encoder.Encode(frame, true, small), 0u);
+    std::vector<uint8_t> coded(SpectrogramCodec::MaxEncodedSize(bands));
+    EXPECT_EQ(encoder.Encode(Frame(bands - 1, 50), true, coded), 0u);
+
+    // A rejected call leaves the encoder in step with the decoder.
+    const size_t size = encoder.Encode(frame, false, coded);
+    SpectrogramDecoder decoder(bands);
+    size_t consumed = 0;
+    const std::span<const uint8_t> decoded = decoder.Decode(
+        std::span<const uint8_t>(coded.data(), size), consumed);
+    EXPECT_TRUE(std::equal(decoded.begin(), decoded.end(), frame.begin(),
+                           frame.end()));
+}
+
+TEST(SpectrogramCodec, DecoderRejectsMalformedFrames) {
+    const size_t bands = 4;
+    size_t consumed = 0;
+    // Truncated literal.
+    SpectrogramDecoder truncated(bands);
+    const uint8_t literal[] = {SpectrogramCodec::kTokenLiteral | 3, 1, 2};
+    EXPECT_TRUE(truncated.Decode(literal, consumed).empty());
+    // Run past the last band.
+    SpectrogramDecoder overrun(bands);
+    const uint8_t run[] = {SpectrogramCodec::kTokenRun | 4};
+    EXPECT_TRUE(overrun.Decode(run, consumed).empty());
+    // Delta pair starting on the last band.
+    SpectrogramDecoder pair(bands);
+    const uint8_t tail_pair[] = {SpectrogramCodec::kTokenRun | 2,
+                                 SpectrogramCodec::kTokenDeltaPair | 0x09};
+    EXPECT_TRUE(pair.Decode(tail_pair, consumed).empty());
+    // Empty input.
+    EXPECT_TRUE(pair.Decode({}, consumed).empty());
+}
+
+}  // namespace
@@ -0,0 +1,89 @@
+#include "ima_adpcm_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+// Quantiser step sizes from the IMA ADPCM specification.
+constexpr std::array<int16_t, 89> kStepTable = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+// Step index adjustment per code magnitude.
+constexpr std::array<int8_t, 8> kIndexTable = {-1, -1, -1, -1, 2, 4, 6, 8};
+}  // namespace
+
+namespace dsp {
+
+void ImaAdpcmEncoder::Reset() {
+    predictor_ = 0;
+    step_index_ = 0;
+}
+
+size_t ImaAdpcmEncoder::EncodeBlock(std::span<const int16_t> samples,
+                                    std::span<uint8_t> out) {
+    const size_t size = EncodedSize(samples.size());
+    if (out.size() < size) {
+        return 0;
+    }
+
+    const uint16_t predictor = static_cast<uint16_t>(predictor_);
+    out[0] = predictor >> 8;
+    out[1] = predictor & 0xFF;
+    out[2] = static_cast<uint8_t>(step_index_);
+
+    uint8_t* data = &out[kHeaderSize];
+    size_t i = 0;
+    for (; i + 1 < samples.size(); i += 2) {
+        const uint8_t low = EncodeSample(samples[i]);
+        const uint8_t high = EncodeSample(samples[i + 1]);
+        *data++ = low | (high << 4);
+    }
+    if (i < samples.size()) {
+        *data = EncodeSample(samples[i]);
+    }
+    return size;
+}
+
+uint8_t ImaAdpcmEncoder::EncodeSample(int32_t sample) {
+    const int32_t step = kStepTable[step_index_];
+    int32_t diff = sample - predictor_;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    // Successive approximation of diff / step in three bits, accumulating
+    // the same reconstruction the decoder will compute.
+    int32_t delta = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    if (diff >= step >> 1) {
+        code |= 2;
+        diff -= step >> 1;
+        delta += step >> 1;
+    }
+    if (diff >= step >> 2) {
+        code |= 1;
+        delta += step >> 2;
+    }
+
+    predictor_ += (code & 8) ? -delta : delta;
+    predictor_ = std::clamp<int32_t>(predictor_, INT16_MIN, INT16_MAX);
+    step_index_ = std::clamp<int32_t>(step_index_ + kIndexTable[code & 7], 0,
+                                      kStepTable.size() - 1);
+    return code;
+}
+
+}  // namespace dsp
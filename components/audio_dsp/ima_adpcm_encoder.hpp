@@ -0,0 +1,58 @@
+#ifndef AUDIO_DSP_IMA_ADPCM_ENCODER_HPP_
+#define AUDIO_DSP_IMA_ADPCM_ENCODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @class ImaAdpcmEncoder
+ * @brief Streaming IMA-ADPCM encoder, 16-bit PCM to 4 bits per sample.
+ *
+ * Every block starts with a header holding the encoder state the block was
+ * coded from, so a decoder can start at any block and recovers from lost
+ * blocks on the next one:
+ * - Bytes 0-1: Predictor (big-endian int16)
+ * - Byte 2: Step index (0-88)
+ * - Bytes 3..: One nibble per sample, the first sample in the low nibble.
+ *
+ * The state carries over between blocks, so a gap-free stream decodes
+ * exactly as if it had been coded in one piece.
+ */
+class ImaAdpcmEncoder {
+   public:
+    static constexpr size_t kHeaderSize = 3;
+
+    /**
+     * @brief Returns the encoded size of a block of `samples` samples.
+     */
+    static constexpr size_t EncodedSize(size_t samples) {
+        return kHeaderSize + (samples + 1) / 2;
+    }
+
+    /**
+     * @brief Encodes one block.
+     * @param samples PCM samples, in capture order.
+     * @param out Destination, at least EncodedSize(samples.size()) bytes.
+     * @return The number of bytes written, or 0 if `out` is too small.
+     */
+    size_t EncodeBlock(std::span<const int16_t> samples,
+                       std::span<uint8_t> out);
+
+    /**
+     * @brief Clears the predictor state, e.g. at the start of a session.
+     */
+    void Reset();
+
+   private:
+    uint8_t EncodeSample(int32_t sample);
+
+    int32_t predictor_ = 0;
+    int32_t step_index_ = 0;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_IMA_ADPCM_ENCODER_HPP_
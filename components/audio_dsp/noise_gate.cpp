@@ -0,0 +1,92 @@
+#include "noise_gate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dsp {
+
+NoiseGate::NoiseGate(const Config& config) : config_(config) {
+    const float frames_per_window =
+        config_.search_window_ms * config_.frame_rate_hz / 1000.0f;
+    frames_per_sub_window_ = std::max<uint32_t>(
+        1, static_cast<uint32_t>(frames_per_window / kSubWindows));
+    hangover_frames_ = static_cast<uint32_t>(
+        static_cast<uint64_t>(config_.hangover_ms) * config_.frame_rate_hz /
+        1000);
+    Reset();
+}
+
+void NoiseGate::Reset() {
+    sub_window_minima_.fill(std::numeric_limits<float>::max());
+    sub_window_index_ = 0;
+    sub_window_fill_ = 0;
+    current_minimum_db_ = std::numeric_limits<float>::max();
+    smoothed_db_ = 0.0f;
+    floor_db_ = config_.min_floor_db;
+    quiet_frames_ = 0;
+    open_ = false;
+    primed_ = false;
+}
+
+bool NoiseGate::Process(std::span<const int16_t> frame) {
+    int64_t sum_of_squares = 0;
+    for (const int16_t sample : frame) {
+        sum_of_squares += static_cast<int32_t>(sample) * sample;
+    }
+    return ProcessEnergy(sum_of_squares, frame.size());
+}
+
+bool NoiseGate::ProcessEnergy(int64_t sum_of_squares, size_t samples) {
+    if (samples == 0) {
+        return open_;
+    }
+
+    const float level_db = 10.0f * std::log10(
+                                       static_cast<float>(sum_of_squares) /
+                                           samples +
+                                       1.0f);
+
+    if (!primed_) {
+        smoothed_db_ = level_db;
+        primed_ = true;
+    }
+    smoothed_db_ += (1.0f - config_.smoothing) * (level_db - smoothed_db_);
+    UpdateFloor(smoothed_db_);
+
+    // Open on the raw frame level so activity is caught within one frame;
+    // close on the smoothed level with a hangover to ride out short pauses.
+    if (level_db >= floor_db_ + config_.open_db) {
+        open_ = true;
+        quiet_frames_ = 0;
+    } else if (open_ && smoothed_db_ < floor_db_ + config_.close_db) {
+        if (++quiet_frames_ >= hangover_frames_) {
+            open_ = false;
+            quiet_frames_ = 0;
+        }
+    } else {
+        quiet_frames_ = 0;
+    }
+    return open_;
+}
+
+void NoiseGate::UpdateFloor(float smoothed_db) {
+    current_minimum_db_ = std::min(current_minimum_db_, smoothed_db);
+
+    if (++sub_window_fill_ >= frames_per_sub_window_) {
+        sub_window_minima_[sub_window_index_] = current_minimum_db_;
+        sub_window_index_ = (sub_window_index_ + 1) % kSubWindows;
+        sub_window_fill_ = 0;
+        current_minimum_db_ = std::numeric_limits<float>::max();
+    }
+
+    // The running minimum of the current sub-window takes part too, so the
+    // floor can drop immediately when the background gets quieter.
+    float floor = current_minimum_db_;
+    for (const float minimum : sub_window_minima_) {
+        floor = std::min(floor, minimum);
+    }
+    floor_db_ = std::max(floor, config_.min_floor_db);
+}
+
+}  // namespace dsp
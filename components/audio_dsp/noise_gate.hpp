@@ -0,0 +1,89 @@
+#ifndef AUDIO_DSP_NOISE_GATE_HPP_
+#define AUDIO_DSP_NOISE_GATE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @class NoiseGate
+ * @brief Frame-level voice/activity gate with an adaptive noise floor.
+ *
+ * The noise floor is tracked with minimum statistics: the smoothed frame
+ * level is reduced to one minimum per sub-window, and the floor is the
+ * smallest of the last kSubWindows minima. Speech and music rarely stay
+ * loud for a whole search window, so the floor follows the background
+ * without being pulled up by activity.
+ *
+ * The gate opens as soon as a single frame rises `open_db` above the floor,
+ * so activity is never reported late. It closes only after the level has
+ * stayed below `close_db` above the floor for the hangover time.
+ */
+class NoiseGate {
+   public:
+    static constexpr size_t kSubWindows = 8;
+
+    struct Config {
+        uint32_t frame_rate_hz = 172;      // Frames per second fed in
+        float search_window_ms = 1500.0f;  // Minimum statistics window
+        float smoothing = 0.7f;            // One-pole level smoothing
+        float open_db = 9.0f;              // Open threshold above the floor
+        float close_db = 5.0f;             // Close threshold above the floor
+        uint32_t hangover_ms = 300;        // Time below close before closing
+        float min_floor_db = 20.0f;        // Floor never drops below this
+    };
+
+    explicit NoiseGate(const Config& config);
+
+    /**
+     * @brief Updates the gate with one frame of PCM samples.
+     * @param frame PCM samples of a single capture frame.
+     * @return true while the gate is open (activity present).
+     */
+    bool Process(std::span<const int16_t> frame);
+
+    /**
+     * @brief Updates the gate from a frame's energy, for callers that
+     * already summed it.
+     * @param sum_of_squares Sum of the squared samples of the frame.
+     * @param samples Number of samples in the frame.
+     * @return true while the gate is open (activity present).
+     */
+    bool ProcessEnergy(int64_t sum_of_squares, size_t samples);
+
+    bool IsOpen() const { return open_; }
+
+    /**
+     * @brief Returns the current noise floor estimate in dB.
+     */
+    float GetNoiseFloorDb() const { return floor_db_; }
+
+    /**
+     * @brief Clears the floor history and closes the gate.
+     */
+    void Reset();
+
+   private:
+    void UpdateFloor(float smoothed_db);
+
+    Config config_;
+    uint32_t frames_per_sub_window_;
+    uint32_t hangover_frames_;
+
+    std::array<float, kSubWindows> sub_window_minima_{};
+    size_t sub_window_index_ = 0;
+    uint32_t sub_window_fill_ = 0;
+    float current_minimum_db_ = 0.0f;
+    float smoothed_db_ = 0.0f;
+    float floor_db_ = 0.0f;
+    uint32_t quiet_frames_ = 0;
+    bool open_ = false;
+    bool primed_ = false;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_NOISE_GATE_HPP_
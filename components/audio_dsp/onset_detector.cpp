@@ -0,0 +1,96 @@
+#include "onset_detector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+namespace {
+// Converts a time constant into a one-pole smoothing coefficient for a
+// filter that is updated once every `period_ms`.
+float SmoothingAlpha(float period_ms, float time_constant_ms) {
+    return 1.0f - std::exp(-period_ms / time_constant_ms);
+}
+}  // namespace
+
+OnsetDetector::OnsetDetector(const Config& config) : config_(config) {
+    const float hop_ms = 1000.0f * config_.hop_samples /
+                         static_cast<float>(config_.sample_rate_hz);
+    envelope_alpha_ = SmoothingAlpha(hop_ms, config_.envelope_time_ms);
+    statistics_alpha_ = SmoothingAlpha(hop_ms, config_.statistics_time_ms);
+    refractory_hops_ =
+        static_cast<uint32_t>(std::ceil(config_.refractory_ms / hop_ms));
+    Reset();
+}
+
+void OnsetDetector::Reset() {
+    hop_energy_ = 0;
+    hop_fill_ = 0;
+    envelope_db_ = 0.0f;
+    flux_mean_ = 0.0f;
+    flux_deviation_ = 0.0f;
+    hops_since_onset_ = refractory_hops_;
+    primed_ = false;
+}
+
+std::optional<OnsetDetector::Onset> OnsetDetector::Process(
+    std::span<const int16_t> frame) {
+    std::optional<Onset> result;
+
+    for (size_t i = 0; i < frame.size(); ++i) {
+        const int32_t sample = frame[i];
+        hop_energy_ += sample * sample;
+        if (++hop_fill_ < config_.hop_samples) {
+            continue;
+        }
+
+        std::optional<float> strength = ProcessHop(hop_energy_);
+        hop_energy_ = 0;
+        hop_fill_ = 0;
+        if (strength && !result) {
+            result = Onset{.sample_offset = i, .strength_db = *strength};
+        }
+    }
+    return result;
+}
+
+std::optional<float> OnsetDetector::ProcessHop(int64_t sum_of_squares) {
+    const float level_db = 10.0f * std::log10(
+                                       static_cast<float>(sum_of_squares) /
+                                           config_.hop_samples +
+                                       1.0f);
+
+    if (!primed_) {
+        envelope_db_ = level_db;
+        primed_ = true;
+        return std::nullopt;
+    }
+
+    // Positive energy derivative against the smoothed envelope.
+    const float flux = std::max(0.0f, level_db - envelope_db_);
+    envelope_db_ += envelope_alpha_ * (level_db - envelope_db_);
+
+    const float threshold =
+        std::max(flux_mean_ + config_.threshold_deviations * flux_deviation_,
+                 config_.min_rise_db);
+
+    // Update the adaptive statistics after the decision so the onset itself
+    // does not raise its own threshold.
+    flux_deviation_ +=
+        statistics_alpha_ * (std::fabs(flux - flux_mean_) - flux_deviation_);
+    flux_mean_ += statistics_alpha_ * (flux - flux_mean_);
+
+    if (hops_since_onset_ < refractory_hops_) {
+        ++hops_since_onset_;
+    }
+
+    if (flux <= threshold || level_db < config_.min_level_db ||
+        hops_since_onset_ < refractory_hops_) {
+        return std::nullopt;
+    }
+
+    hops_since_onset_ = 0;
+    return flux;
+}
+
+}  // namespace dsp
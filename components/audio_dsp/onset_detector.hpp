@@ -0,0 +1,82 @@
+#ifndef AUDIO_DSP_ONSET_DETECTOR_HPP_
+#define AUDIO_DSP_ONSET_DETECTOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @class OnsetDetector
+ * @brief Detects acoustic onsets (note attacks, drum hits) in a PCM stream.
+ *
+ * The detector splits every frame into short hops and computes the log
+ * energy of each hop. The onset function is the positive energy derivative,
+ * i.e. how far the current hop rises above a short-term smoothed envelope.
+ * An onset is reported when the derivative exceeds an adaptive threshold made
+ * of the running mean plus a multiple of the running mean absolute deviation,
+ * so the detector follows both quiet and loud environments.
+ *
+ * State is carried across calls, so frames can be of any length.
+ */
+class OnsetDetector {
+   public:
+    struct Config {
+        uint32_t sample_rate_hz = 44100;
+        size_t hop_samples = 64;           // ~1.5 ms at 44.1 kHz
+        float envelope_time_ms = 20.0f;    // Smoothing of the reference level
+        float statistics_time_ms = 1000.0f;  // Adaptive threshold memory
+        float threshold_deviations = 3.0f;   // k in mean + k * deviation
+        float min_rise_db = 4.0f;            // Absolute floor of the threshold
+        float min_level_db = 30.0f;          // Hops below this are ignored
+        uint32_t refractory_ms = 60;         // Minimum spacing of onsets
+    };
+
+    /**
+     * @brief A detected onset.
+     */
+    struct Onset {
+        size_t sample_offset;  // Frame offset of the onset hop's last sample
+        float strength_db;     // Rise above the smoothed envelope in dB
+    };
+
+    explicit OnsetDetector(const Config& config);
+
+    /**
+     * @brief Feeds a frame of PCM samples through the detector.
+     *
+     * The refractory period is longer than any capture frame, so at most one
+     * onset can be reported per call.
+     *
+     * @param frame PCM samples, in capture order.
+     * @return The detected onset, or std::nullopt if none occurred.
+     */
+    std::optional<Onset> Process(std::span<const int16_t> frame);
+
+    /**
+     * @brief Clears all history, e.g. at the start of a streaming session.
+     */
+    void Reset();
+
+   private:
+    std::optional<float> ProcessHop(int64_t sum_of_squares);
+
+    Config config_;
+    float envelope_alpha_;
+    float statistics_alpha_;
+    uint32_t refractory_hops_;
+
+    int64_t hop_energy_ = 0;
+    size_t hop_fill_ = 0;
+    float envelope_db_ = 0.0f;
+    float flux_mean_ = 0.0f;
+    float flux_deviation_ = 0.0f;
+    uint32_t hops_since_onset_ = 0;
+    bool primed_ = false;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_ONSET_DETECTOR_HPP_
@@ -0,0 +1,142 @@
+#include "pitch_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+PitchTracker::PitchTracker(const Config& config) : config_(config) {
+    // The lag search needs one lag on either side for interpolation.
+    min_lag_ = std::max<size_t>(
+        2, static_cast<size_t>(config_.sample_rate_hz /
+                               config_.max_frequency_hz));
+    max_lag_ = std::min<size_t>(
+        kWindow - 2, static_cast<size_t>(std::ceil(config_.sample_rate_hz /
+                                                   config_.min_frequency_hz)));
+}
+
+void PitchTracker::Reset() {
+    buffer_.fill(0.0f);
+    hop_fill_ = 0;
+    buffered_ = 0;
+}
+
+size_t PitchTracker::Process(std::span<const int16_t> samples,
+                             std::span<Estimate> estimates) {
+    size_t produced = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        // The buffer is shifted once per hop, so new samples are appended
+        // after the kBufferSize - kHop retained ones.
+        buffer_[kBufferSize - kHop + hop_fill_] = samples[i];
+        if (++hop_fill_ < kHop) {
+            continue;
+        }
+        hop_fill_ = 0;
+        buffered_ = std::min(buffered_ + kHop, kBufferSize);
+
+        if (buffered_ == kBufferSize && produced < estimates.size()) {
+            Estimate estimate = Analyze();
+            estimate.sample_offset = i;
+            estimates[produced++] = estimate;
+        }
+        std::copy(buffer_.begin() + kHop, buffer_.end(), buffer_.begin());
+    }
+    return produced;
+}
+
+PitchTracker::Estimate PitchTracker::Analyze() {
+    constexpr Estimate kUnvoiced = {
+        .frequency_hz = 0.0f, .confidence = 0.0f, .sample_offset = 0};
+
+    // Remove the mean so the energy and correlation terms, which are
+    // subtracted from each other, keep their float precision.
+    float mean = 0.0f;
+    for (const float x : buffer_) {
+        mean += x;
+    }
+    mean /= kBufferSize;
+
+    // Pack the zero-padded window a = x[0, W) into the real part and the
+    // full buffer b = x[0, 2W) into the imaginary part.
+    prefix_energy_[0] = 0.0f;
+    for (size_t j = 0; j < kBufferSize; ++j) {
+        const float x = buffer_[j] - mean;
+        spectrum_[j] = std::complex<float>(j < kWindow ? x : 0.0f, x);
+        prefix_energy_[j + 1] = prefix_energy_[j] + x * x;
+    }
+
+    const float window_energy = prefix_energy_[kWindow];
+    const float level_db =
+        10.0f * std::log10(window_energy / kWindow + 1.0f);
+    if (level_db < config_.min_level_db) {
+        return kUnvoiced;
+    }
+
+    fft_.Forward(std::span<std::complex<float>, kBufferSize>(spectrum_));
+
+    // Split the packed spectrum into A and B and form the cross spectrum
+    // conj(A) * B. It is Hermitian since the correlation is real, so only
+    // the lower half is computed.
+    for (size_t k = 0; k <= kBufferSize / 2; ++k) {
+        const std::complex<float> z = spectrum_[k];
+        const std::complex<float> z_mirror =
+            std::conj(spectrum_[(kBufferSize - k) % kBufferSize]);
+        const std::complex<float> a = 0.5f * (z + z_mirror);
+        const std::complex<float> diff = 0.5f * (z - z_mirror);
+        const std::complex<float> b(diff.imag(), -diff.real());  // diff / i
+        const std::complex<float> cross =
+            Fft<kBufferSize>::Multiply(std::conj(a), b);
+        spectrum_[k] = cross;
+        if (k != 0 && k != kBufferSize / 2) {
+            spectrum_[kBufferSize - k] = std::conj(cross);
+        }
+    }
+    fft_.Inverse(std::span<std::complex<float>, kBufferSize>(spectrum_));
+
+    // Cumulative mean normalised difference d'(tau).
+    difference_[0] = 1.0f;
+    float running_sum = 0.0f;
+    for (size_t tau = 1; tau < kWindow; ++tau) {
+        const float lagged_energy =
+            prefix_energy_[tau + kWindow] - prefix_energy_[tau];
+        const float correlation = spectrum_[tau].real() / kBufferSize;
+        const float d =
+            std::max(0.0f, window_energy + lagged_energy - 2.0f * correlation);
+        running_sum += d;
+        difference_[tau] =
+            running_sum > 0.0f ? d * tau / running_sum : 1.0f;
+    }
+
+    // First dip below the absolute threshold, followed down to its minimum.
+    size_t lag = 0;
+    for (size_t tau = min_lag_; tau <= max_lag_; ++tau) {
+        if (difference_[tau] < config_.threshold) {
+            while (tau + 1 <= max_lag_ &&
+                   difference_[tau + 1] < difference_[tau]) {
+                ++tau;
+            }
+            lag = tau;
+            break;
+        }
+    }
+    if (lag == 0) {
+        return kUnvoiced;
+    }
+
+    const float previous = difference_[lag - 1];
+    const float current = difference_[lag];
+    const float next = difference_[lag + 1];
+    float shift = 0.0f;
+    const float curvature = previous - 2.0f * current + next;
+    if (curvature > 0.0f) {
+        shift = std::clamp(0.5f * (previous - next) / curvature, -0.5f, 0.5f);
+    }
+
+    return Estimate{
+        .frequency_hz = config_.sample_rate_hz / (lag + shift),
+        .confidence = std::clamp(1.0f - current, 0.0f, 1.0f),
+        .sample_offset = 0,
+    };
+}
+
+}  // namespace dsp
@@ -0,0 +1,92 @@
+#ifndef AUDIO_DSP_PITCH_TRACKER_HPP_
+#define AUDIO_DSP_PITCH_TRACKER_HPP_
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "fft.hpp"
+
+namespace dsp {
+
+/**
+ * @class PitchTracker
+ * @brief YIN fundamental-frequency estimator for the decimated stream.
+ *
+ * The tracker keeps the newest 2 * kWindow samples and produces one estimate
+ * every kHop new samples. The YIN difference function
+ *
+ *   d(tau) = sum_{j<W} (x[j] - x[j + tau])^2
+ *          = E(0) + E(tau) - 2 * r(tau)
+ *
+ * is evaluated for all lags at once: the window energies E come from a
+ * prefix sum and the cross-correlation r from a single FFT of size 2W, with
+ * both real inputs packed into one complex transform. This makes an estimate
+ * O(W log W) rather than the O(W^2) of the direct form. The cumulative-mean
+ * normalised difference is then searched for the first dip below the
+ * absolute threshold and refined by parabolic interpolation.
+ */
+class PitchTracker {
+   public:
+    static constexpr size_t kWindow = 256;
+    static constexpr size_t kHop = 64;
+
+    struct Config {
+        uint32_t sample_rate_hz = 11025;
+        float min_frequency_hz = 50.0f;
+        float max_frequency_hz = 1000.0f;
+        float threshold = 0.15f;      // YIN absolute threshold
+        float min_level_db = 30.0f;   // Quieter windows are unvoiced
+    };
+
+    /**
+     * @brief A pitch estimate for one hop.
+     */
+    struct Estimate {
+        float frequency_hz;  // 0 when unvoiced
+        float confidence;    // 1 - d'(tau) at the chosen lag, 0.0 to 1.0
+        size_t sample_offset;  // Input offset of the hop's last sample
+    };
+
+    explicit PitchTracker(const Config& config);
+
+    /**
+     * @brief Feeds decimated samples and computes the estimates they complete.
+     * @param samples Samples at the configured rate.
+     * @param[out] estimates Receives one estimate per completed hop.
+     * @return The number of estimates written to `estimates`.
+     */
+    size_t Process(std::span<const int16_t> samples,
+                   std::span<Estimate> estimates);
+
+    /**
+     * @brief Clears the sample history.
+     */
+    void Reset();
+
+   private:
+    static constexpr size_t kBufferSize = 2 * kWindow;
+
+    Estimate Analyze();
+
+    Config config_;
+    size_t min_lag_;
+    size_t max_lag_;
+
+    Fft<kBufferSize> fft_;
+    std::array<float, kBufferSize> buffer_{};
+    size_t hop_fill_ = 0;
+    size_t buffered_ = 0;
+
+    // Working storage of Analyze(), kept out of the task stack.
+    std::array<std::complex<float>, kBufferSize> spectrum_{};
+    std::array<float, kBufferSize + 1> prefix_energy_{};
+    std::array<float, kWindow> difference_{};
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_PITCH_TRACKER_HPP_
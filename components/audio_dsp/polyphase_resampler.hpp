@@ -0,0 +1,228 @@
+#ifndef AUDIO_DSP_POLYPHASE_RESAMPLER_HPP_
+#define AUDIO_DSP_POLYPHASE_RESAMPLER_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
+
+#include "block_exponent.hpp"
+
+namespace dsp {
+
+namespace polyphase_internal {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// std:: math is not constexpr in C++20, so the table is built with series
+// that are accurate to well below the Q15 rounding of the coefficients.
+
+constexpr double Sin(double x) {
+    // Reduce to [-pi, pi], where the Taylor series converges quickly.
+    const long turns = static_cast<long>(x / (2.0 * kPi));
+    x -= 2.0 * kPi * static_cast<double>(turns);
+    if (x > kPi) {
+        x -= 2.0 * kPi;
+    } else if (x < -kPi) {
+        x += 2.0 * kPi;
+    }
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 16; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double Sqrt(double x) {
+    if (x <= 0.0) {
+        return 0.0;
+    }
+    double root = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; ++i) {
+        root = 0.5 * (root + x / root);
+    }
+    return root;
+}
+
+// Zeroth-order modified Bessel function of the first kind.
+constexpr double BesselI0(double x) {
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+}  // namespace polyphase_internal
+
+/**
+ * @class PolyphaseResampler
+ * @brief Rational-ratio sample rate converter with a windowed-sinc filter.
+ *
+ * The rates reduce to an interpolation factor L and a decimation factor M.
+ * A Kaiser-windowed sinc low-pass of L * TapsPerPhase taps, cut off below
+ * the lower of the two Nyquist frequencies, is split into L phases of
+ * TapsPerPhase Q15 coefficients, so every output sample costs
+ * TapsPerPhase multiply-accumulates whatever the ratio. The table is built
+ * at compile time and lives in flash.
+ *
+ * Output times are tracked as an exact multiple of 1 / L input samples, so
+ * the output never drifts against the input however long it runs. When the
+ * output rate is not above the input rate, `output` may alias `input`:
+ * every output sample is written after the input sample at its index has
+ * been consumed.
+ *
+ * @tparam InputRateHz Input sample rate.
+ * @tparam OutputRateHz Output sample rate.
+ * @tparam TapsPerPhase Input samples weighted by every output sample.
+ */
+template <uint32_t InputRateHz, uint32_t OutputRateHz, size_t TapsPerPhase>
+class PolyphaseResampler {
+   public:
+    static constexpr uint32_t kPhases =
+        OutputRateHz / std::gcd(InputRateHz, OutputRateHz);
+    static constexpr uint32_t kStep =
+        InputRateHz / std::gcd(InputRateHz, OutputRateHz);
+
+    /**
+     * @brief Returns the most output samples one call can produce.
+     * @param input_samples Length of the input block.
+     */
+    static constexpr size_t MaxOutputSamples(size_t input_samples) {
+        return static_cast<size_t>(
+                   (static_cast<uint64_t>(input_samples) * kPhases) / kStep) +
+               1;
+    }
+
+    /**
+     * @brief Converts a block of samples.
+     * @param input Samples at the input rate.
+     * @param[out] output Receives the converted samples. Must hold at least
+     * MaxOutputSamples(input.size()) samples.
+     * @return The number of output samples written.
+     */
+    size_t Process(std::span<const int16_t> input, std::span<int16_t> output) {
+        size_t produced = 0;
+        for (const int16_t sample : input) {
+            // As in Decimator, the history is stored twice so the newest
+            // TapsPerPhase samples are always contiguous.
+            history_[head_] = sample;
+            history_[head_ + TapsPerPhase] = sample;
+            head_ = (head_ + 1) % TapsPerPhase;
+
+            // Every output due before the next input sample uses this one
+            // as its newest tap.
+            const int16_t* window = &history_[head_];
+            for (; phase_ < kPhases; phase_ += kStep) {
+                if (produced >= output.size()) {
+                    continue;
+                }
+                const int16_t* coefficients =
+                    &kCoefficients[phase_ * TapsPerPhase];
+                int32_t accumulator = 1 << 14;
+                for (size_t i = 0; i < TapsPerPhase; ++i) {
+                    accumulator +=
+                        static_cast<int32_t>(coefficients[i]) * window[i];
+                }
+                output[produced++] = static_cast<int16_t>(std::clamp<int32_t>(
+                    accumulator >> 15, INT16_MIN, INT16_MAX));
+            }
+            phase_ -= kPhases;
+        }
+        return produced;
+    }
+
+    /**
+     * @brief Moves the filter history to a new block exponent.
+     * @param bits New exponent minus old exponent, see RescaleSamples().
+     */
+    void Rescale(int bits) { RescaleSamples(history_, bits); }
+
+    /**
+     * @brief Clears the filter history.
+     */
+    void Reset() {
+        history_.fill(0);
+        head_ = 0;
+        phase_ = 0;
+    }
+
+   private:
+    static_assert(kPhases <= 1024, "Rate ratio needs too many phases");
+    static_assert(TapsPerPhase >= 4, "TapsPerPhase must be at least 4");
+
+    using Table = std::array<int16_t, kPhases * TapsPerPhase>;
+
+    static constexpr Table MakeCoefficients() {
+        using namespace polyphase_internal;
+        // Kaiser beta for about 70 dB of stopband attenuation.
+        constexpr double kBeta = 7.0;
+        // Cut-off as a fraction of the lower Nyquist frequency, leaving
+        // room for the transition band.
+        constexpr double kCutoffFraction = 0.9;
+
+        constexpr size_t kLength = kPhases * TapsPerPhase;
+        // Cycles per sample at the interpolated rate of L * input rate.
+        const double cutoff = 0.5 * kCutoffFraction / std::max(kPhases, kStep);
+        const double center = (kLength - 1) / 2.0;
+        const double window_scale = 1.0 / BesselI0(kBeta);
+
+        Table table{};
+        for (size_t phase = 0; phase < kPhases; ++phase) {
+            // Output at phase p / L past the newest input sample x[k] is
+            // sum_j h[p + j L] x[k - j]. The taps are stored oldest sample
+            // first to match the history window.
+            double taps[TapsPerPhase] = {};
+            double sum = 0.0;
+            for (size_t j = 0; j < TapsPerPhase; ++j) {
+                const size_t n = phase + j * kPhases;
+                const double t = n - center;
+                const double sinc =
+                    t == 0.0 ? 2.0 * cutoff
+                             : Sin(2.0 * kPi * cutoff * t) / (kPi * t);
+                const double r = 2.0 * n / (kLength - 1) - 1.0;
+                const double window =
+                    BesselI0(kBeta * Sqrt(1.0 - r * r)) * window_scale;
+                taps[TapsPerPhase - 1 - j] = sinc * window;
+                sum += sinc * window;
+            }
+            // Normalise every phase for unity DC gain, so the gain does not
+            // ripple with the phase. The rounding error goes to the largest
+            // tap.
+            int32_t total = 0;
+            size_t largest = 0;
+            for (size_t i = 0; i < TapsPerPhase; ++i) {
+                const double scaled = taps[i] / sum * 32768.0;
+                const int32_t rounded = static_cast<int32_t>(
+                    scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+                table[phase * TapsPerPhase + i] =
+                    static_cast<int16_t>(rounded);
+                total += rounded;
+                if (taps[i] > taps[largest]) {
+                    largest = i;
+                }
+            }
+            table[phase * TapsPerPhase + largest] = static_cast<int16_t>(
+                table[phase * TapsPerPhase + largest] + 32768 - total);
+        }
+        return table;
+    }
+
+    static constexpr Table kCoefficients = MakeCoefficients();
+
+    std::array<int16_t, 2 * TapsPerPhase> history_{};
+    size_t head_ = 0;
+    // Time of the next output past the newest input sample, in 1 / L input
+    // samples. Exact, so the output count never drifts.
+    uint32_t phase_ = 0;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_POLYPHASE_RESAMPLER_HPP_
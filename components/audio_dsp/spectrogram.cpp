@@ -0,0 +1,90 @@
+#include "spectrogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+namespace {
+constexpr float kPi = 3.14159265358979f;
+// Magnitude of an int16 full-scale sample.
+constexpr float kFullScale = 32768.0f;
+}  // namespace
+
+Spectrogram::Spectrogram(const Config& config)
+    : config_(config),
+      hop_samples_(static_cast<size_t>(
+          std::lround(config.sample_rate_hz / config.frame_rate_hz))) {
+    config_.bands = std::clamp<size_t>(config_.bands, 1, kMaxBands);
+
+    float window_energy = 0.0f;
+    for (size_t n = 0; n < kFftSize; ++n) {
+        window_[n] = 0.5f - 0.5f * std::cos(2.0f * kPi * n / kFftSize);
+        window_energy += window_[n] * window_[n];
+    }
+    // A unit sine puts half of N * sum(w^2) / 2 into the positive bins.
+    energy_scale_ = 4.0f / (kFftSize * window_energy);
+
+    // Log-spaced band edges, each band at least one bin wide and the top
+    // band ending below Nyquist.
+    const float bin_hz = static_cast<float>(config_.sample_rate_hz) / kFftSize;
+    const float ratio = config_.max_frequency_hz / config_.min_frequency_hz;
+    for (size_t b = 0; b <= config_.bands; ++b) {
+        const float edge_hz =
+            config_.min_frequency_hz *
+            std::pow(ratio, static_cast<float>(b) / config_.bands);
+        size_t bin = static_cast<size_t>(std::lround(edge_hz / bin_hz));
+        if (b > 0) {
+            bin = std::max<size_t>(bin, band_edges_[b - 1] + 1);
+        }
+        band_edges_[b] =
+            static_cast<uint16_t>(std::clamp<size_t>(bin, 1, kFftSize / 2));
+    }
+}
+
+bool Spectrogram::Process(std::span<const int16_t> frame, int8_t exponent) {
+    const float scale = std::ldexp(1.0f / kFullScale, exponent);
+    bool ready = false;
+    for (size_t i = 0; i < frame.size(); ++i) {
+        history_[history_position_] = frame[i] * scale;
+        history_position_ = (history_position_ + 1) % kFftSize;
+        if (++hop_fill_ < hop_samples_) {
+            continue;
+        }
+        hop_fill_ = 0;
+        ComputeBands();
+        sample_offset_ = i;
+        ready = true;
+    }
+    return ready;
+}
+
+void Spectrogram::Reset() {
+    history_.fill(0.0f);
+    history_position_ = 0;
+    hop_fill_ = 0;
+}
+
+void Spectrogram::ComputeBands() {
+    // history_position_ is the oldest sample.
+    for (size_t n = 0; n < kFftSize; ++n) {
+        spectrum_[n] = std::complex<float>(
+            history_[(history_position_ + n) % kFftSize] * window_[n], 0.0f);
+    }
+    fft_.Forward(std::span<std::complex<float>, kFftSize>(spectrum_));
+
+    constexpr float kMaxValue = 255.0f;
+    for (size_t b = 0; b < config_.bands; ++b) {
+        float energy = 0.0f;
+        for (size_t k = band_edges_[b]; k < band_edges_[b + 1]; ++k) {
+            energy += std::norm(spectrum_[k]);
+        }
+        // The epsilon keeps silence finite, far below the floor.
+        const float db = 10.0f * std::log10(energy * energy_scale_ + 1e-20f);
+        const float value = (db - config_.floor_db) / config_.step_db;
+        bands_[b] = static_cast<uint8_t>(
+            std::clamp(std::round(value), 0.0f, kMaxValue));
+    }
+}
+
+}  // namespace dsp
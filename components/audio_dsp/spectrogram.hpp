@@ -0,0 +1,100 @@
+#ifndef AUDIO_DSP_SPECTROGRAM_HPP_
+#define AUDIO_DSP_SPECTROGRAM_HPP_
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "fft.hpp"
+
+namespace dsp {
+
+/**
+ * @class Spectrogram
+ * @brief Computes quantised log-magnitude band frames for display.
+ *
+ * Every hop (sample rate / frame rate samples) the newest kFftSize samples
+ * are Hann windowed and transformed. The one-sided power spectrum is summed
+ * into log-spaced bands, converted to dB relative to a full-scale sine and
+ * quantised in `step_db` steps above `floor_db`, so a band is one byte.
+ * Every band spans at least one FFT bin, so the lowest bands grow wider
+ * than their log spacing when the resolution runs out.
+ */
+class Spectrogram {
+   public:
+    static constexpr size_t kFftSize = 1024;
+    static constexpr size_t kMaxBands = 64;
+
+    struct Config {
+        uint32_t sample_rate_hz = 44100;
+        float frame_rate_hz = 30.0f;
+        size_t bands = 32;
+        float min_frequency_hz = 60.0f;
+        float max_frequency_hz = 16000.0f;
+        float floor_db = -110.0f;  // dBFS of quantised value 0
+        float step_db = 0.5f;      // dB per quantisation step
+    };
+
+    explicit Spectrogram(const Config& config);
+
+    /**
+     * @brief Feeds a capture frame.
+     *
+     * The hop is longer than any capture frame, so at most one band frame
+     * completes per call.
+     *
+     * @param frame PCM samples, in capture order.
+     * @param exponent Block exponent of the frame: samples times
+     * 2^exponent are at the nominal scale.
+     * @return true if a new band frame is available from GetBands().
+     */
+    bool Process(std::span<const int16_t> frame, int8_t exponent);
+
+    /**
+     * @brief Returns the newest band frame, lowest band first.
+     */
+    std::span<const uint8_t> GetBands() const {
+        return std::span<const uint8_t>(bands_.data(), config_.bands);
+    }
+
+    /**
+     * @brief Returns the frame offset of the last sample of the newest band
+     * frame's window, valid after Process() returned true.
+     */
+    size_t GetSampleOffset() const { return sample_offset_; }
+
+    /**
+     * @brief Clears the sample history.
+     */
+    void Reset();
+
+   private:
+    /**
+     * @brief Transforms the current window into a band frame.
+     */
+    void ComputeBands();
+
+    Config config_;
+    size_t hop_samples_;
+    // Normalises band energy to a full-scale sine.
+    float energy_scale_;
+
+    std::array<float, kFftSize> history_{};
+    size_t history_position_ = 0;
+    size_t hop_fill_ = 0;
+
+    std::array<float, kFftSize> window_;
+    // FFT bin range of every band: [band_edges_[b], band_edges_[b + 1]).
+    std::array<uint16_t, kMaxBands + 1> band_edges_{};
+    Fft<kFftSize> fft_;
+    std::array<std::complex<float>, kFftSize> spectrum_;
+
+    std::array<uint8_t, kMaxBands> bands_{};
+    size_t sample_offset_ = 0;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_SPECTROGRAM_HPP_
@@ -0,0 +1,138 @@
+#include "spectrogram_codec.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace dsp {
+
+namespace {
+constexpr size_t kMaxTokenCount = 64;
+
+bool FitsBits(int value, int bits) {
+    return value >= -(1 << (bits - 1)) && value < (1 << (bits - 1));
+}
+
+int SignExtend(uint8_t value, int bits) {
+    const int shift = 32 - bits;
+    return static_cast<int32_t>(static_cast<uint32_t>(value) << shift) >>
+           shift;
+}
+}  // namespace
+
+SpectrogramEncoder::SpectrogramEncoder(size_t bands, uint8_t deadband)
+    : bands_(std::min(bands, SpectrogramCodec::kMaxBands)),
+      deadband_(deadband) {}
+
+size_t SpectrogramEncoder::Encode(std::span<const uint8_t> frame,
+                                  bool keyframe, std::span<uint8_t> out) {
+    if (frame.size() < bands_ ||
+        out.size() < SpectrogramCodec::MaxEncodedSize(bands_)) {
+        return 0;
+    }
+
+    std::array<int, SpectrogramCodec::kMaxBands> delta;
+    for (size_t b = 0; b < bands_; ++b) {
+        delta[b] = frame[b] - previous_[b];
+        if (!keyframe && std::abs(delta[b]) <= deadband_) {
+            delta[b] = 0;
+        }
+    }
+
+    size_t length = 0;
+    size_t b = 0;
+    while (b < bands_) {
+        const int d = delta[b];
+        if (keyframe || !FitsBits(d, 6)) {
+            // Absolute values for this band and any following large jumps.
+            size_t count = 0;
+            while (b + count < bands_ && count < kMaxTokenCount &&
+                   (keyframe || !FitsBits(delta[b + count], 6))) {
+                ++count;
+            }
+            out[length++] = SpectrogramCodec::kTokenLiteral |
+                            static_cast<uint8_t>(count - 1);
+            for (size_t i = 0; i < count; ++i) {
+                previous_[b + i] = frame[b + i];
+                out[length++] = frame[b + i];
+            }
+            b += count;
+        } else if (d == 0) {
+            size_t count = 1;
+            while (b + count < bands_ && count < kMaxTokenCount &&
+                   delta[b + count] == 0) {
+                ++count;
+            }
+            out[length++] =
+                SpectrogramCodec::kTokenRun | static_cast<uint8_t>(count - 1);
+            b += count;
+        } else if (b + 1 < bands_ && FitsBits(d, 3) &&
+                   FitsBits(delta[b + 1], 3)) {
+            out[length++] = SpectrogramCodec::kTokenDeltaPair |
+                            static_cast<uint8_t>((d & 0x07) << 3) |
+                            static_cast<uint8_t>(delta[b + 1] & 0x07);
+            previous_[b] = static_cast<uint8_t>(previous_[b] + d);
+            previous_[b + 1] = static_cast<uint8_t>(previous_[b + 1] +
+                                                    delta[b + 1]);
+            b += 2;
+        } else {
+            out[length++] = SpectrogramCodec::kTokenDelta |
+                            static_cast<uint8_t>(d & 0x3F);
+            previous_[b] = static_cast<uint8_t>(previous_[b] + d);
+            ++b;
+        }
+    }
+    return length;
+}
+
+SpectrogramDecoder::SpectrogramDecoder(size_t bands)
+    : bands_(std::min(bands, SpectrogramCodec::kMaxBands)) {}
+
+std::span<const uint8_t> SpectrogramDecoder::Decode(
+    std::span<const uint8_t> data, size_t& consumed) {
+    std::array<uint8_t, SpectrogramCodec::kMaxBands> frame = frame_;
+    size_t index = 0;
+    size_t b = 0;
+    while (b < bands_) {
+        if (index == data.size()) {
+            return {};
+        }
+        const uint8_t token = data[index++];
+        const size_t count = (token & ~SpectrogramCodec::kTokenMask) + 1;
+        switch (token & SpectrogramCodec::kTokenMask) {
+            case SpectrogramCodec::kTokenRun:
+                if (b + count > bands_) {
+                    return {};
+                }
+                b += count;
+                break;
+            case SpectrogramCodec::kTokenDelta:
+                frame[b] = static_cast<uint8_t>(frame[b] +
+                                                SignExtend(token & 0x3F, 6));
+                ++b;
+                break;
+            case SpectrogramCodec::kTokenDeltaPair:
+                if (b + 2 > bands_) {
+                    return {};
+                }
+                frame[b] = static_cast<uint8_t>(
+                    frame[b] + SignExtend((token >> 3) & 0x07, 3));
+                frame[b + 1] = static_cast<uint8_t>(
+                    frame[b + 1] + SignExtend(token & 0x07, 3));
+                b += 2;
+                break;
+            default:
+                if (b + count > bands_ || index + count > data.size()) {
+                    return {};
+                }
+                std::copy_n(&data[index], count, &frame[b]);
+                index += count;
+                b += count;
+                break;
+        }
+    }
+    frame_ = frame;
+    consumed = index;
+    return std::span<const uint8_t>(frame_.data(), bands_);
+}
+
+}  // namespace dsp
@@ -0,0 +1,108 @@
+#ifndef AUDIO_DSP_SPECTROGRAM_CODEC_HPP_
+#define AUDIO_DSP_SPECTROGRAM_CODEC_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace dsp {
+
+/**
+ * @brief Temporal delta coding of uint8 band frames.
+ *
+ * Each frame is coded against the previously decoded frame as a sequence
+ * of tokens, which together cover every band exactly once:
+ * - 00nnnnnn: the next n + 1 bands are unchanged.
+ * - 01dddddd: the next band changes by d, a 6-bit signed value (-32..31).
+ * - 10aaabbb: the next two bands change by a and b, 3-bit signed values
+ *   (-4..3).
+ * - 11nnnnnn: n + 1 absolute band values follow.
+ * A keyframe is coded with absolute values only, so it decodes without
+ * history. Frames are self-delimiting given the band count.
+ */
+struct SpectrogramCodec {
+    static constexpr size_t kMaxBands = 64;
+    static constexpr uint8_t kTokenRun = 0x00;
+    static constexpr uint8_t kTokenDelta = 0x40;
+    static constexpr uint8_t kTokenDeltaPair = 0x80;
+    static constexpr uint8_t kTokenLiteral = 0xC0;
+    static constexpr uint8_t kTokenMask = 0xC0;
+
+    /**
+     * @brief Upper bound of a coded frame.
+     *
+     * Reached by delta frames that alternate large jumps, each a one-value
+     * literal of two bytes, with single small deltas: three bytes for every
+     * two bands. Keyframes take one token per kMaxBands values.
+     */
+    static constexpr size_t MaxEncodedSize(size_t bands) {
+        return bands + (bands + 1) / 2;
+    }
+};
+
+/**
+ * @class SpectrogramEncoder
+ * @brief Codes band frames as deltas against the previous frame.
+ *
+ * Changes of at most `deadband` steps are dropped, which turns the
+ * frame-to-frame jitter of steady sounds into unchanged runs. The encoder
+ * tracks the decoder's reconstruction, so dropped changes never accumulate
+ * into drift.
+ */
+class SpectrogramEncoder {
+   public:
+    /**
+     * @param bands Bands per frame, at most SpectrogramCodec::kMaxBands.
+     * @param deadband Largest change, in quantisation steps, sent as
+     * "unchanged".
+     */
+    SpectrogramEncoder(size_t bands, uint8_t deadband);
+
+    /**
+     * @brief Codes one frame.
+     * @param frame The band values, `bands` long.
+     * @param keyframe true to code absolute values that decode without
+     * history.
+     * @param[out] out At least SpectrogramCodec::MaxEncodedSize(bands) bytes.
+     * @return Number of bytes written to `out`, or 0 if `frame` or `out` is
+     * too short; the encoder state is then unchanged.
+     */
+    size_t Encode(std::span<const uint8_t> frame, bool keyframe,
+                  std::span<uint8_t> out);
+
+    size_t GetBands() const { return bands_; }
+
+   private:
+    size_t bands_;
+    uint8_t deadband_;
+    // The frame as the decoder reconstructs it.
+    std::array<uint8_t, SpectrogramCodec::kMaxBands> previous_{};
+};
+
+/**
+ * @class SpectrogramDecoder
+ * @brief Reconstructs band frames coded by SpectrogramEncoder.
+ */
+class SpectrogramDecoder {
+   public:
+    explicit SpectrogramDecoder(size_t bands);
+
+    /**
+     * @brief Decodes one frame.
+     * @param data Coded bytes, starting at a frame boundary.
+     * @param[out] consumed Number of bytes the frame occupied.
+     * @return The decoded frame, or an empty span if `data` is truncated or
+     * malformed.
+     */
+    std::span<const uint8_t> Decode(std::span<const uint8_t> data,
+                                    size_t& consumed);
+
+   private:
+    size_t bands_;
+    std::array<uint8_t, SpectrogramCodec::kMaxBands> frame_{};
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_SPECTROGRAM_CODEC_HPP_
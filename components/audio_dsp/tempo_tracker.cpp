@@ -0,0 +1,124 @@
+#include "tempo_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+namespace {
+constexpr float kMicrosPerMinute = 60.0f * 1000.0f * 1000.0f;
+}  // namespace
+
+TempoTracker::TempoTracker(const Config& config) : config_(config) {}
+
+void TempoTracker::Reset() {
+    histogram_.fill(0.0f);
+    history_count_ = 0;
+    history_head_ = 0;
+    last_beat_us_ = 0;
+    has_beat_ = false;
+}
+
+std::optional<TempoTracker::Beat> TempoTracker::OnOnset(int64_t onset_time_us) {
+    for (float& bin : histogram_) {
+        bin *= config_.histogram_decay;
+    }
+
+    const int64_t max_interval_us =
+        static_cast<int64_t>(config_.max_interval_ms) * 1000;
+    // Walk the history from the newest onset backwards. Intervals that span
+    // more onsets get a smaller vote, which keeps the estimate from locking
+    // onto a multiple of the true beat period.
+    for (size_t rank = 1; rank <= history_count_; ++rank) {
+        const size_t index =
+            (history_head_ + kHistoryLength - rank) % kHistoryLength;
+        const int64_t interval_us = onset_time_us - onset_history_[index];
+        if (interval_us > max_interval_us) {
+            break;
+        }
+        if (interval_us > 0) {
+            AccumulateInterval(interval_us, 1.0f / rank);
+        }
+    }
+
+    onset_history_[history_head_] = onset_time_us;
+    history_head_ = (history_head_ + 1) % kHistoryLength;
+    history_count_ = std::min(history_count_ + 1, kHistoryLength);
+
+    std::optional<Beat> tempo = EstimateTempo();
+    if (!tempo) {
+        return std::nullopt;
+    }
+
+    // Phase check against the grid anchored at the previous beat. The first
+    // confident onset simply anchors the grid.
+    const float period_us = kMicrosPerMinute / tempo->bpm;
+    bool on_grid = !has_beat_;
+    if (has_beat_) {
+        const float elapsed = static_cast<float>(onset_time_us - last_beat_us_);
+        const float phase = std::fmod(elapsed, period_us) / period_us;
+        on_grid = phase < config_.phase_tolerance ||
+                  phase > 1.0f - config_.phase_tolerance;
+    }
+    if (!on_grid) {
+        return std::nullopt;
+    }
+
+    last_beat_us_ = onset_time_us;
+    has_beat_ = true;
+    return tempo;
+}
+
+void TempoTracker::AccumulateInterval(int64_t interval_us, float weight) {
+    // Fold the interval into the tracked range by octaves so that half and
+    // double time intervals reinforce the same tempo.
+    float bpm = kMicrosPerMinute / static_cast<float>(interval_us);
+    while (bpm < kMinBpm) {
+        bpm *= 2.0f;
+    }
+    while (bpm >= kMaxBpm) {
+        bpm *= 0.5f;
+    }
+
+    // Spread the vote over the two nearest bins.
+    const float position = bpm - kMinBpm;
+    const size_t lower = static_cast<size_t>(position);
+    const float fraction = position - lower;
+    histogram_[lower] += weight * (1.0f - fraction);
+    if (lower + 1 < kBinCount) {
+        histogram_[lower + 1] += weight * fraction;
+    }
+}
+
+std::optional<TempoTracker::Beat> TempoTracker::EstimateTempo() const {
+    float total = 0.0f;
+    size_t peak = 0;
+    for (size_t i = 0; i < kBinCount; ++i) {
+        total += histogram_[i];
+        if (histogram_[i] > histogram_[peak]) {
+            peak = i;
+        }
+    }
+    if (total <= 0.0f) {
+        return std::nullopt;
+    }
+
+    // Count the direct neighbours as part of the peak, since votes are split
+    // between adjacent bins.
+    const float left = peak > 0 ? histogram_[peak - 1] : 0.0f;
+    const float right = peak + 1 < kBinCount ? histogram_[peak + 1] : 0.0f;
+    const float confidence = (histogram_[peak] + left + right) / total;
+    if (confidence < config_.min_confidence) {
+        return std::nullopt;
+    }
+
+    float offset = 0.0f;
+    const float curvature = left - 2.0f * histogram_[peak] + right;
+    if (curvature < 0.0f) {
+        offset = 0.5f * (left - right) / curvature;
+    }
+
+    return Beat{.bpm = kMinBpm + peak + offset, .confidence = confidence};
+}
+
+}  // namespace dsp
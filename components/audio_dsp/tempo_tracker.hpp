@@ -0,0 +1,75 @@
+#ifndef AUDIO_DSP_TEMPO_TRACKER_HPP_
+#define AUDIO_DSP_TEMPO_TRACKER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace dsp {
+
+/**
+ * @class TempoTracker
+ * @brief Estimates the tempo of a stream of onsets and marks those that fall
+ * on the beat grid.
+ *
+ * Every new onset is paired with the recent onset history. Each inter-onset
+ * interval is folded into the tracked BPM range and accumulated into a
+ * decaying tempo histogram, whose peak (refined by parabolic interpolation)
+ * is the tempo estimate. An onset is reported as a beat when the estimate is
+ * confident and the onset lands close to the beat grid anchored at the
+ * previous beat.
+ */
+class TempoTracker {
+   public:
+    static constexpr uint32_t kMinBpm = 60;
+    static constexpr uint32_t kMaxBpm = 200;
+
+    struct Config {
+        float histogram_decay = 0.92f;  // Applied once per onset
+        float min_confidence = 0.25f;   // Peak share of the histogram mass
+        float phase_tolerance = 0.15f;  // Allowed beat error, in periods
+        uint32_t max_interval_ms = 2000;
+    };
+
+    /**
+     * @brief A beat aligned with the current tempo estimate.
+     */
+    struct Beat {
+        float bpm;
+        float confidence;
+    };
+
+    explicit TempoTracker(const Config& config);
+
+    /**
+     * @brief Feeds a detected onset into the tracker.
+     * @param onset_time_us Capture time of the onset in microseconds.
+     * @return The beat if this onset lies on the beat grid, or std::nullopt.
+     */
+    std::optional<Beat> OnOnset(int64_t onset_time_us);
+
+    /**
+     * @brief Clears the onset history and tempo histogram.
+     */
+    void Reset();
+
+   private:
+    static constexpr size_t kHistoryLength = 8;
+    static constexpr size_t kBinCount = kMaxBpm - kMinBpm;
+
+    void AccumulateInterval(int64_t interval_us, float weight);
+    std::optional<Beat> EstimateTempo() const;
+
+    Config config_;
+    std::array<float, kBinCount> histogram_{};
+    std::array<int64_t, kHistoryLength> onset_history_{};
+    size_t history_count_ = 0;
+    size_t history_head_ = 0;
+    int64_t last_beat_us_ = 0;
+    bool has_beat_ = false;
+};
+
+}  // namespace dsp
+
+#endif  // AUDIO_DSP_TEMPO_TRACKER_HPP_
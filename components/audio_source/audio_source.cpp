@@ -1,5 +1,6 @@
 #include "audio_source.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstdint>
@@ -11,6 +12,7 @@
 #include "driver/i2s_pdm.h"
 #include "driver/i2s_std.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "hal/i2s_types.h"
 
@@ -18,35 +20,57 @@
 namespace audio {
 static const char* kTag = "AudioSource";
 
-// I2S peripheral configuration
-constexpr i2s_port_t kI2sPort = I2S_NUM_AUTO;
-constexpr uint32_t kI2sSampleRate = 44100;  // 44.1 kHz
+// I2S peripheral configuration. Only I2S0 has the PDM-to-PCM filter on
+// the S3, so PDM capture must claim it; the other modes take any port.
+constexpr i2s_port_t kI2sPdmPort = I2S_NUM_0;
+constexpr i2s_port_t kI2sStdPort = I2S_NUM_AUTO;
+constexpr uint32_t kI2sSampleRate = AudioSource::kSampleRateHz;
 constexpr i2s_data_bit_width_t kI2sBitsPerSample = I2S_DATA_BIT_WIDTH_32BIT;
 constexpr uint32_t kDmaBufferCount = 16;
-constexpr uint32_t kDmaBufferSamples = 1024;
+// One DMA buffer per analysis frame. A read only completes once a whole DMA
+// buffer has been received, so this bounds the capture latency to one frame
+// (~5.8 ms) instead of a 1024-sample buffer (~23 ms).
+constexpr uint32_t kDmaBufferSamples = AudioSource::kMaxFrameSamples;
 
 // GPIO pin configuration
 constexpr gpio_num_t kI2sStdGpioWs = GPIO_NUM_4;
 constexpr gpio_num_t kI2sStdGpioBclk = GPIO_NUM_5;
 constexpr gpio_num_t kI2sStdGpioDin = GPIO_NUM_6;
+// PDM microphones share the bit clock and data pins.
+constexpr gpio_num_t kI2sPdmGpioClk = GPIO_NUM_5;
+constexpr gpio_num_t kI2sPdmGpioDin = GPIO_NUM_6;
 
 // Conversion constants
-constexpr int16_t kAdcToPcmBitShift = 12;
+constexpr int16_t kAdcToPcmBitShift = 12;  // Nominal shift, exponent 0
+
+// Adaptive headroom. Any clipped sample raises the shift (6 dB less gain)
+// at once; the gain only comes back after a second with peaks below
+// -12 dBFS, leaving a 6 dB hysteresis band.
+constexpr uint32_t kBoostMagnitudeLimit = 1u << 13;
+constexpr uint32_t kQuietFramesToBoost =
+    AudioSource::kSampleRateHz / AudioSource::kMaxFrameSamples;
+
+// Microphone pair geometry of the kStereoBeamform mode
+constexpr float kMicSpacingMm = 20.0f;
 
 // Limitation constants
-constexpr size_t kMaxAudioSamples = 256;
+constexpr size_t kMaxAudioSamples = AudioSource::kMaxFrameSamples;
 
 // Feature extraction constants
 constexpr double kReferenceRms = 20.0;
 constexpr float kMaxDbLevel = 96.0f;
 
 // --- Static Factory Method ---
-std::unique_ptr<AudioSource> AudioSource::Create() {
-    ESP_LOGI(kTag, "Attempting to create and initialize AudioSource...");
+std::unique_ptr<AudioSource> AudioSource::Create(CaptureMode mode) {
+    ESP_LOGI(kTag, "Attempting to create and initialize AudioSource (%s)...",
+             mode == CaptureMode::kPdm               ? "PDM"
+             : mode == CaptureMode::kStereoBeamform ? "stereo"
+                                                    : "standard");
 
     // Configure the I2S channel
-    i2s_chan_config_t chan_cfg =
-        I2S_CHANNEL_DEFAULT_CONFIG(kI2sPort, I2S_ROLE_MASTER);
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(
+        mode == CaptureMode::kPdm ? kI2sPdmPort : kI2sStdPort,
+        I2S_ROLE_MASTER);
     chan_cfg.dma_desc_num = kDmaBufferCount;
     chan_cfg.dma_frame_num = kDmaBufferSamples;
     chan_cfg.auto_clear = true;  // Auto clear TX buffer on underflow
@@ -59,11 +83,80 @@ std::unique_ptr<AudioSource> AudioSource::Create() {
         return nullptr;
     }
 
+    // Initialize and enable the channel
+    err = mode == CaptureMode::kPdm
+              ? InitPdmMode(rx_handle)
+              : InitStandardMode(rx_handle,
+                                 mode == CaptureMode::kStereoBeamform);
+    if (err != ESP_OK) {
+        i2s_del_channel(rx_handle);  // Clean up partially acquired resource
+        return nullptr;
+    }
+
+    // Use `new` because constructor is private. std::make_unique cannot access it.
+    std::unique_ptr<AudioSource> source(new AudioSource(rx_handle, mode));
+
+    // The DMA callbacks timestamp every received buffer.
+    err = source->RegisterCallbacks();
+    if (err != ESP_OK) {
+        ESP_LOGE(kTag, "Failed to register I2S callbacks: %s",
+                 esp_err_to_name(err));
+        source->rx_handle_ = nullptr;
+        i2s_del_channel(rx_handle);  // Clean up partially acquired resource
+        return nullptr;
+    }
+
+    err = i2s_channel_enable(rx_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(kTag, "Failed to enable I2S channel: %s",
+                 esp_err_to_name(err));
+        source->rx_handle_ = nullptr;
+        i2s_del_channel(rx_handle);  // Clean up partially acquired resource
+        return nullptr;
+    }
+
+    ESP_LOGI(kTag, "AudioSource created successfully.");
+    return source;
+}
+
+esp_err_t AudioSource::RegisterCallbacks() {
+    i2s_event_callbacks_t callbacks = {
+        .on_recv = OnDmaReceive,
+        .on_recv_q_ovf = OnDmaOverflow,
+        .on_sent = nullptr,
+        .on_send_q_ovf = nullptr,
+    };
+    return i2s_channel_register_event_callback(rx_handle_, &callbacks, this);
+}
+
+bool IRAM_ATTR AudioSource::OnDmaReceive(i2s_chan_handle_t handle,
+                                         i2s_event_data_t* event,
+                                         void* user_ctx) {
+    AudioSource* self = static_cast<AudioSource*>(user_ctx);
+    const int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&self->timeline_lock_);
+    ++self->dma_receive_count_;
+    self->dma_receive_time_us_ = now_us;
+    portEXIT_CRITICAL_ISR(&self->timeline_lock_);
+    return false;
+}
+
+bool IRAM_ATTR AudioSource::OnDmaOverflow(i2s_chan_handle_t handle,
+                                          i2s_event_data_t* event,
+                                          void* user_ctx) {
+    AudioSource* self = static_cast<AudioSource*>(user_ctx);
+    self->dma_overflow_count_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+esp_err_t AudioSource::InitStandardMode(i2s_chan_handle_t handle,
+                                        bool stereo) {
     // Configure the I2S standard mode
     i2s_std_config_t std_cfg = {
         .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(kI2sSampleRate),
-        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(kI2sBitsPerSample,
-                                                    I2S_SLOT_MODE_MONO),
+        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(
+            kI2sBitsPerSample,
+            stereo ? I2S_SLOT_MODE_STEREO : I2S_SLOT_MODE_MONO),
         .gpio_cfg =
             {
                 .mclk = I2S_GPIO_UNUSED,
@@ -79,29 +172,41 @@ std::unique_ptr<AudioSource> AudioSource::Create() {
                     },
             },
     };
-    std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;  // Use left slot for mono
+    // Use left slot for mono, both slots for a microphone pair
+    std_cfg.slot_cfg.slot_mask = stereo ? I2S_STD_SLOT_BOTH : I2S_STD_SLOT_LEFT;
 
-    // Initialize and enable the channel
-    err = i2s_channel_init_std_mode(rx_handle, &std_cfg);
+    esp_err_t err = i2s_channel_init_std_mode(handle, &std_cfg);
     if (err != ESP_OK) {
         ESP_LOGE(kTag, "Failed to initialize I2S channel in std mode: %s",
                  esp_err_to_name(err));
-        i2s_del_channel(rx_handle);  // Clean up partially acquired resource
-        return nullptr;
     }
+    return err;
+}
 
-    err = i2s_channel_enable(rx_handle);
+esp_err_t AudioSource::InitPdmMode(i2s_chan_handle_t handle) {
+    // The PDM RX path runs the peripheral's PDM-to-PCM filter, which
+    // decimates the 1-bit stream to 16-bit PCM at the configured rate.
+    i2s_pdm_rx_config_t pdm_cfg = {
+        .clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(kI2sSampleRate),
+        .slot_cfg = I2S_PDM_RX_SLOT_PCM_FMT_DEFAULT_CONFIG(
+            I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg =
+            {
+                .clk = kI2sPdmGpioClk,
+                .din = kI2sPdmGpioDin,
+                .invert_flags =
+                    {
+                        .clk_inv = false,
+                    },
+            },
+    };
+
+    esp_err_t err = i2s_channel_init_pdm_rx_mode(handle, &pdm_cfg);
     if (err != ESP_OK) {
-        ESP_LOGE(kTag, "Failed to enable I2S channel: %s",
+        ESP_LOGE(kTag, "Failed to initialize I2S channel in PDM mode: %s",
                  esp_err_to_name(err));
-        i2s_del_channel(rx_handle);  // Clean up partially acquired resource
-        return nullptr;
     }
-
-    ESP_LOGI(kTag, "AudioSource created successfully.");
-
-    // Use `new` because constructor is private. std::make_unique cannot access it.
-    return std::unique_ptr<AudioSource>(new AudioSource(rx_handle));
+    return err;
 }
 
 // --- Read Method ---
@@ -125,11 +230,107 @@ esp_err_t AudioSource::Read(std::span<int16_t> dest_buffer,
         return ESP_OK;
     }
 
-    // Temp buffer
-    std::array<int32_t, kMaxAudioSamples> bit32_buffer;
+    // After the driver dropped buffers (nobody was reading), the position
+    // of the next read in the capture stream is unknown. Empty the queue so
+    // the next buffer read is the next one received.
+    const uint32_t overflows =
+        dma_overflow_count_.load(std::memory_order_relaxed);
+    const bool anchor = needs_anchor_ || overflows != seen_overflow_count_;
+    if (anchor) {
+        DrainDmaQueue();
+        seen_overflow_count_ = overflows;
+    }
+
+    ConversionStats stats;
+    esp_err_t ret;
+    frame_shift_ = shift_;
+    switch (mode_) {
+        case CaptureMode::kPdm:
+            ret = ReadPdm(dest_buffer, samples_read, stats);
+            break;
+        case CaptureMode::kStereoBeamform:
+            ret = ReadStereo(dest_buffer, samples_read, stats);
+            break;
+        default:
+            ret = ReadStandard(dest_buffer, samples_read, stats);
+            break;
+    }
+    last_frame_energy_ = ret == ESP_OK ? stats.sum_of_squares : 0;
+    if (ret == ESP_OK) {
+        UpdateTimeline(samples_read, anchor);
+        UpdateHeadroom(stats);
+    }
+    return ret;
+}
+
+void AudioSource::DrainDmaQueue() {
     size_t bytes_read = 0;
+    while (i2s_channel_read(rx_handle_, raw_buffer_.data(),
+                            raw_buffer_.size() * sizeof(int32_t), &bytes_read,
+                            0) == ESP_OK &&
+           bytes_read > 0) {
+    }
+}
+
+void AudioSource::UpdateTimeline(size_t samples_read, bool anchor) {
+    portENTER_CRITICAL(&timeline_lock_);
+    const uint64_t receive_count = dma_receive_count_;
+    const int64_t receive_time_us = dma_receive_time_us_;
+    portEXIT_CRITICAL(&timeline_lock_);
+
+    if (anchor) {
+        // The queue was empty, so the frame just read ends the newest
+        // received DMA buffer. Index samples by received buffers, which
+        // keeps dropped buffers in the count.
+        next_sample_index_ = receive_count * kDmaBufferSamples;
+        needs_anchor_ = false;
+    } else {
+        next_sample_index_ += samples_read;
+    }
+    last_frame_index_ = next_sample_index_ - samples_read;
+
+    // The newest received buffer ended with this sample at that time.
+    if (receive_count > 0) {
+        sample_clock_.Observe(receive_count * kDmaBufferSamples - 1,
+                              receive_time_us);
+    }
+}
 
-    esp_err_t ret = i2s_channel_read(rx_handle_, bit32_buffer.data(),
+void AudioSource::UpdateHeadroom(const ConversionStats& stats) {
+    if (stats.clipped_samples > 0) {
+        headroom_stats_.clipped_samples += stats.clipped_samples;
+        ++headroom_stats_.clipped_frames;
+    }
+    // PCM from the PDM filter has no slot shift to adapt.
+    if (!adaptive_headroom_ || mode_ == CaptureMode::kPdm) {
+        return;
+    }
+
+    int new_shift = shift_;
+    if (stats.clipped_samples > 0) {
+        new_shift = std::min(shift_ + 1, kMaxPcmShift);
+        quiet_frames_ = 0;
+    } else if (stats.magnitude_bits < kBoostMagnitudeLimit) {
+        if (++quiet_frames_ >= kQuietFramesToBoost) {
+            new_shift = std::max(shift_ - 1, kMinPcmShift);
+            quiet_frames_ = 0;
+        }
+    } else {
+        quiet_frames_ = 0;
+    }
+
+    if (new_shift != shift_) {
+        shift_ = new_shift;
+        ++headroom_stats_.shift_changes;
+    }
+}
+
+esp_err_t AudioSource::ReadStandard(std::span<int16_t> dest_buffer,
+                                    size_t& samples_read,
+                                    ConversionStats& stats) {
+    size_t bytes_read = 0;
+
+    esp_err_t ret = i2s_channel_read(rx_handle_, raw_buffer_.data(),
                                      dest_buffer.size() * sizeof(int32_t),
                                      &bytes_read, portMAX_DELAY);
 
@@ -140,43 +341,90 @@ esp_err_t AudioSource::Read(std::span<int16_t> dest_buffer,
 
     samples_read = bytes_read / sizeof(int32_t);
 
-    // Converse the read buffer
+    // Converse the read buffer, removing the DC offset on the way
     for (size_t i = 0; i < samples_read; i++) {
-        int32_t value = bit32_buffer[i] >> kAdcToPcmBitShift;
+        const int16_t pcm =
+            ConvertSlot(raw_buffer_[i], frame_shift_, dc_blocker_, stats);
+        AccumulateEnergy(pcm, stats);
+        dest_buffer[i] = pcm;
+    }
 
-        int32_t clamped_value =
-            std::clamp(value, static_cast<int32_t>(INT16_MIN),
-                       static_cast<int32_t>(INT16_MAX));
-        dest_buffer[i] = static_cast<int16_t>(clamped_value);
+    return ESP_OK;
+}
+
+esp_err_t AudioSource::ReadStereo(std::span<int16_t> dest_buffer,
+                                  size_t& samples_read,
+                                  ConversionStats& stats) {
+    size_t bytes_read = 0;
+    esp_err_t ret = i2s_channel_read(rx_handle_, raw_buffer_.data(),
+                                     dest_buffer.size() * 2 * sizeof(int32_t),
+                                     &bytes_read, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGE(kTag, "I2S read failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    samples_read = bytes_read / (2 * sizeof(int32_t));
+    stats = beamformer_.Process(
+        std::span<const int32_t>(raw_buffer_.data(), 2 * samples_read),
+        frame_shift_, dest_buffer);
+    return ESP_OK;
+}
+
+esp_err_t AudioSource::ReadPdm(std::span<int16_t> dest_buffer,
+                               size_t& samples_read, ConversionStats& stats) {
+    // The hardware filter already produced 16-bit PCM, so the DMA data is
+    // read straight into the destination frame.
+    size_t bytes_read = 0;
+    esp_err_t ret = i2s_channel_read(rx_handle_, dest_buffer.data(),
+                                     dest_buffer.size_bytes(), &bytes_read,
+                                     portMAX_DELAY);
+    if (ret != ESP_OK) {
+        ESP_LOGE(kTag, "I2S read failed: %s", esp_err_to_name(ret));
+        return ret;
     }
 
+    samples_read = bytes_read / sizeof(int16_t);
+    // The only pass over the frame: remove the microphone's DC offset.
+    for (size_t i = 0; i < samples_read; i++) {
+        const int16_t pcm =
+            ConvertPdmSample(dest_buffer[i], dc_blocker_, stats);
+        AccumulateEnergy(pcm, stats);
+        dest_buffer[i] = pcm;
+    }
     return ESP_OK;
 }
 
 esp_err_t AudioSource::GetFeature(int8_t& feature) {
+    return GetFeature(feature, std::span(frame_buffer_));
+}
+
+esp_err_t AudioSource::GetFeature(int8_t& feature,
+                                  std::span<int16_t> frame_storage) {
     // --- Step 0: Argument and Handle Checks (Same as before) ---
     // (I've removed the checks from this snippet for brevity, but they should remain in your code)
     // if (!feature) return ESP_ERR_INVALID_ARG;
     // if (!rx_handle_) return ESP_FAIL;
 
-    std::array<int16_t, kMaxAudioSamples> frame_buffer;
     size_t samples_read = 0;
 
     // --- Step 1: Read Audio Frame (Same as before) ---
-    esp_err_t ret = Read(std::span(frame_buffer), samples_read);
+    frame_storage = frame_storage.first(
+        std::min(frame_storage.size(), kMaxAudioSamples));
+    esp_err_t ret = Read(frame_storage, samples_read);
+    last_frame_ = frame_storage.first(ret == ESP_OK ? samples_read : 0);
     if (ret != ESP_OK || samples_read == 0) {
         feature = 0;
         return ret;
     }
 
-    // --- Step 2: Calculate RMS Value (Same as before) ---
-    int64_t sum_of_squares = 0;
-    for (size_t i = 0; i < samples_read; ++i) {
-        int32_t sample = frame_buffer[i];
-        sum_of_squares += sample * sample;
-    }
-    const double rms_value =
-        std::sqrt(static_cast<double>(sum_of_squares) / samples_read);
+    // --- Step 2: Calculate RMS Value ---
+    // The energy was summed while converting the frame.
+    // Scale back to the nominal shift so the level stays calibrated when
+    // the adaptive shift changes.
+    const double rms_value = std::ldexp(
+        std::sqrt(static_cast<double>(last_frame_energy_) / samples_read),
+        GetLastFrameExponent());
 
     // --- Step 3: Convert RMS to Decibels (dB) ---
     // This is the new, crucial part.
@@ -202,10 +450,19 @@ esp_err_t AudioSource::GetFeature(int8_t& feature) {
 }
 
 // --- Private Constructor Implementation ---
-AudioSource::AudioSource(i2s_chan_handle_t handle) : rx_handle_(handle) {
+AudioSource::AudioSource(i2s_chan_handle_t handle, CaptureMode mode)
+    : rx_handle_(handle),
+      mode_(mode),
+      beamformer_(kSampleRateHz, kMicSpacingMm),
+      shift_(mode == CaptureMode::kPdm ? 0 : kAdcToPcmBitShift),
+      frame_shift_(shift_) {
     ESP_LOGI(kTag, "AudioSource instance constructed.");
 }
 
+int8_t AudioSource::GetLastFrameExponent() const {
+    return mode_ == CaptureMode::kPdm ? 0 : frame_shift_ - kAdcToPcmBitShift;
+}
+
 // --- Destructor ---
 AudioSource::~AudioSource() {
     if (rx_handle_ != nullptr) {
@@ -217,9 +474,20 @@ AudioSource::~AudioSource() {
 
 // --- Move Constructor ---
 AudioSource::AudioSource(AudioSource&& other) noexcept
-    : rx_handle_(other.rx_handle_) {
+    : rx_handle_(other.rx_handle_),
+      mode_(other.mode_),
+      beamformer_(other.beamformer_),
+      dc_blocker_(other.dc_blocker_),
+      adaptive_headroom_(other.adaptive_headroom_),
+      shift_(other.shift_),
+      frame_shift_(other.frame_shift_),
+      quiet_frames_(other.quiet_frames_),
+      headroom_stats_(other.headroom_stats_) {
     ESP_LOGI(kTag, "AudioSource move constructed.");
     other.rx_handle_ = nullptr;
+    // The last frame may live in the other instance's buffer.
+    other.last_frame_ = {};
+    TakeTimeline(other);
 }
 
 // --- Move Assignment Operator ---
@@ -232,9 +500,43 @@ AudioSource& AudioSource::operator=(AudioSource&& other) noexcept {
         // Transfer ownership of the I2S handle
         rx_handle_ = other.rx_handle_;
         other.rx_handle_ = nullptr;
+        mode_ = other.mode_;
+        beamformer_ = other.beamformer_;
+        dc_blocker_ = other.dc_blocker_;
+        adaptive_headroom_ = other.adaptive_headroom_;
+        shift_ = other.shift_;
+        frame_shift_ = other.frame_shift_;
+        quiet_frames_ = other.quiet_frames_;
+        headroom_stats_ = other.headroom_stats_;
+
+        // The last frame may live in the other instance's buffer.
+        last_frame_ = {};
+        other.last_frame_ = {};
+        TakeTimeline(other);
     }
     ESP_LOGI(kTag, "AudioSource move assigned.");
     return *this;
 }
 
+void AudioSource::TakeTimeline(AudioSource& other) {
+    if (rx_handle_ == nullptr) {
+        return;
+    }
+    // The DMA callbacks hold a pointer to the instance; move them over
+    // while the channel is stopped.
+    i2s_channel_disable(rx_handle_);
+    portENTER_CRITICAL(&other.timeline_lock_);
+    dma_receive_count_ = other.dma_receive_count_;
+    dma_receive_time_us_ = other.dma_receive_time_us_;
+    portEXIT_CRITICAL(&other.timeline_lock_);
+    dma_overflow_count_.store(other.dma_overflow_count_.load());
+    seen_overflow_count_ = other.seen_overflow_count_;
+    needs_anchor_ = true;  // Buffers were lost meanwhile
+    sample_clock_ = other.sample_clock_;
+    next_sample_index_ = other.next_sample_index_;
+    last_frame_index_ = other.last_frame_index_;
+    RegisterCallbacks();
+    i2s_channel_enable(rx_handle_);
+}
+
 }  // namespace audio
@@ -2,11 +2,20 @@
 #define AUDIO_SOURCE_HPP_
 
 #include <cstdint>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <span>
 
+#include "driver/i2s_pdm.h"
 #include "driver/i2s_std.h"
 #include "driver/i2s_types.h"
+#include "freertos/FreeRTOS.h"
+
+#include "beamformer.hpp"
+#include "conversion.hpp"
+#include "dc_blocker.hpp"
+#include "sample_clock.hpp"
 
 namespace audio {
 
@@ -16,16 +25,47 @@ namespace audio {
  */
 class AudioSource {
    public:
+    // Capture sample rate of the I2S channel.
+    static constexpr uint32_t kSampleRateHz = 44100;
+
+    // Maximum number of samples in a single Read() or GetFeature() frame.
+    static constexpr size_t kMaxFrameSamples = 256;
+
+    /**
+     * @brief Clipping and gain statistics since the last reset.
+     */
+    struct HeadroomStats {
+        uint32_t clipped_samples;
+        uint32_t clipped_frames;
+        uint32_t shift_changes;
+    };
+
+    /**
+     * @brief The kind of microphone attached to the I2S port.
+     */
+    enum class CaptureMode : uint8_t {
+        // I2S standard (Philips/MSB) microphone, 32-bit slots.
+        kStandard,
+        // PDM MEMS microphone. The I2S peripheral's hardware PDM-to-PCM
+        // filter delivers 16-bit PCM, so no software decimation is needed.
+        kPdm,
+        // Pair of I2S standard microphones on the left and right slots,
+        // combined by a steerable delay-and-sum beamformer.
+        kStereoBeamform,
+    };
+
     /**
      * @brief Creates and initializes an AudioSampler instance.
      *
      * This factory method handles all I2S peripheral configuration and
      * returns a fully initialized object.
      *
+     * @param mode The microphone interface to configure.
      * @return A std::unique_ptr containing the AudioSampler on success,
      * or nullptr on failure.
      */
-    static std::unique_ptr<AudioSource> Create();
+    static std::unique_ptr<AudioSource> Create(
+        CaptureMode mode = CaptureMode::kStandard);
 
     /**
    * @brief Destroy the AudioSampler object
@@ -57,6 +97,112 @@ class AudioSource {
      */
     esp_err_t GetFeature(int8_t& feature);
 
+    /**
+     * @brief Reads a frame into caller-owned storage and calculates its
+     * feature.
+     *
+     * Behaves like GetFeature(int8_t&), but the samples are converted
+     * straight into `frame_storage`, e.g. a slot of a history ring buffer,
+     * so keeping them costs no extra copy.
+     *
+     * @param[out] feature The calculated and scaled audio feature.
+     * @param frame_storage Destination of the frame, at most
+     * kMaxFrameSamples long. Must stay valid while GetLastFrame() is used.
+     * @return esp_err_t ESP_OK on success, or an error code on failure.
+     */
+    esp_err_t GetFeature(int8_t& feature, std::span<int16_t> frame_storage);
+
+    /**
+     * @brief Returns the PCM frame consumed by the most recent GetFeature().
+     *
+     * This lets further analysis stages run on the same samples without a
+     * second I2S read. The view stays valid until the next GetFeature() call.
+     *
+     * @return A read-only view of the last feature frame.
+     */
+    std::span<const int16_t> GetLastFrame() const { return last_frame_; }
+
+    /**
+     * @brief Returns the sum of squares of the last frame's samples.
+     *
+     * Summed while the frame was converted, so level stages can share it
+     * instead of making their own pass over the frame.
+     */
+    int64_t GetLastFrameEnergy() const { return last_frame_energy_; }
+
+    /**
+     * @brief Returns the capture index of the first sample of the last frame.
+     *
+     * Samples are counted from the first DMA buffer the channel received,
+     * including buffers that were dropped while nobody was reading, so the
+     * index is monotonic and maps linearly to capture time.
+     */
+    uint64_t GetLastFrameSampleIndex() const { return last_frame_index_; }
+
+    /**
+     * @brief Returns the capture time of a sample.
+     * @param sample_index Capture index of the sample.
+     * @return esp_timer time in microseconds, derived from the sample index
+     * and the measured capture rate, see SampleClock.
+     */
+    int64_t GetSampleTimeUs(uint64_t sample_index) const {
+        return sample_clock_.GetTimeUs(sample_index);
+    }
+
+    /**
+     * @brief Returns the measured capture sample rate.
+     * @return The rate in Hz; kSampleRateHz until capture has run a while.
+     */
+    double GetMeasuredSampleRateHz() const {
+        return sample_clock_.GetRateHz();
+    }
+
+    /**
+     * @brief Returns the time at which the last frame finished capturing.
+     * @return esp_timer time in microseconds of the frame's last sample.
+     */
+    int64_t GetLastFrameTimeUs() const {
+        return GetSampleTimeUs(last_frame_index_ + last_frame_.size() - 1);
+    }
+
+    /**
+     * @brief Steers the beam in kStereoBeamform mode; ignored otherwise.
+     * @param angle_deg Direction of arrival: 0 is broadside, +90 the left
+     * microphone's side, -90 the right one's.
+     */
+    void SetSteeringAngle(float angle_deg) { beamformer_.Steer(angle_deg); }
+
+    /**
+     * @brief Enables block-floating-point capture.
+     *
+     * The slot-to-PCM shift then follows the signal level: it grows as soon
+     * as a frame clips and shrinks again after a second of quiet frames.
+     * Frames keep the exponent they were captured with, and the feature
+     * level is corrected for it, so dB values stay calibrated. Has no
+     * effect in kPdm mode.
+     *
+     * @param enabled true to adapt the shift, false for the nominal shift.
+     */
+    void SetAdaptiveHeadroom(bool enabled) { adaptive_headroom_ = enabled; }
+
+    /**
+     * @brief Returns the block exponent of the last frame.
+     *
+     * A sample multiplied by 2^exponent is at the nominal (exponent 0)
+     * scale.
+     */
+    int8_t GetLastFrameExponent() const;
+
+    /**
+     * @brief Returns the clipping statistics since the last reset.
+     */
+    HeadroomStats GetHeadroomStats() const { return headroom_stats_; }
+
+    /**
+     * @brief Clears the clipping statistics.
+     */
+    void ResetHeadroomStats() { headroom_stats_ = {}; }
+
     // Delete the copy constructor and copy assignment operator.
     // An AudioSampler instance represents a unique hardware resource and cannot
     // be copied.
@@ -74,8 +220,79 @@ class AudioSource {
     /**
      * @brief Private constructor to enforce creation via the factory method.
      * @param handle An already initialized I2S channel handle.
+     * @param mode The mode the channel was initialized in.
+     */
+    AudioSource(i2s_chan_handle_t handle, CaptureMode mode);
+
+    /**
+     * @brief Points the channel's DMA event callbacks at this instance.
+     * The channel must not be enabled.
+     */
+    esp_err_t RegisterCallbacks();
+
+    /**
+     * @brief DMA receive ISR: timestamps and counts every received buffer.
+     */
+    static bool OnDmaReceive(i2s_chan_handle_t handle, i2s_event_data_t* event,
+                             void* user_ctx);
+
+    /**
+     * @brief DMA overflow ISR: counts buffers dropped by the driver.
+     */
+    static bool OnDmaOverflow(i2s_chan_handle_t handle,
+                              i2s_event_data_t* event, void* user_ctx);
+
+    /**
+     * @brief Takes over the capture timeline of a moved-from instance and
+     * re-targets the DMA callbacks.
+     */
+    void TakeTimeline(AudioSource& other);
+
+    /**
+     * @brief Discards all queued DMA buffers, so the next read returns the
+     * newest buffer and can be tied to its receive event.
+     */
+    void DrainDmaQueue();
+
+    /**
+     * @brief Assigns sample indices to the frame just read.
+     */
+    void UpdateTimeline(size_t samples_read, bool anchor);
+
+    /**
+     * @brief Configures a new channel for one standard I2S microphone, or
+     * for a pair of them on both slots.
+     */
+    static esp_err_t InitStandardMode(i2s_chan_handle_t handle, bool stereo);
+
+    /**
+     * @brief Configures a new channel for a PDM microphone.
+     */
+    static esp_err_t InitPdmMode(i2s_chan_handle_t handle);
+
+    /**
+     * @brief Reads 32-bit standard-mode slots and converts them to PCM.
+     */
+    esp_err_t ReadStandard(std::span<int16_t> dest_buffer,
+                           size_t& samples_read, ConversionStats& stats);
+
+    /**
+     * @brief Reads stereo slot pairs and beamforms them to mono PCM.
+     */
+    esp_err_t ReadStereo(std::span<int16_t> dest_buffer, size_t& samples_read,
+                         ConversionStats& stats);
+
+    /**
+     * @brief Reads hardware-filtered PCM straight into the destination.
+     */
+    esp_err_t ReadPdm(std::span<int16_t> dest_buffer, size_t& samples_read,
+                      ConversionStats& stats);
+
+    /**
+     * @brief Updates the clip statistics and, in adaptive mode, the shift
+     * for the next frame.
      */
-    explicit AudioSource(i2s_chan_handle_t handle);
+    void UpdateHeadroom(const ConversionStats& stats);
 
     /**
      * @brief Handle for the configured I2S receive channel.
@@ -86,6 +303,40 @@ class AudioSource {
      * state.
      */
     i2s_chan_handle_t rx_handle_;
+    CaptureMode mode_;
+
+    // Raw 32-bit slots of the standard modes, room for one stereo frame.
+    std::array<int32_t, 2 * kMaxFrameSamples> raw_buffer_;
+    Beamformer beamformer_;
+    // Removes the microphone's DC offset in the mono modes. Kept across
+    // reads so the filter runs continuously.
+    DcBlocker dc_blocker_;
+
+    bool adaptive_headroom_ = false;
+    int shift_;        // Slot-to-PCM shift for the next frame
+    int frame_shift_;  // Shift the last frame was converted with
+    uint32_t quiet_frames_ = 0;
+    HeadroomStats headroom_stats_{};
+
+    // Default frame storage of GetFeature(int8_t&), kept as a member so
+    // that later pipeline stages can reuse the frame.
+    std::array<int16_t, kMaxFrameSamples> frame_buffer_{};
+    // The frame analysed by the last GetFeature() call.
+    std::span<const int16_t> last_frame_;
+
+    // --- Capture timeline ---
+    // Receive count and time of the newest DMA buffer, written by the ISR.
+    portMUX_TYPE timeline_lock_ = portMUX_INITIALIZER_UNLOCKED;
+    uint64_t dma_receive_count_ = 0;
+    int64_t dma_receive_time_us_ = 0;
+    std::atomic<uint32_t> dma_overflow_count_{0};
+    // Reader side.
+    uint32_t seen_overflow_count_ = 0;
+    bool needs_anchor_ = true;
+    SampleClock sample_clock_{kSampleRateHz};
+    uint64_t next_sample_index_ = 0;
+    uint64_t last_frame_index_ = 0;
+    int64_t last_frame_energy_ = 0;
 };
 
 }  // namespace audio
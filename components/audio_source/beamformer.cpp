@@ -0,0 +1,98 @@
+#include "beamformer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float kSpeedOfSoundMmPerS = 343000.0f;
+constexpr float kPi = 3.14159265358979f;
+}  // namespace
+
+namespace audio {
+
+Beamformer::Beamformer(uint32_t sample_rate_hz, float mic_spacing_mm)
+    : samples_per_mm_sin_(mic_spacing_mm * sample_rate_hz /
+                          kSpeedOfSoundMmPerS) {}
+
+Beamformer::Beamformer(const Beamformer& other)
+    : samples_per_mm_sin_(other.samples_per_mm_sin_),
+      steering_q15_(other.steering_q15_.load(std::memory_order_relaxed)),
+      dc_blockers_(other.dc_blockers_),
+      history_(other.history_),
+      write_index_(other.write_index_) {}
+
+Beamformer& Beamformer::operator=(const Beamformer& other) {
+    samples_per_mm_sin_ = other.samples_per_mm_sin_;
+    steering_q15_.store(other.steering_q15_.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    dc_blockers_ = other.dc_blockers_;
+    history_ = other.history_;
+    write_index_ = other.write_index_;
+    return *this;
+}
+
+void Beamformer::Steer(float angle_deg) {
+    // A source on the left reaches the left mic first, so the left channel
+    // is the one to delay.
+    const float delay = std::clamp(
+        samples_per_mm_sin_ * std::sin(angle_deg * kPi / 180.0f),
+        -static_cast<float>(kMaxDelaySamples),
+        static_cast<float>(kMaxDelaySamples));
+    steering_q15_.store(static_cast<int32_t>(std::lround(delay * 32768.0f)),
+                        std::memory_order_relaxed);
+}
+
+void Beamformer::Reset() {
+    for (DcBlocker& dc_blocker : dc_blockers_) {
+        dc_blocker.Reset();
+    }
+    for (auto& channel : history_) {
+        channel.fill(0);
+    }
+    write_index_ = 0;
+}
+
+ConversionStats Beamformer::Process(std::span<const int32_t> interleaved,
+                                    int shift, std::span<int16_t> out) {
+    constexpr uint32_t kMask = kHistory - 1;
+    const size_t frames = std::min(interleaved.size() / 2, out.size());
+
+    // Latched once, so the whole block uses one direction.
+    const int32_t steering = steering_q15_.load(std::memory_order_relaxed);
+    const uint32_t magnitude =
+        static_cast<uint32_t>(steering < 0 ? -steering : steering);
+    const uint32_t whole = magnitude >> 15;
+    const int32_t fraction = static_cast<int32_t>(magnitude & 0x7FFF);
+    const uint32_t left_whole = steering > 0 ? whole : 0;
+    const int32_t left_fraction = steering > 0 ? fraction : 0;
+    const uint32_t right_whole = steering < 0 ? whole : 0;
+    const int32_t right_fraction = steering < 0 ? fraction : 0;
+    std::array<int16_t, kHistory>& left = history_[0];
+    std::array<int16_t, kHistory>& right = history_[1];
+    uint32_t w = write_index_;
+    ConversionStats stats;
+
+    for (size_t n = 0; n < frames; ++n, ++w) {
+        left[w & kMask] =
+            ConvertSlot(interleaved[2 * n], shift, dc_blockers_[0], stats);
+        right[w & kMask] =
+            ConvertSlot(interleaved[2 * n + 1], shift, dc_blockers_[1], stats);
+
+        // x[n - d] = (1 - f) * x[n - whole] + f * x[n - whole - 1], Q15.
+        const int32_t l =
+            (left[(w - left_whole) & kMask] * (32768 - left_fraction) +
+             left[(w - left_whole - 1) & kMask] * left_fraction) >>
+            15;
+        const int32_t r =
+            (right[(w - right_whole) & kMask] * (32768 - right_fraction) +
+             right[(w - right_whole - 1) & kMask] * right_fraction) >>
+            15;
+        const int32_t sum = (l + r) >> 1;
+        out[n] = static_cast<int16_t>(sum);
+        AccumulateEnergy(out[n], stats);
+    }
+    write_index_ = w;
+    return stats;
+}
+
+}  // namespace audio
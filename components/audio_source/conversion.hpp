@@ -0,0 +1,80 @@
+#ifndef AUDIO_SOURCE_CONVERSION_HPP_
+#define AUDIO_SOURCE_CONVERSION_HPP_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "dc_blocker.hpp"
+
+namespace audio {
+
+// Raw 32-bit slots are shifted right by kFilterShift before DC blocking.
+// The adaptive rest of the slot-to-PCM shift is applied to the filter
+// output, so changing it does not disturb the filter state.
+constexpr int kFilterShift = 8;
+// Range of the adaptive slot-to-PCM shift. At kMaxPcmShift the top 16 bits
+// of a slot become the sample; every step below adds 6 dB of gain.
+constexpr int kMinPcmShift = kFilterShift;
+constexpr int kMaxPcmShift = 16;
+
+/**
+ * @brief Level statistics gathered while converting one block to PCM.
+ */
+struct ConversionStats {
+    uint32_t clipped_samples = 0;
+    // OR of all sample magnitudes before clamping. Its highest set bit is
+    // the block's peak exponent.
+    uint32_t magnitude_bits = 0;
+    // Energy of the output PCM, accumulated in the conversion loop so the
+    // frame level needs no pass of its own.
+    int64_t sum_of_squares = 0;
+};
+
+/**
+ * @brief Clamps a converted sample to 16-bit PCM and accounts for it.
+ *
+ * Peak tracking is branch-free, so the only cost over a plain clamp is the
+ * clip compare.
+ */
+inline int16_t ToPcm(int32_t value, ConversionStats& stats) {
+    stats.magnitude_bits |= static_cast<uint32_t>(value ^ (value >> 31));
+    const int32_t clamped =
+        std::clamp(value, static_cast<int32_t>(INT16_MIN),
+                   static_cast<int32_t>(INT16_MAX));
+    stats.clipped_samples += clamped != value;
+    return static_cast<int16_t>(clamped);
+}
+
+/**
+ * @brief Converts one raw 32-bit I2S slot to PCM: the filter pre-shift, DC
+ * blocking, the gain shift `pcm_shift - kFilterShift` and the clamp.
+ *
+ * The per-sample kernel of the standard and stereo capture loops.
+ */
+inline int16_t ConvertSlot(int32_t slot, int pcm_shift, DcBlocker& dc_blocker,
+                           ConversionStats& stats) {
+    return ToPcm(
+        dc_blocker.Process(slot >> kFilterShift) >> (pcm_shift - kFilterShift),
+        stats);
+}
+
+/**
+ * @brief Removes the DC offset of one 16-bit PDM sample and clamps it.
+ *
+ * The per-sample kernel of the PDM capture loop.
+ */
+inline int16_t ConvertPdmSample(int16_t sample, DcBlocker& dc_blocker,
+                                ConversionStats& stats) {
+    return ToPcm(dc_blocker.Process(sample), stats);
+}
+
+/**
+ * @brief Adds one output sample to the block's energy.
+ */
+inline void AccumulateEnergy(int16_t pcm, ConversionStats& stats) {
+    stats.sum_of_squares += static_cast<int32_t>(pcm) * pcm;
+}
+
+}  // namespace audio
+
+#endif  // AUDIO_SOURCE_CONVERSION_HPP_
@@ -0,0 +1,42 @@
+#ifndef AUDIO_SOURCE_DC_BLOCKER_HPP_
+#define AUDIO_SOURCE_DC_BLOCKER_HPP_
+
+#include <cstdint>
+
+namespace audio {
+
+/**
+ * @class DcBlocker
+ * @brief One-pole fixed-point DC-blocking high-pass filter.
+ *
+ * y[n] = x[n] - x[n-1] + a * y[n-1], with the output kept in Q15 so the
+ * rounding error feeds back into the next sample instead of building up a
+ * residual offset. Meant to be called from a conversion loop, one sample at
+ * a time, before the output is clamped to 16 bits.
+ */
+class DcBlocker {
+   public:
+    // a = 1 - 2 * pi * fc / fs, for a ~20 Hz corner at 44.1 kHz.
+    static constexpr int64_t kPoleQ15 = 32674;
+
+    int32_t Process(int32_t x) {
+        state_ = (static_cast<int64_t>(x - previous_input_) << 15) +
+                 ((kPoleQ15 * state_) >> 15);
+        previous_input_ = x;
+        // Round to nearest; truncating would bias the output by -0.5 LSB.
+        return static_cast<int32_t>((state_ + (1 << 14)) >> 15);
+    }
+
+    void Reset() {
+        previous_input_ = 0;
+        state_ = 0;
+    }
+
+   private:
+    int32_t previous_input_ = 0;
+    int64_t state_ = 0;  // Last output, Q15
+};
+
+}  // namespace audio
+
+#endif  // AUDIO_SOURCE_DC_BLOCKER_HPP_
@@ -0,0 +1,170 @@
+#include "beamformer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "conversion.hpp"
+
+namespace {
+
+using audio::Beamformer;
+
+constexpr uint32_t kSampleRateHz = 44100;
+constexpr float kMicSpacingMm = 20.0f;
+constexpr double kSpeedOfSoundMmPerS = 343000.0;
+constexpr double kAmplitude = 10000.0;
+// Past the DC blockers' start-up transient.
+constexpr size_t kSettleSamples = 8192;
+constexpr size_t kSamples = kSettleSamples + 4096;
+constexpr size_t kBlock = 256;
+
+// Delay in samples between the mics for a source at `angle_deg`.
+double ArrivalDelay(double angle_deg) {
+    return kMicSpacingMm * kSampleRateHz / kSpeedOfSoundMmPerS *
+           std::sin(angle_deg * M_PI / 180.0);
+}
+
+int32_t ToSlot(double value) {
+    return static_cast<int32_t>(std::lround(value * 65536.0));
+}
+
+// Interleaved slots of a tone from `angle_deg`: the mic on the source's
+// side hears it `ArrivalDelay` samples before the other one.
+std::vector<int32_t> MakeSource(double frequency_hz, double angle_deg) {
+    const double delay = ArrivalDelay(angle_deg);
+    const double left_lag = delay < 0.0 ? -delay : 0.0;
+    const double right_lag = delay > 0.0 ? delay : 0.0;
+    std::vector<int32_t> slots(2 * kSamples);
+    for (size_t n = 0; n < kSamples; ++n) {
+        const double w = 2.0 * M_PI * frequency_hz / kSampleRateHz;
+        slots[2 * n] = ToSlot(kAmplitude * std::sin(w * (n - left_lag)));
+        slots[2 * n + 1] = ToSlot(kAmplitude * std::sin(w * (n - right_lag)));
+    }
+    return slots;
+}
+
+std::vector<int16_t> Beamform(Beamformer& beamformer,
+                              const std::vector<int32_t>& slots) {
+    std::vector<int16_t> out(slots.size() / 2);
+    for (size_t start = 0; start < out.size(); start += kBlock) {
+        const size_t count = std::min(kBlock, out.size() - start);
+        beamformer.Process(
+            std::span<const int32_t>(&slots[2 * start], 2 * count),
+            audio::kMaxPcmShift, std::span<int16_t>(&out[start], count));
+    }
+    return out;
+}
+
+// One channel through the same conversion, undelayed.
+std::vector<int16_t> ConvertChannel(const std::vector<int32_t>& slots,
+                                    size_t channel) {
+    audio::DcBlocker dc_blocker;
+    audio::ConversionStats stats;
+    std::vector<int16_t> pcm(slots.size() / 2);
+    for (size_t n = 0; n < pcm.size(); ++n) {
+        pcm[n] = audio::ConvertSlot(slots[2 * n + channel],
+                                    audio::kMaxPcmShift, dc_blocker, stats);
+    }
+    return pcm;
+}
+
+int MaxError(const std::vector<int16_t>& a, const std::vector<int16_t>& b) {
+    int error = 0;
+    for (size_t n = kSettleSamples; n < a.size(); ++n) {
+        error = std::max(error, std::abs(a[n] - b[n]));
+    }
+    return error;
+}
+
+TEST(BeamformerTest, BroadsidePassesTheChannelAverage) {
+    Beamformer beamformer(kSampleRateHz, kMicSpacingMm);
+    beamformer.Steer(0.0f);
+    const std::vector<int32_t> slots = MakeSource(1000.0, 0.0);
+    EXPECT_LE(MaxError(Beamform(beamformer, slots), ConvertChannel(slots, 0)),
+              0);
+}
+
+// Steering at the source delays the near mic by the arrival delay, so the
+// output matches the far mic's channel up to the error of the linear
+// interpolation between samples.
+TEST(BeamformerTest, FractionalDelayAlignsTheChannels) {
+    for (const float angle : {90.0f, 55.0f, 20.0f, 7.0f, -13.0f, -48.0f,
+                              -90.0f}) {
+        SCOPED_TRACE(angle);
+        const std::vector<int32_t> slots = MakeSource(500.0, angle);
+        const size_t far_channel = angle > 0.0f ? 1 : 0;
+        const std::vector<int16_t> far = ConvertChannel(slots, far_channel);
+
+        Beamformer steered(kSampleRateHz, kMicSpacingMm);
+        steered.Steer(angle);
+        // Linear interpolation of a 500 Hz tone is off by at most
+        // (pi f / fs)^2 / 8 of the amplitude, 6 LSB here, plus rounding.
+        EXPECT_LE(MaxError(Beamform(steered, slots), far), 10);
+
+        Beamformer unsteered(kSampleRateHz, kMicSpacingMm);
+        unsteered.Steer(0.0f);
+        EXPECT_GT(MaxError(Beamform(unsteered, slots), far),
+                  20 * std::fabs(ArrivalDelay(angle)));
+    }
+}
+
+TEST(BeamformerTest, SteeringAtTheSourceKeepsItsLevel) {
+    // A 4 kHz tone from the side: aligned, both mics add coherently;
+    // steered the other way, they are 5.1 samples apart and mostly cancel.
+    const std::vector<int32_t> slots = MakeSource(4000.0, 90.0);
+    const auto rms = [](const std::vector<int16_t>& pcm) {
+        double sum = 0.0;
+        for (size_t n = kSettleSamples; n < pcm.size(); ++n) {
+            sum += static_cast<double>(pcm[n]) * pcm[n];
+        }
+        return std::sqrt(sum / (pcm.size() - kSettleSamples));
+    };
+
+    Beamformer towards(kSampleRateHz, kMicSpacingMm);
+    towards.Steer(90.0f);
+    Beamformer away(kSampleRateHz, kMicSpacingMm);
+    away.Steer(-90.0f);
+    const double aligned = rms(Beamform(towards, slots));
+    const double opposed = rms(Beamform(away, slots));
+    // The DC blocker and interpolation lose a little of the tone.
+    EXPECT_NEAR(aligned, kAmplitude / std::sqrt(2.0), 0.05 * aligned);
+    EXPECT_LT(opposed, 0.5 * aligned);
+}
+
+TEST(BeamformerTest, DelayIsClampedToTheHistory) {
+    // A spacing whose arrival delay exceeds kMaxDelaySamples.
+    Beamformer beamformer(kSampleRateHz, 200.0f);
+    beamformer.Steer(90.0f);
+    const std::vector<int32_t> slots = MakeSource(300.0, 0.0);
+    const std::vector<int16_t> out = Beamform(beamformer, slots);
+    const std::vector<int16_t> channel = ConvertChannel(slots, 0);
+
+    // Left delayed by exactly kMaxDelaySamples, averaged with right.
+    int error = 0;
+    for (size_t n = kSettleSamples; n < out.size(); ++n) {
+        const int expected =
+            (channel[n - Beamformer::kMaxDelaySamples] + channel[n]) >> 1;
+        error = std::max(error, std::abs(out[n] - expected));
+    }
+    EXPECT_LE(error, 1);
+}
+
+TEST(BeamformerTest, CopyKeepsTheSteering) {
+    Beamformer original(kSampleRateHz, kMicSpacingMm);
+    original.Steer(60.0f);
+    Beamformer copy(original);
+    Beamformer assigned(kSampleRateHz, kMicSpacingMm);
+    assigned = original;
+
+    const std::vector<int32_t> slots = MakeSource(700.0, 60.0);
+    const std::vector<int16_t> expected = Beamform(original, slots);
+    EXPECT_EQ(Beamform(copy, slots), expected);
+    EXPECT_EQ(Beamform(assigned, slots), expected);
+}
+
+}  // namespace
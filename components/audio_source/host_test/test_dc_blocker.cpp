@@ -0,0 +1,224 @@
+#include "dc_blocker.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "conversion.hpp"
+
+namespace {
+
+using audio::DcBlocker;
+
+constexpr double kSampleRateHz = 44100.0;
+// The filter time constant is 1 / (1 - a), about 350 samples; after this
+// many the start-up transient has decayed below 1e-9 of the offset.
+constexpr size_t kSettleSamples = 8192;
+// 200 whole periods of 1 kHz, so the fitted tone is orthogonal to DC.
+constexpr size_t kAnalysisSamples = 8820;
+constexpr double kToneHz = 1000.0;
+
+struct Signal {
+    double offset;
+    double amplitude;
+    double noise_rms;  // In 16-bit LSB
+};
+
+// Raw 32-bit I2S slots carrying `signal` at 16-bit scale in the top bits.
+std::vector<int32_t> MakeSlots(const Signal& signal, size_t samples) {
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, signal.noise_rms);
+    std::vector<int32_t> slots(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        const double value =
+            signal.offset + noise(rng) +
+            signal.amplitude *
+                std::sin(2.0 * M_PI * kToneHz * i / kSampleRateHz);
+        slots[i] = static_cast<int32_t>(std::lround(value * 65536.0));
+    }
+    return slots;
+}
+
+// The standard-mode conversion loop, with the production kernel at the
+// shift that takes 16-bit PCM from the top of the slot. Without the filter
+// the same shifts are applied to the raw slot.
+std::vector<int16_t> Convert(const std::vector<int32_t>& slots, bool filter,
+                             audio::ConversionStats& stats,
+                             int pcm_shift = audio::kMaxPcmShift) {
+    DcBlocker dc_blocker;
+    std::vector<int16_t> pcm(slots.size());
+    for (size_t i = 0; i < slots.size(); ++i) {
+        pcm[i] = filter ? audio::ConvertSlot(slots[i], pcm_shift, dc_blocker,
+                                             stats)
+                        : audio::ToPcm(slots[i] >> pcm_shift, stats);
+        audio::AccumulateEnergy(pcm[i], stats);
+    }
+    return pcm;
+}
+
+struct Floor {
+    double mean;        // Residual offset in LSB
+    double residual_db;  // Everything but the tone, in dBFS
+};
+
+// Fits the tone by least squares over the analysis window and measures
+// what is left: offset, noise, rounding and distortion.
+Floor MeasureFloor(const std::vector<int16_t>& pcm) {
+    double in_phase = 0.0;
+    double quadrature = 0.0;
+    double mean = 0.0;
+    for (size_t i = 0; i < kAnalysisSamples; ++i) {
+        const double phase = 2.0 * M_PI * kToneHz * i / kSampleRateHz;
+        const double x = pcm[kSettleSamples + i];
+        in_phase += x * std::sin(phase);
+        quadrature += x * std::cos(phase);
+        mean += x;
+    }
+    in_phase *= 2.0 / kAnalysisSamples;
+    quadrature *= 2.0 / kAnalysisSamples;
+    mean /= kAnalysisSamples;
+
+    double power = 0.0;
+    for (size_t i = 0; i < kAnalysisSamples; ++i) {
+        const double phase = 2.0 * M_PI * kToneHz * i / kSampleRateHz;
+        const double residual = pcm[kSettleSamples + i] -
+                                in_phase * std::sin(phase) -
+                                quadrature * std::cos(phase);
+        power += residual * residual;
+    }
+    power /= kAnalysisSamples;
+    return Floor{mean, 10.0 * std::log10(power / (32768.0 * 32768.0))};
+}
+
+// Noise plus the rounding of the final shift, in dBFS.
+double ExpectedFloorDb(double noise_rms) {
+    return 10.0 * std::log10((noise_rms * noise_rms + 1.0 / 12.0) /
+                             (32768.0 * 32768.0));
+}
+
+TEST(DcBlocker, LowersNoiseFloorOfOffsetTone) {
+    constexpr Signal kCases[] = {
+        {3000.0, 50.0, 2.0},
+        {-12000.0, 8000.0, 4.0},
+        {500.0, 20000.0, 1.0},
+    };
+    for (const Signal& signal : kCases) {
+        const std::vector<int32_t> slots =
+            MakeSlots(signal, kSettleSamples + kAnalysisSamples);
+        audio::ConversionStats raw_stats;
+        audio::ConversionStats filtered_stats;
+        const Floor raw = MeasureFloor(Convert(slots, false, raw_stats));
+        const std::vector<int16_t> filtered_pcm =
+            Convert(slots, true, filtered_stats);
+        const Floor filtered = MeasureFloor(filtered_pcm);
+        const double expected = ExpectedFloorDb(signal.noise_rms);
+        std::printf(
+            "offset %6.0f tone %5.0f: floor %6.1f -> %6.1f dBFS "
+            "(noise %6.1f), mean %.2f LSB\n",
+            signal.offset, signal.amplitude, raw.residual_db,
+            filtered.residual_db, expected, filtered.mean);
+
+        // Without the filter the offset dominates what is left.
+        EXPECT_GT(raw.residual_db - filtered.residual_db, 30.0);
+        // With it, only the injected noise and the output rounding remain.
+        // The final shift truncates, which leaves half an LSB of offset.
+        EXPECT_LT(filtered.residual_db, expected + 1.0);
+        EXPECT_LE(std::abs(filtered.mean), 0.55);
+        EXPECT_EQ(filtered_stats.clipped_samples, 0u);
+
+        int64_t energy = 0;
+        for (const int16_t sample : filtered_pcm) {
+            energy += static_cast<int32_t>(sample) * sample;
+        }
+        EXPECT_EQ(filtered_stats.sum_of_squares, energy);
+    }
+}
+
+TEST(DcBlocker, OffsetNoLongerClipsTheTone) {
+    // With 6 dB of adaptive gain, the tone fits in 16 bits only once the
+    // offset is removed.
+    constexpr int kBoostedShift = audio::kMaxPcmShift - 1;
+    const Signal signal{4500.0, 14000.0, 0.5};
+    const std::vector<int32_t> slots =
+        MakeSlots(signal, kSettleSamples + kAnalysisSamples);
+    audio::ConversionStats raw_stats;
+    const Floor raw =
+        MeasureFloor(Convert(slots, false, raw_stats, kBoostedShift));
+    EXPECT_GT(raw_stats.clipped_samples, 0u);
+    // Clipping distortion is far above the noise.
+    EXPECT_GT(raw.residual_db, ExpectedFloorDb(2 * signal.noise_rms) + 40.0);
+
+    // Only the start-up transient, before the offset decays, may clip.
+    DcBlocker dc_blocker;
+    audio::ConversionStats settled_stats;
+    audio::ConversionStats transient_stats;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        audio::ConvertSlot(slots[i], kBoostedShift, dc_blocker,
+                           i >= kSettleSamples ? settled_stats
+                                               : transient_stats);
+    }
+    EXPECT_EQ(settled_stats.clipped_samples, 0u);
+}
+
+TEST(DcBlocker, PassesAudioBand) {
+    // Gain of a full-scale-ish tone through the PDM path, which filters
+    // 16-bit samples directly.
+    const auto gain_db = [](double frequency_hz) {
+        DcBlocker dc_blocker;
+        double in_power = 0.0;
+        double out_power = 0.0;
+        const size_t samples = 4 * static_cast<size_t>(kSampleRateHz);
+        audio::ConversionStats stats;
+        for (size_t i = 0; i < samples; ++i) {
+            const double x =
+                10000.0 *
+                std::sin(2.0 * M_PI * frequency_hz * i / kSampleRateHz);
+            const int16_t y = audio::ConvertPdmSample(
+                static_cast<int16_t>(std::lround(x)), dc_blocker, stats);
+            if (i >= samples / 2) {
+                in_power += x * x;
+                out_power += static_cast<double>(y) * y;
+            }
+        }
+        return 10.0 * std::log10(out_power / in_power);
+    };
+    EXPECT_NEAR(gain_db(1000.0), 0.0, 0.05);
+    EXPECT_NEAR(gain_db(200.0), 0.0, 0.1);
+    // Corner near 20 Hz.
+    EXPECT_NEAR(gain_db(20.0), -3.0, 1.0);
+    EXPECT_LT(gain_db(2.0), -15.0);
+}
+
+TEST(DcBlocker, PdmOutputHasNoResidualOffset) {
+    // The PDM path uses the filter output as PCM directly, so the filter's
+    // own rounding must not leave an offset.
+    DcBlocker dc_blocker;
+    double sum = 0.0;
+    const size_t samples = kSettleSamples + kAnalysisSamples;
+    audio::ConversionStats stats;
+    for (size_t i = 0; i < samples; ++i) {
+        const int16_t x = static_cast<int16_t>(std::lround(
+            -2500.0 +
+            3000.0 * std::sin(2.0 * M_PI * kToneHz * i / kSampleRateHz)));
+        const int16_t y = audio::ConvertPdmSample(x, dc_blocker, stats);
+        if (i >= kSettleSamples) {
+            sum += y;
+        }
+    }
+    EXPECT_LT(std::abs(sum / kAnalysisSamples), 0.1);
+}
+
+TEST(DcBlocker, ResetClearsState) {
+    DcBlocker dc_blocker;
+    for (int i = 0; i < 100; ++i) {
+        dc_blocker.Process(5000);
+    }
+    dc_blocker.Reset();
+    EXPECT_EQ(dc_blocker.Process(0), 0);
+}
+
+}  // namespace
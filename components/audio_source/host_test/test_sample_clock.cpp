@@ -0,0 +1,165 @@
+#include "sample_clock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+using audio::SampleClock;
+
+constexpr uint32_t kNominalRateHz = 44100;
+constexpr uint64_t kBufferSamples = 512;
+constexpr int64_t kStartUs = 123456789;
+
+// DMA buffers from an I2S clock `ppm` off nominal, stamped by an interrupt
+// handler that runs up to `max_latency_us` late.
+class DmaSimulator {
+   public:
+    DmaSimulator(double ppm, int max_latency_us)
+        : rate_hz_(kNominalRateHz * (1.0 + ppm * 1e-6)),
+          latency_(0, max_latency_us) {}
+
+    // Feeds the next buffer to `clock`.
+    void Feed(SampleClock& clock) {
+        ++buffers_;
+        clock.Observe(LastIndex(), std::llround(TrueTimeUs(LastIndex())) +
+                                       latency_(rng_));
+    }
+
+    uint64_t LastIndex() const { return buffers_ * kBufferSamples - 1; }
+    double TrueTimeUs(uint64_t index) const {
+        return kStartUs + (index + 1) * 1e6 / rate_hz_;
+    }
+    double rate_hz() const { return rate_hz_; }
+
+   private:
+    double rate_hz_;
+    std::mt19937 rng_{11};
+    std::uniform_int_distribution<int> latency_;
+    uint64_t buffers_ = 0;
+};
+
+uint64_t BuffersFor(double seconds) {
+    return static_cast<uint64_t>(seconds * kNominalRateHz / kBufferSamples);
+}
+
+TEST(SampleClock, FollowsNominalRateBeforeObservations) {
+    const SampleClock clock(kNominalRateHz);
+    EXPECT_FALSE(clock.IsValid());
+    EXPECT_NEAR(clock.GetTimeUs(kNominalRateHz), 1000000, 1);
+    EXPECT_DOUBLE_EQ(std::round(clock.GetRateHz()), kNominalRateHz);
+}
+
+TEST(SampleClock, TracksOffNominalRate) {
+    for (const double ppm : {-80.0, 0.0, 50.0, 300.0}) {
+        SampleClock clock(kNominalRateHz);
+        DmaSimulator dma(ppm, 200);
+        double worst_us = 0.0;
+        const uint64_t buffers = BuffersFor(3600.0);
+        for (uint64_t i = 0; i < buffers; ++i) {
+            dma.Feed(clock);
+            if (i < BuffersFor(60.0)) {
+                continue;
+            }
+            // Observations are late by 100 us on average, so that is
+            // where the mapping settles.
+            const double error_us = clock.GetTimeUs(dma.LastIndex()) -
+                                    (dma.TrueTimeUs(dma.LastIndex()) + 100.0);
+            worst_us = std::max(worst_us, std::abs(error_us));
+        }
+        const double rate_error_ppm =
+            (clock.GetRateHz() / dma.rate_hz() - 1.0) * 1e6;
+        std::printf("%+5.0f ppm: worst error %.0f us, rate error %.2f ppm\n",
+                    ppm, worst_us, rate_error_ppm);
+        // A fixed epoch at the nominal rate would be off by ppm * 3.6 ms.
+        EXPECT_LT(worst_us, 150.0) << ppm << " ppm";
+        EXPECT_LT(std::abs(rate_error_ppm), 1.0) << ppm << " ppm";
+    }
+}
+
+TEST(SampleClock, TimeIsMonotonic) {
+    SampleClock clock(kNominalRateHz);
+    DmaSimulator dma(120.0, 500);
+    int64_t last_us = INT64_MIN;
+    for (uint64_t i = 0; i < BuffersFor(120.0); ++i) {
+        dma.Feed(clock);
+        // Every sample of the buffer just received.
+        for (uint64_t index = dma.LastIndex() + 1 - kBufferSamples;
+             index <= dma.LastIndex(); index += 64) {
+            const int64_t time_us = clock.GetTimeUs(index);
+            ASSERT_GE(time_us, last_us) << "index " << index;
+            last_us = time_us;
+        }
+    }
+}
+
+TEST(SampleClock, StepsAfterLargeError) {
+    SampleClock clock(kNominalRateHz);
+    DmaSimulator dma(0.0, 0);
+    for (uint64_t i = 0; i < BuffersFor(5.0); ++i) {
+        dma.Feed(clock);
+    }
+    // The capture stalled for 20 ms without the index moving on.
+    const uint64_t index = dma.LastIndex() + 2 * kNominalRateHz;
+    const int64_t time_us =
+        std::llround(dma.TrueTimeUs(index)) + 20000;
+    clock.Observe(index, time_us);
+    EXPECT_EQ(clock.GetTimeUs(index), time_us);
+}
+
+TEST(SampleClock, HoldsTimeAfterBackwardStep) {
+    SampleClock clock(kNominalRateHz);
+    DmaSimulator dma(0.0, 0);
+    for (uint64_t i = 0; i < BuffersFor(5.0); ++i) {
+        dma.Feed(clock);
+    }
+    // The observation is 20 ms earlier than the mapping predicts, e.g.
+    // after a stall of the interrupt that stamped the earlier buffers.
+    const uint64_t index = dma.LastIndex() + 2 * kNominalRateHz;
+    const int64_t handed_out_us = clock.GetTimeUs(index);
+    const int64_t earlier_us = clock.GetTimeUs(dma.LastIndex());
+    const int64_t time_us = handed_out_us - 20000;
+    clock.Observe(index, time_us);
+
+    // Times already handed out are never undercut, for this sample or
+    // earlier ones.
+    EXPECT_EQ(clock.GetTimeUs(index), handed_out_us);
+    EXPECT_GE(clock.GetTimeUs(dma.LastIndex()), earlier_us);
+    int64_t last_us = clock.GetTimeUs(dma.LastIndex());
+    const uint64_t catch_up = kNominalRateHz / 50;  // 20 ms of samples
+    for (uint64_t k = 0; k <= 2 * catch_up; k += 16) {
+        const int64_t mapped_us = clock.GetTimeUs(index + k);
+        ASSERT_GE(mapped_us, last_us) << "sample " << k;
+        ASSERT_GE(mapped_us, handed_out_us) << "sample " << k;
+        last_us = mapped_us;
+    }
+    // Once the new mapping has caught up it is followed again.
+    EXPECT_NEAR(clock.GetTimeUs(index + 2 * catch_up), time_us + 40000, 1);
+
+    // The next regular update continues from there.
+    clock.Observe(index + kNominalRateHz, time_us + 1000000);
+    EXPECT_NEAR(clock.GetTimeUs(index + kNominalRateHz), time_us + 1000000, 1);
+}
+
+TEST(SampleClock, LimitsRateToPlausibleRange) {
+    SampleClock clock(kNominalRateHz);
+    DmaSimulator dma(2000.0, 0);
+    double worst_us = 0.0;
+    for (uint64_t i = 0; i < BuffersFor(30.0); ++i) {
+        dma.Feed(clock);
+        worst_us = std::max(worst_us,
+                            std::abs(clock.GetTimeUs(dma.LastIndex()) -
+                                     dma.TrueTimeUs(dma.LastIndex())));
+    }
+    EXPECT_NEAR(clock.GetRateHz(),
+                kNominalRateHz * (1.0 + SampleClock::kMaxDeviationPpm * 1e-6),
+                0.1);
+    // The rest of the error builds up until it is stepped out.
+    EXPECT_LT(worst_us, SampleClock::kMaxSlewErrorUs + 2000.0);
+}
+
+}  // namespace
@@ -0,0 +1,161 @@
+#ifndef AUDIO_SOURCE_SAMPLE_CLOCK_HPP_
+#define AUDIO_SOURCE_SAMPLE_CLOCK_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace audio {
+
+/**
+ * @class SampleClock
+ * @brief Maps capture sample indices to esp_timer time.
+ *
+ * The I2S clock is derived from its own divider chain and runs a few tens
+ * of ppm off the nominal rate, which adds up to seconds over a day. The
+ * clock is fed the receive times of DMA buffers, which carry interrupt
+ * latency jitter, and measures the actual rate over a baseline of up to
+ * kMaxBaselineUs. Once per kUpdatePeriodUs it re-anchors the mapping at
+ * the newest observation and steers the phase towards it, a fraction of
+ * the error at a time, so time stays continuous and monotonic. Larger
+ * errors, e.g. after the capture stalled, are stepped out at once. A step
+ * back holds time at the latest mapped value until the new mapping catches
+ * up, so time never runs backwards.
+ *
+ * The period is Q24 microseconds per sample, exact to well below 1 ppm.
+ * The mapping is linear between anchors, which are at most a few seconds
+ * apart while capture runs.
+ */
+class SampleClock {
+   public:
+    static constexpr int64_t kUpdatePeriodUs = 1000000;
+    static constexpr int64_t kMaxBaselineUs = 600 * 1000000LL;
+    // Crystal tolerance plus divider error, with margin.
+    static constexpr int32_t kMaxDeviationPpm = 1000;
+    // Errors above this are stepped instead of slewed.
+    static constexpr int64_t kMaxSlewErrorUs = 5000;
+    // Fraction 1/n of the phase error removed per update.
+    static constexpr int64_t kPhaseGainInverse = 8;
+
+    explicit SampleClock(uint32_t nominal_rate_hz)
+        : nominal_rate_hz_(nominal_rate_hz) {
+        Reset();
+    }
+
+    /**
+     * @brief Forgets all observations; times follow the nominal rate.
+     */
+    void Reset() {
+        valid_ = false;
+        anchor_index_ = 0;
+        anchor_time_us_ = 0;
+        hold_us_ = INT64_MIN;
+        period_q24_ = PeriodQ24(nominal_rate_hz_);
+        measured_q24_ = period_q24_;
+    }
+
+    /**
+     * @brief Records that a sample was captured at a given time.
+     *
+     * Cheap unless an update is due, so it can be called every frame.
+     *
+     * @param index Capture index of the sample.
+     * @param time_us esp_timer time of its capture, late by up to the
+     * interrupt latency.
+     */
+    void Observe(uint64_t index, int64_t time_us) {
+        if (!valid_) {
+            baseline_index_ = anchor_index_ = index;
+            baseline_time_us_ = anchor_time_us_ = time_us;
+            valid_ = true;
+            return;
+        }
+        if (time_us - anchor_time_us_ < kUpdatePeriodUs ||
+            index <= anchor_index_) {
+            return;
+        }
+
+        const int64_t predicted_us = GetTimeUs(index);
+        const int64_t error_us = time_us - predicted_us;
+        if (std::abs(error_us) > kMaxSlewErrorUs) {
+            // The mapping is lost; start over from this observation. Times
+            // up to predicted_us may have been handed out already.
+            baseline_index_ = anchor_index_ = index;
+            baseline_time_us_ = anchor_time_us_ = time_us;
+            hold_us_ = error_us < 0 ? predicted_us : INT64_MIN;
+            return;
+        }
+
+        // Rate over the whole baseline: the latency jitter of a single
+        // observation is spread over all of it.
+        const double measured_q24 =
+            std::ldexp(static_cast<double>(time_us - baseline_time_us_) /
+                           static_cast<double>(index - baseline_index_),
+                       24);
+        // Steer so the mapping meets the observations again after about
+        // kPhaseGainInverse updates.
+        const double steps = static_cast<double>(index - anchor_index_);
+        const double correction_q24 = std::ldexp(
+            static_cast<double>(error_us) / (kPhaseGainInverse * steps), 24);
+        const int64_t nominal_q24 = PeriodQ24(nominal_rate_hz_);
+        const int64_t limit_q24 = nominal_q24 * kMaxDeviationPpm / 1000000;
+        measured_q24_ = std::clamp<int64_t>(std::llround(measured_q24),
+                                            nominal_q24 - limit_q24,
+                                            nominal_q24 + limit_q24);
+        period_q24_ = std::clamp<int64_t>(
+            measured_q24_ + std::llround(correction_q24),
+            nominal_q24 - limit_q24, nominal_q24 + limit_q24);
+
+        anchor_index_ = index;
+        anchor_time_us_ = predicted_us;
+        hold_us_ = INT64_MIN;
+        if (time_us - baseline_time_us_ > kMaxBaselineUs) {
+            // Follow temperature drift of the crystal.
+            baseline_index_ = index;
+            baseline_time_us_ = predicted_us;
+        }
+    }
+
+    /**
+     * @brief Returns the capture time of a sample.
+     * @param index Capture index of the sample.
+     * @return esp_timer time in microseconds.
+     */
+    int64_t GetTimeUs(uint64_t index) const {
+        const int64_t samples = static_cast<int64_t>(index - anchor_index_);
+        return std::max(anchor_time_us_ + ((samples * period_q24_) >> 24),
+                        hold_us_);
+    }
+
+    /**
+     * @brief Returns the measured sample rate in Hz, without the phase
+     * steering.
+     */
+    double GetRateHz() const {
+        return std::ldexp(1000000.0, 24) / static_cast<double>(measured_q24_);
+    }
+
+    bool IsValid() const { return valid_; }
+
+   private:
+    static constexpr int64_t PeriodQ24(uint32_t rate_hz) {
+        return (1000000LL << 24) / rate_hz;
+    }
+
+    uint32_t nominal_rate_hz_;
+    bool valid_ = false;
+    // The mapping passes through the anchor with slope period_q24_.
+    uint64_t anchor_index_ = 0;
+    int64_t anchor_time_us_ = 0;
+    // After a step back, the floor of the times from the anchor on.
+    int64_t hold_us_ = INT64_MIN;
+    int64_t period_q24_ = 0;
+    // Period measured over the baseline, and its start.
+    int64_t measured_q24_ = 0;
+    uint64_t baseline_index_ = 0;
+    int64_t baseline_time_us_ = 0;
+};
+
+}  // namespace audio
+
+#endif  // AUDIO_SOURCE_SAMPLE_CLOCK_HPP_
@@ -1,11 +1,14 @@
 #include "ble_manager.hpp"
 
 // C Standard Libraries
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 // ESP-IDF & FreeRTOS Headers
 #include "esp_log.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 // NimBLE Host Stack Headers
@@ -13,6 +16,7 @@
 #include "nimble/nimble_port_freertos.h"
 #include "services/gap/ble_svc_gap.h"
 #include "services/gatt/ble_svc_gatt.h"
+#include "store/config/ble_store_config.h"
 
 namespace ble {
 
@@ -24,6 +28,38 @@ static const char* kTag = "BLEManager";
 // File-scope static variable to store the characteristic handle. This avoids
 // C++ language issues with static initializers and private member access.
 static uint16_t g_audio_characteristic_handle = 0;
+static uint16_t g_snapshot_characteristic_handle = 0;
+
+// Snapshot reads that raced a publish are retried at once: a store takes
+// well under a microsecond unless the writer was preempted mid-store, and
+// then the last good copy is served instead of waiting for it.
+static constexpr int kSnapshotReadAttempts = 8;
+
+// Returns whether a link is encrypted with an authenticated (MITM
+// protected) key of full size.
+static bool IsLinkAuthenticated(uint16_t conn_handle) {
+    struct ble_gap_conn_desc desc;
+    return ble_gap_conn_find(conn_handle, &desc) == 0 &&
+           desc.sec_state.encrypted && desc.sec_state.authenticated &&
+           desc.sec_state.key_size >= 16;
+}
+
+// Reads a big-endian 64-bit value.
+static int64_t GetBigEndian64(const uint8_t* data) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return static_cast<int64_t>(value);
+}
+
+// Writes a big-endian 64-bit value.
+static void PutBigEndian64(uint8_t* data, int64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        data[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >>
+                                       (8 * (7 - i)));
+    }
+}
 
 // Static singleton instance pointer.
 std::unique_ptr<BLEManager> BLEManager::s_instance_ = nullptr;
@@ -38,6 +74,10 @@ static const ble_uuid128_t gatt_char_uuid =
     BLE_UUID128_INIT(0x2A, 0x37, 0x86, 0x24, 0x4A, 0x2B, 0x45, 0x47, 0xAD, 0x93,
                      0x82, 0x6E, 0x8A, 0x43, 0xD7, 0x9B);
 
+static const ble_uuid128_t gatt_snapshot_char_uuid =
+    BLE_UUID128_INIT(0x2B, 0x37, 0x86, 0x24, 0x4A, 0x2B, 0x45, 0x47, 0xAD, 0x93,
+                     0x82, 0x6E, 0x8A, 0x43, 0xD7, 0x9B);
+
 // --- GATT Characteristic Definition ---
 static const struct ble_gatt_chr_def gatt_audio_characteristics[] = {
     {
@@ -45,11 +85,25 @@ static const struct ble_gatt_chr_def gatt_audio_characteristics[] = {
         .access_cb = BLEManager::GattAccessCallback,
         .arg = nullptr,
         .descriptors = nullptr,
-        .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+        // Writes without response let bulk transfers such as firmware
+        // updates use every connection event.
+        .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP |
+                 BLE_GATT_CHR_F_NOTIFY,
         .min_key_size = 0,
         .val_handle = &g_audio_characteristic_handle,
         .cpfd = nullptr,
     },
+    {
+        // Latest feature snapshot for clients that poll.
+        .uuid = (const ble_uuid_t*)&gatt_snapshot_char_uuid,
+        .access_cb = BLEManager::GattAccessCallback,
+        .arg = nullptr,
+        .descriptors = nullptr,
+        .flags = BLE_GATT_CHR_F_READ,
+        .min_key_size = 0,
+        .val_handle = &g_snapshot_characteristic_handle,
+        .cpfd = nullptr,
+    },
     {} /* End of characteristics array */
 };
 
@@ -93,6 +147,11 @@ BLEManager* BLEManager::GetInstance() {
 // Public API Methods
 
 esp_err_t BLEManager::StartAdvertising() {
+    // Advertising continues while links are free, so it may already run.
+    if (ble_gap_adv_active()) {
+        return ESP_OK;
+    }
+
     struct ble_hs_adv_fields fields;
     memset(&fields, 0, sizeof(fields));
 
@@ -141,21 +200,155 @@ esp_err_t BLEManager::SendAudioPacket(const AudioPacket& packet) {
         return ESP_FAIL;
     }
 
-    std::array<uint8_t, PacketConfig::kPacketSize> encoded_data =
-        PacketEncoder::Encode(packet);
+    return EnqueueStreamPacket(MakeOutbound(packet, 0));
+}
 
-    if (xQueueSend(send_queue_, &encoded_data, pdMS_TO_TICKS(100)) != pdPASS) {
-        ESP_LOGE(kTag, "Send queue is full.");
-        if (on_error_cb_) {
-            on_error_cb_("Send queue is full.");
+esp_err_t BLEManager::SendFeaturePacket(const AudioPacket& packet,
+                                        int64_t capture_time_us) {
+    if (send_queue_ == nullptr) {
+        ESP_LOGE(kTag, "Send queue is not initialized.");
+        return ESP_FAIL;
+    }
+
+    esp_err_t result = ESP_OK;
+    for (size_t i = 0; i < kMaxLinks; ++i) {
+        const uint16_t conn_handle =
+            links_[i].conn_handle.load(std::memory_order_acquire);
+        if (conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+            continue;
+        }
+        FeatureDecimator& decimator = feature_decimators_[i];
+        const uint32_t session =
+            links_[i].session.load(std::memory_order_relaxed);
+        const uint32_t feature_rate =
+            links_[i].feature_rate.load(std::memory_order_relaxed);
+        if (decimator.session != session) {
+            decimator = FeatureDecimator{.session = session};
         }
+        if (decimator.feature_rate != feature_rate) {
+            // Restart the period; the sequence carries on.
+            decimator.feature_rate = feature_rate;
+            decimator.period_start_us = 0;
+            decimator.count = 0;
+        }
+
+        AudioPacket link_packet = packet;
+        if (packet.data_type == PacketConfig::kDataTypeAudio &&
+            !DecimateFeature(decimator, packet.payload, capture_time_us,
+                             link_packet.payload)) {
+            continue;
+        }
+        link_packet.sequence = decimator.sequence++;
+        OutboundPacket outbound = MakeOutbound(link_packet, 0);
+        outbound.conn_handle = conn_handle;
+        const esp_err_t ret = EnqueueStreamPacket(outbound);
+        if (ret != ESP_OK) {
+            result = ret;
+        }
+    }
+    return result;
+}
+
+esp_err_t BLEManager::SendEventPacket(const AudioPacket& packet,
+                                      int64_t capture_time_us) {
+    if (send_queue_ == nullptr) {
+        ESP_LOGE(kTag, "Send queue is not initialized.");
+        return ESP_FAIL;
+    }
+
+    OutboundPacket outbound = MakeOutbound(packet, capture_time_us);
+
+    // Events jump the queue and never wait for space.
+    if (xQueueSendToFront(send_queue_, &outbound, 0) != pdPASS) {
+        ESP_LOGW(kTag, "Send queue is full, event dropped.");
         return ESP_ERR_TIMEOUT;
     }
     return ESP_OK;
 }
 
+esp_err_t BLEManager::SendFramePacket(const FramePacket& packet) {
+    if (send_queue_ == nullptr) {
+        ESP_LOGE(kTag, "Send queue is not initialized.");
+        return ESP_FAIL;
+    }
+
+    OutboundPacket outbound;
+    outbound.length = PacketEncoder::EncodeFrame(packet, outbound.data);
+    outbound.capture_time_us = 0;
+    outbound.time_sync_reply = false;
+    outbound.conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    if (outbound.length == 0) {
+        ESP_LOGE(kTag, "Frame payload too long (%u bytes).", packet.length);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return EnqueueStreamPacket(outbound);
+}
+
+esp_err_t BLEManager::PublishSnapshot(const ble::FramePacket& snapshot) {
+    std::array<uint8_t, PacketConfig::kMaxFrameSize> encoded;
+    const size_t length = PacketEncoder::EncodeFrame(snapshot, encoded);
+    if (length == 0 || length > PacketConfig::kMaxSnapshotSize) {
+        ESP_LOGE(kTag, "Snapshot too long (%u bytes).", snapshot.length);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    Snapshot value;
+    std::copy_n(encoded.begin(), length, value.data.begin());
+    value.length = static_cast<uint16_t>(length);
+    snapshot_.Store(value);
+    return ESP_OK;
+}
+
+float BLEManager::GetSendQueueOccupancy() const {
+    if (send_queue_ == nullptr) {
+        return 0.0f;
+    }
+    return static_cast<float>(uxQueueMessagesWaiting(send_queue_)) /
+           kSendQueueLength;
+}
+
+size_t BLEManager::GetMaxFramePayload() const {
+    constexpr size_t kFrameOverhead =
+        kAttNotifyHeaderSize + PacketConfig::kFrameHeaderSize + 1;
+    // Frames go to every link, so the smallest MTU decides.
+    size_t mtu = PacketConfig::kMaxFrameSize + kAttNotifyHeaderSize;
+    bool connected = false;
+    for (const Link& link : links_) {
+        if (link.conn_handle.load(std::memory_order_acquire) !=
+            BLE_HS_CONN_HANDLE_NONE) {
+            mtu = std::min<size_t>(mtu, link.att_mtu.load());
+            connected = true;
+        }
+    }
+    if (!connected) {
+        mtu = kDefaultAttMtu;
+    }
+    return mtu > kFrameOverhead
+               ? std::min(mtu - kFrameOverhead, PacketConfig::kMaxFramePayload)
+               : 0;
+}
+
+BLEManager::LatencyStats BLEManager::GetEventLatencyStats() const {
+    return LatencyStats{
+        .count = event_count_.load(std::memory_order_relaxed),
+        .last_us = event_last_latency_us_.load(std::memory_order_relaxed),
+        .max_us = event_max_latency_us_.load(std::memory_order_relaxed),
+        .over_target = event_over_target_.load(std::memory_order_relaxed),
+    };
+}
+
+void BLEManager::ResetEventLatencyStats() {
+    event_count_.store(0, std::memory_order_relaxed);
+    event_last_latency_us_.store(0, std::memory_order_relaxed);
+    event_max_latency_us_.store(0, std::memory_order_relaxed);
+    event_over_target_.store(0, std::memory_order_relaxed);
+}
+
 bool BLEManager::IsConnected() const {
-    return conn_handle_ != BLE_HS_CONN_HANDLE_NONE;
+    return std::any_of(links_.begin(), links_.end(), [](const Link& link) {
+        return link.conn_handle.load(std::memory_order_acquire) !=
+               BLE_HS_CONN_HANDLE_NONE;
+    });
 }
 
 bool BLEManager::IsAdvertising() const {
@@ -177,6 +370,11 @@ void BLEManager::SetOnAudioPacketReceivedCallback(
     on_audio_packet_received_cb_ = std::move(callback);
 }
 
+void BLEManager::SetOnFramePacketReceivedCallback(
+    std::function<void(const FramePacket&)> callback) {
+    on_frame_packet_received_cb_ = std::move(callback);
+}
+
 void BLEManager::SetOnErrorCallback(
     std::function<void(const std::string&)> callback) {
     on_error_cb_ = std::move(callback);
@@ -184,6 +382,85 @@ void BLEManager::SetOnErrorCallback(
 
 // Private Methods
 
+BLEManager::OutboundPacket BLEManager::MakeOutbound(const AudioPacket& packet,
+                                                   int64_t capture_time_us) {
+    OutboundPacket outbound;
+    const std::array<uint8_t, PacketConfig::kPacketSize> encoded =
+        PacketEncoder::Encode(packet);
+    std::copy(encoded.begin(), encoded.end(), outbound.data.begin());
+    outbound.length = encoded.size();
+    outbound.capture_time_us = capture_time_us;
+    outbound.time_sync_reply = false;
+    outbound.conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    return outbound;
+}
+
+bool BLEManager::DecimateFeature(FeatureDecimator& decimator, int8_t value,
+                                 int64_t capture_time_us, int8_t& output) {
+    const int64_t period_us =
+        static_cast<int64_t>(decimator.feature_rate & 0xFFFF) * 1000;
+    decimator.sum = decimator.count == 0 ? value : decimator.sum + value;
+    decimator.max = decimator.count == 0 ? value
+                                         : std::max(decimator.max, value);
+    ++decimator.count;
+    if (decimator.period_start_us != 0 &&
+        capture_time_us - decimator.period_start_us < period_us) {
+        return false;
+    }
+
+    switch (static_cast<FeatureAggregation>(decimator.feature_rate >> 16)) {
+        case FeatureAggregation::kMean:
+            output = static_cast<int8_t>(std::lround(
+                static_cast<float>(decimator.sum) / decimator.count));
+            break;
+        case FeatureAggregation::kMaxHold:
+            output = decimator.max;
+            break;
+        default:
+            output = value;
+            break;
+    }
+    decimator.count = 0;
+    // Periods follow each other without drifting by the frame remainder,
+    // unless the stream paused, e.g. while the noise gate was closed.
+    decimator.period_start_us += period_us;
+    if (capture_time_us - decimator.period_start_us >= period_us) {
+        decimator.period_start_us = capture_time_us;
+    }
+    return true;
+}
+
+const char* BLEManager::GetAggregationName(FeatureAggregation aggregation) {
+    switch (aggregation) {
+        case FeatureAggregation::kMean:
+            return "mean";
+        case FeatureAggregation::kMaxHold:
+            return "max-hold";
+        default:
+            return "sample";
+    }
+}
+
+BLEManager::Link* BLEManager::FindLink(uint16_t conn_handle) {
+    for (Link& link : links_) {
+        if (link.conn_handle.load(std::memory_order_acquire) == conn_handle) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t BLEManager::EnqueueStreamPacket(const OutboundPacket& outbound) {
+    if (xQueueSend(send_queue_, &outbound, pdMS_TO_TICKS(100)) != pdPASS) {
+        ESP_LOGE(kTag, "Send queue is full.");
+        if (on_error_cb_) {
+            on_error_cb_("Send queue is full.");
+        }
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
 std::unique_ptr<BLEManager> BLEManager::Create() {
     return std::unique_ptr<BLEManager>(new BLEManager());
 }
@@ -208,6 +485,20 @@ esp_err_t BLEManager::Initialize() {
     // Configure the NimBLE host with our static callback functions.
     ble_hs_cfg.reset_cb = BLEManager::OnReset;
     ble_hs_cfg.sync_cb = BLEManager::OnSync;
+    ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+
+    // Firmware updates need an authenticated link. The device has no
+    // input, so it pairs with a fixed passkey printed on the product;
+    // streaming works without pairing.
+    ble_hs_cfg.sm_io_cap = BLE_HS_IO_DISPLAY_ONLY;
+    ble_hs_cfg.sm_bonding = 1;
+    ble_hs_cfg.sm_mitm = 1;
+    ble_hs_cfg.sm_sc = 1;
+    ble_hs_cfg.sm_our_key_dist = BLE_SM_PAIR_KEY_DIST_ENC |
+                                 BLE_SM_PAIR_KEY_DIST_ID;
+    ble_hs_cfg.sm_their_key_dist = BLE_SM_PAIR_KEY_DIST_ENC |
+                                   BLE_SM_PAIR_KEY_DIST_ID;
+    ble_store_config_init();
 
     ble_svc_gap_init();
     ble_svc_gatt_init();
@@ -217,8 +508,18 @@ esp_err_t BLEManager::Initialize() {
         return ret;
     }
 
-    send_queue_ = xQueueCreate(
-        10, sizeof(std::array<uint8_t, PacketConfig::kPacketSize>));
+    // Both the streaming and the send task copy every packet through the
+    // queue, so its storage is kept in internal RAM.
+    send_queue_storage_ = memory::MemoryPlacement::Allocate<uint8_t>(
+        memory::BufferClass::kHotScratch,
+        kSendQueueLength * sizeof(OutboundPacket));
+    if (!send_queue_storage_) {
+        ESP_LOGE(kTag, "Failed to allocate send queue storage.");
+        return ESP_ERR_NO_MEM;
+    }
+    send_queue_ =
+        xQueueCreateStatic(kSendQueueLength, sizeof(OutboundPacket),
+                           send_queue_storage_.get(), &send_queue_buffer_);
     if (send_queue_ == nullptr) {
         ESP_LOGE(kTag, "Failed to create send queue.");
         return ESP_ERR_NO_MEM;
@@ -257,23 +558,67 @@ esp_err_t BLEManager::RegisterGattServices() {
 
 void BLEManager::HandleGapEvent(struct ble_gap_event* event) {
     switch (event->type) {
-        case BLE_GAP_EVENT_CONNECT:
+        case BLE_GAP_EVENT_CONNECT: {
+            if (event->connect.status != 0) {
+                ESP_LOGW(kTag, "Connection failed; status=%d",
+                         event->connect.status);
+                StartAdvertising();
+                break;
+            }
+            Link* link = FindLink(BLE_HS_CONN_HANDLE_NONE);
+            if (link == nullptr) {
+                ESP_LOGW(kTag, "No free link for conn_handle=%d.",
+                         event->connect.conn_handle);
+                ble_gap_terminate(event->connect.conn_handle,
+                                  BLE_ERR_REM_USER_CONN_TERM);
+                break;
+            }
             ESP_LOGI(kTag, "Device connected; conn_handle=%d",
                      event->connect.conn_handle);
-            conn_handle_ = event->connect.conn_handle;
-            if (on_connected_cb_) {
+            const bool first = !IsConnected();
+            link->att_mtu = kDefaultAttMtu;
+            link->feature_rate = PackFeatureRate(kDefaultFeaturePeriodMs,
+                                                 FeatureAggregation::kSample);
+            link->session.fetch_add(1, std::memory_order_relaxed);
+            link->conn_handle.store(event->connect.conn_handle,
+                                    std::memory_order_release);
+            // Clock sync replies and larger frames need more than the
+            // default MTU, so ask for it rather than wait for the client.
+            if (ble_gattc_exchange_mtu(event->connect.conn_handle, nullptr,
+                                       nullptr) != 0) {
+                ESP_LOGW(kTag, "Failed to start MTU exchange.");
+            }
+            // Keep advertising while another client fits.
+            if (FindLink(BLE_HS_CONN_HANDLE_NONE) != nullptr) {
+                StartAdvertising();
+            }
+            if (first && on_connected_cb_) {
                 on_connected_cb_();
             }
             break;
+        }
 
-        case BLE_GAP_EVENT_DISCONNECT:
-            ESP_LOGW(kTag, "Device disconnected; reason=%d",
-                     event->disconnect.reason);
-            conn_handle_ = BLE_HS_CONN_HANDLE_NONE;
-            if (on_disconnected_cb_) {
+        case BLE_GAP_EVENT_DISCONNECT: {
+            const uint16_t conn_handle = event->disconnect.conn.conn_handle;
+            ESP_LOGW(kTag, "Device disconnected; conn_handle=%d, reason=%d",
+                     conn_handle, event->disconnect.reason);
+            Link* link = FindLink(conn_handle);
+            if (link == nullptr) {
+                break;
+            }
+            link->conn_handle.store(BLE_HS_CONN_HANDLE_NONE,
+                                    std::memory_order_release);
+            if (clock_sync_conn_handle_ == conn_handle) {
+                clock_sync_conn_handle_ = BLE_HS_CONN_HANDLE_NONE;
+            }
+            // Advertising stopped once every link was taken; the freed one
+            // can take a new client.
+            StartAdvertising();
+            if (!IsConnected() && on_disconnected_cb_) {
                 on_disconnected_cb_();
             }
             break;
+        }
 
         case BLE_GAP_EVENT_ADV_COMPLETE:
             ESP_LOGI(kTag, "Advertising complete; reason=%d",
@@ -290,6 +635,36 @@ void BLEManager::HandleGapEvent(struct ble_gap_event* event) {
                      event->subscribe.cur_notify);
             break;
 
+        case BLE_GAP_EVENT_PASSKEY_ACTION: {
+            if (event->passkey.params.action != BLE_SM_IOACT_DISP) {
+                ESP_LOGW(kTag, "Unsupported pairing action %d.",
+                         event->passkey.params.action);
+                break;
+            }
+            struct ble_sm_io io;
+            memset(&io, 0, sizeof(io));
+            io.action = BLE_SM_IOACT_DISP;
+            io.passkey = CONFIG_SONAFLOW_BLE_PASSKEY;
+            const int rc = ble_sm_inject_io(event->passkey.conn_handle, &io);
+            if (rc != 0) {
+                ESP_LOGE(kTag, "Failed to set passkey; rc=%d", rc);
+            }
+            break;
+        }
+
+        case BLE_GAP_EVENT_ENC_CHANGE:
+            ESP_LOGI(kTag, "Encryption changed; conn_handle=%d, status=%d",
+                     event->enc_change.conn_handle, event->enc_change.status);
+            break;
+
+        case BLE_GAP_EVENT_MTU:
+            ESP_LOGI(kTag, "MTU updated; conn_handle=%d, mtu=%d",
+                     event->mtu.conn_handle, event->mtu.value);
+            if (Link* link = FindLink(event->mtu.conn_handle)) {
+                link->att_mtu = event->mtu.value;
+            }
+            break;
+
         default:
             break;
     }
@@ -316,11 +691,53 @@ int BLEManager::GapEventHandler(struct ble_gap_event* event, void* arg) {
 int BLEManager::GattAccessCallback(uint16_t conn_handle, uint16_t attr_handle,
                                    struct ble_gatt_access_ctxt* ctxt,
                                    void* arg) {
+    if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR) {
+        if (attr_handle != g_snapshot_characteristic_handle) {
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+        return GetInstance()->ReadSnapshot(ctxt->om);
+    }
+
     // Handle write requests from the client.
     if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
+        // Taken first, as the receive time of clock sync requests.
+        const int64_t receive_time_us = esp_timer_get_time();
+        // Long writes may arrive as a chain of mbufs.
+        std::array<uint8_t, PacketConfig::kMaxFrameSize> data;
+        uint16_t length = 0;
+        if (ble_hs_mbuf_to_flat(ctxt->om, data.data(), data.size(),
+                                &length) != 0) {
+            ESP_LOGW(kTag, "Received packet too long.");
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        if (length > 0 && data[0] == PacketConfig::kFrameSync) {
+            ble::FramePacket frame;
+            if (!PacketDecoder::DecodeFrame(data.data(), length, frame)) {
+                ESP_LOGW(kTag, "Failed to decode received frame.");
+            } else if (frame.data_type == PacketConfig::kDataTypeTimeSync) {
+                GetInstance()->HandleTimeSyncRequest(conn_handle, frame,
+                                                     receive_time_us);
+            } else if (frame.data_type ==
+                       PacketConfig::kDataTypeFeatureRate) {
+                GetInstance()->HandleFeatureRateRequest(conn_handle, frame);
+            } else if (frame.data_type == PacketConfig::kDataTypeOta &&
+                       !IsLinkAuthenticated(conn_handle)) {
+                // Lets the client start pairing; write commands are
+                // dropped without a reply.
+                ESP_LOGW(kTag, "OTA request on unauthenticated link %d.",
+                         conn_handle);
+                return BLE_ATT_ERR_INSUFFICIENT_AUTHEN;
+            } else if (GetInstance()->on_frame_packet_received_cb_) {
+                GetInstance()->on_frame_packet_received_cb_(frame);
+            } else {
+                ESP_LOGW(kTag, "Unhandled frame type 0x%02x.",
+                         frame.data_type);
+            }
+            return 0;
+        }
+
         ble::AudioPacket packet;
-        if (PacketDecoder::Decode(ctxt->om->om_data, ctxt->om->om_len,
-                                  packet)) {
+        if (PacketDecoder::Decode(data.data(), length, packet)) {
             if (GetInstance()->on_audio_packet_received_cb_) {
                 GetInstance()->on_audio_packet_received_cb_(packet);
             }
@@ -342,25 +759,185 @@ void BLEManager::NimbleHostTask(void* /*param*/) {
 
 void BLEManager::SendTask(void* param) {
     BLEManager* manager = static_cast<BLEManager*>(param);
-    std::array<uint8_t, PacketConfig::kPacketSize> packet_data;
+    OutboundPacket packet;
 
     ESP_LOGI(kTag, "Send Task Started.");
 
     while (true) {
         // Block until an item is available in the queue.
-        if (xQueueReceive(manager->send_queue_, &packet_data, portMAX_DELAY) ==
+        if (xQueueReceive(manager->send_queue_, &packet, portMAX_DELAY) ==
             pdPASS) {
-            if (manager->conn_handle_ != BLE_HS_CONN_HANDLE_NONE) {
-                struct os_mbuf* om = ble_hs_mbuf_from_flat(packet_data.data(),
-                                                           packet_data.size());
-                int rc = ble_gattc_notify_custom(
-                    manager->conn_handle_, g_audio_characteristic_handle, om);
-                if (rc != 0) {
-                    ESP_LOGE(kTag, "Error sending notification; rc=%d", rc);
-                }
-            }
+            manager->NotifyLinks(packet);
+        }
+    }
+}
+
+void BLEManager::NotifyLinks(OutboundPacket& packet) {
+    for (Link& link : links_) {
+        const uint16_t conn_handle =
+            link.conn_handle.load(std::memory_order_acquire);
+        if (conn_handle == BLE_HS_CONN_HANDLE_NONE ||
+            (packet.conn_handle != BLE_HS_CONN_HANDLE_NONE &&
+             packet.conn_handle != conn_handle)) {
+            continue;
+        }
+        if (packet.length + kAttNotifyHeaderSize > link.att_mtu) {
+            ESP_LOGW(kTag, "Packet of %u bytes exceeds MTU %u, dropped.",
+                     packet.length, link.att_mtu.load());
+            continue;
+        }
+        if (packet.time_sync_reply) {
+            StampTimeSyncReply(packet);
+        }
+        // The stack consumes the mbuf, so every link gets its own.
+        struct os_mbuf* om =
+            ble_hs_mbuf_from_flat(packet.data.data(), packet.length);
+        int rc = ble_gattc_notify_custom(conn_handle,
+                                         g_audio_characteristic_handle, om);
+        if (rc != 0) {
+            ESP_LOGE(kTag, "Error sending notification; rc=%d", rc);
+        } else if (packet.capture_time_us != 0) {
+            RecordEventLatency(esp_timer_get_time() - packet.capture_time_us);
         }
     }
 }
 
+void BLEManager::HandleTimeSyncRequest(uint16_t conn_handle,
+                                       const FramePacket& request,
+                                       int64_t receive_time_us) {
+    // Stated in the kDataTypeTimeSync protocol description.
+    static_assert(kTimeSyncMinAttMtu == 38);
+    if (request.length != kTimeSyncRequestSize &&
+        request.length != kTimeSyncReceiptSize) {
+        ESP_LOGW(kTag, "Malformed clock sync request (%u bytes).",
+                 request.length);
+        return;
+    }
+    const Link* link = FindLink(conn_handle);
+    if (link == nullptr) {
+        return;
+    }
+    const uint16_t att_mtu = link->att_mtu.load();
+    const bool refused = att_mtu < kTimeSyncMinAttMtu;
+    if (refused) {
+        ESP_LOGW(kTag, "Clock sync needs an ATT MTU of %u, link has %u.",
+                 kTimeSyncMinAttMtu, att_mtu);
+    } else if (conn_handle != clock_sync_conn_handle_) {
+        // One clock is followed at a time; another client brings a new
+        // clock.
+        if (clock_sync_conn_handle_ != BLE_HS_CONN_HANDLE_NONE) {
+            ESP_LOGD(kTag, "Clock sync follows conn_handle=%d, ignored.",
+                     clock_sync_conn_handle_);
+            return;
+        }
+        clock_sync_conn_handle_ = conn_handle;
+        clock_sync_.Reset();
+    }
+
+    // Complete the previous exchange first, its reply has been sent.
+    if (!refused && request.length == kTimeSyncReceiptSize) {
+        clock_sync_.OnReplyReceived(
+            request.payload[kTimeSyncRequestSize],
+            GetBigEndian64(&request.payload[kTimeSyncRequestSize + 1]));
+    }
+
+    const uint8_t id = request.payload[0];
+    const int64_t client_transmit_us = GetBigEndian64(&request.payload[1]);
+    FramePacket reply = {
+        .data_type = PacketConfig::kDataTypeTimeSync,
+        .sequence = time_sync_sequence_++,
+        .timestamp = static_cast<uint32_t>(receive_time_us / 1000),
+        .length = static_cast<uint8_t>(refused ? kTimeSyncRefusalSize
+                                               : kTimeSyncReplySize),
+    };
+    reply.payload[0] = id;
+    if (!refused) {
+        clock_sync_.OnRequest(id, client_transmit_us, receive_time_us);
+        PutBigEndian64(&reply.payload[1], client_transmit_us);
+        PutBigEndian64(&reply.payload[9], receive_time_us);
+        // The transmit time t3 is filled in by the send task.
+        PutBigEndian64(&reply.payload[kTimeSyncTransmitOffset], 0);
+    }
+
+    OutboundPacket outbound;
+    outbound.length = PacketEncoder::EncodeFrame(reply, outbound.data);
+    outbound.capture_time_us = 0;
+    outbound.time_sync_reply = !refused;
+    outbound.conn_handle = conn_handle;
+
+    // Time spent queued falls between t2 and t3 and cancels out, but like
+    // events the reply jumps the queue so it never waits behind a backlog.
+    if (xQueueSendToFront(send_queue_, &outbound, 0) != pdPASS) {
+        ESP_LOGW(kTag, "Send queue is full, clock sync reply dropped.");
+    }
+}
+
+void BLEManager::HandleFeatureRateRequest(uint16_t conn_handle,
+                                          const FramePacket& request) {
+    Link* link = FindLink(conn_handle);
+    if (link == nullptr) {
+        return;
+    }
+    if (request.length != kFeatureRateRequestSize ||
+        request.payload[2] >=
+            static_cast<uint8_t>(FeatureAggregation::kCount)) {
+        ESP_LOGW(kTag, "Malformed feature rate request (%u bytes).",
+                 request.length);
+        return;
+    }
+
+    uint16_t period_ms = (request.payload[0] << 8) | request.payload[1];
+    if (period_ms == 0) {
+        period_ms = kDefaultFeaturePeriodMs;
+    }
+    const auto aggregation =
+        static_cast<FeatureAggregation>(request.payload[2]);
+    link->feature_rate.store(PackFeatureRate(period_ms, aggregation),
+                             std::memory_order_relaxed);
+    ESP_LOGI(kTag, "Feature stream of conn_handle=%d: every %u ms, %s.",
+             conn_handle, period_ms, GetAggregationName(aggregation));
+}
+
+void BLEManager::StampTimeSyncReply(OutboundPacket& packet) {
+    const int64_t transmit_time_us = esp_timer_get_time();
+    uint8_t* payload = &packet.data[PacketConfig::kFrameHeaderSize];
+    PutBigEndian64(&payload[kTimeSyncTransmitOffset], transmit_time_us);
+    packet.data[packet.length - 1] =
+        PacketEncoder::CalculateChecksum(packet.data.data(), packet.length - 1);
+    clock_sync_.OnReplySent(payload[0], transmit_time_us);
+}
+
+int BLEManager::ReadSnapshot(struct os_mbuf* om) {
+    // Runs in the NimBLE host task, so it must not block.
+    bool loaded = false;
+    for (int attempt = 0; attempt < kSnapshotReadAttempts && !loaded;
+         ++attempt) {
+        loaded = snapshot_.TryLoad(last_snapshot_);
+    }
+    if (!loaded) {
+        ESP_LOGD(kTag, "Snapshot busy, serving the previous one.");
+    }
+    // Before the first publish the value is empty.
+    if (os_mbuf_append(om, last_snapshot_.data.data(),
+                       last_snapshot_.length) != 0) {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
+    }
+    return 0;
+}
+
+void BLEManager::RecordEventLatency(int64_t latency_us) {
+    const uint32_t latency = static_cast<uint32_t>(latency_us);
+    event_count_.fetch_add(1, std::memory_order_relaxed);
+    event_last_latency_us_.store(latency, std::memory_order_relaxed);
+    if (latency > event_max_latency_us_.load(std::memory_order_relaxed)) {
+        event_max_latency_us_.store(latency, std::memory_order_relaxed);
+    }
+    if (latency > kEventLatencyTargetUs) {
+        event_over_target_.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGW(kTag, "Event latency %lu us exceeds the %lu us target.",
+                 static_cast<unsigned long>(latency),
+                 static_cast<unsigned long>(kEventLatencyTargetUs));
+    }
+}
+
 }  // namespace ble
\ No newline at end of file
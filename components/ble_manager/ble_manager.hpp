@@ -2,6 +2,7 @@
 #define BLE_MANAGER_HPP_
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -9,6 +10,7 @@
 
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
+#include "sdkconfig.h"
 
 // NimBLE header files
 #include "host/ble_hs.h"
@@ -18,6 +20,9 @@
 
 // Your custom packet header
 #include "ble_packet.hpp"
+#include "clock_sync.hpp"
+#include "memory_placement.hpp"
+#include "seqlock.hpp"
 
 namespace ble {
 
@@ -29,9 +34,41 @@ namespace ble {
  * advertising, connection events, data transfer, and security.
  * The class is implemented as a singleton to ensure a single, consistent
  * point of control over the BLE radio.
+ *
+ * Up to kMaxLinks clients may be connected at once. Stream packets go to
+ * every link, except the feature stream, which every link receives at its
+ * own rate, see SendFeaturePacket().
  */
 class BLEManager {
    public:
+    /**
+     * @brief Capture-to-notify latency statistics of event packets.
+     */
+    struct LatencyStats {
+        uint32_t count;        // Number of event packets notified
+        uint32_t last_us;      // Latency of the most recent event
+        uint32_t max_us;       // Worst latency seen since the last reset
+        uint32_t over_target;  // Events that missed kEventLatencyTargetUs
+    };
+
+    /**
+     * @brief How a link reduces the feature stream to its own rate.
+     */
+    enum class FeatureAggregation : uint8_t {
+        kSample = 0,  // The latest value
+        kMean,        // The mean over the period
+        kMaxHold,     // The largest value over the period
+        kCount,
+    };
+
+    // Capture-to-notify latency budget of event packets.
+    static constexpr uint32_t kEventLatencyTargetUs = 20 * 1000;
+
+    // Clients that may be connected at once.
+    static constexpr size_t kMaxLinks = CONFIG_BT_NIMBLE_MAX_CONNECTIONS;
+    // Feature stream period of a link until its client asks for another.
+    static constexpr uint16_t kDefaultFeaturePeriodMs = 20;
+
     /**
      * @brief Singleton Factory Method. Creates and initializes the unique BLEManager instance.
      *
@@ -80,7 +117,90 @@ class BLEManager {
     esp_err_t SendAudioPacket(const ble::AudioPacket& packet);
 
     /**
-     * @brief Checks if a client device is currently connected.
+     * @brief Sends the feature stream to every link at the link's own rate.
+     * * Call with the kDataTypeAudio packet of every frame. Each link
+     * reduces the stream to the period and aggregation its client asked
+     * for with a kDataTypeFeatureRate frame, by default the latest value
+     * every kDefaultFeaturePeriodMs; the first packet after connecting or
+     * changing the rate goes out right away. Other packet types, such as
+     * heartbeats, go to every link as they are. Each link numbers its
+     * stream itself, so the sequence of the packet is ignored. Only one
+     * task may send the feature stream.
+     * * @param packet A kDataTypeAudio or kDataTypeHeartbeat packet.
+     * @param capture_time_us esp_timer time at which the packet's frame was
+     * captured, which paces the decimation.
+     * @return esp_err_t ESP_OK on success, or the error of the last link
+     * that failed.
+     */
+    esp_err_t SendFeaturePacket(const ble::AudioPacket& packet,
+                                int64_t capture_time_us);
+
+    /**
+     * @brief Sends a time-critical event packet ahead of the feature stream.
+     * * The packet is placed at the front of the send queue so that it
+     * overtakes any queued feature packets. The call never blocks; if the
+     * queue is full the event is dropped, since a late event is worthless.
+     * * @param packet The ble::AudioPacket describing the event.
+     * @param capture_time_us esp_timer time at which the event was captured,
+     * used to measure the capture-to-notify latency.
+     * @return esp_err_t ESP_OK on success, or an error code otherwise.
+     */
+    esp_err_t SendEventPacket(const ble::AudioPacket& packet,
+                              int64_t capture_time_us);
+
+    /**
+     * @brief Sends a variable-length frame packet over BLE.
+     * * Frames share the send queue with audio packets. A frame longer than
+     * the negotiated ATT MTU allows is dropped by the send task.
+     * * @param packet The ble::FramePacket to be sent.
+     * @return esp_err_t ESP_OK on success, or an error code otherwise.
+     */
+    esp_err_t SendFramePacket(const ble::FramePacket& packet);
+
+    /**
+     * @brief Publishes the value served by the snapshot characteristic.
+     * * Clients that poll instead of subscribing read the latest snapshot
+     * on demand. The call never blocks: the NimBLE host task reads the
+     * value through a seqlock. Only one task may publish.
+     * * @param snapshot A kDataTypeSnapshot frame.
+     * @return esp_err_t ESP_OK on success, or ESP_ERR_INVALID_SIZE if the
+     * frame is too long for the characteristic.
+     */
+    esp_err_t PublishSnapshot(const ble::FramePacket& snapshot);
+
+    /**
+     * @brief Returns the largest frame payload that fits one notification
+     * at the ATT MTU of every link.
+     */
+    size_t GetMaxFramePayload() const;
+
+    /**
+     * @brief Returns the share of the send queue in use, 0.0 to 1.0.
+     * * A persistently full queue means the link cannot keep up.
+     */
+    float GetSendQueueOccupancy() const;
+
+    /**
+     * @brief Returns the capture-to-notify latency of event packets.
+     * @return A snapshot of the latency statistics.
+     */
+    LatencyStats GetEventLatencyStats() const;
+
+    /**
+     * @brief Clears the event latency statistics.
+     */
+    void ResetEventLatencyStats();
+
+    /**
+     * @brief Returns the synchronisation with a connected client's clock.
+     * * With several links, the first client to request synchronisation is
+     * followed until it disconnects, and requests from the others are
+     * ignored. The estimate is reset whenever another client takes over.
+     */
+    const ClockSync& GetClockSync() const { return clock_sync_; }
+
+    /**
+     * @brief Checks if any client device is currently connected.
      * @return true if connected, false otherwise.
      */
     bool IsConnected() const;
@@ -100,12 +220,14 @@ class BLEManager {
 
     /**
      * @brief Sets the callback for a successful connection event.
+     * * Only the first link to connect calls it.
      * @param callback The function to be called when a connection is established.
      */
     void SetOnConnectedCallback(std::function<void()> callback);
 
     /**
      * @brief Sets the callback for a disconnection event.
+     * * Only the last link to disconnect calls it.
      * @param callback The function to be called when the device disconnects.
      */
     void SetOnDisconnectedCallback(std::function<void()> callback);
@@ -117,6 +239,15 @@ class BLEManager {
     void SetOnAudioPacketReceivedCallback(
         std::function<void(const ble::AudioPacket&)> callback);
 
+    /**
+     * @brief Sets the callback for frame packets written by the client.
+     * * Frames the BLEManager handles itself, such as clock sync requests,
+     * are not passed on. The callback runs in the BLE host task.
+     * @param callback The function to be called with the received frame.
+     */
+    void SetOnFramePacketReceivedCallback(
+        std::function<void(const ble::FramePacket&)> callback);
+
     /**
      * @brief Sets the callback for reporting errors.
      * @param callback The function to be called with an error message.
@@ -133,6 +264,123 @@ class BLEManager {
                                   struct ble_gatt_access_ctxt* ctxt, void* arg);
 
    private:
+    /**
+     * @brief An encoded packet waiting in the send queue.
+     */
+    struct OutboundPacket {
+        std::array<uint8_t, PacketConfig::kMaxFrameSize> data;
+        uint16_t length;
+        // Capture time of an event packet, or 0 for stream packets.
+        int64_t capture_time_us;
+        // Clock sync replies get their transmit time stamped on sending.
+        bool time_sync_reply;
+        // The link to notify, or BLE_HS_CONN_HANDLE_NONE for every link.
+        uint16_t conn_handle;
+    };
+
+    /**
+     * @brief A connected client.
+     * * Written by the NimBLE host task; read by the send task and the task
+     * sending the feature stream.
+     */
+    struct Link {
+        std::atomic<uint16_t> conn_handle{BLE_HS_CONN_HANDLE_NONE};
+        std::atomic<uint16_t> att_mtu{kDefaultAttMtu};
+        // Counts connections on this slot, so feature state of a previous
+        // client is never carried over.
+        std::atomic<uint32_t> session{0};
+        // Packed by PackFeatureRate(), set on connect.
+        std::atomic<uint32_t> feature_rate{0};
+    };
+
+    /**
+     * @brief Decimation state of a link's feature stream.
+     * * Owned by the task sending the feature stream.
+     */
+    struct FeatureDecimator {
+        uint32_t session;
+        uint32_t feature_rate;
+        uint16_t sequence;
+        // Start of the current period; the first packet closes it at once.
+        int64_t period_start_us;
+        int32_t sum;
+        uint16_t count;
+        int8_t max;
+    };
+
+    /**
+     * @brief The encoded frame served by the snapshot characteristic.
+     */
+    struct Snapshot {
+        std::array<uint8_t, PacketConfig::kMaxSnapshotSize> data;
+        uint16_t length;
+    };
+
+    // Layout of kDataTypeTimeSync payloads.
+    static constexpr size_t kTimeSyncRequestSize = 9;
+    static constexpr size_t kTimeSyncReceiptSize = 18;
+    static constexpr size_t kTimeSyncReplySize = 25;
+    static constexpr size_t kTimeSyncTransmitOffset = 17;
+    // Layout of kDataTypeFeatureRate payloads.
+    static constexpr size_t kFeatureRateRequestSize = 3;
+
+    static constexpr UBaseType_t kSendQueueLength = 10;
+
+    // ATT MTU before the client negotiates a larger one.
+    static constexpr uint16_t kDefaultAttMtu = 23;
+    // ATT notification header: opcode and attribute handle.
+    static constexpr uint16_t kAttNotifyHeaderSize = 3;
+    // Smallest ATT MTU that carries a clock sync receipt and reply. Below
+    // it a request is refused with a reply holding only the exchange id.
+    static constexpr uint16_t kTimeSyncMinAttMtu =
+        kAttNotifyHeaderSize + PacketConfig::kFrameHeaderSize +
+        kTimeSyncReplySize + 1;
+    static constexpr size_t kTimeSyncRefusalSize = 1;
+
+    /**
+     * @brief Wraps an encoded fixed-size packet for the send queue.
+     */
+    static OutboundPacket MakeOutbound(const AudioPacket& packet,
+                                       int64_t capture_time_us);
+
+    /**
+     * @brief Packs a feature period and aggregation into one word, so both
+     * change together.
+     */
+    static constexpr uint32_t PackFeatureRate(uint16_t period_ms,
+                                              FeatureAggregation aggregation) {
+        return period_ms | static_cast<uint32_t>(aggregation) << 16;
+    }
+
+    /**
+     * @brief Adds one value to a link's feature stream.
+     * @param output Set to the aggregated value when one is due.
+     * @return true if the link's period closed and a packet is due.
+     */
+    static bool DecimateFeature(FeatureDecimator& decimator, int8_t value,
+                                int64_t capture_time_us, int8_t& output);
+
+    /**
+     * @brief Returns a short name for an aggregation, for logs.
+     */
+    static const char* GetAggregationName(FeatureAggregation aggregation);
+
+    /**
+     * @brief Returns the link of a connection, or nullptr.
+     * * Pass BLE_HS_CONN_HANDLE_NONE to find a free slot.
+     */
+    Link* FindLink(uint16_t conn_handle);
+
+    /**
+     * @brief Queues a stream packet, waiting briefly for space.
+     */
+    esp_err_t EnqueueStreamPacket(const OutboundPacket& outbound);
+
+    /**
+     * @brief Notifies a dequeued packet to its link or links.
+     */
+    void NotifyLinks(OutboundPacket& packet);
+
     BLEManager() = default;
 
     /**
@@ -170,6 +418,46 @@ class BLEManager {
      */
     static void SendTask(void* param);
 
+    /**
+     * @brief Answers a clock sync request and completes the exchange the
+     * client reports the receipt of.
+     * @param conn_handle The link the request arrived on.
+     * @param request The decoded kDataTypeTimeSync frame.
+     * @param receive_time_us esp_timer time at which the write arrived.
+     */
+    void HandleTimeSyncRequest(uint16_t conn_handle,
+                               const FramePacket& request,
+                               int64_t receive_time_us);
+
+    /**
+     * @brief Applies a client's feature stream rate to its link.
+     * @param conn_handle The link the request arrived on.
+     * @param request The decoded kDataTypeFeatureRate frame.
+     */
+    void HandleFeatureRateRequest(uint16_t conn_handle,
+                                  const FramePacket& request);
+
+    /**
+     * @brief Stamps the transmit time into a clock sync reply.
+     */
+    void StampTimeSyncReply(OutboundPacket& packet);
+
+    /**
+     * @brief Serves a read of the snapshot characteristic.
+     *
+     * Never waits for the writer: if a publish keeps overlapping the copy,
+     * the last value read consistently is served.
+     *
+     * @return 0 on success, or a BLE_ATT_ERR_* code.
+     */
+    int ReadSnapshot(struct os_mbuf* om);
+
+    /**
+     * @brief Updates the event latency statistics after a notification.
+     * @param latency_us Time from event capture to notification.
+     */
+    void RecordEventLatency(int64_t latency_us);
+
     /**
      * @brief Static callback for NimBLE stack synchronization events.
      */
@@ -205,12 +493,33 @@ class BLEManager {
     std::function<void()> on_connected_cb_;
     std::function<void()> on_disconnected_cb_;
     std::function<void(const ble::AudioPacket&)> on_audio_packet_received_cb_;
+    std::function<void(const ble::FramePacket&)> on_frame_packet_received_cb_;
     std::function<void(const std::string& error_message)> on_error_cb_;
 
-    uint16_t conn_handle_ = BLE_HS_CONN_HANDLE_NONE;
+    std::array<Link, kMaxLinks> links_;
+    // Indexed like links_.
+    std::array<FeatureDecimator, kMaxLinks> feature_decimators_{};
 
     QueueHandle_t send_queue_ = nullptr;
+    StaticQueue_t send_queue_buffer_{};
+    memory::MemoryPlacement::UniquePtr<uint8_t> send_queue_storage_;
     TaskHandle_t send_task_handle_ = nullptr;
+
+    ClockSync clock_sync_;
+    // The link clock_sync_ follows, written by the NimBLE host task only.
+    uint16_t clock_sync_conn_handle_ = BLE_HS_CONN_HANDLE_NONE;
+
+    // Written by the streaming task, read by the NimBLE host task.
+    SeqLock<Snapshot> snapshot_;
+    // The last consistent copy of snapshot_, owned by the NimBLE host task.
+    Snapshot last_snapshot_{};
+    uint16_t time_sync_sequence_ = 0;
+
+    // Event latency statistics, written by the send task only.
+    std::atomic<uint32_t> event_count_{0};
+    std::atomic<uint32_t> event_last_latency_us_{0};
+    std::atomic<uint32_t> event_max_latency_us_{0};
+    std::atomic<uint32_t> event_over_target_{0};
 };
 
 }  // namespace ble
@@ -31,6 +31,38 @@ std::array<uint8_t, PacketConfig::kPacketSize> PacketEncoder::Encode(
     return encoded_data;
 }
 
+size_t PacketEncoder::EncodeFrame(
+    const FramePacket& packet,
+    std::array<uint8_t, PacketConfig::kMaxFrameSize>& encoded_data) {
+    if (packet.length > PacketConfig::kMaxFramePayload) {
+        return 0;
+    }
+
+    encoded_data[0] = PacketConfig::kFrameSync;
+    encoded_data[1] = packet.data_type;
+
+    // Convert sequence number to big-endian
+    encoded_data[2] = (packet.sequence >> 8) & 0xFF;
+    encoded_data[3] = packet.sequence & 0xFF;
+
+    // Convert timestamp to big-endian
+    encoded_data[4] = (packet.timestamp >> 24) & 0xFF;
+    encoded_data[5] = (packet.timestamp >> 16) & 0xFF;
+    encoded_data[6] = (packet.timestamp >> 8) & 0xFF;
+    encoded_data[7] = packet.timestamp & 0xFF;
+
+    encoded_data[8] = packet.length;
+    memcpy(&encoded_data[PacketConfig::kFrameHeaderSize],
+           packet.payload.data(), packet.length);
+
+    const size_t checksum_offset =
+        PacketConfig::kFrameHeaderSize + packet.length;
+    encoded_data[checksum_offset] =
+        CalculateChecksum(encoded_data.data(), checksum_offset);
+
+    return checksum_offset + 1;
+}
+
 uint8_t PacketEncoder::CalculateChecksum(const uint8_t* data, size_t size) {
     uint8_t checksum = 0;
     for (size_t i = 0; i < size; ++i) {
@@ -62,6 +94,36 @@ bool PacketDecoder::Decode(const uint8_t* data, size_t size,
     return true;
 }
 
+bool PacketDecoder::DecodeFrame(const uint8_t* data, size_t size,
+                                FramePacket& packet) {
+    if (size < PacketConfig::kFrameHeaderSize + 1 ||
+        data[0] != PacketConfig::kFrameSync) {
+        return false;
+    }
+
+    const size_t length = data[8];
+    if (length > PacketConfig::kMaxFramePayload ||
+        size != PacketConfig::kFrameHeaderSize + length + 1) {
+        return false;
+    }
+
+    // Validate checksum (last byte is checksum of preceding bytes)
+    if (PacketEncoder::CalculateChecksum(data, size - 1) != data[size - 1]) {
+        return false;
+    }
+
+    packet.data_type = data[1];
+    packet.sequence = (static_cast<uint16_t>(data[2]) << 8) | data[3];
+    packet.timestamp = (static_cast<uint32_t>(data[4]) << 24) |
+                       (static_cast<uint32_t>(data[5]) << 16) |
+                       (static_cast<uint32_t>(data[6]) << 8) | data[7];
+    packet.length = static_cast<uint8_t>(length);
+    memcpy(packet.payload.data(), &data[PacketConfig::kFrameHeaderSize],
+           length);
+
+    return true;
+}
+
 bool PacketDecoder::ValidatePacket(const uint8_t* data, size_t size) {
     if (size != PacketConfig::kPacketSize) {
         return false;
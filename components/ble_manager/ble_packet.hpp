@@ -1,6 +1,8 @@
 #ifndef BLE_PACKET_HPP_
 #define BLE_PACKET_HPP_
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -13,6 +15,92 @@ struct PacketConfig {
     static constexpr size_t kPacketSize = 10;
     static constexpr uint8_t kHeaderSync = 0xAA;
     static constexpr uint8_t kDataTypeAudio = 0x01;
+    // Event packets, sent ahead of the feature stream. The timestamp is the
+    // capture time of the event rather than the send time.
+    static constexpr uint8_t kDataTypeOnset = 0x02;  // Payload: rise, 0.5 dB
+    static constexpr uint8_t kDataTypeBeat = 0x03;   // Payload: tempo, 2 BPM
+    // Payload: bit 6 set if the tone started, bits 0-5 the tone index:
+    // 0 smoke alarm, 1 mains hum (50 or 60 Hz).
+    static constexpr uint8_t kDataTypeTone = 0x04;
+    // Sent instead of the feature stream while the environment is quiet.
+    // Shares the stream's sequence, which counts per connection. Payload:
+    // noise floor in dB.
+    static constexpr uint8_t kDataTypeHeartbeat = 0x06;
+
+    // Variable-length frame packets, for payloads that do not fit one byte.
+    // The largest frame fits one notification at an ATT MTU of 247.
+    static constexpr uint8_t kFrameSync = 0xAB;
+    static constexpr size_t kFrameHeaderSize = 9;
+    static constexpr size_t kMaxFramePayload = 234;
+    static constexpr size_t kMaxFrameSize =
+        kFrameHeaderSize + kMaxFramePayload + 1;
+    // Payload: per-hop (pitch in 0.1 Hz as big-endian uint16, confidence
+    // 0-255) triplets, as many as the smallest link MTU allows; a period's
+    // hops may span several frames. Timestamp: capture time of the first
+    // hop.
+    static constexpr uint8_t kDataTypePitch = 0x05;
+    // Audio frames start with the capture block exponent (int8): decoded
+    // samples times 2^exponent are at the calibrated nominal scale.
+    // Payload: exponent, then one IMA-ADPCM block (see dsp::ImaAdpcmEncoder)
+    // of 11.025 kHz mono audio. Timestamp: capture time of the first sample.
+    static constexpr uint8_t kDataTypeAdpcm = 0x07;
+    // Payload: exponent, sample rate in kHz, encoded frame size N, then
+    // consecutive N-byte LC3 frames of 10 ms each. Timestamp: capture time
+    // of the first frame.
+    static constexpr uint8_t kDataTypeLc3 = 0x08;
+    // Maps the capture sample clock to device time, sent once a second.
+    // All timestamps are derived from this clock. Payload: sample rate in Hz
+    // (uint32), capture index of a sample (uint64) and its capture time in
+    // microseconds (int64), all big-endian. Once the client clock is
+    // synchronised, the same sample's client time in microseconds (int64)
+    // follows.
+    static constexpr uint8_t kDataTypeTimebase = 0x09;
+    // NTP-style clock synchronisation, see ble::ClockSync. The client writes
+    // a frame of this type; all times are big-endian int64 microseconds.
+    // Request payload: exchange id (uint8) and client transmit time t1,
+    // optionally followed by the id of the previous exchange and the client
+    // receive time t4 of its reply. Reply payload, notified right away:
+    // exchange id, t1 echoed, device receive time t2 and device transmit
+    // time t3, stamped as the reply is handed to the BLE stack. Receipts and
+    // replies need an ATT MTU of at least 38; the device requests a larger
+    // one on connect, and on a link still below it a request is answered
+    // with a reply holding only the exchange id.
+    static constexpr uint8_t kDataTypeTimeSync = 0x0A;
+    // Firmware update transfer in both directions, see ota::OtaUpdater.
+    // Payload: opcode, then its arguments.
+    static constexpr uint8_t kDataTypeOta = 0x0B;
+    // Scrolling spectrogram, enabled by the client writing an AudioPacket of
+    // this type with payload 1 (0 disables it). Frame payload: index of the
+    // first band frame (uint8, wrapping), band count, flags (bit 0: the
+    // first frame is a keyframe), then consecutive band frames coded by
+    // dsp::SpectrogramEncoder. Bands are log-magnitudes in 0.5 dB steps
+    // above -110 dBFS, about 30 frames per second. A client that missed a
+    // frame waits for the next keyframe, sent at least once a second.
+    // Timestamp: capture time of the first frame.
+    static constexpr uint8_t kDataTypeSpectrogram = 0x0C;
+    // Latest feature values, served by the snapshot characteristic to
+    // clients that read on demand instead of subscribing. Never notified.
+    // Payload: level feature (as kDataTypeAudio), flags (bit 0: the noise
+    // gate is open), noise floor (as kDataTypeHeartbeat), pitch in 0.1 Hz
+    // (uint16, 0 when unvoiced) and its confidence (0-255), tempo in 0.1 BPM
+    // (uint16, 0 before the first beat), all big-endian, and the capture
+    // block exponent (int8, as in audio frames). Sequence: counts captured
+    // frames. Timestamp: capture time of the frame.
+    static constexpr uint8_t kDataTypeSnapshot = 0x0D;
+    // Streaming deadline statistics since the session started, see
+    // pipeline::DeadlineMonitor, sent every 5 seconds. Payload: entry count,
+    // then per entry overruns (uint16), worst time in microseconds (uint16)
+    // and the cause of the latest overrun (0 unknown, 1 I2S wait, 2 send
+    // queue full, 3 flash stall). Counts and times saturate. The first entry
+    // is the frame period, the rest are the pipeline stages in order.
+    static constexpr uint8_t kDataTypeDeadline = 0x0E;
+    // Sets the feature stream rate of the connection that writes it, see
+    // BLEManager::SendFeaturePacket(). Payload: period in milliseconds
+    // (big-endian uint16, 0 restores the 20 ms default) and how values are
+    // reduced to it (0 the latest value, 1 the mean, 2 the maximum).
+    static constexpr uint8_t kDataTypeFeatureRate = 0x0F;
+    static constexpr size_t kSnapshotPayloadSize = 9;
+    static constexpr size_t kMaxSnapshotSize = 32;
 };
 
 /**
@@ -35,6 +123,26 @@ struct AudioPacket {
     uint8_t checksum;    // Data integrity check
 };
 
+/**
+ * @brief BLE frame packet with a variable-length payload.
+ *
+ * Packet format:
+ * - Byte 0: Header sync byte (0xAB)
+ * - Byte 1: Data type indicator
+ * - Byte 2-3: Sequence number (big-endian)
+ * - Byte 4-7: Timestamp (big-endian)
+ * - Byte 8: Payload length N
+ * - Byte 9 to 8+N: Payload
+ * - Byte 9+N: XOR checksum
+ */
+struct FramePacket {
+    uint8_t data_type;   // Data type identifier
+    uint16_t sequence;   // Packet sequence number
+    uint32_t timestamp;  // Timestamp in milliseconds
+    uint8_t length;      // Number of valid payload bytes
+    std::array<uint8_t, PacketConfig::kMaxFramePayload> payload;
+};
+
 /**
  * @brief Encodes AudioPacket to raw byte buffer for BLE transmission.
  */
@@ -48,6 +156,16 @@ class PacketEncoder {
     static std::array<uint8_t, PacketConfig::kPacketSize> Encode(
         const AudioPacket& packet);
 
+    /**
+     * @brief Encodes a FramePacket into a byte buffer.
+     * @param packet Source packet to encode.
+     * @param[out] encoded_data Receives the encoded bytes.
+     * @return Number of encoded bytes, or 0 if the payload is too long.
+     */
+    static size_t EncodeFrame(
+        const FramePacket& packet,
+        std::array<uint8_t, PacketConfig::kMaxFrameSize>& encoded_data);
+
     /**
      * @brief Calculates XOR checksum for data integrity.
      * @param data Pointer to the data buffer.
@@ -70,6 +188,16 @@ class PacketDecoder {
      */
     static bool Decode(const uint8_t* data, size_t size, AudioPacket& packet);
 
+    /**
+     * @brief Decodes raw bytes into a FramePacket.
+     * @param data Pointer to the raw byte data.
+     * @param size Size of the data buffer.
+     * @param[out] packet Receives the decoded packet.
+     * @return True if the frame is valid, false otherwise.
+     */
+    static bool DecodeFrame(const uint8_t* data, size_t size,
+                            FramePacket& packet);
+
     /**
      * @brief Validates packet integrity using header and checksum.
      * @param data Pointer to the packet data.
@@ -0,0 +1,238 @@
+#include "clock_sync.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Least-squares line through (x, y) pairs.
+struct LineFit {
+    double intercept;
+    double slope;
+    double rms_residual;
+    size_t count;
+};
+
+// Fits y = intercept + slope * x over the samples selected by `use`. The
+// slope is only fitted if the samples span at least `min_span`, otherwise
+// it is zero and the intercept is the mean.
+template <size_t N>
+LineFit FitLine(const std::array<double, N>& x, const std::array<double, N>& y,
+                const std::array<bool, N>& use, size_t size,
+                double min_span) {
+    size_t count = 0;
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    double min_x = 0.0;
+    double max_x = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        if (!use[i]) {
+            continue;
+        }
+        min_x = count == 0 ? x[i] : std::min(min_x, x[i]);
+        max_x = count == 0 ? x[i] : std::max(max_x, x[i]);
+        sum_x += x[i];
+        sum_y += y[i];
+        ++count;
+    }
+    if (count == 0) {
+        return LineFit{};
+    }
+
+    const double mean_x = sum_x / count;
+    const double mean_y = sum_y / count;
+    double slope = 0.0;
+    if (max_x - min_x >= min_span) {
+        double sxx = 0.0;
+        double sxy = 0.0;
+        for (size_t i = 0; i < size; ++i) {
+            if (use[i]) {
+                sxx += (x[i] - mean_x) * (x[i] - mean_x);
+                sxy += (x[i] - mean_x) * (y[i] - mean_y);
+            }
+        }
+        slope = sxy / sxx;
+    }
+    const double intercept = mean_y - slope * mean_x;
+
+    double sum_squares = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        if (use[i]) {
+            const double residual = y[i] - (intercept + slope * x[i]);
+            sum_squares += residual * residual;
+        }
+    }
+    return LineFit{intercept, slope, std::sqrt(sum_squares / count), count};
+}
+
+}  // namespace
+
+namespace ble {
+
+void ClockSync::OnRequest(uint8_t id, int64_t client_transmit_us,
+                          int64_t device_receive_us) {
+    portENTER_CRITICAL(&lock_);
+    // The oldest exchange makes room; its reply was evidently lost.
+    Exchange& exchange = pending_[next_pending_];
+    next_pending_ = (next_pending_ + 1) % kMaxPendingExchanges;
+    exchange = Exchange{
+        .in_use = true,
+        .sent = false,
+        .id = id,
+        .client_transmit_us = client_transmit_us,
+        .device_receive_us = device_receive_us,
+        .device_transmit_us = 0,
+    };
+    portEXIT_CRITICAL(&lock_);
+}
+
+void ClockSync::OnReplySent(uint8_t id, int64_t device_transmit_us) {
+    portENTER_CRITICAL(&lock_);
+    for (Exchange& exchange : pending_) {
+        if (exchange.in_use && !exchange.sent && exchange.id == id) {
+            exchange.sent = true;
+            exchange.device_transmit_us = device_transmit_us;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock_);
+}
+
+void ClockSync::OnReplyReceived(uint8_t id, int64_t client_receive_us) {
+    Exchange completed{};
+    portENTER_CRITICAL(&lock_);
+    for (Exchange& exchange : pending_) {
+        if (exchange.in_use && exchange.sent && exchange.id == id) {
+            completed = exchange;
+            exchange.in_use = false;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock_);
+    if (!completed.in_use) {
+        return;
+    }
+
+    const int64_t device_hold_us =
+        completed.device_transmit_us - completed.device_receive_us;
+    const int64_t delay_us =
+        (client_receive_us - completed.client_transmit_us) - device_hold_us;
+    if (delay_us < 0 || delay_us > kMaxDelayUs) {
+        ++discarded_;
+        UpdateEstimate();
+        return;
+    }
+
+    samples_[next_sample_] = Sample{
+        .device_us = completed.device_receive_us + device_hold_us / 2,
+        .offset_us = ((completed.client_transmit_us -
+                       completed.device_receive_us) +
+                      (client_receive_us - completed.device_transmit_us)) /
+                     2,
+        .delay_us = delay_us,
+    };
+    next_sample_ = (next_sample_ + 1) % kWindowSize;
+    sample_count_ = std::min(sample_count_ + 1, kWindowSize);
+    UpdateEstimate();
+}
+
+ClockSync::Estimate ClockSync::GetEstimate() const {
+    portENTER_CRITICAL(&lock_);
+    const Estimate estimate = estimate_;
+    portEXIT_CRITICAL(&lock_);
+    return estimate;
+}
+
+bool ClockSync::ToClientTimeUs(int64_t device_us, int64_t& client_us) const {
+    const Estimate estimate = GetEstimate();
+    if (!estimate.valid) {
+        return false;
+    }
+    const double elapsed_us =
+        static_cast<double>(device_us - estimate.reference_us);
+    client_us = device_us + estimate.offset_us +
+                std::llround(elapsed_us * estimate.skew_ppm * 1e-6);
+    return true;
+}
+
+void ClockSync::Reset() {
+    portENTER_CRITICAL(&lock_);
+    pending_ = {};
+    next_pending_ = 0;
+    estimate_ = Estimate{};
+    portEXIT_CRITICAL(&lock_);
+    sample_count_ = 0;
+    next_sample_ = 0;
+    discarded_ = 0;
+}
+
+void ClockSync::UpdateEstimate() {
+    Estimate estimate{};
+    estimate.samples = static_cast<uint16_t>(sample_count_);
+    estimate.discarded = discarded_;
+
+    if (sample_count_ >= kMinSamples) {
+        // Work relative to the newest sample, so that doubles keep
+        // microsecond precision even for wall-clock client times.
+        const Sample& newest =
+            samples_[(next_sample_ + kWindowSize - 1) % kWindowSize];
+        int64_t min_delay_us = newest.delay_us;
+        for (size_t i = 0; i < sample_count_; ++i) {
+            min_delay_us = std::min(min_delay_us, samples_[i].delay_us);
+        }
+
+        std::array<double, kWindowSize> x;
+        std::array<double, kWindowSize> y;
+        std::array<bool, kWindowSize> use;
+        for (size_t i = 0; i < sample_count_; ++i) {
+            x[i] = static_cast<double>(samples_[i].device_us -
+                                       newest.device_us);
+            y[i] = static_cast<double>(samples_[i].offset_us -
+                                       newest.offset_us);
+            use[i] = samples_[i].delay_us <= min_delay_us + kDelayToleranceUs;
+        }
+        LineFit fit = FitLine(x, y, use, sample_count_,
+                              static_cast<double>(kMinSkewSpanUs));
+
+        // Second pass: drop samples far off the line, judged by the median
+        // absolute residual, and fit again.
+        std::array<double, kWindowSize> residuals;
+        size_t count = 0;
+        for (size_t i = 0; i < sample_count_; ++i) {
+            if (use[i]) {
+                residuals[count++] =
+                    std::fabs(y[i] - (fit.intercept + fit.slope * x[i]));
+            }
+        }
+        std::nth_element(residuals.begin(), residuals.begin() + count / 2,
+                         residuals.begin() + count);
+        const double limit =
+            std::max(3.0 * 1.4826 * residuals[count / 2], kResidualFloorUs);
+        bool dropped = false;
+        for (size_t i = 0; i < sample_count_; ++i) {
+            if (use[i] &&
+                std::fabs(y[i] - (fit.intercept + fit.slope * x[i])) > limit) {
+                use[i] = false;
+                dropped = true;
+            }
+        }
+        if (dropped) {
+            fit = FitLine(x, y, use, sample_count_,
+                          static_cast<double>(kMinSkewSpanUs));
+        }
+
+        estimate.valid = fit.count >= kMinSamples;
+        estimate.reference_us = newest.device_us;
+        estimate.offset_us = newest.offset_us + std::llround(fit.intercept);
+        estimate.skew_ppm = static_cast<float>(fit.slope * 1e6);
+        estimate.dispersion_us = static_cast<uint32_t>(fit.rms_residual);
+        estimate.min_delay_us = static_cast<uint32_t>(min_delay_us);
+        estimate.accepted = static_cast<uint16_t>(fit.count);
+    }
+
+    portENTER_CRITICAL(&lock_);
+    estimate_ = estimate;
+    portEXIT_CRITICAL(&lock_);
+}
+
+}  // namespace ble
@@ -0,0 +1,152 @@
+#ifndef BLE_CLOCK_SYNC_HPP_
+#define BLE_CLOCK_SYNC_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+
+namespace ble {
+
+/**
+ * @class ClockSync
+ * @brief Estimates the mapping from device time to a client's clock.
+ *
+ * The client runs NTP-style exchanges: it sends its transmit time t1, the
+ * device notes its receive time t2 and transmit time t3, and the client
+ * reports its receive time t4 of the reply with its next request. Each
+ * complete exchange yields an offset sample
+ *     offset = ((t1 - t2) + (t4 - t3)) / 2
+ * whose error is bounded by half the round-trip delay
+ *     delay = (t4 - t1) - (t3 - t2).
+ *
+ * Samples whose delay exceeds the window's minimum by more than a tolerance
+ * were held up by connection events or retransmissions and are rejected.
+ * A least-squares line through the rest gives the offset and the skew of
+ * the client clock relative to the device; a second pass drops samples
+ * that sit far off that line.
+ *
+ * Requests and receipts are handled by the BLE host task, transmit times by
+ * the send task, and estimates may be read from any task.
+ */
+class ClockSync {
+   public:
+    // Offset samples kept for the fit.
+    static constexpr size_t kWindowSize = 64;
+    // Exchanges that may await their client receive time at once.
+    static constexpr size_t kMaxPendingExchanges = 4;
+    // Samples slower than the fastest one by more than this are rejected.
+    static constexpr int64_t kDelayToleranceUs = 2000;
+    // Round trips longer than this are never used.
+    static constexpr int64_t kMaxDelayUs = 500 * 1000;
+    // Residuals below this are never treated as outliers.
+    static constexpr double kResidualFloorUs = 250.0;
+    // Samples needed before an estimate is published.
+    static constexpr size_t kMinSamples = 4;
+    // Time span the accepted samples must cover before skew is fitted.
+    static constexpr int64_t kMinSkewSpanUs = 10 * 1000 * 1000;
+
+    /**
+     * @brief The current device-to-client time mapping.
+     *
+     * client_us = device_us + offset_us + skew_ppm * 1e-6 *
+     *             (device_us - reference_us)
+     */
+    struct Estimate {
+        bool valid;
+        int64_t reference_us;    // Device time the offset refers to
+        int64_t offset_us;       // Client minus device time at reference_us
+        float skew_ppm;          // Client clock rate error against the device
+        uint32_t dispersion_us;  // RMS residual of the accepted samples
+        uint32_t min_delay_us;   // Fastest round trip in the window
+        uint16_t samples;        // Samples in the window
+        uint16_t accepted;       // Samples used by the last fit
+        uint32_t discarded;      // Exchanges with an impossible round trip
+    };
+
+    ClockSync() = default;
+
+    ClockSync(const ClockSync&) = delete;
+    ClockSync& operator=(const ClockSync&) = delete;
+
+    /**
+     * @brief Records a client request.
+     * @param id Exchange id chosen by the client.
+     * @param client_transmit_us Client time t1 the request was sent at.
+     * @param device_receive_us Device time t2 the request arrived at.
+     */
+    void OnRequest(uint8_t id, int64_t client_transmit_us,
+                   int64_t device_receive_us);
+
+    /**
+     * @brief Records the time the reply to an exchange was handed to the
+     * BLE stack.
+     * @param id Exchange id.
+     * @param device_transmit_us Device time t3 of the reply.
+     */
+    void OnReplySent(uint8_t id, int64_t device_transmit_us);
+
+    /**
+     * @brief Completes an exchange with the client's receive time of the
+     * reply and updates the estimate.
+     * @param id Exchange id.
+     * @param client_receive_us Client time t4 the reply arrived at.
+     */
+    void OnReplyReceived(uint8_t id, int64_t client_receive_us);
+
+    /**
+     * @brief Returns a snapshot of the current estimate.
+     */
+    Estimate GetEstimate() const;
+
+    /**
+     * @brief Maps a device time to client time.
+     * @param device_us esp_timer time in microseconds.
+     * @param[out] client_us Corresponding client time in microseconds.
+     * @return true if an estimate is available, false otherwise.
+     */
+    bool ToClientTimeUs(int64_t device_us, int64_t& client_us) const;
+
+    /**
+     * @brief Forgets all exchanges and samples, e.g. for a new client.
+     */
+    void Reset();
+
+   private:
+    struct Exchange {
+        bool in_use;
+        bool sent;
+        uint8_t id;
+        int64_t client_transmit_us;
+        int64_t device_receive_us;
+        int64_t device_transmit_us;
+    };
+
+    struct Sample {
+        int64_t device_us;  // Midpoint of the device's receive and transmit
+        int64_t offset_us;
+        int64_t delay_us;
+    };
+
+    /**
+     * @brief Fits the offset line through the window and publishes it.
+     */
+    void UpdateEstimate();
+
+    // Guards pending_ and estimate_, which are shared between tasks.
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    std::array<Exchange, kMaxPendingExchanges> pending_{};
+    size_t next_pending_ = 0;
+    Estimate estimate_{};
+
+    // Owned by the BLE host task.
+    std::array<Sample, kWindowSize> samples_{};
+    size_t sample_count_ = 0;
+    size_t next_sample_ = 0;
+    uint32_t discarded_ = 0;
+};
+
+}  // namespace ble
+
+#endif  // BLE_CLOCK_SYNC_HPP_
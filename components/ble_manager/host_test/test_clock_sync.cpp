@@ -0,0 +1,192 @@
+#include "clock_sync.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace {
+
+using ble::ClockSync;
+
+// A client whose clock runs `skew_ppm` fast against the device and reads
+// `offset_us` ahead of it at device time 0, reached over a link with a
+// fixed one-way delay, uniform jitter and occasional long stalls.
+class SimulatedClient {
+   public:
+    SimulatedClient(int64_t offset_us, double skew_ppm, uint32_t seed)
+        : offset_us_(offset_us), skew_ppm_(skew_ppm), rng_(seed) {}
+
+    int64_t ClientTimeUs(int64_t device_us) const {
+        return device_us + offset_us_ +
+               std::llround(device_us * skew_ppm_ * 1e-6);
+    }
+
+    // Runs one exchange starting at `device_us` and feeds it to `sync`.
+    // Every `stall_every`-th exchange has one direction held up by a
+    // missed connection event.
+    void Exchange(ClockSync& sync, uint8_t id, int64_t device_us,
+                  int stall_every) {
+        const int64_t uplink_us = OneWayDelayUs();
+        const int64_t downlink_us = OneWayDelayUs();
+        int64_t stall_us = 0;
+        if (stall_every > 0 && id % stall_every == 0) {
+            stall_us = kStallUs;
+        }
+        const bool stall_up = id % 2 == 0;
+
+        const int64_t t1 = ClientTimeUs(device_us);
+        const int64_t t2 = device_us + uplink_us + (stall_up ? stall_us : 0);
+        const int64_t t3 = t2 + kHoldUs;
+        const int64_t t4 =
+            ClientTimeUs(t3 + downlink_us + (stall_up ? 0 : stall_us));
+        sync.OnRequest(id, t1, t2);
+        sync.OnReplySent(id, t3);
+        sync.OnReplyReceived(id, t4);
+    }
+
+   private:
+    static constexpr int64_t kBaseDelayUs = 7500;
+    static constexpr int64_t kJitterUs = 1000;
+    static constexpr int64_t kStallUs = 30000;
+    static constexpr int64_t kHoldUs = 300;
+
+    int64_t OneWayDelayUs() {
+        return kBaseDelayUs +
+               std::uniform_int_distribution<int64_t>(0, kJitterUs)(rng_);
+    }
+
+    const int64_t offset_us_;
+    const double skew_ppm_;
+    std::mt19937 rng_;
+};
+
+// Client clock in microseconds since the epoch, as a phone would send.
+constexpr int64_t kWallClockOffsetUs = 1'760'000'000'000'000;
+constexpr int64_t kExchangePeriodUs = 500 * 1000;
+
+// Runs `count` exchanges from device time `start_us` and returns the time
+// after the last one.
+int64_t RunExchanges(ClockSync& sync, SimulatedClient& client,
+                     int64_t start_us, int count, int stall_every) {
+    int64_t device_us = start_us;
+    for (int i = 0; i < count; ++i) {
+        client.Exchange(sync, static_cast<uint8_t>(i), device_us,
+                        stall_every);
+        device_us += kExchangePeriodUs;
+    }
+    return device_us;
+}
+
+TEST(ClockSyncTest, NoEstimateBeforeEnoughSamples) {
+    ClockSync sync;
+    SimulatedClient client(kWallClockOffsetUs, 0.0, 1);
+    RunExchanges(sync, client, 0, ClockSync::kMinSamples - 1, 0);
+
+    EXPECT_FALSE(sync.GetEstimate().valid);
+    int64_t client_us = 0;
+    EXPECT_FALSE(sync.ToClientTimeUs(0, client_us));
+
+    RunExchanges(sync, client, 10 * kExchangePeriodUs, 1, 0);
+    EXPECT_TRUE(sync.GetEstimate().valid);
+}
+
+TEST(ClockSyncTest, RecoversOffsetWithoutSkew) {
+    ClockSync sync;
+    SimulatedClient client(kWallClockOffsetUs, 0.0, 2);
+    const int64_t end_us = RunExchanges(sync, client, 0, 20, 0);
+
+    const ClockSync::Estimate estimate = sync.GetEstimate();
+    ASSERT_TRUE(estimate.valid);
+    EXPECT_NEAR(estimate.skew_ppm, 0.0, 5.0);
+    int64_t client_us = 0;
+    ASSERT_TRUE(sync.ToClientTimeUs(end_us, client_us));
+    EXPECT_NEAR(static_cast<double>(client_us - client.ClientTimeUs(end_us)),
+                0.0, 300.0);
+}
+
+// The case the estimator exists for: a drifting client clock over a link
+// with jitter and stalls of many times the jitter.
+TEST(ClockSyncTest, RecoversOffsetAndSkewThroughJitterSpikes) {
+    for (const double skew_ppm : {-80.0, -20.0, 35.0, 100.0}) {
+        SCOPED_TRACE(skew_ppm);
+        ClockSync sync;
+        SimulatedClient client(kWallClockOffsetUs, skew_ppm, 3);
+        const int64_t end_us = RunExchanges(sync, client, 0, 120, 4);
+
+        const ClockSync::Estimate estimate = sync.GetEstimate();
+        ASSERT_TRUE(estimate.valid);
+        EXPECT_NEAR(estimate.skew_ppm, skew_ppm, 5.0);
+        // The stalled exchanges are rejected.
+        EXPECT_LT(estimate.accepted, estimate.samples);
+        EXPECT_LT(estimate.dispersion_us, 500u);
+
+        // Both now and a few seconds ahead, where skew errors show.
+        for (const int64_t device_us : {end_us, end_us + 5'000'000}) {
+            int64_t client_us = 0;
+            ASSERT_TRUE(sync.ToClientTimeUs(device_us, client_us));
+            EXPECT_NEAR(
+                static_cast<double>(client_us - client.ClientTimeUs(device_us)),
+                0.0, 300.0)
+                << "at device time " << device_us;
+        }
+    }
+}
+
+TEST(ClockSyncTest, DiscardsImpossibleRoundTrips) {
+    ClockSync sync;
+    SimulatedClient client(kWallClockOffsetUs, 0.0, 4);
+    const int64_t device_us = RunExchanges(sync, client, 0, 8, 0);
+    const ClockSync::Estimate before = sync.GetEstimate();
+
+    // The reply arrived before the request was sent.
+    sync.OnRequest(200, client.ClientTimeUs(device_us), device_us + 8000);
+    sync.OnReplySent(200, device_us + 8300);
+    sync.OnReplyReceived(200, client.ClientTimeUs(device_us) - 1000);
+    // A round trip longer than any connection interval.
+    sync.OnRequest(201, client.ClientTimeUs(device_us), device_us + 8000);
+    sync.OnReplySent(201, device_us + 8300);
+    sync.OnReplyReceived(
+        201, client.ClientTimeUs(device_us + ClockSync::kMaxDelayUs + 20000));
+
+    const ClockSync::Estimate after = sync.GetEstimate();
+    EXPECT_EQ(after.discarded, 2u);
+    EXPECT_EQ(after.samples, before.samples);
+    EXPECT_EQ(after.offset_us, before.offset_us);
+}
+
+TEST(ClockSyncTest, IgnoresUnknownAndUnsentExchanges) {
+    ClockSync sync;
+    SimulatedClient client(kWallClockOffsetUs, 0.0, 5);
+    RunExchanges(sync, client, 0, 8, 0);
+    const uint16_t samples = sync.GetEstimate().samples;
+
+    // Never requested.
+    sync.OnReplyReceived(77, client.ClientTimeUs(10'000'000));
+    // Requested, but the reply was not sent yet.
+    sync.OnRequest(78, client.ClientTimeUs(10'000'000), 10'008'000);
+    sync.OnReplyReceived(78, client.ClientTimeUs(10'020'000));
+
+    EXPECT_EQ(sync.GetEstimate().samples, samples);
+    EXPECT_EQ(sync.GetEstimate().discarded, 0u);
+}
+
+TEST(ClockSyncTest, ResetForgetsTheClient) {
+    ClockSync sync;
+    SimulatedClient first(kWallClockOffsetUs, 50.0, 6);
+    const int64_t device_us = RunExchanges(sync, first, 0, 40, 0);
+    sync.Reset();
+    EXPECT_FALSE(sync.GetEstimate().valid);
+    EXPECT_EQ(sync.GetEstimate().samples, 0u);
+
+    // A new client with an unrelated clock.
+    SimulatedClient second(-3'000'000, 0.0, 7);
+    const int64_t end_us = RunExchanges(sync, second, device_us, 20, 0);
+    int64_t client_us = 0;
+    ASSERT_TRUE(sync.ToClientTimeUs(end_us, client_us));
+    EXPECT_NEAR(static_cast<double>(client_us - second.ClientTimeUs(end_us)),
+                0.0, 300.0);
+}
+
+}  // namespace
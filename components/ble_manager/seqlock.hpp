@@ -0,0 +1,81 @@
+#ifndef BLE_SEQLOCK_HPP_
+#define BLE_SEQLOCK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ble {
+
+/**
+ * @class SeqLock
+ * @brief Single-writer latest-value cell that readers never block.
+ *
+ * The writer bumps a sequence counter to odd, copies the value and bumps it
+ * back to even; a reader copies the value and keeps it only if it saw the
+ * same even sequence before and after. Neither side takes a lock, so a
+ * reader in another task, or on the other core, never stalls the producer.
+ * The value is stored as relaxed atomic words, so the torn copies a reader
+ * discards are not data races.
+ *
+ * Only one task may call Store().
+ *
+ * @tparam T A trivially copyable value type.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "SeqLock values must be trivially copyable");
+
+   public:
+    /**
+     * @brief Publishes a new value.
+     */
+    void Store(const T& value) {
+        std::array<uint32_t, kWords> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies the latest value, unless a Store() overlapped the copy.
+     * @param[out] value Receives the value on success.
+     * @return true if `value` is consistent, false to try again. A writer
+     * that was preempted mid-store keeps failing until it runs again.
+     */
+    bool TryLoad(T& value) const {
+        const uint32_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        std::array<uint32_t, kWords> words;
+        for (size_t i = 0; i < kWords; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+        std::memcpy(&value, words.data(), sizeof(T));
+        return true;
+    }
+
+   private:
+    static constexpr size_t kWords = (sizeof(T) + 3) / 4;
+
+    std::atomic<uint32_t> sequence_{0};
+    std::array<std::atomic<uint32_t>, kWords> words_{};
+};
+
+}  // namespace ble
+
+#endif  // BLE_SEQLOCK_HPP_
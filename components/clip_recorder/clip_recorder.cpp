@@ -0,0 +1,322 @@
+#include "clip_recorder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include <sys/stat.h>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+#include "storage_manager.hpp"
+
+namespace {
+static const char* kTag = "ClipRecorder";
+
+// Clips rotate through a fixed number of files so they cannot fill the
+// storage partition. Every file must fit its share even when nothing
+// compresses; the rest stays free for the feature log and for SPIFFS,
+// which slows down badly when nearly full.
+constexpr uint32_t kMaxClips = 2;
+constexpr size_t kLogReserveBytes = 64 * 1024;
+constexpr size_t kClipSharePercent = 75;
+// Clip windows are shortened to fit, but not below this.
+constexpr uint32_t kMinClipMs = 500;
+// How long the writer waits for the post-roll to be captured.
+constexpr uint32_t kWaitForSamplesMs = 20;
+// A clip is cut short once capture has stopped for this long, e.g. because
+// streaming ended during the post-roll.
+constexpr uint32_t kCaptureStallMs = 500;
+
+constexpr uint32_t kWriterTaskStackSize = 4096;
+constexpr UBaseType_t kWriterTaskPriority = 2;
+
+const char* TriggerName(clip::ClipRecorder::TriggerSource source) {
+    switch (source) {
+        case clip::ClipRecorder::TriggerSource::kLevel:
+            return "level";
+        case clip::ClipRecorder::TriggerSource::kOnset:
+            return "onset";
+    }
+    return "unknown";
+}
+
+// Largest clip file `samples` can encode to, with every block verbatim.
+size_t MaxClipBytes(uint64_t samples) {
+    const uint64_t blocks =
+        (samples + codec::LosslessEncoder::kBlockSamples - 1) /
+        codec::LosslessEncoder::kBlockSamples;
+    return codec::LosslessEncoder::kStreamHeaderSize +
+           blocks * codec::LosslessEncoder::kMaxEncodedBlockBytes;
+}
+}  // namespace
+
+namespace clip {
+
+std::unique_ptr<ClipRecorder> ClipRecorder::Create(const Config& config) {
+    // Round the history up to whole capture frames, so a frame slot never
+    // straddles the end of the ring.
+    const size_t frames =
+        (static_cast<uint64_t>(config.history_ms) * config.sample_rate_hz /
+             1000 +
+         config.frame_samples - 1) /
+        config.frame_samples;
+    const size_t history_samples = frames * config.frame_samples;
+    if (config.pre_roll_ms + config.post_roll_ms >= config.history_ms) {
+        ESP_LOGE(kTag, "Clip window must be shorter than the history.");
+        return nullptr;
+    }
+
+    // Shorten both rolls alike until the worst-case clip fits its share.
+    Config sized = config;
+    size_t total_bytes = 0;
+    size_t used_bytes = 0;
+    if (storage::StorageManager::GetInstance().GetUsage(
+            total_bytes, used_bytes) != ESP_OK) {
+        return nullptr;
+    }
+    const size_t clip_budget =
+        total_bytes > kLogReserveBytes
+            ? (total_bytes - kLogReserveBytes) * kClipSharePercent / 100 /
+                  kMaxClips
+            : 0;
+    const size_t budget_blocks =
+        clip_budget > codec::LosslessEncoder::kStreamHeaderSize
+            ? (clip_budget - codec::LosslessEncoder::kStreamHeaderSize) /
+                  codec::LosslessEncoder::kMaxEncodedBlockBytes
+            : 0;
+    const uint32_t max_clip_ms = static_cast<uint32_t>(
+        static_cast<uint64_t>(budget_blocks) *
+        codec::LosslessEncoder::kBlockSamples * 1000 / config.sample_rate_hz);
+    const uint32_t clip_ms = config.pre_roll_ms + config.post_roll_ms;
+    if (max_clip_ms < kMinClipMs) {
+        ESP_LOGE(kTag, "Storage too small for clips (%u bytes per clip).",
+                 static_cast<unsigned>(clip_budget));
+        return nullptr;
+    }
+    if (clip_ms > max_clip_ms) {
+        sized.pre_roll_ms = static_cast<uint32_t>(
+            static_cast<uint64_t>(config.pre_roll_ms) * max_clip_ms / clip_ms);
+        sized.post_roll_ms = max_clip_ms - sized.pre_roll_ms;
+        ESP_LOGW(kTag, "Clips shortened to %lu ms to fit the storage.",
+                 static_cast<unsigned long>(max_clip_ms));
+    }
+
+    std::unique_ptr<PreRollBuffer> buffer =
+        PreRollBuffer::Create(history_samples);
+    if (!buffer) {
+        return nullptr;
+    }
+
+    // Use `new` because constructor is private.
+    std::unique_ptr<ClipRecorder> recorder(
+        new ClipRecorder(sized, std::move(buffer)));
+    if (recorder->Initialize() != ESP_OK) {
+        return nullptr;
+    }
+    return recorder;
+}
+
+ClipRecorder::ClipRecorder(const Config& config,
+                           std::unique_ptr<PreRollBuffer> buffer)
+    : config_(config), buffer_(std::move(buffer)) {}
+
+ClipRecorder::~ClipRecorder() {
+    if (writer_task_handle_ != nullptr) {
+        vTaskDelete(writer_task_handle_);
+    }
+    if (job_queue_ != nullptr) {
+        vQueueDelete(job_queue_);
+    }
+}
+
+esp_err_t ClipRecorder::Initialize() {
+    job_queue_ = xQueueCreate(1, sizeof(ClipJob));
+    if (job_queue_ == nullptr) {
+        ESP_LOGE(kTag, "Failed to create clip job queue.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(WriterTask, "clip_writer_task", kWriterTaskStackSize,
+                    this, kWriterTaskPriority,
+                    &writer_task_handle_) != pdPASS) {
+        ESP_LOGE(kTag, "Failed to create clip writer task.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+bool ClipRecorder::Trigger(TriggerSource source) {
+    bool expected = false;
+    if (!busy_.compare_exchange_strong(expected, true,
+                                       std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    const uint64_t trigger = buffer_->GetWrittenSamples();
+    const uint64_t pre_roll = static_cast<uint64_t>(config_.pre_roll_ms) *
+                              config_.sample_rate_hz / 1000;
+    const uint64_t post_roll = static_cast<uint64_t>(config_.post_roll_ms) *
+                               config_.sample_rate_hz / 1000;
+
+    ClipJob job = {
+        // Early in a session there may be less pre-roll than requested.
+        .start = trigger > pre_roll ? trigger - pre_roll : 0,
+        .end = trigger + post_roll,
+        .source = source,
+    };
+    if (xQueueSend(job_queue_, &job, 0) != pdPASS) {
+        busy_.store(false, std::memory_order_release);
+        return false;
+    }
+
+    ESP_LOGI(kTag, "Clip triggered by %s.", TriggerName(source));
+    return true;
+}
+
+void ClipRecorder::WriterTask(void* param) {
+    ClipRecorder* recorder = static_cast<ClipRecorder*>(param);
+    ClipJob job;
+
+    ESP_LOGI(kTag, "Clip writer task started.");
+
+    while (true) {
+        if (xQueueReceive(recorder->job_queue_, &job, portMAX_DELAY) ==
+            pdPASS) {
+            recorder->WriteClip(job);
+            recorder->busy_.store(false, std::memory_order_release);
+        }
+    }
+}
+
+esp_err_t ClipRecorder::WriteClip(const ClipJob& job) {
+    char path[48];
+    snprintf(path, sizeof(path), "%s/clip_%lu.sfl",
+             storage::StorageManager::kBasePath,
+             static_cast<unsigned long>(next_clip_index_));
+    next_clip_index_ = (next_clip_index_ + 1) % kMaxClips;
+
+    // The file replaced frees its space; the rest must already be free.
+    size_t total_bytes = 0;
+    size_t used_bytes = 0;
+    if (storage::StorageManager::GetInstance().GetUsage(
+            total_bytes, used_bytes) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    struct stat replaced;
+    const size_t replaced_bytes =
+        stat(path, &replaced) == 0 ? static_cast<size_t>(replaced.st_size)
+                                   : 0;
+    const size_t free_bytes = total_bytes - std::min(total_bytes, used_bytes);
+    if (MaxClipBytes(job.end - job.start) > free_bytes + replaced_bytes) {
+        ESP_LOGW(kTag, "Not enough storage for a clip, skipped.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t total_samples = static_cast<uint32_t>(job.end - job.start);
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        ESP_LOGE(kTag, "Failed to open clip file '%s'.", path);
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = ESP_OK;
+    std::array<uint8_t, codec::LosslessEncoder::kStreamHeaderSize> header;
+    codec::LosslessEncoder::WriteStreamHeader(config_.sample_rate_hz,
+                                              total_samples, header);
+    size_t file_bytes = fwrite(header.data(), 1, header.size(), file);
+    if (file_bytes != header.size()) {
+        ret = ESP_FAIL;
+    }
+
+    uint64_t encode_cycles = 0;
+    uint64_t position = job.start;
+    uint64_t end = job.end;
+    size_t block_fill = 0;
+    uint64_t last_written = buffer_->GetWrittenSamples();
+    TickType_t last_progress = xTaskGetTickCount();
+    auto flush_block = [&]() {
+        const uint32_t start_cycles = esp_cpu_get_cycle_count();
+        const size_t encoded_bytes = encoder_.EncodeBlock(
+            std::span<const int16_t>(block_.data(), block_fill), encoded_);
+        encode_cycles += esp_cpu_get_cycle_count() - start_cycles;
+        block_fill = 0;
+
+        if (fwrite(encoded_.data(), 1, encoded_bytes, file) != encoded_bytes) {
+            ESP_LOGE(kTag, "Failed to write clip data (storage full?).");
+            ret = ESP_FAIL;
+            return;
+        }
+        file_bytes += encoded_bytes;
+    };
+    while (ret == ESP_OK && position < end) {
+        const size_t wanted =
+            std::min<uint64_t>(block_.size() - block_fill, end - position);
+        std::span<const int16_t> samples = buffer_->View(position, wanted);
+        if (samples.empty()) {
+            const uint64_t written = buffer_->GetWrittenSamples();
+            if (!buffer_->Contains(position) && position < written) {
+                ESP_LOGE(kTag, "Clip overrun by the capture position.");
+                ret = ESP_ERR_TIMEOUT;
+                break;
+            }
+            // The post-roll has not been captured yet.
+            if (written != last_written) {
+                last_written = written;
+                last_progress = xTaskGetTickCount();
+            } else if (xTaskGetTickCount() - last_progress >=
+                       pdMS_TO_TICKS(kCaptureStallMs)) {
+                ESP_LOGW(kTag, "Capture stopped, clip cut short.");
+                end = position;
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(kWaitForSamplesMs));
+            continue;
+        }
+
+        // Gather a block; views end where the ring wraps.
+        std::copy(samples.begin(), samples.end(), &block_[block_fill]);
+        // The writer may have lapped us while we copied the samples.
+        if (!buffer_->Contains(position)) {
+            ESP_LOGE(kTag, "Clip overrun by the capture position.");
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+        block_fill += samples.size();
+        position += samples.size();
+        if (block_fill == block_.size() || position == end) {
+            flush_block();
+        }
+    }
+    if (ret == ESP_OK && block_fill > 0) {
+        flush_block();
+    }
+
+    // A clip cut short records the samples it actually holds.
+    if (ret == ESP_OK && end != job.end) {
+        total_samples = static_cast<uint32_t>(end - job.start);
+        codec::LosslessEncoder::WriteStreamHeader(config_.sample_rate_hz,
+                                                  total_samples, header);
+        if (total_samples == 0 || fseek(file, 0, SEEK_SET) != 0 ||
+            fwrite(header.data(), 1, header.size(), file) != header.size()) {
+            ret = ESP_FAIL;
+        }
+    }
+
+    fclose(file);
+    if (ret != ESP_OK) {
+        remove(path);
+        return ret;
+    }
+
+    ESP_LOGI(kTag,
+             "Saved %s clip '%s': %lu samples, ratio %.2f, %.1f cycles/sample.",
+             TriggerName(job.source), path,
+             static_cast<unsigned long>(total_samples),
+             static_cast<double>(total_samples) * sizeof(int16_t) / file_bytes,
+             static_cast<double>(encode_cycles) / total_samples);
+    return ESP_OK;
+}
+
+}  // namespace clip
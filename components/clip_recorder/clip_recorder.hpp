@@ -0,0 +1,135 @@
+#ifndef CLIP_RECORDER_CLIP_RECORDER_HPP_
+#define CLIP_RECORDER_CLIP_RECORDER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "lossless_encoder.hpp"
+#include "pre_roll_buffer.hpp"
+
+namespace clip {
+
+/**
+ * @class ClipRecorder
+ * @brief Retrospective PCM recorder that saves audio around acoustic events.
+ *
+ * The recorder keeps the last few seconds of captured audio in a
+ * PreRollBuffer. When a trigger fires, the window from `pre_roll_ms` before
+ * to `post_roll_ms` after the trigger is losslessly encoded to a clip file
+ * by a low-priority writer task. The writer starts on the pre-roll immediately
+ * and follows the capture position through the post-roll, so streaming is
+ * never interrupted and samples are only read out of the ring for triggered
+ * windows.
+ */
+class ClipRecorder {
+   public:
+    enum class TriggerSource : uint8_t {
+        kLevel,  // Feature level crossed the trigger threshold
+        kOnset,  // Strong acoustic onset
+    };
+
+    struct Config {
+        uint32_t sample_rate_hz;
+        size_t frame_samples;  // Capture frame length
+        uint32_t history_ms = 8000;
+        uint32_t pre_roll_ms = 2000;
+        uint32_t post_roll_ms = 1000;
+    };
+
+    /**
+     * @brief Creates a recorder with its history buffer and writer task.
+     * * The pre- and post-roll are shortened alike if a clip could not
+     * otherwise fit its share of the storage partition. The storage
+     * manager must already exist.
+     * @param config Recorder configuration.
+     * @return The recorder on success, or nullptr on failure (e.g. when the
+     * board has no PSRAM).
+     */
+    static std::unique_ptr<ClipRecorder> Create(const Config& config);
+
+    ~ClipRecorder();
+
+    ClipRecorder(const ClipRecorder&) = delete;
+    ClipRecorder& operator=(const ClipRecorder&) = delete;
+
+    /**
+     * @brief Returns the history slot the next capture frame should be
+     * written to.
+     * @param max_samples Frame length.
+     * @return A slot of up to `max_samples`, shorter where the ring wraps.
+     */
+    std::span<int16_t> AcquireFrame(size_t max_samples) {
+        return buffer_->AcquireWrite(max_samples);
+    }
+
+    /**
+     * @brief Publishes a frame written into the slot from AcquireFrame().
+     * @param samples Number of samples captured.
+     */
+    void CommitFrame(size_t samples) { buffer_->CommitWrite(samples); }
+
+    /**
+     * @brief Requests a clip around the newest captured sample.
+     * @param source What caused the trigger, recorded in the log.
+     * @return true if a clip was started, false if one is still in progress.
+     */
+    bool Trigger(TriggerSource source);
+
+    /**
+     * @brief Checks whether a triggered clip is still being written.
+     */
+    bool IsBusy() const { return busy_.load(std::memory_order_acquire); }
+
+   private:
+    struct ClipJob {
+        uint64_t start;  // Absolute sample index of the first clip sample
+        uint64_t end;    // One past the last clip sample
+        TriggerSource source;
+    };
+
+    ClipRecorder(const Config& config, std::unique_ptr<PreRollBuffer> buffer);
+
+    /**
+     * @brief Creates the job queue and the writer task.
+     */
+    esp_err_t Initialize();
+
+    /**
+     * @brief FreeRTOS task that writes triggered clips to flash.
+     * @param param A void pointer to the owning ClipRecorder.
+     */
+    static void WriterTask(void* param);
+
+    /**
+     * @brief Encodes one clip window from the history buffer to a file.
+     * * Skips the clip if the storage cannot hold it, and cuts it short if
+     * capture stops before the post-roll is complete.
+     */
+    esp_err_t WriteClip(const ClipJob& job);
+
+    Config config_;
+    std::unique_ptr<PreRollBuffer> buffer_;
+    QueueHandle_t job_queue_ = nullptr;
+    TaskHandle_t writer_task_handle_ = nullptr;
+    std::atomic<bool> busy_{false};
+    uint32_t next_clip_index_ = 0;
+
+    // Writer task working memory, one block regardless of clip length.
+    codec::LosslessEncoder encoder_;
+    std::array<int16_t, codec::LosslessEncoder::kBlockSamples> block_;
+    std::array<uint8_t, codec::LosslessEncoder::kMaxEncodedBlockBytes>
+        encoded_;
+};
+
+}  // namespace clip
+
+#endif  // CLIP_RECORDER_CLIP_RECORDER_HPP_
@@ -0,0 +1,73 @@
+#include "pre_roll_buffer.hpp"
+
+#include <algorithm>
+
+#include "esp_log.h"
+#include "memory_placement.hpp"
+
+namespace {
+static const char* kTag = "PreRollBuffer";
+}  // namespace
+
+namespace clip {
+
+std::unique_ptr<PreRollBuffer> PreRollBuffer::Create(size_t capacity_samples) {
+    auto* storage = static_cast<int16_t*>(memory::MemoryPlacement::Allocate(
+        memory::BufferClass::kBulkHistory,
+        capacity_samples * sizeof(int16_t)));
+    if (storage == nullptr) {
+        return nullptr;
+    }
+    ESP_LOGI(kTag, "Allocated %zu samples of history.", capacity_samples);
+    return std::unique_ptr<PreRollBuffer>(
+        new PreRollBuffer(storage, capacity_samples));
+}
+
+PreRollBuffer::PreRollBuffer(int16_t* storage, size_t capacity)
+    : storage_(storage), capacity_(capacity) {}
+
+PreRollBuffer::~PreRollBuffer() {
+    memory::MemoryPlacement::Free(memory::BufferClass::kBulkHistory, storage_);
+}
+
+std::span<int16_t> PreRollBuffer::AcquireWrite(size_t max_samples) {
+    const size_t position = GetWrittenSamples() % capacity_;
+    const size_t length = std::min(max_samples, capacity_ - position);
+    // Published before the slot is written, as in ble::SeqLock, so a
+    // reader that copied overwritten samples sees them excluded when it
+    // re-checks Contains().
+    in_flight_.store(length, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return std::span<int16_t>(storage_ + position, length);
+}
+
+void PreRollBuffer::CommitWrite(size_t samples) {
+    written_.fetch_add(samples, std::memory_order_release);
+    in_flight_.store(0, std::memory_order_release);
+}
+
+uint64_t PreRollBuffer::GetOldestReadable(uint64_t written) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t held = capacity_ - in_flight_.load(std::memory_order_relaxed);
+    return written > held ? written - held : 0;
+}
+
+bool PreRollBuffer::Contains(uint64_t sample_index) const {
+    const uint64_t written = GetWrittenSamples();
+    return sample_index < written &&
+           sample_index >= GetOldestReadable(written);
+}
+
+std::span<const int16_t> PreRollBuffer::View(uint64_t start,
+                                             size_t max_samples) const {
+    const uint64_t written = GetWrittenSamples();
+    if (start >= written || start < GetOldestReadable(written)) {
+        return {};
+    }
+    const size_t position = start % capacity_;
+    const size_t length = std::min<uint64_t>(
+        {max_samples, written - start, capacity_ - position});
+    return std::span<const int16_t>(storage_ + position, length);
+}
+
+}  // namespace clip
@@ -0,0 +1,101 @@
+#ifndef CLIP_RECORDER_PRE_ROLL_BUFFER_HPP_
+#define CLIP_RECORDER_PRE_ROLL_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace clip {
+
+/**
+ * @class PreRollBuffer
+ * @brief A PSRAM-backed circular buffer holding the most recent PCM history.
+ *
+ * The capture path writes each frame directly into the ring through
+ * AcquireWrite() / CommitWrite(), so keeping the history costs no copy.
+ * Samples are addressed by their absolute index since the buffer was
+ * created; a sample stays readable until the writer acquires the slot
+ * holding it, which happens once `capacity` newer samples, including the
+ * slot, would follow it.
+ *
+ * There is a single writer (the capture task) and any number of readers.
+ * Readers must re-check Contains() after consuming a view, since the writer
+ * may overwrite the oldest samples at any time.
+ */
+class PreRollBuffer {
+   public:
+    /**
+     * @brief Allocates a ring buffer as bulk history, i.e. in PSRAM, or in
+     * internal RAM if PSRAM is missing and enough internal RAM stays free.
+     * @param capacity_samples Number of samples of history to keep.
+     * @return The buffer on success, or nullptr if no region has room.
+     */
+    static std::unique_ptr<PreRollBuffer> Create(size_t capacity_samples);
+
+    ~PreRollBuffer();
+
+    PreRollBuffer(const PreRollBuffer&) = delete;
+    PreRollBuffer& operator=(const PreRollBuffer&) = delete;
+
+    /**
+     * @brief Returns the contiguous free slot at the write position.
+     *
+     * The samples the slot overwrites stop being readable at once, before
+     * the writer touches them.
+     *
+     * @param max_samples Requested slot length.
+     * @return A slot of up to `max_samples`, shorter if the ring wraps.
+     */
+    std::span<int16_t> AcquireWrite(size_t max_samples);
+
+    /**
+     * @brief Publishes samples written into the slot from AcquireWrite().
+     * @param samples Number of samples written.
+     */
+    void CommitWrite(size_t samples);
+
+    /**
+     * @brief Returns the absolute index one past the newest sample.
+     */
+    uint64_t GetWrittenSamples() const {
+        return written_.load(std::memory_order_acquire);
+    }
+
+    size_t GetCapacity() const { return capacity_; }
+
+    /**
+     * @brief Checks whether a sample is still held by the buffer.
+     * @param sample_index Absolute sample index.
+     */
+    bool Contains(uint64_t sample_index) const;
+
+    /**
+     * @brief Returns a contiguous read-only view of buffered samples.
+     * @param start Absolute index of the first sample.
+     * @param max_samples Maximum view length.
+     * @return The view, shortened at the wrap point or the newest sample.
+     * Empty if `start` has already been overwritten or not yet written.
+     */
+    std::span<const int16_t> View(uint64_t start, size_t max_samples) const;
+
+   private:
+    PreRollBuffer(int16_t* storage, size_t capacity);
+
+    int16_t* storage_;
+    size_t capacity_;
+    std::atomic<uint64_t> written_{0};
+    // Length of the slot handed out by AcquireWrite() and not yet
+    // committed. Its old samples are excluded from reads.
+    std::atomic<size_t> in_flight_{0};
+
+    /**
+     * @brief Returns the absolute index of the oldest readable sample.
+     */
+    uint64_t GetOldestReadable(uint64_t written) const;
+};
+
+}  // namespace clip
+
+#endif  // CLIP_RECORDER_PRE_ROLL_BUFFER_HPP_
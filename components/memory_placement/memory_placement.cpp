@@ -0,0 +1,143 @@
+#include "memory_placement.hpp"
+
+#include <iterator>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+namespace {
+static const char* kTag = "MemoryPlacement";
+
+constexpr uint32_t kInternalCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+constexpr uint32_t kDmaCaps = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL;
+constexpr uint32_t kPsramCaps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+
+/**
+ * @brief Regions to try for a buffer class, in order of preference.
+ */
+struct Route {
+    uint32_t preferred_caps;
+    uint32_t fallback_caps;  // 0 if there is no fallback
+};
+
+constexpr Route kRoutes[] = {
+    {kDmaCaps, 0},               // kDma
+    {kInternalCaps, 0},          // kHotScratch
+    {kPsramCaps, kInternalCaps},  // kBulkHistory
+    {kPsramCaps, kInternalCaps},  // kLogStaging
+};
+static_assert(std::size(kRoutes) ==
+              static_cast<size_t>(memory::BufferClass::kCount));
+
+const char* const kClassNames[] = {"DMA", "hot scratch", "bulk history",
+                                   "log staging"};
+const char* const kRegionNames[] = {"internal", "DMA", "PSRAM"};
+constexpr uint32_t kRegionCaps[] = {kInternalCaps, kDmaCaps, kPsramCaps};
+}  // namespace
+
+namespace memory {
+
+std::array<MemoryPlacement::ClassCounters,
+           static_cast<size_t>(BufferClass::kCount)>
+    MemoryPlacement::s_counters_;
+
+void* MemoryPlacement::Allocate(BufferClass buffer_class, size_t bytes) {
+    const size_t index = static_cast<size_t>(buffer_class);
+    if (index >= static_cast<size_t>(BufferClass::kCount) || bytes == 0) {
+        return nullptr;
+    }
+    ClassCounters& counters = s_counters_[index];
+    const Route& route = kRoutes[index];
+    const size_t padded =
+        (bytes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+
+    void* pointer =
+        heap_caps_aligned_alloc(kCacheLineSize, padded, route.preferred_caps);
+    if (pointer == nullptr && route.fallback_caps != 0 &&
+        heap_caps_get_free_size(route.fallback_caps) >=
+            padded + kInternalReserveBytes) {
+        pointer = heap_caps_aligned_alloc(kCacheLineSize, padded,
+                                          route.fallback_caps);
+        if (pointer != nullptr) {
+            counters.fallbacks.fetch_add(1, std::memory_order_relaxed);
+            ESP_LOGW(kTag, "Placed %zu bytes of %s in internal RAM.", padded,
+                     kClassNames[index]);
+        }
+    }
+    if (pointer == nullptr) {
+        counters.failures.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGE(kTag, "Failed to allocate %zu bytes of %s.", padded,
+                 kClassNames[index]);
+        return nullptr;
+    }
+
+    // Account what the heap actually reserved, so Free() can subtract the
+    // same amount without the size being stored alongside the buffer.
+    const size_t reserved = heap_caps_get_allocated_size(pointer);
+    const size_t total =
+        counters.bytes.fetch_add(reserved, std::memory_order_relaxed) +
+        reserved;
+    size_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+    while (peak < total && !counters.peak_bytes.compare_exchange_weak(
+                               peak, total, std::memory_order_relaxed)) {
+    }
+    return pointer;
+}
+
+void MemoryPlacement::Free(BufferClass buffer_class, void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    s_counters_[static_cast<size_t>(buffer_class)].bytes.fetch_sub(
+        heap_caps_get_allocated_size(pointer), std::memory_order_relaxed);
+    heap_caps_free(pointer);
+}
+
+void MemoryPlacement::Deleter::operator()(void* pointer) const {
+    Free(buffer_class, pointer);
+}
+
+MemoryPlacement::ClassUsage MemoryPlacement::GetClassUsage(
+    BufferClass buffer_class) {
+    const ClassCounters& counters =
+        s_counters_[static_cast<size_t>(buffer_class)];
+    return ClassUsage{
+        .bytes = counters.bytes.load(std::memory_order_relaxed),
+        .peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed),
+        .failures = counters.failures.load(std::memory_order_relaxed),
+        .fallbacks = counters.fallbacks.load(std::memory_order_relaxed),
+    };
+}
+
+MemoryPlacement::RegionUsage MemoryPlacement::GetRegionUsage(Region region) {
+    const uint32_t caps = kRegionCaps[static_cast<size_t>(region)];
+    return RegionUsage{
+        .total_bytes = heap_caps_get_total_size(caps),
+        .free_bytes = heap_caps_get_free_size(caps),
+        .minimum_free_bytes = heap_caps_get_minimum_free_size(caps),
+        .largest_free_block = heap_caps_get_largest_free_block(caps),
+    };
+}
+
+void MemoryPlacement::LogUsage() {
+    for (size_t i = 0; i < static_cast<size_t>(Region::kCount); ++i) {
+        const RegionUsage usage = GetRegionUsage(static_cast<Region>(i));
+        if (usage.total_bytes == 0) {
+            ESP_LOGI(kTag, "%s: not present.", kRegionNames[i]);
+            continue;
+        }
+        ESP_LOGI(kTag,
+                 "%s: %zu of %zu bytes free, minimum %zu, largest block %zu.",
+                 kRegionNames[i], usage.free_bytes, usage.total_bytes,
+                 usage.minimum_free_bytes, usage.largest_free_block);
+    }
+    for (size_t i = 0; i < static_cast<size_t>(BufferClass::kCount); ++i) {
+        const ClassUsage usage = GetClassUsage(static_cast<BufferClass>(i));
+        ESP_LOGI(kTag, "%s: %zu bytes, peak %zu, %lu fallbacks, %lu failures.",
+                 kClassNames[i], usage.bytes, usage.peak_bytes,
+                 static_cast<unsigned long>(usage.fallbacks),
+                 static_cast<unsigned long>(usage.failures));
+    }
+}
+
+}  // namespace memory
@@ -0,0 +1,126 @@
+#ifndef MEMORY_PLACEMENT_HPP_
+#define MEMORY_PLACEMENT_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace memory {
+
+/**
+ * @brief What a buffer is used for, which decides where it is placed.
+ */
+enum class BufferClass : uint8_t {
+    kDma = 0,      // Read or written by a peripheral DMA: internal DMA RAM
+    kHotScratch,   // Touched every frame by DSP code: internal RAM only
+    kBulkHistory,  // Large rings touched a frame at a time: PSRAM first
+    kLogStaging,   // Staging for flash writes, off the hot path: PSRAM first
+    kCount,
+};
+
+/**
+ * @brief Heap regions usage is reported for.
+ */
+enum class Region : uint8_t {
+    kInternal = 0,
+    kDma,
+    kPsram,
+    kCount,
+};
+
+/**
+ * @class MemoryPlacement
+ * @brief Routes buffer allocations to heap_caps regions by buffer class.
+ *
+ * Every allocation is aligned to, and padded to a multiple of, the data
+ * cache line, so buffers never share a line with unrelated data; that is
+ * required for DMA into cached memory and avoids false sharing between the
+ * cores. PSRAM-first classes fall back to internal RAM only while at least
+ * kInternalReserveBytes of it stay free, so large history buffers cannot
+ * starve the BLE stack and task stacks on boards without PSRAM.
+ *
+ * Thread-safe.
+ */
+class MemoryPlacement {
+   public:
+    static constexpr size_t kCacheLineSize = 64;
+    static constexpr size_t kInternalReserveBytes = 64 * 1024;
+
+    struct ClassUsage {
+        size_t bytes;        // Currently reserved, including padding
+        size_t peak_bytes;   // Most allocated at once
+        uint32_t failures;   // Allocations no region could satisfy
+        uint32_t fallbacks;  // Allocations placed outside the first choice
+    };
+
+    struct RegionUsage {
+        size_t total_bytes;
+        size_t free_bytes;
+        size_t minimum_free_bytes;  // Low-water mark since boot
+        size_t largest_free_block;
+    };
+
+    /**
+     * @brief Frees a buffer and updates the usage of its class.
+     */
+    struct Deleter {
+        BufferClass buffer_class;
+        void operator()(void* pointer) const;
+    };
+
+    template <typename T>
+    using UniquePtr = std::unique_ptr<T[], Deleter>;
+
+    /**
+     * @brief Allocates an uninitialised buffer.
+     * @param buffer_class Decides the region, see BufferClass.
+     * @param bytes Requested size.
+     * @return The buffer, or nullptr if no permitted region has room.
+     */
+    static void* Allocate(BufferClass buffer_class, size_t bytes);
+
+    /**
+     * @brief Frees a buffer from Allocate().
+     */
+    static void Free(BufferClass buffer_class, void* pointer);
+
+    /**
+     * @brief Allocates an owned array of `count` elements.
+     * @return The array, or an empty pointer if no permitted region has
+     * room.
+     */
+    template <typename T>
+    static UniquePtr<T> Allocate(BufferClass buffer_class, size_t count) {
+        static_assert(std::is_trivially_default_constructible_v<T>,
+                      "Elements are left uninitialised");
+        return UniquePtr<T>(
+            static_cast<T*>(Allocate(buffer_class, count * sizeof(T))),
+            Deleter{buffer_class});
+    }
+
+    static ClassUsage GetClassUsage(BufferClass buffer_class);
+    static RegionUsage GetRegionUsage(Region region);
+
+    /**
+     * @brief Logs the usage of every region and buffer class.
+     */
+    static void LogUsage();
+
+   private:
+    struct ClassCounters {
+        std::atomic<size_t> bytes{0};
+        std::atomic<size_t> peak_bytes{0};
+        std::atomic<uint32_t> failures{0};
+        std::atomic<uint32_t> fallbacks{0};
+    };
+
+    static std::array<ClassCounters, static_cast<size_t>(BufferClass::kCount)>
+        s_counters_;
+};
+
+}  // namespace memory
+
+#endif  // MEMORY_PLACEMENT_HPP_
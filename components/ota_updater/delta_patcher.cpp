@@ -0,0 +1,182 @@
+#include "delta_patcher.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace ota {
+
+DeltaPatcher::DeltaPatcher(SourceReader reader, Sink sink)
+    : reader_(std::move(reader)), sink_(std::move(sink)) {}
+
+void DeltaPatcher::Reset(uint32_t source_size) {
+    state_ = State::kOpcode;
+    opcode_ = kOpEnd;
+    varint_ = 0;
+    varint_shift_ = 0;
+    remaining_ = 0;
+    source_size_ = source_size;
+    source_cursor_ = 0;
+    target_size_ = 0;
+    chunk_offset_ = 0;
+    chunk_length_ = 0;
+    output_fill_ = 0;
+}
+
+esp_err_t DeltaPatcher::Write(std::span<const uint8_t> data) {
+    size_t index = 0;
+    while (index < data.size()) {
+        switch (state_) {
+            case State::kOpcode:
+                opcode_ = data[index++];
+                if (opcode_ == kOpEnd) {
+                    state_ = State::kDone;
+                } else if (opcode_ == kOpAdd || opcode_ == kOpInsert) {
+                    state_ = State::kLength;
+                } else {
+                    state_ = State::kError;
+                }
+                break;
+
+            case State::kLength:
+                if (!ReadVarint(data[index++])) {
+                    break;
+                }
+                if (varint_ > UINT32_MAX) {
+                    state_ = State::kError;
+                    break;
+                }
+                remaining_ = static_cast<uint32_t>(varint_);
+                varint_ = 0;
+                state_ = opcode_ == kOpAdd ? State::kSeek : State::kInsertData;
+                if (state_ == State::kInsertData && remaining_ == 0) {
+                    state_ = State::kOpcode;
+                }
+                break;
+
+            case State::kSeek: {
+                if (!ReadVarint(data[index++])) {
+                    break;
+                }
+                // Zigzag: even values are positive, odd ones negative.
+                const int64_t seek =
+                    static_cast<int64_t>(varint_ >> 1) ^
+                    -static_cast<int64_t>(varint_ & 1);
+                varint_ = 0;
+                const int64_t cursor = source_cursor_ + seek;
+                if (cursor < 0 || cursor + remaining_ > source_size_) {
+                    state_ = State::kError;
+                    break;
+                }
+                source_cursor_ = static_cast<uint32_t>(cursor);
+                state_ = remaining_ > 0 ? State::kAddData : State::kOpcode;
+                break;
+            }
+
+            case State::kAddData:
+            case State::kInsertData: {
+                const size_t length = std::min<size_t>(
+                    remaining_, data.size() - index);
+                const std::span<const uint8_t> piece =
+                    data.subspan(index, length);
+                esp_err_t ret = ESP_OK;
+                if (state_ == State::kAddData) {
+                    ret = ApplyAdd(piece);
+                } else {
+                    for (uint8_t value : piece) {
+                        ret = Emit(value);
+                        if (ret != ESP_OK) {
+                            break;
+                        }
+                    }
+                }
+                if (ret != ESP_OK) {
+                    state_ = State::kError;
+                    return ret;
+                }
+                index += length;
+                remaining_ -= length;
+                if (remaining_ == 0) {
+                    state_ = State::kOpcode;
+                }
+                break;
+            }
+
+            case State::kDone:
+                // Nothing may follow the end command.
+                state_ = State::kError;
+                break;
+
+            case State::kError:
+                return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    return state_ == State::kError ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+}
+
+esp_err_t DeltaPatcher::Finish() {
+    if (state_ == State::kError) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (state_ != State::kDone) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (output_fill_ > 0) {
+        esp_err_t ret = sink_(std::span<const uint8_t>(output_.data(),
+                                                       output_fill_));
+        output_fill_ = 0;
+        return ret;
+    }
+    return ESP_OK;
+}
+
+bool DeltaPatcher::ReadVarint(uint8_t byte) {
+    // A uint64_t takes at most ten bytes, the last holding only bit 63.
+    if (varint_shift_ > 63 || (varint_shift_ == 63 && (byte & 0x7E) != 0)) {
+        state_ = State::kError;
+        return false;
+    }
+    varint_ |= static_cast<uint64_t>(byte & 0x7F) << varint_shift_;
+    varint_shift_ += 7;
+    if (byte & 0x80) {
+        return false;
+    }
+    varint_shift_ = 0;
+    return true;
+}
+
+esp_err_t DeltaPatcher::ApplyAdd(std::span<const uint8_t> diff) {
+    for (uint8_t delta : diff) {
+        if (source_cursor_ < chunk_offset_ ||
+            source_cursor_ >= chunk_offset_ + chunk_length_) {
+            chunk_offset_ = source_cursor_;
+            chunk_length_ = std::min<size_t>(kSourceChunkSize,
+                                             source_size_ - source_cursor_);
+            esp_err_t ret = reader_(
+                chunk_offset_,
+                std::span<uint8_t>(source_chunk_.data(), chunk_length_));
+            if (ret != ESP_OK) {
+                chunk_length_ = 0;
+                return ret;
+            }
+        }
+        const uint8_t source = source_chunk_[source_cursor_ - chunk_offset_];
+        ++source_cursor_;
+        esp_err_t ret = Emit(static_cast<uint8_t>(source + delta));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t DeltaPatcher::Emit(uint8_t value) {
+    output_[output_fill_++] = value;
+    ++target_size_;
+    if (output_fill_ == output_.size()) {
+        output_fill_ = 0;
+        return sink_(output_);
+    }
+    return ESP_OK;
+}
+
+}  // namespace ota
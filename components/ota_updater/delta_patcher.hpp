@@ -0,0 +1,135 @@
+#ifndef OTA_UPDATER_DELTA_PATCHER_HPP_
+#define OTA_UPDATER_DELTA_PATCHER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "esp_err.h"
+
+namespace ota {
+
+/**
+ * @class DeltaPatcher
+ * @brief Rebuilds a target image from a source image and a patch stream.
+ *
+ * The patch is a sequence of commands, each an opcode byte followed by
+ * unsigned LEB128 varints:
+ * - kOpEnd: the target is complete.
+ * - kOpAdd (length, seek): moves the source cursor by `seek`, zigzag
+ *   encoded, then reads `length` difference bytes. Each target byte is the
+ *   source byte at the cursor plus the difference, modulo 256, and the
+ *   cursor advances with it. Unchanged code yields runs of zeros, which
+ *   compress well.
+ * - kOpInsert (length): `length` literal target bytes follow.
+ *
+ * A full image is a single insert. The patch may be fed in pieces of any
+ * size. Memory use is fixed: source bytes are read in small chunks and the
+ * target is handed to the sink in blocks of kOutputBlockSize.
+ */
+class DeltaPatcher {
+   public:
+    static constexpr uint8_t kOpEnd = 0x00;
+    static constexpr uint8_t kOpAdd = 0x01;
+    static constexpr uint8_t kOpInsert = 0x02;
+
+    static constexpr size_t kSourceChunkSize = 256;
+    static constexpr size_t kOutputBlockSize = 512;
+
+    // Reads `dest.size()` source bytes starting at `offset`.
+    using SourceReader =
+        std::function<esp_err_t(uint32_t offset, std::span<uint8_t> dest)>;
+    // Consumes the next block of target bytes.
+    using Sink = std::function<esp_err_t(std::span<const uint8_t> data)>;
+
+    DeltaPatcher(SourceReader reader, Sink sink);
+
+    DeltaPatcher(const DeltaPatcher&) = delete;
+    DeltaPatcher& operator=(const DeltaPatcher&) = delete;
+
+    /**
+     * @brief Prepares for a new patch.
+     * @param source_size Size of the source image, which bounds the cursor.
+     */
+    void Reset(uint32_t source_size);
+
+    /**
+     * @brief Applies the next piece of the patch stream.
+     * @param data Patch bytes, in stream order.
+     * @return ESP_OK on success, ESP_ERR_INVALID_RESPONSE for a malformed
+     * patch, or the error of the reader or sink.
+     */
+    esp_err_t Write(std::span<const uint8_t> data);
+
+    /**
+     * @brief Hands the remaining target bytes to the sink.
+     * @return ESP_OK if the end command was reached and the output flushed,
+     * ESP_ERR_INVALID_SIZE if the patch is truncated.
+     */
+    esp_err_t Finish();
+
+    /**
+     * @brief Checks whether the end command has been reached.
+     */
+    bool IsDone() const { return state_ == State::kDone; }
+
+    /**
+     * @brief Returns the number of target bytes produced so far.
+     */
+    uint32_t GetTargetSize() const { return target_size_; }
+
+   private:
+    enum class State : uint8_t {
+        kOpcode,
+        kLength,
+        kSeek,
+        kAddData,
+        kInsertData,
+        kDone,
+        kError,
+    };
+
+    /**
+     * @brief Accumulates one varint byte.
+     * @return true once the varint is complete, in `varint_`. Varints
+     * longer than ten bytes, or above UINT64_MAX, set the error state.
+     */
+    bool ReadVarint(uint8_t byte);
+
+    /**
+     * @brief Applies difference bytes against the source.
+     */
+    esp_err_t ApplyAdd(std::span<const uint8_t> diff);
+
+    /**
+     * @brief Appends target bytes, flushing full blocks to the sink.
+     */
+    esp_err_t Emit(uint8_t value);
+
+    SourceReader reader_;
+    Sink sink_;
+
+    State state_ = State::kOpcode;
+    uint8_t opcode_ = kOpEnd;
+    uint64_t varint_ = 0;
+    uint8_t varint_shift_ = 0;
+    uint32_t remaining_ = 0;
+
+    uint32_t source_size_ = 0;
+    uint32_t source_cursor_ = 0;
+    uint32_t target_size_ = 0;
+
+    // Source bytes at [chunk_offset_, chunk_offset_ + chunk_length_).
+    std::array<uint8_t, kSourceChunkSize> source_chunk_{};
+    uint32_t chunk_offset_ = 0;
+    size_t chunk_length_ = 0;
+
+    std::array<uint8_t, kOutputBlockSize> output_{};
+    size_t output_fill_ = 0;
+};
+
+}  // namespace ota
+
+#endif  // OTA_UPDATER_DELTA_PATCHER_HPP_
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Writes the OTA patch fixtures of the host tests.
+
+Usage:
+    make_fixtures.py MAKE_OTA_PATCH.py OUT_DIR
+
+Builds a source image and an edited target image, then patches between
+them with the real tool: a full compressed image, a compressed delta and a
+raw delta.
+"""
+
+import os
+import random
+import subprocess
+import sys
+
+
+def make_source(rng, size):
+    """Code-like data: a small vocabulary of repeated words with noise."""
+    words = [bytes(rng.randrange(256) for _ in range(rng.randrange(2, 9)))
+             for _ in range(200)]
+    out = bytearray()
+    while len(out) < size:
+        out += rng.choice(words)
+        if rng.random() < 0.1:
+            out.append(rng.randrange(256))
+    return bytes(out[:size])
+
+
+def make_target(rng, source):
+    target = bytearray(source)
+    # Patched constants.
+    for _ in range(40):
+        target[rng.randrange(len(target))] ^= 0x5A
+    # Inserted and removed code shifts everything after it.
+    middle = len(target) // 2
+    target[middle:middle] = bytes(rng.randrange(256) for _ in range(700))
+    del target[3000:3400]
+    # A moved function.
+    block = target[8000:10000]
+    del target[8000:10000]
+    target[20000:20000] = block
+    # New code at the end.
+    target += bytes(rng.randrange(256) for _ in range(1500))
+    return bytes(target)
+
+
+def main():
+    tool, out_dir = sys.argv[1], sys.argv[2]
+    os.makedirs(out_dir, exist_ok=True)
+    rng = random.Random(90)
+    source = make_source(rng, 40000)
+    target = make_target(rng, source)
+
+    paths = {name: os.path.join(out_dir, name)
+             for name in ("source.bin", "target.bin")}
+    for name, data in (("source.bin", source), ("target.bin", target)):
+        with open(paths[name], "wb") as f:
+            f.write(data)
+
+    def run(output, *args):
+        subprocess.run([sys.executable, tool, paths["target.bin"],
+                        os.path.join(out_dir, output), *args], check=True)
+
+    run("full.sfp")
+    run("delta.sfp", "--source", paths["source.bin"])
+    run("delta_raw.sfp", "--source", paths["source.bin"], "--raw")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "delta_patcher.hpp"
+#include "lzss_decoder.hpp"
+
+namespace {
+
+using ota::DeltaPatcher;
+using ota::LzssDecoder;
+
+using Bytes = std::vector<uint8_t>;
+
+// Header written by tools/make_ota_patch.py, see ota::OtaUpdater.
+constexpr size_t kPatchHeaderSize = 24;
+constexpr uint8_t kFlagCompressed = 0x01;
+// Largest OTA data chunk over BLE.
+constexpr size_t kMaxChunkBytes = 229;
+
+Bytes ReadFixture(const std::string& name) {
+    std::ifstream file(std::string(OTA_FIXTURE_DIR) + "/" + name,
+                       std::ios::binary);
+    EXPECT_TRUE(file.good()) << name;
+    return Bytes(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+}
+
+// Patches against `source`, collecting the target.
+class PatchHarness {
+   public:
+    explicit PatchHarness(const Bytes& source)
+        : source_(source),
+          patcher_(
+              [this](uint32_t offset, std::span<uint8_t> dest) {
+                  if (offset + dest.size() > source_.size()) {
+                      return ESP_ERR_INVALID_SIZE;
+                  }
+                  std::copy_n(&source_[offset], dest.size(), dest.begin());
+                  return ESP_OK;
+              },
+              [this](std::span<const uint8_t> data) {
+                  target_.insert(target_.end(), data.begin(), data.end());
+                  return ESP_OK;
+              }) {
+        patcher_.Reset(source_.size());
+    }
+
+    DeltaPatcher& patcher() { return patcher_; }
+    const Bytes& target() const { return target_; }
+
+   private:
+    const Bytes& source_;
+    DeltaPatcher patcher_;
+    Bytes target_;
+};
+
+// Applies a patch file the way OtaUpdater does, fed in `chunk` byte pieces
+// and decoded through a `buffer_size` byte buffer.
+Bytes ApplyPatch(const Bytes& patch, const Bytes& source, size_t chunk,
+                 size_t buffer_size) {
+    EXPECT_GE(patch.size(), kPatchHeaderSize);
+    EXPECT_EQ(std::memcmp(patch.data(), "SFPT", 4), 0);
+    const bool compressed = (patch[5] & kFlagCompressed) != 0;
+
+    PatchHarness harness(source);
+    LzssDecoder decoder;
+    Bytes buffer(buffer_size);
+    const auto write = [&harness](std::span<const uint8_t> decoded) {
+        return harness.patcher().Write(decoded);
+    };
+    for (size_t offset = kPatchHeaderSize; offset < patch.size();
+         offset += chunk) {
+        const std::span<const uint8_t> piece(
+            &patch[offset], std::min(chunk, patch.size() - offset));
+        const esp_err_t ret = compressed
+                                  ? decoder.DecodeAll(piece, buffer, write)
+                                  : harness.patcher().Write(piece);
+        EXPECT_EQ(ret, ESP_OK) << "at patch offset " << offset;
+        if (ret != ESP_OK) {
+            return {};
+        }
+    }
+    if (compressed) {
+        EXPECT_EQ(decoder.DecodeAll({}, buffer, write), ESP_OK);
+    }
+    EXPECT_EQ(harness.patcher().Finish(), ESP_OK);
+    EXPECT_EQ(harness.patcher().GetTargetSize(), harness.target().size());
+    return harness.target();
+}
+
+TEST(OtaPatch, AppliesToolPatchesInAnyChunking) {
+    const Bytes source = ReadFixture("source.bin");
+    const Bytes target = ReadFixture("target.bin");
+    struct Case {
+        const char* file;
+        const Bytes* source;
+    };
+    const Bytes no_source;
+    const Case kCases[] = {
+        {"full.sfp", &no_source},
+        {"delta.sfp", &source},
+        {"delta_raw.sfp", &source},
+    };
+    for (const Case& test : kCases) {
+        const Bytes patch = ReadFixture(test.file);
+        for (const size_t chunk : {size_t{1}, size_t{7}, kMaxChunkBytes,
+                                   patch.size()}) {
+            for (const size_t buffer_size :
+                 {size_t{1}, size_t{5}, DeltaPatcher::kOutputBlockSize}) {
+                EXPECT_EQ(ApplyPatch(patch, *test.source, chunk, buffer_size),
+                          target)
+                    << test.file << ", chunks of " << chunk
+                    << ", buffer of " << buffer_size;
+            }
+        }
+    }
+}
+
+TEST(OtaPatch, RejectsPatchForOtherSource) {
+    Bytes source = ReadFixture("source.bin");
+    const Bytes target = ReadFixture("target.bin");
+    source[100] ^= 1;
+    // The updater refuses this by CRC; the patcher itself just applies
+    // the differences, so the target comes out wrong.
+    PatchHarness harness(source);
+    LzssDecoder decoder;
+    const Bytes patch = ReadFixture("delta_raw.sfp");
+    ASSERT_EQ(harness.patcher().Write(std::span<const uint8_t>(patch).subspan(
+                  kPatchHeaderSize)),
+              ESP_OK);
+    ASSERT_EQ(harness.patcher().Finish(), ESP_OK);
+    EXPECT_NE(harness.target(), target);
+}
+
+TEST(LzssDecoder, DrainsMatchEndingTheInput) {
+    // A literal 'A', then a match of 18 bytes at distance 1.
+    const Bytes stream = {0x01, 'A', 0x00, 0x0F};
+    const Bytes expected(1 + LzssDecoder::kMaxMatch, 'A');
+
+    // Decode() alone stops when its output is full, with the input
+    // already used up.
+    LzssDecoder decoder;
+    Bytes buffer(4);
+    size_t consumed = 0;
+    size_t produced = 0;
+    ASSERT_EQ(decoder.Decode(stream, consumed, buffer, produced), ESP_OK);
+    EXPECT_EQ(consumed, stream.size());
+    EXPECT_EQ(produced, buffer.size());
+
+    decoder.Reset();
+    Bytes output;
+    ASSERT_EQ(decoder.DecodeAll(stream, buffer,
+                                [&output](std::span<const uint8_t> data) {
+                                    output.insert(output.end(), data.begin(),
+                                                  data.end());
+                                    return ESP_OK;
+                                }),
+              ESP_OK);
+    EXPECT_EQ(output, expected);
+}
+
+TEST(LzssDecoder, RejectsMatchBeforeStreamStart) {
+    // A literal, then a match reaching two bytes back.
+    const Bytes stream = {0x01, 'A', 0x01, 0x00};
+    LzssDecoder decoder;
+    Bytes buffer(16);
+    size_t consumed = 0;
+    size_t produced = 0;
+    EXPECT_EQ(decoder.Decode(stream, consumed, buffer, produced),
+              ESP_ERR_INVALID_RESPONSE);
+}
+
+TEST(LzssDecoder, PropagatesSinkErrors) {
+    const Bytes stream = {0xFF, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h'};
+    LzssDecoder decoder;
+    Bytes buffer(3);
+    EXPECT_EQ(decoder.DecodeAll(stream, buffer,
+                                [](std::span<const uint8_t>) {
+                                    return ESP_ERR_TIMEOUT;
+                                }),
+              ESP_ERR_TIMEOUT);
+}
+
+TEST(DeltaPatcher, AcceptsTenByteVarints) {
+    const Bytes source;
+    PatchHarness harness(source);
+    // Insert of 3 bytes, the length padded to the longest varint.
+    Bytes patch = {DeltaPatcher::kOpInsert, 0x83};
+    patch.insert(patch.end(), 8, 0x80);
+    patch.push_back(0x00);
+    patch.insert(patch.end(), {'x', 'y', 'z', DeltaPatcher::kOpEnd});
+    ASSERT_EQ(harness.patcher().Write(patch), ESP_OK);
+    ASSERT_EQ(harness.patcher().Finish(), ESP_OK);
+    EXPECT_EQ(harness.target(), (Bytes{'x', 'y', 'z'}));
+}
+
+TEST(DeltaPatcher, RejectsOverlongVarints) {
+    const Bytes source(64);
+    {
+        // Eleven bytes: continuation past the tenth.
+        PatchHarness harness(source);
+        Bytes patch = {DeltaPatcher::kOpInsert};
+        patch.insert(patch.end(), 10, 0x80);
+        patch.push_back(0x00);
+        EXPECT_EQ(harness.patcher().Write(patch), ESP_ERR_INVALID_RESPONSE);
+    }
+    {
+        // Ten bytes, but the last sets bits above 63.
+        PatchHarness harness(source);
+        Bytes patch = {DeltaPatcher::kOpAdd, 0x01};
+        patch.insert(patch.end(), 9, 0x80);
+        patch.push_back(0x02);
+        EXPECT_EQ(harness.patcher().Write(patch), ESP_ERR_INVALID_RESPONSE);
+    }
+    {
+        // Fed one byte at a time, the error still sticks.
+        PatchHarness harness(source);
+        Bytes patch = {DeltaPatcher::kOpInsert};
+        patch.insert(patch.end(), 40, 0xFF);
+        esp_err_t ret = ESP_OK;
+        for (const uint8_t byte : patch) {
+            ret = harness.patcher().Write(std::span<const uint8_t>(&byte, 1));
+        }
+        EXPECT_EQ(ret, ESP_ERR_INVALID_RESPONSE);
+        EXPECT_EQ(harness.patcher().Finish(), ESP_ERR_INVALID_RESPONSE);
+    }
+}
+
+TEST(DeltaPatcher, RejectsSeekOutsideSource) {
+    const Bytes source(64);
+    PatchHarness harness(source);
+    // Add 8 bytes at +60: runs past the end of the source.
+    const Bytes patch = {DeltaPatcher::kOpAdd, 8, 120};
+    EXPECT_EQ(harness.patcher().Write(patch), ESP_ERR_INVALID_RESPONSE);
+
+    PatchHarness backwards(source);
+    // Seek to -1.
+    const Bytes before_start = {DeltaPatcher::kOpAdd, 1, 1};
+    EXPECT_EQ(backwards.patcher().Write(before_start),
+              ESP_ERR_INVALID_RESPONSE);
+}
+
+TEST(DeltaPatcher, ReportsTruncationAndTrailingData) {
+    const Bytes source;
+    PatchHarness truncated(source);
+    const Bytes partial = {DeltaPatcher::kOpInsert, 4, 'a', 'b'};
+    ASSERT_EQ(truncated.patcher().Write(partial), ESP_OK);
+    EXPECT_EQ(truncated.patcher().Finish(), ESP_ERR_INVALID_SIZE);
+
+    PatchHarness trailing(source);
+    const Bytes after_end = {DeltaPatcher::kOpEnd, DeltaPatcher::kOpEnd};
+    EXPECT_EQ(trailing.patcher().Write(after_end), ESP_ERR_INVALID_RESPONSE);
+}
+
+}  // namespace
@@ -0,0 +1,73 @@
+#include "lzss_decoder.hpp"
+
+namespace ota {
+
+esp_err_t LzssDecoder::Decode(std::span<const uint8_t> input,
+                              size_t& consumed, std::span<uint8_t> output,
+                              size_t& produced) {
+    constexpr size_t kMask = kWindowSize - 1;
+    consumed = 0;
+    produced = 0;
+
+    while (produced < output.size()) {
+        uint8_t value;
+        if (match_remaining_ > 0) {
+            value = window_[(position_ - match_distance_) & kMask];
+            --match_remaining_;
+        } else if (flag_bits_ == 0) {
+            if (consumed == input.size()) {
+                break;
+            }
+            flags_ = input[consumed++];
+            flag_bits_ = 8;
+            continue;
+        } else if (flags_ & 1) {
+            if (consumed == input.size()) {
+                break;
+            }
+            value = input[consumed++];
+            flags_ >>= 1;
+            --flag_bits_;
+        } else {
+            if (consumed == input.size()) {
+                break;
+            }
+            if (!has_match_low_) {
+                match_low_ = input[consumed++];
+                has_match_low_ = true;
+                continue;
+            }
+            const uint8_t high = input[consumed++];
+            has_match_low_ = false;
+            flags_ >>= 1;
+            --flag_bits_;
+            match_distance_ = ((static_cast<size_t>(high >> 4) << 8) |
+                               match_low_) +
+                              1;
+            match_remaining_ = (high & 0x0F) + kMinMatch;
+            if (match_distance_ > total_out_) {
+                return ESP_ERR_INVALID_RESPONSE;
+            }
+            continue;
+        }
+
+        window_[position_ & kMask] = value;
+        ++position_;
+        ++total_out_;
+        output[produced++] = value;
+    }
+    return ESP_OK;
+}
+
+void LzssDecoder::Reset() {
+    position_ = 0;
+    total_out_ = 0;
+    flags_ = 0;
+    flag_bits_ = 0;
+    has_match_low_ = false;
+    match_low_ = 0;
+    match_distance_ = 0;
+    match_remaining_ = 0;
+}
+
+}  // namespace ota
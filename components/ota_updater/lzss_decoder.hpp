@@ -0,0 +1,97 @@
+#ifndef OTA_UPDATER_LZSS_DECODER_HPP_
+#define OTA_UPDATER_LZSS_DECODER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "esp_err.h"
+
+namespace ota {
+
+/**
+ * @class LzssDecoder
+ * @brief Streaming LZSS decompressor with a fixed 4 KB window.
+ *
+ * Stream format: a flag byte announces the next eight items, least
+ * significant bit first. A set bit is a literal byte. A clear bit is a
+ * two-byte match: the low 8 bits of (distance - 1), then its high 4 bits
+ * followed by (length - kMinMatch) in the low nibble. Matches copy `length`
+ * bytes starting `distance` bytes back in the output, and may overlap the
+ * bytes they produce.
+ *
+ * Input and output may be split anywhere, so compressed data can be fed as
+ * it arrives and decoded into a small buffer.
+ */
+class LzssDecoder {
+   public:
+    static constexpr size_t kWindowBits = 12;
+    static constexpr size_t kWindowSize = size_t{1} << kWindowBits;
+    static constexpr size_t kMinMatch = 3;
+    static constexpr size_t kMaxMatch = kMinMatch + 15;
+
+    LzssDecoder() = default;
+
+    /**
+     * @brief Decodes until the input is used up or the output is full.
+     * @param input Compressed bytes.
+     * @param[out] consumed Number of input bytes used.
+     * @param output Destination of the decoded bytes.
+     * @param[out] produced Number of bytes written to `output`.
+     * @return ESP_OK on success, or ESP_ERR_INVALID_RESPONSE if a match
+     * reaches back before the start of the stream.
+     */
+    esp_err_t Decode(std::span<const uint8_t> input, size_t& consumed,
+                     std::span<uint8_t> output, size_t& produced);
+
+    /**
+     * @brief Decodes all of `input` through a buffer.
+     *
+     * A match may produce bytes after its last input byte has been read,
+     * so decoding goes on while the buffer keeps filling up, even once the
+     * input is used up. Nothing is left pending on return.
+     *
+     * @param input Compressed bytes, possibly empty.
+     * @param buffer Scratch space for decoded bytes.
+     * @param sink Called with every decoded piece; returns esp_err_t.
+     * @return ESP_OK on success, or the error of Decode() or `sink`.
+     */
+    template <typename Sink>
+    esp_err_t DecodeAll(std::span<const uint8_t> input,
+                        std::span<uint8_t> buffer, Sink&& sink) {
+        size_t produced = buffer.size();
+        while (!input.empty() || produced == buffer.size()) {
+            size_t consumed = 0;
+            esp_err_t ret = Decode(input, consumed, buffer, produced);
+            if (ret == ESP_OK && produced > 0) {
+                ret = sink(std::span<const uint8_t>(buffer.data(), produced));
+            }
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            input = input.subspan(consumed);
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Prepares the decoder for a new stream.
+     */
+    void Reset();
+
+   private:
+    std::array<uint8_t, kWindowSize> window_{};
+    size_t position_ = 0;      // Window position of the next output byte
+    uint32_t total_out_ = 0;   // Bytes produced, to validate distances
+    uint8_t flags_ = 0;
+    uint8_t flag_bits_ = 0;    // Items left in the current group
+    bool has_match_low_ = false;
+    uint8_t match_low_ = 0;
+    size_t match_distance_ = 0;
+    size_t match_remaining_ = 0;
+};
+
+}  // namespace ota
+
+#endif  // OTA_UPDATER_LZSS_DECODER_HPP_
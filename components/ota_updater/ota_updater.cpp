@@ -0,0 +1,409 @@
+#include "ota_updater.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "ble_manager.hpp"
+
+// The CRC and the image SHA-256 only show that an image arrived intact;
+// the signature check in esp_ota_end() shows that it is ours.
+#if !defined(CONFIG_SECURE_SIGNED_ON_UPDATE)
+#error "OTA updates need signed app verification, see sdkconfig.defaults"
+#endif
+
+namespace {
+static const char* kTag = "OtaUpdater";
+
+constexpr uint32_t kWorkerTaskStackSize = 4096;
+// Below the BLE tasks, so flash writes never delay notifications.
+constexpr UBaseType_t kWorkerTaskPriority = 3;
+// Time for the final result to reach the client before restarting.
+constexpr uint32_t kRestartDelayMs = 1000;
+
+constexpr uint8_t kPatchMagic[4] = {'S', 'F', 'P', 'T'};
+
+uint32_t GetBigEndian32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) |
+           (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+void PutBigEndian32(uint8_t* data, uint32_t value) {
+    data[0] = static_cast<uint8_t>(value >> 24);
+    data[1] = static_cast<uint8_t>(value >> 16);
+    data[2] = static_cast<uint8_t>(value >> 8);
+    data[3] = static_cast<uint8_t>(value);
+}
+}  // namespace
+
+namespace ota {
+
+std::unique_ptr<OtaUpdater> OtaUpdater::Create() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_partition_t* target = esp_ota_get_next_update_partition(nullptr);
+    if (running == nullptr || target == nullptr) {
+        ESP_LOGE(kTag, "No OTA slot available.");
+        return nullptr;
+    }
+
+    // Use `new` because constructor is private.
+    std::unique_ptr<OtaUpdater> updater(new OtaUpdater(running, target));
+    if (updater->Initialize() != ESP_OK) {
+        return nullptr;
+    }
+    ESP_LOGI(kTag, "Running from '%s', updates go to '%s'.", running->label,
+             target->label);
+    return updater;
+}
+
+OtaUpdater::OtaUpdater(const esp_partition_t* running,
+                       const esp_partition_t* target)
+    : running_(running),
+      target_(target),
+      patcher_(
+          [this](uint32_t offset, std::span<uint8_t> dest) {
+              return esp_partition_read(running_, offset, dest.data(),
+                                        dest.size());
+          },
+          [this](std::span<const uint8_t> data) {
+              target_crc_ =
+                  esp_rom_crc32_le(target_crc_, data.data(), data.size());
+              return esp_ota_write(ota_handle_, data.data(), data.size());
+          }) {}
+
+OtaUpdater::~OtaUpdater() {
+    if (worker_task_handle_ != nullptr) {
+        vTaskDelete(worker_task_handle_);
+    }
+    if (request_queue_ != nullptr) {
+        vQueueDelete(request_queue_);
+    }
+    if (ota_open_) {
+        esp_ota_abort(ota_handle_);
+    }
+}
+
+esp_err_t OtaUpdater::Initialize() {
+    request_queue_ = xQueueCreate(kWindowChunks, sizeof(Request));
+    if (request_queue_ == nullptr) {
+        ESP_LOGE(kTag, "Failed to create OTA request queue.");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(WorkerTask, "ota_worker_task", kWorkerTaskStackSize, this,
+                    kWorkerTaskPriority, &worker_task_handle_) != pdPASS) {
+        ESP_LOGE(kTag, "Failed to create OTA worker task.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void OtaUpdater::HandlePacket(const ble::FramePacket& packet) {
+    if (packet.length == 0) {
+        return;
+    }
+
+    Request request;
+    request.opcode = packet.payload[0];
+    request.value = 0;
+    request.length = 0;
+    switch (request.opcode) {
+        case kOpBegin:
+        case kOpData:
+            if (packet.length < kDataHeaderSize) {
+                ESP_LOGW(kTag, "Truncated OTA request.");
+                return;
+            }
+            request.value = GetBigEndian32(&packet.payload[1]);
+            request.length = packet.length - kDataHeaderSize;
+            memcpy(request.data.data(), &packet.payload[kDataHeaderSize],
+                   request.length);
+            break;
+        case kOpFinish:
+        case kOpAbort:
+            break;
+        default:
+            ESP_LOGW(kTag, "Unknown OTA opcode 0x%02x.", request.opcode);
+            return;
+    }
+
+    // The window keeps the queue from overflowing. A chunk dropped anyway
+    // is resent by the client after the next ack.
+    if (xQueueSend(request_queue_, &request, 0) != pdPASS) {
+        ESP_LOGW(kTag, "OTA queue is full, request dropped.");
+    }
+}
+
+void OtaUpdater::ConfirmRunningImage() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGI(kTag, "New image started, cancelling rollback.");
+        esp_ota_mark_app_valid_cancel_rollback();
+    }
+}
+
+void OtaUpdater::RejectRunningImage() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGE(kTag, "New image failed to start, rolling back.");
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
+
+void OtaUpdater::WorkerTask(void* param) {
+    OtaUpdater* updater = static_cast<OtaUpdater*>(param);
+    Request& request = updater->request_;
+
+    while (true) {
+        if (xQueueReceive(updater->request_queue_, &request, portMAX_DELAY) !=
+            pdPASS) {
+            continue;
+        }
+        switch (request.opcode) {
+            case kOpBegin:
+                updater->Begin(request.value);
+                break;
+            case kOpData:
+                updater->ReceiveChunk(request);
+                break;
+            case kOpFinish:
+                updater->Finish();
+                break;
+            case kOpAbort:
+                if (updater->IsActive()) {
+                    updater->Fail(Status::kAborted);
+                }
+                break;
+        }
+    }
+}
+
+void OtaUpdater::Begin(uint32_t patch_size) {
+    if (IsActive()) {
+        ESP_LOGW(kTag, "Restarting OTA transfer.");
+        Fail(Status::kAborted);
+    }
+
+    patch_size_ = patch_size;
+    received_ = 0;
+    header_fill_ = 0;
+    target_crc_ = 0;
+    decoder_.Reset();
+    active_.store(true, std::memory_order_release);
+    ESP_LOGI(kTag, "OTA transfer of %lu bytes started.",
+             static_cast<unsigned long>(patch_size));
+
+    const uint8_t reply[] = {kOpBeginReply, static_cast<uint8_t>(Status::kOk),
+                             static_cast<uint8_t>(kWindowChunks),
+                             static_cast<uint8_t>(kMaxChunkBytes)};
+    SendReply(reply);
+}
+
+void OtaUpdater::ReceiveChunk(const Request& request) {
+    if (!IsActive()) {
+        return;
+    }
+    // Duplicates and chunks after a gap are dropped; the repeated ack
+    // tells the client where to resume.
+    if (request.value != received_ ||
+        request.length > patch_size_ - received_) {
+        SendAck();
+        return;
+    }
+
+    const Status status = Consume(
+        std::span<const uint8_t>(request.data.data(), request.length));
+    if (status != Status::kOk) {
+        Fail(status);
+        return;
+    }
+    received_ += request.length;
+    SendAck();
+}
+
+void OtaUpdater::Finish() {
+    if (!IsActive()) {
+        return;
+    }
+    if (received_ != patch_size_ || header_fill_ < kPatchHeaderSize) {
+        ESP_LOGE(kTag, "OTA transfer incomplete: %lu of %lu bytes.",
+                 static_cast<unsigned long>(received_),
+                 static_cast<unsigned long>(patch_size_));
+        Fail(Status::kVerifyFailed);
+        return;
+    }
+
+    // Consume() drains the decoder after every chunk; make sure nothing of
+    // a final match is still pending before the end is checked.
+    esp_err_t ret = compressed_ ? WriteCompressed({}) : ESP_OK;
+    if (ret == ESP_OK) {
+        ret = patcher_.Finish();
+    }
+    if (ret != ESP_OK) {
+        Fail(ret == ESP_ERR_INVALID_SIZE       ? Status::kVerifyFailed
+             : ret == ESP_ERR_INVALID_RESPONSE ? Status::kCorrupt
+                                               : Status::kFlashError);
+        return;
+    }
+    if (patcher_.GetTargetSize() != expected_target_size_ ||
+        target_crc_ != expected_target_crc_) {
+        ESP_LOGE(kTag, "Target mismatch: %lu bytes, CRC %08lx.",
+                 static_cast<unsigned long>(patcher_.GetTargetSize()),
+                 static_cast<unsigned long>(target_crc_));
+        Fail(Status::kVerifyFailed);
+        return;
+    }
+
+    // Checks the image header, segments, appended SHA-256 and signature,
+    // before the slot can be marked bootable.
+    ota_open_ = false;
+    ret = esp_ota_end(ota_handle_);
+    if (ret != ESP_OK) {
+        ESP_LOGE(kTag, "Image validation failed: %s", esp_err_to_name(ret));
+        Fail(Status::kVerifyFailed);
+        return;
+    }
+    ret = esp_ota_set_boot_partition(target_);
+    if (ret != ESP_OK) {
+        ESP_LOGE(kTag, "Failed to select boot slot: %s",
+                 esp_err_to_name(ret));
+        Fail(Status::kFlashError);
+        return;
+    }
+
+    ESP_LOGI(kTag, "Update installed to '%s', restarting.", target_->label);
+    SendResult(Status::kOk);
+    vTaskDelay(pdMS_TO_TICKS(kRestartDelayMs));
+    esp_restart();
+}
+
+OtaUpdater::Status OtaUpdater::Consume(std::span<const uint8_t> data) {
+    if (header_fill_ < kPatchHeaderSize) {
+        const size_t length =
+            std::min(data.size(), kPatchHeaderSize - header_fill_);
+        memcpy(&header_[header_fill_], data.data(), length);
+        header_fill_ += length;
+        data = data.subspan(length);
+        if (header_fill_ < kPatchHeaderSize) {
+            return Status::kOk;
+        }
+        const Status status = StartPatch();
+        if (status != Status::kOk) {
+            return status;
+        }
+    }
+
+    const esp_err_t ret =
+        compressed_ ? WriteCompressed(data) : patcher_.Write(data);
+    if (ret == ESP_ERR_INVALID_RESPONSE) {
+        return Status::kCorrupt;
+    }
+    return ret == ESP_OK ? Status::kOk : Status::kFlashError;
+}
+
+esp_err_t OtaUpdater::WriteCompressed(std::span<const uint8_t> data) {
+    return decoder_.DecodeAll(data, decoded_,
+                              [this](std::span<const uint8_t> decoded) {
+                                  return patcher_.Write(decoded);
+                              });
+}
+
+OtaUpdater::Status OtaUpdater::StartPatch() {
+    if (memcmp(header_.data(), kPatchMagic, sizeof(kPatchMagic)) != 0 ||
+        header_[4] != kPatchVersion) {
+        ESP_LOGE(kTag, "Not a version %u patch.", kPatchVersion);
+        return Status::kBadHeader;
+    }
+    compressed_ = (header_[5] & kFlagCompressed) != 0;
+    source_size_ = GetBigEndian32(&header_[8]);
+    const uint32_t source_crc = GetBigEndian32(&header_[12]);
+    expected_target_size_ = GetBigEndian32(&header_[16]);
+    expected_target_crc_ = GetBigEndian32(&header_[20]);
+    if (source_size_ > running_->size ||
+        expected_target_size_ > target_->size) {
+        ESP_LOGE(kTag, "Image sizes exceed the OTA slots.");
+        return Status::kBadHeader;
+    }
+
+    // A delta only makes sense against the exact image it was made from.
+    if (source_size_ > 0) {
+        uint32_t crc = 0;
+        for (uint32_t offset = 0; offset < source_size_;
+             offset += decoded_.size()) {
+            const size_t length =
+                std::min<size_t>(decoded_.size(), source_size_ - offset);
+            if (esp_partition_read(running_, offset, decoded_.data(),
+                                   length) != ESP_OK) {
+                return Status::kFlashError;
+            }
+            crc = esp_rom_crc32_le(crc, decoded_.data(), length);
+        }
+        if (crc != source_crc) {
+            ESP_LOGE(kTag, "Patch does not match the running image.");
+            return Status::kWrongSource;
+        }
+    }
+
+    // Sequential writes erase the slot sector by sector as it fills, so no
+    // single call blocks for the whole erase.
+    esp_err_t ret =
+        esp_ota_begin(target_, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle_);
+    if (ret != ESP_OK) {
+        ESP_LOGE(kTag, "esp_ota_begin failed: %s", esp_err_to_name(ret));
+        return Status::kFlashError;
+    }
+    ota_open_ = true;
+    patcher_.Reset(source_size_);
+    ESP_LOGI(kTag, "Applying %s%s patch: %lu -> %lu bytes.",
+             compressed_ ? "compressed " : "",
+             source_size_ > 0 ? "delta" : "full",
+             static_cast<unsigned long>(source_size_),
+             static_cast<unsigned long>(expected_target_size_));
+    return Status::kOk;
+}
+
+void OtaUpdater::Fail(Status status) {
+    if (ota_open_) {
+        esp_ota_abort(ota_handle_);
+        ota_open_ = false;
+    }
+    active_.store(false, std::memory_order_release);
+    ESP_LOGW(kTag, "OTA transfer ended with status %u after %lu bytes.",
+             static_cast<unsigned>(status),
+             static_cast<unsigned long>(received_));
+    SendResult(status);
+}
+
+void OtaUpdater::SendReply(std::span<const uint8_t> payload) {
+    ble::FramePacket frame = {
+        .data_type = ble::PacketConfig::kDataTypeOta,
+        .sequence = sequence_number_++,
+        .timestamp = static_cast<uint32_t>(esp_timer_get_time() / 1000),
+        .length = static_cast<uint8_t>(payload.size()),
+    };
+    memcpy(frame.payload.data(), payload.data(), payload.size());
+    ble::BLEManager::GetInstance()->SendFramePacket(frame);
+}
+
+void OtaUpdater::SendAck() {
+    uint8_t reply[kDataHeaderSize] = {kOpAck};
+    PutBigEndian32(&reply[1], received_);
+    SendReply(reply);
+}
+
+void OtaUpdater::SendResult(Status status) {
+    const uint8_t reply[] = {kOpResult, static_cast<uint8_t>(status)};
+    SendReply(reply);
+}
+
+}  // namespace ota
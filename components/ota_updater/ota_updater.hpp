@@ -0,0 +1,206 @@
+#ifndef OTA_UPDATER_OTA_UPDATER_HPP_
+#define OTA_UPDATER_OTA_UPDATER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "esp_err.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "ble_packet.hpp"
+#include "delta_patcher.hpp"
+#include "lzss_decoder.hpp"
+
+namespace ota {
+
+/**
+ * @class OtaUpdater
+ * @brief Receives firmware patches over BLE and installs them in the
+ * inactive OTA slot.
+ *
+ * A patch file is a kPatchHeaderSize header followed by a DeltaPatcher
+ * stream, optionally LZSS compressed. The header (big-endian) holds the
+ * magic "SFPT", the format version, flags, the size and CRC-32 of the
+ * source image the patch applies to (0 for a full image), and the size and
+ * CRC-32 of the target image.
+ *
+ * The client drives the transfer with kDataTypeOta frames whose first
+ * payload byte is an opcode:
+ * - kOpBegin (patch size, uint32): starts a transfer, answered by
+ *   kOpBeginReply (status, window in chunks, maximum chunk size).
+ * - kOpData (patch offset, uint32; data): the next chunk. Every processed
+ *   chunk is answered by kOpAck with the number of patch bytes received.
+ *   The client keeps at most `window` chunks unacknowledged; on a gap the
+ *   device repeats its last ack and the client resends from there.
+ * - kOpFinish: verifies the target, switches the boot slot and answers
+ *   with kOpResult before restarting.
+ * - kOpAbort: discards the transfer.
+ * Any failure ends the transfer with a kOpResult carrying the Status.
+ *
+ * The patch is applied as it streams in, against the running image, by a
+ * dedicated task with fixed buffers. The new image boots in the pending
+ * verification state: ConfirmRunningImage() keeps it once the application
+ * has started, and the bootloader rolls back to the previous slot if it
+ * never does.
+ */
+class OtaUpdater {
+   public:
+    // Client requests.
+    static constexpr uint8_t kOpBegin = 0x01;
+    static constexpr uint8_t kOpData = 0x02;
+    static constexpr uint8_t kOpFinish = 0x03;
+    static constexpr uint8_t kOpAbort = 0x04;
+    // Device replies.
+    static constexpr uint8_t kOpBeginReply = 0x81;
+    static constexpr uint8_t kOpAck = 0x82;
+    static constexpr uint8_t kOpResult = 0x83;
+
+    enum class Status : uint8_t {
+        kOk = 0,
+        kBadHeader,     // Not a patch file, or an unknown version
+        kWrongSource,   // Patch made for a different running image
+        kCorrupt,       // Malformed compressed or patch stream
+        kFlashError,    // Writing the OTA slot failed
+        kVerifyFailed,  // Size, checksum or image validation mismatch
+        kAborted,
+    };
+
+    // Chunks the client may have in flight, one queue slot each.
+    static constexpr size_t kWindowChunks = 8;
+    static constexpr size_t kDataHeaderSize = 5;
+    static constexpr size_t kMaxChunkBytes =
+        ble::PacketConfig::kMaxFramePayload - kDataHeaderSize;
+    static constexpr size_t kPatchHeaderSize = 24;
+    static constexpr uint8_t kPatchVersion = 1;
+    // Header flag: the patch stream is LZSS compressed.
+    static constexpr uint8_t kFlagCompressed = 0x01;
+
+    /**
+     * @brief Creates the updater and its worker task.
+     * @return The updater on success, or nullptr on failure (e.g. when the
+     * partition table has no OTA slots).
+     */
+    static std::unique_ptr<OtaUpdater> Create();
+
+    ~OtaUpdater();
+
+    OtaUpdater(const OtaUpdater&) = delete;
+    OtaUpdater& operator=(const OtaUpdater&) = delete;
+
+    /**
+     * @brief Accepts a kDataTypeOta frame from the client.
+     *
+     * Called from the BLE host task. The frame is queued for the worker
+     * task and the call never blocks.
+     */
+    void HandlePacket(const ble::FramePacket& packet);
+
+    /**
+     * @brief Checks whether a transfer is in progress.
+     */
+    bool IsActive() const { return active_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Keeps a freshly installed image after a successful start.
+     *
+     * Does nothing unless the running image is pending verification.
+     */
+    static void ConfirmRunningImage();
+
+    /**
+     * @brief Rolls back a freshly installed image that failed to start.
+     *
+     * Restarts into the previous image if the running one is pending
+     * verification, and returns otherwise.
+     */
+    static void RejectRunningImage();
+
+   private:
+    struct Request {
+        uint8_t opcode;
+        uint32_t value;  // Patch size or chunk offset
+        uint16_t length;
+        std::array<uint8_t, kMaxChunkBytes> data;
+    };
+
+    OtaUpdater(const esp_partition_t* running, const esp_partition_t* target);
+
+    /**
+     * @brief Creates the request queue and the worker task.
+     */
+    esp_err_t Initialize();
+
+    /**
+     * @brief FreeRTOS task that applies patch chunks to flash.
+     * @param param A void pointer to the owning OtaUpdater.
+     */
+    static void WorkerTask(void* param);
+
+    void Begin(uint32_t patch_size);
+    void ReceiveChunk(const Request& request);
+    void Finish();
+
+    /**
+     * @brief Feeds patch bytes through header parsing, decompression and
+     * patching.
+     */
+    Status Consume(std::span<const uint8_t> data);
+
+    /**
+     * @brief Decompresses patch bytes into the patcher, leaving nothing
+     * pending in the decoder.
+     */
+    esp_err_t WriteCompressed(std::span<const uint8_t> data);
+
+    /**
+     * @brief Validates the header and opens the target slot.
+     */
+    Status StartPatch();
+
+    /**
+     * @brief Ends the transfer, discarding the partial image.
+     */
+    void Fail(Status status);
+
+    void SendReply(std::span<const uint8_t> payload);
+    void SendAck();
+    void SendResult(Status status);
+
+    const esp_partition_t* running_;
+    const esp_partition_t* target_;
+
+    QueueHandle_t request_queue_ = nullptr;
+    TaskHandle_t worker_task_handle_ = nullptr;
+    std::atomic<bool> active_{false};
+    uint16_t sequence_number_ = 0;
+
+    // Transfer state, owned by the worker task.
+    esp_ota_handle_t ota_handle_ = 0;
+    bool ota_open_ = false;
+    uint32_t patch_size_ = 0;
+    uint32_t received_ = 0;
+    std::array<uint8_t, kPatchHeaderSize> header_{};
+    size_t header_fill_ = 0;
+    bool compressed_ = false;
+    uint32_t source_size_ = 0;
+    uint32_t expected_target_size_ = 0;
+    uint32_t expected_target_crc_ = 0;
+    uint32_t target_crc_ = 0;
+
+    LzssDecoder decoder_;
+    DeltaPatcher patcher_;
+    std::array<uint8_t, DeltaPatcher::kOutputBlockSize> decoded_{};
+    Request request_{};
+};
+
+}  // namespace ota
+
+#endif  // OTA_UPDATER_OTA_UPDATER_HPP_
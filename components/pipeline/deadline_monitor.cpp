@@ -0,0 +1,98 @@
+#include "deadline_monitor.hpp"
+
+#include <algorithm>
+
+#include "esp_timer.h"
+
+namespace pipeline {
+
+DeadlineMonitor::DeadlineMonitor(uint32_t frame_budget_us)
+    : frame_budget_us_(frame_budget_us) {}
+
+size_t DeadlineMonitor::AddStage(const StageConfig& config) {
+    if (stage_count_ >= kMaxStages || config.budget_us == 0) {
+        return kMaxStages;
+    }
+    stages_[stage_count_] = Stage{.config = config, .stats = {}};
+    return stage_count_++;
+}
+
+void DeadlineMonitor::BeginFrame() {
+    const int64_t now_us = esp_timer_get_time();
+    if (frame_start_us_ != 0) {
+        Record(frame_stats_, static_cast<uint32_t>(now_us - frame_start_us_),
+               frame_budget_us_, Cause::kUnknown);
+    }
+    frame_start_us_ = now_us;
+}
+
+void DeadlineMonitor::EndFrame() {
+    if (current_stage_ != kMaxStages) {
+        EndStage();
+    }
+}
+
+void DeadlineMonitor::BeginStage(size_t stage) {
+    if (stage >= stage_count_) {
+        return;
+    }
+    current_stage_ = stage;
+    noted_cause_ = Cause::kUnknown;
+    stage_start_us_ = esp_timer_get_time();
+}
+
+void DeadlineMonitor::EndStage() {
+    if (current_stage_ == kMaxStages) {
+        return;
+    }
+    Stage& stage = stages_[current_stage_];
+    current_stage_ = kMaxStages;
+    const uint32_t elapsed_us =
+        static_cast<uint32_t>(esp_timer_get_time() - stage_start_us_);
+    Record(stage.stats, elapsed_us, stage.config.budget_us,
+           noted_cause_ != Cause::kUnknown ? noted_cause_
+                                           : stage.config.cause);
+}
+
+void DeadlineMonitor::NoteCause(Cause cause) {
+    if (current_stage_ != kMaxStages) {
+        noted_cause_ = cause;
+    }
+}
+
+void DeadlineMonitor::ResetStats() {
+    for (size_t i = 0; i < stage_count_; ++i) {
+        stages_[i].stats = {};
+    }
+    frame_stats_ = {};
+    frame_start_us_ = 0;
+    current_stage_ = kMaxStages;
+}
+
+const char* DeadlineMonitor::GetCauseName(Cause cause) {
+    switch (cause) {
+        case Cause::kI2sWait:
+            return "I2S wait";
+        case Cause::kQueueFull:
+            return "queue full";
+        case Cause::kFlashStall:
+            return "flash stall";
+        default:
+            return "unknown";
+    }
+}
+
+void DeadlineMonitor::Record(Stats& stats, uint32_t elapsed_us,
+                             uint32_t budget_us, Cause cause) {
+    ++stats.runs;
+    stats.last_us = elapsed_us;
+    stats.worst_us = std::max(stats.worst_us, elapsed_us);
+    if (elapsed_us <= budget_us) {
+        return;
+    }
+    ++stats.overruns;
+    stats.last_cause = cause;
+    ++stats.overruns_by_cause[static_cast<size_t>(cause)];
+}
+
+}  // namespace pipeline
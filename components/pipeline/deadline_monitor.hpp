@@ -0,0 +1,153 @@
+#ifndef PIPELINE_DEADLINE_MONITOR_HPP_
+#define PIPELINE_DEADLINE_MONITOR_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace pipeline {
+
+/**
+ * @class DeadlineMonitor
+ * @brief Times the stages of a periodic task against per-frame budgets.
+ *
+ * Every stage declares how long it may take per frame and what it usually
+ * waits on when it runs late. The task brackets each frame with
+ * BeginFrame() and EndFrame() and each stage with a Scope. A stage that
+ * exceeds its budget counts an overrun, attributed to the cause noted
+ * while it ran, or to its declared cause otherwise. A frame overruns when
+ * it starts later than the frame budget after the previous one, i.e. when
+ * the task falls behind its period.
+ *
+ * Only stages that return can be timed. Hangs are left to the task
+ * watchdog, which the monitored task's loop must feed.
+ *
+ * Not thread-safe: all calls, including the statistics getters, must come
+ * from the monitored task.
+ */
+class DeadlineMonitor {
+   public:
+    static constexpr size_t kMaxStages = 12;
+
+    /**
+     * @brief What a late stage was waiting on.
+     */
+    enum class Cause : uint8_t {
+        kUnknown = 0,  // Computation, or nothing noted
+        kI2sWait,      // Blocked on the capture DMA
+        kQueueFull,    // Blocked on a full BLE send queue
+        kFlashStall,   // Blocked on a flash write or erase
+        kCount,
+    };
+
+    struct StageConfig {
+        const char* name;
+        uint32_t budget_us;
+        Cause cause;  // Assumed cause of overruns, unless one is noted
+    };
+
+    struct Stats {
+        uint32_t runs;
+        uint32_t overruns;
+        uint32_t last_us;
+        uint32_t worst_us;
+        Cause last_cause;  // Cause of the most recent overrun
+        std::array<uint32_t, static_cast<size_t>(Cause::kCount)>
+            overruns_by_cause;
+    };
+
+    /**
+     * @brief Times one stage for the lifetime of the object.
+     */
+    class Scope {
+       public:
+        Scope(DeadlineMonitor& monitor, size_t stage) : monitor_(monitor) {
+            monitor_.BeginStage(stage);
+        }
+        ~Scope() { monitor_.EndStage(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        DeadlineMonitor& monitor_;
+    };
+
+    /**
+     * @param frame_budget_us Longest allowed time from one frame start to
+     * the next.
+     */
+    explicit DeadlineMonitor(uint32_t frame_budget_us);
+
+    /**
+     * @brief Declares a stage.
+     * @return The stage index, or kMaxStages if all slots are in use.
+     */
+    size_t AddStage(const StageConfig& config);
+
+    /**
+     * @brief Marks the start of a frame and checks the frame period.
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Marks the end of a frame, closing a stage left open.
+     */
+    void EndFrame();
+
+    void BeginStage(size_t stage);
+    void EndStage();
+
+    /**
+     * @brief Records what the current stage is waiting on, e.g. after a
+     * send timed out on a full queue. Applies if the stage overruns.
+     */
+    void NoteCause(Cause cause);
+
+    size_t GetStageCount() const { return stage_count_; }
+    const char* GetStageName(size_t stage) const {
+        return stages_[stage].config.name;
+    }
+    const Stats& GetStageStats(size_t stage) const {
+        return stages_[stage].stats;
+    }
+    const Stats& GetFrameStats() const { return frame_stats_; }
+
+    /**
+     * @brief Clears all statistics, and the frame period reference.
+     */
+    void ResetStats();
+
+    /**
+     * @brief Returns a short name for a cause, for logs.
+     */
+    static const char* GetCauseName(Cause cause);
+
+   private:
+    struct Stage {
+        StageConfig config;
+        Stats stats;
+    };
+
+    /**
+     * @brief Accounts one timed run against a budget.
+     */
+    static void Record(Stats& stats, uint32_t elapsed_us, uint32_t budget_us,
+                       Cause cause);
+
+    uint32_t frame_budget_us_;
+    std::array<Stage, kMaxStages> stages_{};
+    size_t stage_count_ = 0;
+    Stats frame_stats_{};
+
+    // Start of the previous frame, 0 before the first.
+    int64_t frame_start_us_ = 0;
+    // The running stage, or kMaxStages between stages.
+    size_t current_stage_ = kMaxStages;
+    int64_t stage_start_us_ = 0;
+    Cause noted_cause_ = Cause::kUnknown;
+};
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_DEADLINE_MONITOR_HPP_
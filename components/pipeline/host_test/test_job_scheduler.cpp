@@ -0,0 +1,247 @@
+#include "job_scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "job_queue.hpp"
+
+namespace {
+
+using pipeline::JobQueue;
+using pipeline::JobScheduler;
+
+using Job = JobScheduler::Job;
+
+TEST(JobQueueTest, PopsInPushOrder) {
+    JobQueue<int, 4> queue;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(queue.TryPush(i));
+    }
+    for (int i = 0; i < 3; ++i) {
+        int value = -1;
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+}
+
+TEST(JobQueueTest, ReportsEmpty) {
+    JobQueue<int, 4> queue;
+    int value = 7;
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_EQ(value, 7);
+
+    ASSERT_TRUE(queue.TryPush(1));
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+TEST(JobQueueTest, ReportsFullAndRecovers) {
+    JobQueue<int, 4> queue;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPush(i));
+    }
+    EXPECT_FALSE(queue.TryPush(4));
+
+    int value = -1;
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(queue.TryPush(4));
+    EXPECT_FALSE(queue.TryPush(5));
+}
+
+TEST(JobQueueTest, WrapsAroundManyTimes) {
+    JobQueue<int, 2> queue;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(queue.TryPush(i));
+        int value = -1;
+        ASSERT_TRUE(queue.TryPop(value));
+        ASSERT_EQ(value, i);
+    }
+}
+
+// Several producers and consumers hammer a small queue; every value must
+// come out exactly once.
+TEST(JobQueueTest, ConcurrentProducersAndConsumersLoseNothing) {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    constexpr int kPerProducer = 20000;
+    constexpr int kTotal = kProducers * kPerProducer;
+    JobQueue<int, 16> queue;
+    std::vector<std::atomic<int>> seen(kTotal);
+    std::atomic<int> popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                while (!queue.TryPush(p * kPerProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&queue, &seen, &popped] {
+            while (popped.load(std::memory_order_relaxed) < kTotal) {
+                int value;
+                if (queue.TryPop(value)) {
+                    seen[value].fetch_add(1, std::memory_order_relaxed);
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(popped.load(), kTotal);
+    for (int i = 0; i < kTotal; ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << "value " << i;
+    }
+    int value;
+    EXPECT_FALSE(queue.TryPop(value));
+}
+
+// A job that records how often it ran and, optionally, takes some time so
+// the workers get a chance to pick up the rest of the batch.
+struct CountingJob {
+    std::atomic<int> runs{0};
+    std::chrono::microseconds busy{0};
+
+    void operator()() {
+        if (busy.count() > 0) {
+            const auto until = std::chrono::steady_clock::now() + busy;
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        }
+        runs.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+class JobSchedulerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        scheduler_ = JobScheduler::Create(JobScheduler::Config{});
+        ASSERT_NE(scheduler_, nullptr);
+    }
+
+    std::unique_ptr<JobScheduler> scheduler_;
+};
+
+TEST_F(JobSchedulerTest, EmptyBatchIsNotCounted) {
+    EXPECT_EQ(scheduler_->Run({}), ESP_OK);
+    EXPECT_EQ(scheduler_->GetStats().batches, 0u);
+    EXPECT_EQ(scheduler_->GetSpeedup(), 0.0f);
+    EXPECT_EQ(scheduler_->GetOverheadUs(), 0u);
+}
+
+TEST_F(JobSchedulerTest, RejectsOversizedBatchWithoutRunningIt) {
+    std::array<CountingJob, JobScheduler::kMaxJobs + 1> counters;
+    std::vector<Job> jobs;
+    for (CountingJob& counter : counters) {
+        jobs.push_back(Job::Of(counter));
+    }
+
+    EXPECT_EQ(scheduler_->Run(jobs), ESP_ERR_INVALID_SIZE);
+    for (const CountingJob& counter : counters) {
+        EXPECT_EQ(counter.runs.load(), 0);
+    }
+    EXPECT_EQ(scheduler_->GetStats().batches, 0u);
+}
+
+TEST_F(JobSchedulerTest, RunsEveryJobExactlyOncePerBatch) {
+    constexpr int kBatches = 500;
+    std::array<CountingJob, JobScheduler::kMaxJobs> counters;
+    std::vector<Job> jobs;
+    for (CountingJob& counter : counters) {
+        jobs.push_back(Job::Of(counter));
+    }
+
+    std::array<int, JobScheduler::kMaxJobs> expected{};
+    uint32_t expected_jobs = 0;
+    for (int batch = 0; batch < kBatches; ++batch) {
+        // Vary the batch size so every split across the queues occurs.
+        const size_t size = 1 + batch % JobScheduler::kMaxJobs;
+        ASSERT_EQ(scheduler_->Run(std::span<const Job>(jobs).first(size)),
+                  ESP_OK);
+        for (size_t i = 0; i < size; ++i) {
+            ++expected[i];
+        }
+        expected_jobs += size;
+        // Run() is the join: every job of the batch has already finished.
+        for (size_t i = 0; i < counters.size(); ++i) {
+            ASSERT_EQ(counters[i].runs.load(), expected[i])
+                << "job " << i << " after batch " << batch;
+        }
+    }
+
+    const JobScheduler::Stats& stats = scheduler_->GetStats();
+    EXPECT_EQ(stats.batches, static_cast<uint32_t>(kBatches));
+    EXPECT_EQ(stats.jobs, expected_jobs);
+    EXPECT_LE(stats.stolen, stats.jobs);
+}
+
+TEST_F(JobSchedulerTest, JoinsBeforeReturning) {
+    std::array<CountingJob, 8> counters;
+    std::vector<Job> jobs;
+    for (CountingJob& counter : counters) {
+        counter.busy = std::chrono::microseconds(500);
+        jobs.push_back(Job::Of(counter));
+    }
+
+    for (int batch = 1; batch <= 20; ++batch) {
+        ASSERT_EQ(scheduler_->Run(jobs), ESP_OK);
+        for (const CountingJob& counter : counters) {
+            ASSERT_EQ(counter.runs.load(), batch);
+        }
+    }
+}
+
+TEST_F(JobSchedulerTest, ReportsTimingStats) {
+    std::array<CountingJob, 6> counters;
+    std::vector<Job> jobs;
+    for (CountingJob& counter : counters) {
+        counter.busy = std::chrono::microseconds(1000);
+        jobs.push_back(Job::Of(counter));
+    }
+
+    constexpr int kBatches = 10;
+    for (int batch = 0; batch < kBatches; ++batch) {
+        ASSERT_EQ(scheduler_->Run(jobs), ESP_OK);
+    }
+
+    const JobScheduler::Stats& stats = scheduler_->GetStats();
+    EXPECT_EQ(stats.batches, static_cast<uint32_t>(kBatches));
+    EXPECT_EQ(stats.jobs, static_cast<uint32_t>(kBatches * counters.size()));
+    // Every job spins for at least its busy time.
+    EXPECT_GE(stats.job_us, static_cast<uint64_t>(kBatches) * counters.size() *
+                                1000);
+    EXPECT_GE(stats.last_job_us, counters.size() * 1000);
+    EXPECT_GT(stats.last_wall_us, 0u);
+    EXPECT_LE(stats.last_wall_us, stats.max_wall_us);
+    EXPECT_LE(stats.max_wall_us, stats.wall_us);
+    // A batch is never shorter than its longest job, nor is the speedup
+    // more than the number of participants. Scheduling on the host gives
+    // no lower bound.
+    EXPECT_GE(stats.max_wall_us, 1000u);
+    EXPECT_GT(scheduler_->GetSpeedup(), 0.0f);
+    EXPECT_LE(scheduler_->GetSpeedup(),
+              static_cast<float>(JobScheduler::kMaxWorkers + 1) + 0.1f);
+
+    scheduler_->ResetStats();
+    EXPECT_EQ(scheduler_->GetStats().batches, 0u);
+    EXPECT_EQ(scheduler_->GetStats().wall_us, 0u);
+    EXPECT_EQ(scheduler_->GetSpeedup(), 0.0f);
+}
+
+}  // namespace
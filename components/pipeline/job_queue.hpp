@@ -0,0 +1,108 @@
+#ifndef PIPELINE_JOB_QUEUE_HPP_
+#define PIPELINE_JOB_QUEUE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace pipeline {
+
+/**
+ * @class JobQueue
+ * @brief Bounded lock-free multi-producer, multi-consumer queue.
+ *
+ * Every cell carries a sequence number telling producers and consumers
+ * whose turn it is, so a push or pop is one compare-and-swap on the shared
+ * position plus a release store on the cell (D. Vyukov's bounded MPMC
+ * queue). Neither side ever blocks; a full or empty queue is reported
+ * instead.
+ *
+ * @tparam T Element type, copied in and out.
+ * @tparam Capacity Number of cells, a power of two.
+ */
+template <typename T, size_t Capacity>
+class JobQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+   public:
+    JobQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    JobQueue(const JobQueue&) = delete;
+    JobQueue& operator=(const JobQueue&) = delete;
+
+    /**
+     * @return false if the queue is full.
+     */
+    bool TryPush(const T& value) {
+        size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & (Capacity - 1)];
+            const size_t sequence =
+                cell.sequence.load(std::memory_order_acquire);
+            const ptrdiff_t lag = static_cast<ptrdiff_t>(sequence - position);
+            if (lag == 0) {
+                if (enqueue_position_.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @return false if the queue is empty.
+     */
+    bool TryPop(T& value) {
+        size_t position = dequeue_position_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & (Capacity - 1)];
+            const size_t sequence =
+                cell.sequence.load(std::memory_order_acquire);
+            const ptrdiff_t lag =
+                static_cast<ptrdiff_t>(sequence - (position + 1));
+            if (lag == 0) {
+                if (dequeue_position_.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.sequence.store(position + Capacity,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;
+            } else {
+                position = dequeue_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+   private:
+    // Producers and consumers on different cores contend on separate
+    // cache lines.
+    static constexpr size_t kLineSize = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    alignas(kLineSize) std::array<Cell, Capacity> cells_;
+    alignas(kLineSize) std::atomic<size_t> enqueue_position_{0};
+    alignas(kLineSize) std::atomic<size_t> dequeue_position_{0};
+};
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_JOB_QUEUE_HPP_
@@ -0,0 +1,163 @@
+#include "job_scheduler.hpp"
+
+#include <algorithm>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+namespace {
+static const char* kTag = "JobScheduler";
+}  // namespace
+
+namespace pipeline {
+
+std::unique_ptr<JobScheduler> JobScheduler::Create(const Config& config) {
+    auto scheduler = std::unique_ptr<JobScheduler>(new JobScheduler(config));
+    if (scheduler->Initialize() != ESP_OK) {
+        return nullptr;
+    }
+    return scheduler;
+}
+
+JobScheduler::JobScheduler(const Config& config) : config_(config) {}
+
+JobScheduler::~JobScheduler() {
+    for (const Worker& worker : workers_) {
+        if (worker.handle != nullptr) {
+            vTaskDelete(worker.handle);
+        }
+    }
+    if (batch_done_ != nullptr) {
+        vSemaphoreDelete(batch_done_);
+    }
+}
+
+esp_err_t JobScheduler::Initialize() {
+    batch_done_ = xSemaphoreCreateBinary();
+    if (batch_done_ == nullptr) {
+        ESP_LOGE(kTag, "Failed to create join semaphore.");
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t core = 0; core < kMaxWorkers; ++core) {
+        Worker& worker = workers_[core];
+        worker.scheduler = this;
+        worker.queue = core + 1;
+        if (xTaskCreatePinnedToCore(WorkerTask, "dsp_worker_task",
+                                    config_.stack_size, &worker,
+                                    config_.priority, &worker.handle,
+                                    static_cast<BaseType_t>(core)) != pdPASS) {
+            ESP_LOGE(kTag, "Failed to create worker task on core %u.",
+                     static_cast<unsigned>(core));
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t JobScheduler::Run(std::span<const Job> jobs) {
+    if (jobs.size() > kMaxJobs) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (jobs.empty()) {
+        return ESP_OK;
+    }
+    const int64_t start_us = esp_timer_get_time();
+    batch_job_us_.store(0, std::memory_order_relaxed);
+    batch_stolen_.store(0, std::memory_order_relaxed);
+    pending_.store(jobs.size(), std::memory_order_relaxed);
+
+    // The caller takes the first job of every round, so a single job runs
+    // inline without a worker being involved.
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        // Cannot fail: every queue is empty between batches and holds
+        // kMaxJobs.
+        queues_[i % kQueueCount].TryPush(jobs[i]);
+    }
+    const size_t woken = std::min(jobs.size() - 1, kMaxWorkers);
+    for (size_t i = 0; i < woken; ++i) {
+        xTaskNotifyGive(workers_[i].handle);
+    }
+
+    while (true) {
+        while (RunOne(kCallerQueue)) {
+        }
+        if (pending_.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+        // The rest is running on the workers. A give left over from an
+        // earlier batch only causes another pass.
+        xSemaphoreTake(batch_done_, portMAX_DELAY);
+    }
+
+    const uint32_t wall_us =
+        static_cast<uint32_t>(esp_timer_get_time() - start_us);
+    const uint32_t job_us = batch_job_us_.load(std::memory_order_relaxed);
+    ++stats_.batches;
+    stats_.jobs += jobs.size();
+    stats_.stolen += batch_stolen_.load(std::memory_order_relaxed);
+    stats_.wall_us += wall_us;
+    stats_.job_us += job_us;
+    stats_.last_wall_us = wall_us;
+    stats_.last_job_us = job_us;
+    stats_.max_wall_us = std::max(stats_.max_wall_us, wall_us);
+    return ESP_OK;
+}
+
+float JobScheduler::GetSpeedup() const {
+    if (stats_.wall_us == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(stats_.job_us) / stats_.wall_us;
+}
+
+uint32_t JobScheduler::GetOverheadUs() const {
+    if (stats_.batches == 0) {
+        return 0;
+    }
+    const uint64_t ideal_us = stats_.job_us / portNUM_PROCESSORS;
+    if (stats_.wall_us <= ideal_us) {
+        return 0;
+    }
+    return static_cast<uint32_t>((stats_.wall_us - ideal_us) /
+                                 stats_.batches);
+}
+
+void JobScheduler::WorkerTask(void* param) {
+    const Worker* worker = static_cast<const Worker*>(param);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (worker->scheduler->RunOne(worker->queue)) {
+        }
+    }
+}
+
+bool JobScheduler::RunOne(size_t home) {
+    Job job;
+    bool stolen = false;
+    if (!queues_[home].TryPop(job)) {
+        size_t victim = home;
+        do {
+            victim = (victim + 1) % kQueueCount;
+        } while (victim != home && !queues_[victim].TryPop(job));
+        if (victim == home) {
+            return false;
+        }
+        stolen = true;
+    }
+
+    const int64_t start_us = esp_timer_get_time();
+    job.function(job.context);
+    batch_job_us_.fetch_add(
+        static_cast<uint32_t>(esp_timer_get_time() - start_us),
+        std::memory_order_relaxed);
+    if (stolen) {
+        batch_stolen_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+        home != kCallerQueue) {
+        xSemaphoreGive(batch_done_);
+    }
+    return true;
+}
+
+}  // namespace pipeline
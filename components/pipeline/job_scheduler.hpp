@@ -0,0 +1,150 @@
+#ifndef PIPELINE_JOB_SCHEDULER_HPP_
+#define PIPELINE_JOB_SCHEDULER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "job_queue.hpp"
+
+namespace pipeline {
+
+/**
+ * @class JobScheduler
+ * @brief Runs a frame's independent DSP jobs in parallel on both cores.
+ *
+ * One worker task is pinned to every core. Run() deals a batch of jobs
+ * round-robin onto lock-free queues, one per worker plus one for the
+ * calling task, wakes the workers and then works through the batch
+ * itself. Whoever runs out of work on its own queue steals from the
+ * others, so an unlucky split or a worker delayed by a higher-priority
+ * task does not hold the batch up. Run() returns once every job has
+ * finished, which is the frame's join barrier.
+ *
+ * Jobs must not block and must not touch state another job of the same
+ * batch touches. Run() and the statistics are for one calling task only.
+ */
+class JobScheduler {
+   public:
+    static constexpr size_t kMaxJobs = 16;
+    static constexpr size_t kMaxWorkers = portNUM_PROCESSORS;
+
+    /**
+     * @brief A function and its argument, run once.
+     */
+    struct Job {
+        void (*function)(void* context);
+        void* context;
+
+        /**
+         * @brief Wraps a callable, e.g. a lambda, that outlives the batch.
+         */
+        template <typename F>
+        static Job Of(F& callable) {
+            return Job{[](void* context) { (*static_cast<F*>(context))(); },
+                       &callable};
+        }
+    };
+
+    struct Config {
+        uint32_t stack_size = 3072;
+        // Same as the streaming task, so a worker is not starved by it.
+        UBaseType_t priority = 5;
+    };
+
+    // Times come from esp_timer: cycle counters are per core, and the
+    // calling task may move between cores during a batch.
+    struct Stats {
+        uint32_t batches;
+        uint32_t jobs;
+        // Jobs run by another participant than the one they were dealt to.
+        uint32_t stolen;
+        // Sum over batches of the time from Run() to the join.
+        uint64_t wall_us;
+        // Sum over jobs of their run time; the serial cost of the batches.
+        uint64_t job_us;
+        uint32_t last_wall_us;
+        uint32_t last_job_us;
+        uint32_t max_wall_us;
+    };
+
+    /**
+     * @brief Creates the scheduler and its worker tasks.
+     * @return The scheduler, or nullptr if a task could not be created.
+     */
+    static std::unique_ptr<JobScheduler> Create(const Config& config);
+
+    ~JobScheduler();
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    /**
+     * @brief Runs a batch of jobs and waits for all of them.
+     * @return ESP_ERR_INVALID_SIZE, running nothing, if the batch holds
+     * more than kMaxJobs jobs.
+     */
+    esp_err_t Run(std::span<const Job> jobs);
+
+    const Stats& GetStats() const { return stats_; }
+    void ResetStats() { stats_ = {}; }
+
+    /**
+     * @brief Returns the speedup of the batches so far over running their
+     * jobs one after another, or 0 before the first batch.
+     */
+    float GetSpeedup() const;
+
+    /**
+     * @brief Returns the average time per batch beyond an even split of
+     * its jobs across the cores: dealing, waking, stealing, the join and
+     * any imbalance between the jobs.
+     */
+    uint32_t GetOverheadUs() const;
+
+   private:
+    // Queue 0 belongs to the calling task, queue i + 1 to worker i.
+    static constexpr size_t kQueueCount = kMaxWorkers + 1;
+    static constexpr size_t kCallerQueue = 0;
+
+    explicit JobScheduler(const Config& config);
+    esp_err_t Initialize();
+
+    struct Worker {
+        JobScheduler* scheduler;
+        size_t queue;
+        TaskHandle_t handle;
+    };
+
+    static void WorkerTask(void* param);
+
+    /**
+     * @brief Runs one job, from `home` or stolen from another queue.
+     * @return false if every queue was empty.
+     */
+    bool RunOne(size_t home);
+
+    Config config_;
+    std::array<JobQueue<Job, kMaxJobs>, kQueueCount> queues_;
+    std::array<Worker, kMaxWorkers> workers_{};
+    // Given by the worker that finishes a batch's last job.
+    SemaphoreHandle_t batch_done_ = nullptr;
+
+    std::atomic<uint32_t> pending_{0};
+    std::atomic<uint32_t> batch_job_us_{0};
+    std::atomic<uint32_t> batch_stolen_{0};
+
+    Stats stats_{};
+};
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_JOB_SCHEDULER_HPP_
@@ -0,0 +1,78 @@
+#include "load_shedder.hpp"
+
+#include <algorithm>
+
+namespace pipeline {
+
+LoadShedder::LoadShedder(const Config& config, std::span<const Step> ladder)
+    : config_(config) {
+    for (const Step& step : ladder) {
+        if (ladder_size_ == kMaxSteps ||
+            step.priority <= Priority::kCoreFeature ||
+            step.priority >= Priority::kCount) {
+            continue;
+        }
+        ladder_[ladder_size_++] = step;
+    }
+    Reset();
+}
+
+bool LoadShedder::Update(float cpu_load, float queue_occupancy) {
+    ++frame_;
+    cpu_load_ += config_.smoothing * (cpu_load - cpu_load_);
+    queue_occupancy_ += config_.smoothing * (queue_occupancy - queue_occupancy_);
+
+    const bool overloaded = cpu_load_ > config_.high_load ||
+                            queue_occupancy_ > config_.high_queue;
+    const bool underloaded = cpu_load_ < config_.low_load &&
+                             queue_occupancy_ < config_.low_queue;
+    // Both counts restart whenever the condition breaks, so only a
+    // sustained overload or recovery moves the level.
+    overloaded_frames_ = overloaded ? overloaded_frames_ + 1 : 0;
+    underloaded_frames_ = underloaded ? underloaded_frames_ + 1 : 0;
+
+    if (overloaded_frames_ >= config_.shed_after_frames &&
+        level_ < ladder_size_) {
+        ++level_;
+        max_level_ = std::max(max_level_, level_);
+    } else if (underloaded_frames_ >= config_.restore_after_frames &&
+               level_ > 0) {
+        --level_;
+    } else {
+        return false;
+    }
+    overloaded_frames_ = 0;
+    underloaded_frames_ = 0;
+    ApplyLevel();
+    return true;
+}
+
+bool LoadShedder::ShouldRun(Priority priority) const {
+    const size_t index = static_cast<size_t>(priority);
+    const uint8_t decimation = decimation_[index];
+    return decimation != 0 && (frame_ / span_[index]) % decimation == 0;
+}
+
+void LoadShedder::Reset() {
+    level_ = 0;
+    max_level_ = 0;
+    frame_ = 0;
+    cpu_load_ = 0.0f;
+    queue_occupancy_ = 0.0f;
+    overloaded_frames_ = 0;
+    underloaded_frames_ = 0;
+    ApplyLevel();
+}
+
+void LoadShedder::ApplyLevel() {
+    decimation_.fill(1);
+    span_.fill(1);
+    // Later steps for the same class override earlier ones.
+    for (size_t i = 0; i < level_; ++i) {
+        const size_t index = static_cast<size_t>(ladder_[i].priority);
+        decimation_[index] = ladder_[i].decimation;
+        span_[index] = std::max<uint16_t>(ladder_[i].span_frames, 1);
+    }
+}
+
+}  // namespace pipeline
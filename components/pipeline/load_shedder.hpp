@@ -0,0 +1,128 @@
+#ifndef PIPELINE_LOAD_SHEDDER_HPP_
+#define PIPELINE_LOAD_SHEDDER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace pipeline {
+
+/**
+ * @class LoadShedder
+ * @brief Sheds optional pipeline work under CPU or link overload.
+ *
+ * Work is ranked by Priority. The caller supplies a ladder of shedding
+ * steps, lowest priority first; each step decimates or stops one class of
+ * work. Decimated work runs in spans of consecutive frames. Once per frame the controller is fed the task's CPU load and the
+ * send queue occupancy, both smoothed. While either stays above its high
+ * mark for `shed_after_frames` frames, one more step is taken. Steps are
+ * undone one at a time only after both have stayed below their low marks
+ * for `restore_after_frames` frames, so the pipeline does not oscillate
+ * around the overload point. Capture and the core feature stream are never
+ * shed.
+ *
+ * Not thread-safe: call from the pipeline task only.
+ */
+class LoadShedder {
+   public:
+    static constexpr size_t kMaxSteps = 8;
+
+    /**
+     * @brief Classes of pipeline work, most important first.
+     */
+    enum class Priority : uint8_t {
+        kCapture = 0,
+        kCoreFeature,
+        kTransport,
+        kLogging,
+        kLed,
+        kAnalytics,
+        kCount,
+    };
+
+    /**
+     * @brief One rung of the shedding ladder.
+     */
+    struct Step {
+        Priority priority;
+        // Run the class one span in `decimation`, or never if 0.
+        uint8_t decimation;
+        // Consecutive frames per span. Stateful stages need spans of
+        // whole blocks, as skipped frames would splice their input.
+        uint16_t span_frames = 1;
+    };
+
+    struct Config {
+        float high_load = 0.85f;  // Share of the frame period spent working
+        float low_load = 0.60f;
+        float high_queue = 0.50f;  // Share of the send queue in use
+        float low_queue = 0.20f;
+        // Long enough for the smoothed load to show the previous step.
+        uint32_t shed_after_frames = 16;
+        uint32_t restore_after_frames = 200;
+        float smoothing = 0.125f;  // Weight of the newest measurement
+    };
+
+    /**
+     * @param ladder Shedding steps, taken in order. Steps beyond kMaxSteps
+     * and steps for capture or the core feature stream are ignored.
+     */
+    LoadShedder(const Config& config, std::span<const Step> ladder);
+
+    /**
+     * @brief Feeds one frame's measurements and moves along the ladder.
+     * @param cpu_load Time spent working divided by the frame period.
+     * @param queue_occupancy Share of the send queue in use, 0.0 to 1.0.
+     * @return true if the shedding level changed.
+     */
+    bool Update(float cpu_load, float queue_occupancy);
+
+    /**
+     * @brief Returns whether work of a class runs in the current frame.
+     *
+     * A class that was skipped in the previous frame starts a new span of
+     * input; stateful stages should be reset before running again.
+     */
+    bool ShouldRun(Priority priority) const;
+
+    /**
+     * @brief Returns the number of ladder steps currently taken.
+     */
+    size_t GetLevel() const { return level_; }
+    size_t GetMaxLevel() const { return max_level_; }
+    float GetCpuLoad() const { return cpu_load_; }
+    float GetQueueOccupancy() const { return queue_occupancy_; }
+
+    /**
+     * @brief Restores all work and clears the measurements.
+     */
+    void Reset();
+
+   private:
+    /**
+     * @brief Recomputes the decimation of every class from the ladder.
+     */
+    void ApplyLevel();
+
+    Config config_;
+    std::array<Step, kMaxSteps> ladder_{};
+    size_t ladder_size_ = 0;
+
+    // Decimation of every class at the current level, 0 when shed, and
+    // the length of its spans.
+    std::array<uint8_t, static_cast<size_t>(Priority::kCount)> decimation_{};
+    std::array<uint16_t, static_cast<size_t>(Priority::kCount)> span_{};
+    size_t level_ = 0;
+    size_t max_level_ = 0;
+    uint32_t frame_ = 0;
+
+    float cpu_load_ = 0.0f;
+    float queue_occupancy_ = 0.0f;
+    uint32_t overloaded_frames_ = 0;
+    uint32_t underloaded_frames_ = 0;
+};
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_LOAD_SHEDDER_HPP_
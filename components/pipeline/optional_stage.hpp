@@ -0,0 +1,49 @@
+#ifndef PIPELINE_OPTIONAL_STAGE_HPP_
+#define PIPELINE_OPTIONAL_STAGE_HPP_
+
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+/**
+ * @brief Stands in for a pipeline stage compiled out of the build.
+ *
+ * Empty, and constructible from the arguments of any stage, so a slot can
+ * switch between the two without touching its initialiser.
+ */
+struct Omitted {
+    template <typename... Args>
+    constexpr explicit Omitted(Args&&...) {}
+};
+
+/**
+ * @brief A pipeline stage slot: T when the stage is built, Omitted
+ * otherwise. Declare slots [[no_unique_address]] so omitted stages take no
+ * space.
+ */
+template <bool Enabled, typename T>
+using OptionalStage = std::conditional_t<Enabled, T, Omitted>;
+
+template <typename T>
+inline constexpr bool kIsPresent =
+    !std::is_same_v<std::remove_cv_t<T>, Omitted>;
+
+/**
+ * @brief Runs `body` on a stage if it is built.
+ *
+ * The body must be a generic lambda: it is only instantiated for a present
+ * stage, so an omitted stage's code, and everything only it references,
+ * never reaches the image. Resolved at compile time and inlined, the call
+ * costs nothing over using the stage directly.
+ */
+template <typename T, typename Body>
+inline void IfPresent(T& stage, Body&& body) {
+    if constexpr (kIsPresent<T>) {
+        std::forward<Body>(body)(stage);
+    }
+}
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_OPTIONAL_STAGE_HPP_
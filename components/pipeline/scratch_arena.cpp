@@ -0,0 +1,37 @@
+#include "scratch_arena.hpp"
+
+#include <algorithm>
+
+#include "esp_log.h"
+
+namespace {
+static const char* kTag = "ScratchArena";
+}  // namespace
+
+namespace pipeline {
+
+ScratchArena::ScratchArena(size_t capacity_bytes)
+    : storage_(memory::MemoryPlacement::Allocate<uint8_t>(
+          memory::BufferClass::kHotScratch, capacity_bytes)) {
+    if (!storage_) {
+        ESP_LOGE(kTag, "Failed to allocate %zu bytes of scratch.",
+                 capacity_bytes);
+        return;
+    }
+    capacity_ = capacity_bytes;
+}
+
+void* ScratchArena::AllocateBytes(size_t bytes) {
+    // The storage is cache-line aligned and every footprint is a multiple
+    // of kAlignment, so used_ keeps every allocation aligned.
+    if (bytes > capacity_ - used_) {
+        ++failures_;
+        return nullptr;
+    }
+    void* start = storage_.get() + used_;
+    used_ += bytes;
+    peak_ = std::max(peak_, used_);
+    return start;
+}
+
+}  // namespace pipeline
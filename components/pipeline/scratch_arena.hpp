@@ -0,0 +1,116 @@
+#ifndef PIPELINE_SCRATCH_ARENA_HPP_
+#define PIPELINE_SCRATCH_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include "memory_placement.hpp"
+
+namespace pipeline {
+
+/**
+ * @class ScratchArena
+ * @brief Bump-pointer arena for the temporaries of a periodic pipeline.
+ *
+ * Stages carve their per-frame buffers from the arena instead of the task
+ * stack, so adding a stage grows a budget that is sized and tracked in one
+ * place rather than the stack. The owner calls Reset() at the start of
+ * every frame, which releases everything at once. A stage that only needs
+ * its buffers while it runs brackets itself with a Checkpoint, so the
+ * arena needs the frame-long buffers plus the largest single stage rather
+ * than the sum of all stages.
+ *
+ * Memory is returned uninitialised. An allocation that does not fit returns
+ * an empty span and is counted as a failure; callers treat that like a
+ * skipped stage.
+ *
+ * Not thread-safe: use from the owning task only.
+ */
+class ScratchArena {
+   public:
+    // Every allocation starts on this boundary, enough for any DSP type.
+    static constexpr size_t kAlignment = 16;
+
+    /**
+     * @brief Rewinds the arena to where it was on construction.
+     */
+    class Checkpoint {
+       public:
+        explicit Checkpoint(ScratchArena& arena)
+            : arena_(arena), used_(arena.used_) {}
+        ~Checkpoint() { arena_.used_ = used_; }
+
+        Checkpoint(const Checkpoint&) = delete;
+        Checkpoint& operator=(const Checkpoint&) = delete;
+
+       private:
+        ScratchArena& arena_;
+        size_t used_;
+    };
+
+    /**
+     * @brief Returns the arena bytes taken by `count` elements of T.
+     */
+    template <typename T>
+    static constexpr size_t Footprint(size_t count) {
+        return (count * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    /**
+     * @param capacity_bytes Arena size. Allocated as hot scratch, i.e. in
+     * internal RAM; on failure the arena is empty and every allocation
+     * fails.
+     */
+    explicit ScratchArena(size_t capacity_bytes);
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    /**
+     * @brief Carves `count` uninitialised elements of T from the arena.
+     * @return The elements, or an empty span if they do not fit.
+     */
+    template <typename T>
+    std::span<T> Allocate(size_t count) {
+        static_assert(std::is_trivially_default_constructible_v<T> &&
+                          std::is_trivially_destructible_v<T>,
+                      "Arena memory is never constructed or destroyed");
+        static_assert(alignof(T) <= kAlignment, "Over-aligned type");
+        void* bytes = AllocateBytes(Footprint<T>(count));
+        if (bytes == nullptr) {
+            return {};
+        }
+        return std::span<T>(static_cast<T*>(bytes), count);
+    }
+
+    /**
+     * @brief Releases every allocation. Call once per frame.
+     */
+    void Reset() { used_ = 0; }
+
+    size_t GetCapacity() const { return capacity_; }
+    size_t GetUsed() const { return used_; }
+    // Most bytes in use at once since the last ResetStats().
+    size_t GetPeak() const { return peak_; }
+    uint32_t GetFailures() const { return failures_; }
+
+    void ResetStats() {
+        peak_ = used_;
+        failures_ = 0;
+    }
+
+   private:
+    void* AllocateBytes(size_t bytes);
+
+    memory::MemoryPlacement::UniquePtr<uint8_t> storage_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    size_t peak_ = 0;
+    uint32_t failures_ = 0;
+};
+
+}  // namespace pipeline
+
+#endif  // PIPELINE_SCRATCH_ARENA_HPP_
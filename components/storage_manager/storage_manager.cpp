@@ -5,6 +5,7 @@
 
 #include "esp_log.h"
 #include "esp_spiffs.h"
+#include "memory_placement.hpp"
 
 namespace {
 // File-local constants for the StorageManager implementation.
@@ -53,7 +54,7 @@ StorageManager::~StorageManager() {
 esp_err_t StorageManager::Initialize() {
     ESP_LOGI(kTag, "Initializing and mounting SPIFFS filesystem...");
 
-    esp_vfs_spiffs_conf_t conf = {.base_path = "/spiffs",
+    esp_vfs_spiffs_conf_t conf = {.base_path = kBasePath,
                                   .partition_label = kSpiffsPartitionLabel,
                                   .max_files = 5,
                                   // Format the partition if mounting fails.
@@ -85,6 +86,14 @@ esp_err_t StorageManager::Initialize() {
         return ESP_FAIL;
     }
 
+    // Without a buffer of our own, newlib allocates the stdio buffer from
+    // internal RAM on the first write. Staging lives off the hot path.
+    log_buffer_ = memory::MemoryPlacement::Allocate<char>(
+        memory::BufferClass::kLogStaging, kLogBufferSize);
+    if (log_buffer_) {
+        setvbuf(log_file_, log_buffer_.get(), _IOFBF, kLogBufferSize);
+    }
+
     ESP_LOGI(kTag, "SPIFFS mounted and log file opened successfully.");
     return ESP_OK;
 }
@@ -108,4 +117,14 @@ esp_err_t StorageManager::LogAudioFeature(const ble::AudioPacket& packet) {
     return ESP_OK;
 }
 
+esp_err_t StorageManager::GetUsage(size_t& total_bytes,
+                                   size_t& used_bytes) const {
+    esp_err_t ret =
+        esp_spiffs_info(kSpiffsPartitionLabel, &total_bytes, &used_bytes);
+    if (ret != ESP_OK) {
+        ESP_LOGE(kTag, "Failed to get SPIFFS usage (%s)", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
 }  // namespace storage
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <string>
 #include "ble_packet.hpp"
 #include "esp_err.h"
+#include "memory_placement.hpp"
 
 namespace storage {
 
@@ -14,6 +15,9 @@ namespace storage {
  */
 class StorageManager {
    public:
+    // Mount point of the SPIFFS filesystem.
+    static constexpr const char* kBasePath = "/spiffs";
+
     StorageManager(const StorageManager&) = delete;
     StorageManager& operator=(const StorageManager&) = delete;
     ~StorageManager();
@@ -38,10 +42,22 @@ class StorageManager {
      */
     esp_err_t LogAudioFeature(const ble::AudioPacket& packet);
 
+    /**
+     * @brief Reports the size of the filesystem and how much of it is used.
+     * @param[out] total_bytes Usable size of the filesystem.
+     * @param[out] used_bytes Bytes currently in use.
+     * @return esp_err_t ESP_OK on success.
+     */
+    esp_err_t GetUsage(size_t& total_bytes, size_t& used_bytes) const;
+
    private:
     StorageManager() = default;
     esp_err_t Initialize();
 
+    static constexpr size_t kLogBufferSize = 1024;
+
+    // Must outlive log_file_, which the destructor closes first.
+    memory::MemoryPlacement::UniquePtr<char> log_buffer_;
     FILE* log_file_ = nullptr;
     static std::unique_ptr<StorageManager> s_instance_;
 };
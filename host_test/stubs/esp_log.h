@@ -0,0 +1,19 @@
+// Host stand-in for the ESP-IDF header. Errors and warnings go to stderr,
+// the rest is dropped.
+#pragma once
+
+#include <cstdio>
+
+#define ESP_LOGE(tag, format, ...) \
+    std::fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) \
+    std::fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) \
+    do {                           \
+    } while (0)
+#define ESP_LOGD(tag, format, ...) \
+    do {                           \
+    } while (0)
+#define ESP_LOGV(tag, format, ...) \
+    do {                           \
+    } while (0)
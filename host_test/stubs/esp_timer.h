@@ -0,0 +1,12 @@
+// Host stand-in for the ESP-IDF header: microseconds since first use.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+inline int64_t esp_timer_get_time() {
+    static const auto kStart = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - kStart)
+        .count();
+}
@@ -0,0 +1,87 @@
+// Host stand-in for the FreeRTOS kernel header. Tasks are std::threads,
+// semaphores and notifications are atomic counters and critical sections
+// are spinlocks, which is enough for components that only create tasks,
+// notify them, wait and guard shared state.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY UINT32_MAX
+#define portNUM_PROCESSORS 2
+
+struct portMUX_TYPE {
+    std::atomic_flag locked = ATOMIC_FLAG_INIT;
+};
+#define portMUX_INITIALIZER_UNLOCKED \
+    {}
+#define portENTER_CRITICAL(mux)                                      \
+    do {                                                             \
+        while ((mux)->locked.test_and_set(std::memory_order_acquire)) { \
+        }                                                            \
+    } while (0)
+#define portEXIT_CRITICAL(mux) (mux)->locked.clear(std::memory_order_release)
+
+namespace freertos_host {
+
+// A count that Give() raises and Take() waits on. Closing it makes every
+// waiter give up, which is how a task is deleted.
+struct Counter {
+    static constexpr uint32_t kClosed = 1u << 31;
+
+    std::atomic<uint32_t> count{0};
+
+    void Give() {
+        count.fetch_add(1, std::memory_order_release);
+        count.notify_all();
+    }
+
+    // Raises the count from 0 to 1 only, like a binary semaphore.
+    bool GiveOnce() {
+        uint32_t expected = 0;
+        if (!count.compare_exchange_strong(expected, 1,
+                                           std::memory_order_release)) {
+            return false;
+        }
+        count.notify_all();
+        return true;
+    }
+
+    // Returns the count before taking, or 0 once closed.
+    uint32_t Take(bool clear) {
+        uint32_t value = count.load(std::memory_order_acquire);
+        while (true) {
+            if ((value & kClosed) != 0) {
+                return 0;
+            }
+            if (value == 0) {
+                count.wait(0, std::memory_order_acquire);
+                value = count.load(std::memory_order_acquire);
+                continue;
+            }
+            if (count.compare_exchange_weak(value, clear ? 0 : value - 1,
+                                            std::memory_order_acquire)) {
+                return value;
+            }
+        }
+    }
+
+    void Close() {
+        count.fetch_or(kClosed, std::memory_order_release);
+        count.notify_all();
+    }
+};
+
+// Thrown out of a blocking call of a deleted task to unwind its thread.
+struct TaskDeleted {};
+
+}  // namespace freertos_host
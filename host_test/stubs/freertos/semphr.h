@@ -0,0 +1,24 @@
+// Host stand-in for the FreeRTOS semaphore API, see FreeRTOS.h.
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef freertos_host::Counter* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new freertos_host::Counter;
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore,
+                                 TickType_t /*ticks_to_wait*/) {
+    semaphore->Take(/*clear=*/true);
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return semaphore->GiveOnce() ? pdTRUE : pdFALSE;
+}
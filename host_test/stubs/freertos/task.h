@@ -0,0 +1,59 @@
+// Host stand-in for the FreeRTOS task API, see FreeRTOS.h.
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+struct tskTaskControlBlock {
+    std::thread thread;
+    freertos_host::Counter notification;
+};
+typedef tskTaskControlBlock* TaskHandle_t;
+
+namespace freertos_host {
+
+inline thread_local TaskHandle_t current_task = nullptr;
+
+}  // namespace freertos_host
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function,
+                                          const char* /*name*/,
+                                          uint32_t /*stack_depth*/,
+                                          void* parameter,
+                                          UBaseType_t /*priority*/,
+                                          TaskHandle_t* created,
+                                          BaseType_t /*core*/) {
+    TaskHandle_t task = new tskTaskControlBlock;
+    if (created != nullptr) {
+        *created = task;
+    }
+    task->thread = std::thread([task, function, parameter] {
+        freertos_host::current_task = task;
+        try {
+            function(parameter);
+        } catch (const freertos_host::TaskDeleted&) {
+        }
+    });
+    return pdPASS;
+}
+
+// Only deletes other tasks that are blocked in, or will reach,
+// ulTaskNotifyTake.
+inline void vTaskDelete(TaskHandle_t task) {
+    task->notification.Close();
+    task->thread.join();
+    delete task;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task) { task->notification.Give(); }
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit,
+                                 TickType_t /*ticks_to_wait*/) {
+    const uint32_t value =
+        freertos_host::current_task->notification.Take(clear_on_exit);
+    if (value == 0) {
+        throw freertos_host::TaskDeleted();
+    }
+    return value;
+}
@@ -4,6 +4,7 @@
 
 // The only application-specific header we need is our main coordinator.
 #include "application.hpp"
+#include "ota_updater.hpp"
 
 namespace {
 // File-local constants.
@@ -36,6 +37,8 @@ extern "C" void app_main(void) {
     // --- 3. Check for initialization success and start the application ---
     if (ret == ESP_OK) {
         ESP_LOGI(kTag, "Application created successfully. Starting...");
+        // A freshly installed update has proven itself; keep it.
+        ota::OtaUpdater::ConfirmRunningImage();
         // If initialization was successful, get the instance and start its main
         // task.
         app::Application::GetInstance().Start();
@@ -43,6 +46,8 @@ extern "C" void app_main(void) {
         ESP_LOGE(kTag,
                  "FATAL: Failed to create Application instance. Error: %s (%d)",
                  esp_err_to_name(ret), ret);
+        // A freshly installed update that cannot start is rolled back.
+        ota::OtaUpdater::RejectRunningImage();
         ESP_LOGE(kTag, "System will halt.");
         // If the core application fails to initialize, there is nothing more to
         // do. We enter an infinite loop to halt further execution. A production
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Compares the image size of a full-analytics and a minimal RMS build.
+
+Usage:
+    compare_pipeline_builds.py [--skip-build]
+
+Builds the firmware twice with idf.py, once from sdkconfig.defaults and
+once with sdkconfig.minimal_rms layered on top, each in its own build
+directory, then prints the IRAM, DRAM and flash use of both images and the
+size of the app binary that has to fit an OTA slot.
+
+Per-frame cost is measured on the device: flash each image, stream for a
+while and compare the "Frame work: N cycles avg, M max" line StreamingState
+logs when streaming stops.
+"""
+
+import argparse
+import os
+import struct
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROJECT = "sonaflow-firmware"
+
+BUILDS = (
+    ("full", "sdkconfig.defaults"),
+    ("minimal_rms", "sdkconfig.defaults;sdkconfig.minimal_rms"),
+)
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+# Output sections by the memory they occupy, from the ESP32-S3 linker
+# scripts. Sections not listed are not counted.
+REGIONS = (
+    ("IRAM", (".iram0.vectors", ".iram0.text", ".iram0.text_end")),
+    ("DRAM", (".dram0.data", ".dram0.bss", ".noinit")),
+    ("flash code", (".flash.text",)),
+    ("flash data", (".flash.rodata", ".flash.appdesc", ".eh_frame",
+                    ".flash.rodata_noload")),
+)
+
+
+def section_sizes(elf_path):
+    """Returns {name: size} of the allocated sections of an ELF32 file."""
+    with open(elf_path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1:
+        sys.exit("%s: not an ELF32 file" % elf_path)
+    (shoff,) = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def header(index):
+        return struct.unpack_from("<10I", data, shoff + index * shentsize)
+
+    names_offset = header(shstrndx)[4]
+    sizes = {}
+    for index in range(shnum):
+        name, _, flags, _, _, size = header(index)[:6]
+        if not flags & SHF_ALLOC:
+            continue
+        end = data.index(b"\0", names_offset + name)
+        sizes[data[names_offset + name:end].decode()] = size
+    return sizes
+
+
+def build(name, defaults):
+    build_dir = os.path.join(ROOT, "build_" + name)
+    subprocess.run(
+        ["idf.py", "-B", build_dir,
+         "-D", "SDKCONFIG=" + os.path.join(build_dir, "sdkconfig"),
+         "-D", "SDKCONFIG_DEFAULTS=" + defaults, "build"],
+        cwd=ROOT, check=True)
+    return build_dir
+
+
+def measure(build_dir):
+    sizes = section_sizes(os.path.join(build_dir, PROJECT + ".elf"))
+    row = {region: sum(sizes.get(s, 0) for s in sections)
+           for region, sections in REGIONS}
+    row["app binary"] = os.path.getsize(
+        os.path.join(build_dir, PROJECT + ".bin"))
+    return row
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--skip-build", action="store_true",
+                        help="measure the existing build directories")
+    args = parser.parse_args()
+
+    rows = {}
+    for name, defaults in BUILDS:
+        build_dir = os.path.join(ROOT, "build_" + name)
+        if not args.skip_build:
+            build_dir = build(name, defaults)
+        rows[name] = measure(build_dir)
+
+    full, minimal = rows["full"], rows["minimal_rms"]
+    print("%-12s %12s %12s %12s" % ("", "full", "minimal_rms", "saved"))
+    for key in full:
+        print("%-12s %12d %12d %12d" %
+              (key, full[key], minimal[key], full[key] - minimal[key]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Builds firmware update patches for ota::OtaUpdater.
+
+Usage:
+    make_ota_patch.py TARGET.bin OUT.sfp [--source RUNNING.bin] [--raw]
+
+Without --source the patch carries the full image. With it, the patch only
+applies to a device running exactly that image. The stream is LZSS
+compressed unless --raw is given.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b"SFPT"
+VERSION = 1
+FLAG_COMPRESSED = 0x01
+
+OP_END = 0x00
+OP_ADD = 0x01
+OP_INSERT = 0x02
+
+# Source matches are seeded from K-byte fingerprints.
+K = 8
+# Shorter source matches are sent as literal inserts instead.
+MIN_MATCH = 24
+
+WINDOW_BITS = 12
+WINDOW_SIZE = 1 << WINDOW_BITS
+LZ_MIN_MATCH = 3
+LZ_MAX_MATCH = LZ_MIN_MATCH + 15
+LZ_MAX_CANDIDATES = 32
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def extend(source, target, s, t):
+    """Length of the approximate match at (s, t) that maximises the number
+    of matching bytes minus mismatches, as bsdiff does."""
+    score = best = best_length = 0
+    length = 0
+    limit = min(len(source) - s, len(target) - t)
+    while length < limit:
+        score += 1 if source[s + length] == target[t + length] else -1
+        length += 1
+        if score > best:
+            best, best_length = score, length
+        elif score < best - 32:
+            break
+    return best_length
+
+
+def diff(source, target):
+    index = {}
+    for offset in range(len(source) - K + 1):
+        index.setdefault(source[offset:offset + K], offset)
+
+    commands = bytearray()
+    cursor = 0
+    insert_start = 0
+    t = 0
+
+    def emit_insert(end):
+        if end > insert_start:
+            commands.append(OP_INSERT)
+            commands.extend(varint(end - insert_start))
+            commands.extend(target[insert_start:end])
+
+    while t < len(target):
+        # Prefer continuing with the current displacement, which follows
+        # code that merely moved.
+        candidates = []
+        key = target[t:t + K]
+        aligned = cursor + (t - insert_start)
+        if source[aligned:aligned + K] == key:
+            candidates.append(aligned)
+        seeded = index.get(key)
+        if seeded is not None:
+            candidates.append(seeded)
+
+        best_s, best_length = None, 0
+        for s in candidates:
+            length = extend(source, target, s, t)
+            if length > best_length:
+                best_s, best_length = s, length
+        if best_length < MIN_MATCH:
+            t += 1
+            continue
+
+        emit_insert(t)
+        commands.append(OP_ADD)
+        commands.extend(varint(best_length))
+        commands.extend(varint(zigzag(best_s - cursor)))
+        commands.extend((target[t + i] - source[best_s + i]) & 0xFF
+                        for i in range(best_length))
+        cursor = best_s + best_length
+        t += best_length
+        insert_start = t
+
+    emit_insert(len(target))
+    commands.append(OP_END)
+    return bytes(commands)
+
+
+def compress(data):
+    out = bytearray()
+    chains = {}
+    group_flags = 0
+    group_items = bytearray()
+    group_count = 0
+    position = 0
+
+    def flush_group():
+        out.append(group_flags)
+        out.extend(group_items)
+
+    while position < len(data):
+        best_length, best_distance = 0, 0
+        key = data[position:position + LZ_MIN_MATCH]
+        for candidate in reversed(chains.get(key, [])):
+            distance = position - candidate
+            if distance > WINDOW_SIZE:
+                break
+            length = 0
+            while (length < LZ_MAX_MATCH and position + length < len(data)
+                   and data[candidate + length] == data[position + length]):
+                length += 1
+            if length > best_length:
+                best_length, best_distance = length, distance
+                if length == LZ_MAX_MATCH:
+                    break
+
+        if best_length >= LZ_MIN_MATCH:
+            encoded = best_distance - 1
+            group_items.append(encoded & 0xFF)
+            group_items.append(((encoded >> 8) << 4) |
+                               (best_length - LZ_MIN_MATCH))
+            step = best_length
+        else:
+            group_flags |= 1 << group_count
+            group_items.append(data[position])
+            step = 1
+
+        for p in range(position, position + step):
+            chain = chains.setdefault(data[p:p + LZ_MIN_MATCH], [])
+            chain.append(p)
+            if len(chain) > LZ_MAX_CANDIDATES:
+                del chain[0]
+        position += step
+
+        group_count += 1
+        if group_count == 8:
+            flush_group()
+            group_flags, group_items, group_count = 0, bytearray(), 0
+
+    if group_count:
+        flush_group()
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("target", help="new application image")
+    parser.add_argument("output", help="patch file to write")
+    parser.add_argument("--source", help="image currently on the device")
+    parser.add_argument("--raw", action="store_true",
+                        help="do not compress the patch stream")
+    args = parser.parse_args()
+
+    with open(args.target, "rb") as f:
+        target = f.read()
+    source = b""
+    if args.source:
+        with open(args.source, "rb") as f:
+            source = f.read()
+
+    stream = diff(source, target)
+    flags = 0
+    if not args.raw:
+        stream = compress(stream)
+        flags |= FLAG_COMPRESSED
+
+    header = MAGIC + struct.pack(">BBHIIII", VERSION, flags, 0, len(source),
+                                 zlib.crc32(source), len(target),
+                                 zlib.crc32(target))
+    with open(args.output, "wb") as f:
+        f.write(header + stream)
+
+    print(f"{args.output}: {len(header) + len(stream)} bytes for a "
+          f"{len(target)} byte image", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()